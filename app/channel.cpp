@@ -4,9 +4,13 @@
 #include "user_channel/channel_layer.hpp"
 
 #include <arpa/inet.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 
+#include <boost/asio/posix/stream_descriptor.hpp>
 #include <boost/process/child.hpp>
 #include <fstream>
+#include <ipmid/api.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -21,22 +25,84 @@ using namespace sdbusplus::xyz::openbmc_project::Common::Error;
 namespace cipher
 {
 
-/** @brief Get the supported Cipher records
+namespace
+{
+
+// directory of the cipher suite configuration
+constexpr auto configDir = "/usr/share/ipmi-providers";
+
+// the records are only kept while the configuration directory is watched
+std::shared_ptr<const Records> records;
+
+std::unique_ptr<boost::asio::posix::stream_descriptor> changes;
+
+void waitChanges()
+{
+    changes->async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        [](const boost::system::error_code& ec) {
+            if (ec || !changes)
+            {
+                return;
+            }
+            alignas(inotify_event) char events[4096];
+            while (read(changes->native_handle(), events, sizeof(events)) > 0)
+            {
+            }
+            records.reset();
+            waitChanges();
+        });
+}
+
+bool watch()
+{
+    if (changes)
+    {
+        return true;
+    }
+    auto io = getIoContext();
+    if (!io)
+    {
+        return false;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to create the cipher suites watch",
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+    if (inotify_add_watch(fd, configDir,
+                          IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                              IN_MOVED_FROM | IN_MOVED_TO) < 0)
+    {
+        log<level::ERR>("Failed to watch the cipher suites file",
+                        entry("DIR=%s", configDir), entry("ERRNO=%d", errno));
+        close(fd);
+        return false;
+    }
+    changes =
+        std::make_unique<boost::asio::posix::stream_descriptor>(*io, fd);
+    waitChanges();
+    return true;
+}
+
+/** @brief Parse the cipher suite records
  *
  * The cipher records are read from the JSON file and converted into
  * 1. cipher suite record format mentioned in the IPMI specification. The
  * records can be either OEM or standard cipher. Each json entry is parsed and
  * converted into the cipher record format and pushed into the vector.
  * 2. Algorithms listed in vector format
+ * 3. The list of cipher suite IDs of the LAN configuration parameters
  *
- * @return pair of vector containing 1. all the cipher suite records. 2.
- * Algorithms supported
- *
+ * @return the records
  */
-std::pair<std::vector<uint8_t>, std::vector<uint8_t>> getCipherRecords()
+Records parseRecords()
 {
-    std::vector<uint8_t> cipherRecords;
-    std::vector<uint8_t> supportedAlgorithmRecords;
+    Records parsed;
+    auto& cipherRecords = parsed.cipherSuites;
     // create set to get the unique supported algorithms
     std::set<uint8_t> supportedAlgorithmSet;
 
@@ -54,6 +120,9 @@ std::pair<std::vector<uint8_t>, std::vector<uint8_t>> getCipherRecords()
         elog<InternalFailure>();
     }
 
+    // Byte 1 of the cipher suite list is reserved
+    parsed.cipherList.push_back(0x00);
+
     for (const auto& record : data)
     {
         if (record.find(oem) != record.end())
@@ -75,6 +144,8 @@ std::pair<std::vector<uint8_t>, std::vector<uint8_t>> getCipherRecords()
             cipherRecords.push_back(record.value(cipher, 0));
         }
 
+        parsed.cipherList.push_back(record.value(cipher, 0));
+
         // Authentication algorithm number
         cipherRecords.push_back(record.value(auth, 0));
         supportedAlgorithmSet.insert(record.value(auth, 0));
@@ -88,11 +159,27 @@ std::pair<std::vector<uint8_t>, std::vector<uint8_t>> getCipherRecords()
         supportedAlgorithmSet.insert(record.value(conf, 0) | confTag);
     }
 
-    // copy the set to supportedAlgorithmRecord which is vector based.
+    // copy the set to the algorithms which are vector based.
     std::copy(supportedAlgorithmSet.begin(), supportedAlgorithmSet.end(),
-              std::back_inserter(supportedAlgorithmRecords));
+              std::back_inserter(parsed.algorithms));
 
-    return std::make_pair(cipherRecords, supportedAlgorithmRecords);
+    return parsed;
+}
+
+} // namespace
+
+std::shared_ptr<const Records> getRecords()
+{
+    if (records)
+    {
+        return records;
+    }
+    auto parsed = std::make_shared<const Records>(parseRecords());
+    if (watch())
+    {
+        records = parsed;
+    }
+    return parsed;
 }
 
 } // namespace cipher
@@ -103,10 +190,6 @@ ipmi_ret_t getChannelCipherSuites(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                   ipmi_data_len_t data_len,
                                   ipmi_context_t context)
 {
-    static std::vector<uint8_t> cipherRecords;
-    static std::vector<uint8_t> supportedAlgorithms;
-    static auto recordInit = false;
-
     auto requestData =
         reinterpret_cast<const GetChannelCipherRequest*>(request);
 
@@ -118,24 +201,20 @@ ipmi_ret_t getChannelCipherSuites(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     *data_len = 0;
 
-    if (!recordInit)
+    std::shared_ptr<const cipher::Records> parsed;
+    try
     {
-        try
-        {
-            std::tie(cipherRecords, supportedAlgorithms) =
-                cipher::getCipherRecords();
-            recordInit = true;
-        }
-        catch (const std::exception& e)
-        {
-            return IPMI_CC_UNSPECIFIED_ERROR;
-        }
+        parsed = cipher::getRecords();
+    }
+    catch (const std::exception& e)
+    {
+        return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
     const auto& records = (cipher::listCipherSuite ==
                            (requestData->listIndex & cipher::listTypeMask))
-                              ? cipherRecords
-                              : supportedAlgorithms;
+                              ? parsed->cipherSuites
+                              : parsed->algorithms;
 
     // List index(00h-3Fh), 0h selects the first set of 16, 1h selects the next
     // set of 16 and so on.
@@ -2,6 +2,10 @@
 
 #include <ipmid/api.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 /** @brief The set channel access IPMI command.
  *
  *  @param[in] netfn
@@ -91,6 +95,27 @@ static constexpr auto integrityTag = 0x40;
 static constexpr auto conf = "confidentiality";
 static constexpr auto confTag = 0x80;
 
+/** @struct Records
+ *  @brief The cipher suite configuration in the formats it is reported in
+ */
+struct Records
+{
+    /** @brief Cipher suite records of Get Channel Cipher Suites */
+    std::vector<uint8_t> cipherSuites;
+    /** @brief Supported algorithms of Get Channel Cipher Suites */
+    std::vector<uint8_t> algorithms;
+    /** @brief Reserved byte and cipher suite IDs of the LAN parameters */
+    std::vector<uint8_t> cipherList;
+};
+
+/** @brief Get the cipher suite records
+ *
+ *  The JSON file is parsed on first use and again only after it changed.
+ *
+ *  @return the records; throws InternalFailure if the file can't be read
+ */
+std::shared_ptr<const Records> getRecords();
+
 } // namespace cipher
 
 /** @struct GetChannelCipherRequest
@@ -3,38 +3,39 @@
 #include <ipmid/api.hpp>
 
 /** @brief The RESET watchdog IPMI command.
+ *
+ *  @param[in] ctx - context of the request; selects the watchdog of its host
  */
-ipmi::RspType<> ipmiAppResetWatchdogTimer();
+ipmi::RspType<> ipmiAppResetWatchdogTimer(ipmi::Context::ptr ctx);
 
 /** @brief The SET watchdog IPMI command.
  *
- *  @param[in] netfn
- *  @param[in] cmd
- *  @param[in] request
- *  @param[in,out] response
- *  @param[out] data_len
- *  @param[in] context
+ *  @param[in] ctx - context of the request; selects the watchdog of its host
+ *  @param[in] timerUse - timer use, with the don't log and don't stop bits
+ *  @param[in] timerAction - timeout and pre-timeout interrupt actions
+ *  @param[in] pretimeout - pre-timeout interval in seconds
+ *  @param[in] expireFlags - timer use expiration flags to clear
+ *  @param[in] initialCountdown - initial countdown in deciseconds
  *
- *  @return IPMI_CC_OK on success, an IPMI error code otherwise.
+ *  @return completion code on success.
  */
-ipmi_ret_t ipmi_app_watchdog_set(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                 ipmi_request_t request,
-                                 ipmi_response_t response,
-                                 ipmi_data_len_t data_len,
-                                 ipmi_context_t context);
+ipmi::RspType<> ipmiSetWatchdogTimer(ipmi::Context::ptr ctx, uint8_t timerUse,
+                                     uint8_t timerAction, uint8_t pretimeout,
+                                     uint8_t expireFlags,
+                                     uint16_t initialCountdown);
 
 /** @brief The GET watchdog IPMI command.
- *  @param[in] netfn
- *  @param[in] cmd
- *  @param[in] request
- *  @param[in,out] response
- *  @param[out] data_len
- *  @param[in] context
  *
- *  @return IPMI_CC_OK on success, an IPMI error code otherwise.
+ *  @param[in] ctx - context of the request; selects the watchdog of its host
+ *
+ *  @return completion code, timer use, timer action, pre-timeout interval,
+ *          expiration flags, initial countdown and present countdown.
  */
-ipmi_ret_t ipmi_app_watchdog_get(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                 ipmi_request_t request,
-                                 ipmi_response_t response,
-                                 ipmi_data_len_t data_len,
-                                 ipmi_context_t context);
+ipmi::RspType<uint8_t,  // timer use
+              uint8_t,  // timer action
+              uint8_t,  // pretimeout
+              uint8_t,  // expiration flags
+              uint16_t, // initial countdown (deciseconds)
+              uint16_t  // present countdown (deciseconds)
+              >
+    ipmiGetWatchdogTimer(ipmi::Context::ptr ctx);
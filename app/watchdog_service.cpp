@@ -1,14 +1,21 @@
 #include "watchdog_service.hpp"
 
+#include <chrono>
 #include <exception>
 #include <ipmid/api.hpp>
+#include <ipmid/per-host.hpp>
+#include <map>
+#include <memory>
+#include <optional>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/message.hpp>
 #include <stdexcept>
 #include <string>
+#include <variant>
 #include <xyz/openbmc_project/Common/error.hpp>
 #include <xyz/openbmc_project/State/Watchdog/server.hpp>
 
@@ -20,18 +27,181 @@ using sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 using sdbusplus::xyz::openbmc_project::State::server::convertForMessage;
 using sdbusplus::xyz::openbmc_project::State::server::Watchdog;
 
-static constexpr char wd_path[] = "/xyz/openbmc_project/watchdog/host0";
+static constexpr char wd_root[] = "/xyz/openbmc_project/watchdog/host";
 static constexpr char wd_intf[] = "xyz.openbmc_project.State.Watchdog";
 static constexpr char prop_intf[] = "org.freedesktop.DBus.Properties";
 
-ipmi::ServiceCache WatchdogService::wd_service(wd_intf, wd_path);
+using PropertyValue = std::variant<bool, uint64_t, std::string>;
 
-WatchdogService::WatchdogService() : bus(ipmid_get_sd_bus_connection())
+/* what is known of the watchdog of one host */
+struct WatchdogService::State
+{
+    explicit State(size_t host) :
+        path(wd_root + std::to_string(host)), service(wd_intf, path)
+    {
+    }
+
+    std::string path;
+    ipmi::ServiceCache service;
+
+    /* the watchdog properties, kept up to date from the PropertiesChanged
+     * signals of the watchdog for as long as they are watched */
+    std::optional<Properties> cached;
+
+    /* when the cached time remaining was current; the watchdog counts it
+     * down from there while it is enabled without signalling the change */
+    std::chrono::steady_clock::time_point remainingSince;
+
+    std::unique_ptr<sdbusplus::bus::match::match> propertiesChanged;
+    std::unique_ptr<sdbusplus::bus::match::match> ownerChanged;
+
+    /* update one property of the cached copy; the caller handles the
+     * std::bad_variant_access of a value of the wrong type */
+    void apply(const std::string& key, const PropertyValue& value);
+
+    /* start updating the cached copy from the property changes; returns
+     * true if the copy can be kept */
+    bool watch();
+};
+
+namespace
+{
+
+/* the hosts are given one watchdog each */
+ipmi::PerHost<WatchdogService::State> watchdogs([](size_t host) {
+    return std::make_unique<WatchdogService::State>(host);
+});
+
+} // namespace
+
+void WatchdogService::State::apply(const std::string& key,
+                                   const PropertyValue& value)
+{
+    Properties& properties = *cached;
+
+    if (key == "Initialized")
+    {
+        properties.initialized = std::get<bool>(value);
+    }
+    else if (key == "CurrentTimerUse")
+    {
+        properties.timerUse =
+            Watchdog::convertTimerUseFromString(std::get<std::string>(value));
+    }
+    else if (key == "Interval")
+    {
+        properties.interval = std::get<uint64_t>(value);
+    }
+    else if (key == "TimeRemaining")
+    {
+        properties.timeRemaining = std::get<uint64_t>(value);
+        remainingSince = std::chrono::steady_clock::now();
+    }
+}
+
+bool WatchdogService::State::watch()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto bus = ipmi::getSdBus();
+    if (!bus)
+    {
+        return false;
+    }
+    if (!propertiesChanged)
+    {
+        propertiesChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::propertiesChanged(path, wd_intf),
+            [this](sdbusplus::message::message& msg) {
+                if (!cached)
+                {
+                    return;
+                }
+                try
+                {
+                    std::string interface;
+                    std::map<std::string, PropertyValue> properties;
+                    msg.read(interface, properties);
+                    for (const auto& [key, value] : properties)
+                    {
+                        // the watchdog restarts the countdown when it is
+                        // enabled or falls back to another action, and
+                        // doesn't signal the time remaining it restarts
+                        // from; read it all again
+                        if (key == "Enabled" || key == "ExpireAction")
+                        {
+                            cached.reset();
+                            return;
+                        }
+                        apply(key, value);
+                    }
+                }
+                catch (const std::exception& e)
+                {
+                    cached.reset();
+                }
+            });
+    }
+    if (!ownerChanged)
+    {
+        std::string name;
+        try
+        {
+            name = service.getService(ipmi::getBus());
+        }
+        catch (const std::exception& e)
+        {
+            // not running; nothing can be cached until it is
+            return false;
+        }
+        // a restarted watchdog comes back with its defaults; only its own
+        // name matters, not every name on the bus
+        ownerChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::nameOwnerChanged() + rules::argN(0, name),
+            [this](sdbusplus::message::message&) {
+                cached.reset();
+                service.invalidate();
+            });
+    }
+    return true;
+}
+
+WatchdogService::WatchdogService(size_t host) :
+    bus(getBus()), state(watchdogs[host]), wd_service(state.service),
+    cached(state.cached)
 {
 }
 
 void WatchdogService::resetTimeRemaining(bool enableWatchdog)
 {
+    auto sdbus = ipmi::getSdBus();
+    if (sdbus && cached)
+    {
+        // nothing is read back, so don't wait for the watchdog to answer;
+        // the cached copy gets what the reset does right away
+        const std::string& service = wd_service.getService(bus);
+        State& state = this->state;
+        sdbus->async_method_call(
+            [enableWatchdog, &state](const boost::system::error_code ec) {
+                if (ec)
+                {
+                    log<level::ERR>(
+                        "WatchdogService: Method error resetting time "
+                        "remaining",
+                        entry("ENABLE_WATCHDOG=%d", !!enableWatchdog),
+                        entry("ERROR=%s", ec.message().c_str()));
+                    state.service.invalidate();
+                    state.cached.reset();
+                }
+            },
+            service, state.path, wd_intf, "ResetTimeRemaining",
+            enableWatchdog);
+        cached->enabled = cached->enabled || enableWatchdog;
+        cached->timeRemaining = cached->interval;
+        state.remainingSince = std::chrono::steady_clock::now();
+        return;
+    }
+
     bool wasValid = wd_service.isValid(bus);
     auto request = wd_service.newMethodCall(bus, wd_intf, "ResetTimeRemaining");
     request.append(enableWatchdog);
@@ -53,6 +223,30 @@ void WatchdogService::resetTimeRemaining(bool enableWatchdog)
 
 WatchdogService::Properties WatchdogService::getProperties()
 {
+    if (cached)
+    {
+        Properties wd_prop = *cached;
+        if (!wd_prop.enabled)
+        {
+            return wd_prop;
+        }
+        uint64_t elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - state.remainingSince)
+                .count();
+        if (elapsed < wd_prop.timeRemaining)
+        {
+            wd_prop.timeRemaining -= elapsed;
+            return wd_prop;
+        }
+        // expired; the watchdog may have restarted with its fallback
+        // action and interval without signalling them
+        cached.reset();
+    }
+
+    // watch before reading, so that a change that arrives while the
+    // properties are read is applied to them
+    bool keep = state.watch();
     bool wasValid = wd_service.isValid(bus);
     auto request = wd_service.newMethodCall(bus, prop_intf, "GetAll");
     request.append(wd_intf);
@@ -70,8 +264,7 @@ WatchdogService::Properties WatchdogService::getProperties()
     }
     try
     {
-        std::map<std::string, std::variant<bool, uint64_t, std::string>>
-            properties;
+        std::map<std::string, PropertyValue> properties;
         response.read(properties);
         Properties wd_prop;
         wd_prop.initialized = std::get<bool>(properties.at("Initialized"));
@@ -84,6 +277,11 @@ WatchdogService::Properties WatchdogService::getProperties()
         wd_prop.interval = std::get<uint64_t>(properties.at("Interval"));
         wd_prop.timeRemaining =
             std::get<uint64_t>(properties.at("TimeRemaining"));
+        if (keep)
+        {
+            cached = wd_prop;
+            state.remainingSince = std::chrono::steady_clock::now();
+        }
         return wd_prop;
     }
     catch (const std::exception& e)
@@ -100,46 +298,6 @@ WatchdogService::Properties WatchdogService::getProperties()
         "WatchdogService: Should not reach end of getProperties");
 }
 
-template <typename T>
-T WatchdogService::getProperty(const std::string& key)
-{
-    bool wasValid = wd_service.isValid(bus);
-    auto request = wd_service.newMethodCall(bus, prop_intf, "Get");
-    request.append(wd_intf, key);
-    auto response = bus.call(request);
-    if (response.is_method_error())
-    {
-        wd_service.invalidate();
-        if (wasValid)
-        {
-            // Retry the request once in case the cached service was stale
-            return getProperty<T>(key);
-        }
-        log<level::ERR>("WatchdogService: Method error getting property",
-                        entry("PROPERTY=%s", key.c_str()));
-        elog<InternalFailure>();
-    }
-    try
-    {
-        std::variant<T> value;
-        response.read(value);
-        return std::get<T>(value);
-    }
-    catch (const std::exception& e)
-    {
-        log<level::ERR>("WatchdogService: Decode error in get property",
-                        entry("PROPERTY=%s", key.c_str()),
-                        entry("ERROR=%s", e.what()),
-                        entry("REPLY_SIG=%s", response.get_signature()));
-        elog<InternalFailure>();
-    }
-
-    // Needed instead of elog<InternalFailure>() since the compiler can't
-    // deduce the that elog<>() always throws
-    throw std::runtime_error(
-        "WatchdogService: Should not reach end of getProperty");
-}
-
 template <typename T>
 void WatchdogService::setProperty(const std::string& key, const T& val)
 {
@@ -159,11 +317,19 @@ void WatchdogService::setProperty(const std::string& key, const T& val)
                         entry("PROPERTY=%s", key.c_str()));
         elog<InternalFailure>();
     }
+    if (cached)
+    {
+        state.apply(key, val);
+    }
 }
 
 bool WatchdogService::getInitialized()
 {
-    return getProperty<bool>("Initialized");
+    if (cached)
+    {
+        return cached->initialized;
+    }
+    return getProperties().initialized;
 }
 
 void WatchdogService::setInitialized(bool initialized)
@@ -1,5 +1,7 @@
 #pragma once
+#include <cstddef>
 #include <ipmid/utils.hpp>
+#include <optional>
 #include <sdbusplus/bus.hpp>
 #include <xyz/openbmc_project/State/Watchdog/server.hpp>
 
@@ -11,7 +13,15 @@
 class WatchdogService
 {
   public:
-    WatchdogService();
+    /** @brief Access the watchdog of a host
+     *
+     *  @param[in] host - instance of the host, from the request context
+     */
+    explicit WatchdogService(size_t host = 0);
+
+    /** @brief What is known of the watchdog of one host; kept for as long
+     *         as ipmid runs */
+    struct State;
 
     using Action =
         sdbusplus::xyz::openbmc_project::State::server::Watchdog::Action;
@@ -22,6 +32,9 @@ class WatchdogService
      *         Equivalent to setTimeRemaining(getInterval()).
      *         Optionally enables the watchdog.
      *
+     *  @details Once the properties are cached, the reset is sent without
+     *           waiting for the reply, so a failure is only logged.
+     *
      *  @param[in] enableWatchdog - Should the call also enable the watchdog
      */
     void resetTimeRemaining(bool enableWatchdog);
@@ -42,12 +55,16 @@ class WatchdogService
     /** @brief Retrieves a copy of the currently set properties on the
      *         host watchdog
      *
+     *  @details Served from the cached properties if there are any, with
+     *           the time remaining counted down from its last update. Once
+     *           that runs out they are read again.
+     *
      *  @return A populated WatchdogProperties struct
      */
     Properties getProperties();
 
     /** @brief Get the value of the initialized property on the host
-     *         watchdog
+     *         watchdog, from the cached properties if there are any
      *
      *  @return The value of the property
      */
@@ -93,17 +110,13 @@ class WatchdogService
 
   private:
     /** @brief sdbusplus handle */
-    sdbusplus::bus::bus bus;
+    sdbusplus::bus::bus& bus;
+    /** @brief The watchdog of the host */
+    State& state;
     /** @brief The name of the mapped host watchdog service */
-    static ipmi::ServiceCache wd_service;
-
-    /** @brief Gets the value of the property on the host watchdog
-     *
-     *  @param[in] key - The name of the property
-     *  @return The value of the property
-     */
-    template <typename T>
-    T getProperty(const std::string& key);
+    ipmi::ServiceCache& wd_service;
+    /** @brief The properties of the watchdog, if they are being kept */
+    std::optional<Properties>& cached;
 
     /** @brief Sets the value of the property on the host watchdog
      *
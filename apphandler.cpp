@@ -9,6 +9,7 @@
 #include <app/watchdog.hpp>
 #include <apphandler.hpp>
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
@@ -16,10 +17,12 @@
 #include <ipmid/api.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
+#include <map>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/message/types.hpp>
 #include <string>
 #include <sys_info_param.hpp>
@@ -144,14 +147,16 @@ std::string getActiveSoftwareVersionInfo()
 
 bool getCurrentBmcState()
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     // Get the Inventory object implementing the BMC interface
     ipmi::DbusObjectInfo bmcObject =
         ipmi::getDbusObject(bus, bmc_state_interface);
+    // the state manager announces state changes with PropertiesChanged, so
+    // the state is read through the ObjectCache
     auto variant =
-        ipmi::getDbusProperty(bus, bmcObject.second, bmcObject.first,
-                              bmc_state_interface, bmc_state_property);
+        ipmi::getCachedDbusProperty(bus, bmcObject.second, bmcObject.first,
+                                    bmc_state_interface, bmc_state_property);
 
     return std::holds_alternative<std::string>(variant) &&
            BMC::convertBMCStateFromString(std::get<std::string>(variant)) ==
@@ -267,7 +272,7 @@ ipmi_ret_t ipmi_app_set_acpi_power_state(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     auto s = static_cast<uint8_t>(acpi_state::PowerState::unknown);
     ipmi_ret_t rc = IPMI_CC_OK;
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     auto value = acpi_state::ACPIPowerState::ACPI::Unknown;
 
@@ -394,7 +399,7 @@ ipmi_ret_t ipmi_app_get_acpi_power_state(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     auto* res = reinterpret_cast<acpi_state::ACPIState*>(response);
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     *data_len = 0;
 
@@ -523,6 +528,52 @@ int convertVersion(std::string s, Revision& rev)
     return 0;
 }
 
+namespace dev_id
+{
+
+/* the firmware revision of the Device ID is looked up again only after
+ * the software images changed */
+bool versionValid = false;
+
+std::vector<std::unique_ptr<sdbusplus::bus::match::match>> softwareChanged;
+
+/* start dropping the firmware revision when the software images change;
+ * returns true if the revision can be kept */
+bool watch()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    if (!softwareChanged.empty())
+    {
+        return true;
+    }
+    auto bus = getSdBus();
+    if (!bus)
+    {
+        return false;
+    }
+    auto drop = [](sdbusplus::message::message&) { versionValid = false; };
+    softwareChanged.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesAdded(softwareRoot), drop));
+    softwareChanged.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesRemoved(softwareRoot), drop));
+    // the active image follows from the activation and the priority
+    for (const char* intf : {activationIntf, redundancyIntf})
+    {
+        softwareChanged.emplace_back(
+            std::make_unique<sdbusplus::bus::match::match>(
+                *bus, rules::type::signal() +
+                          rules::member("PropertiesChanged") +
+                          rules::interface("org.freedesktop.DBus.Properties") +
+                          rules::path_namespace(softwareRoot) +
+                          rules::argN(0, intf),
+                drop));
+    }
+    return true;
+}
+
+} // namespace dev_id
+
 auto ipmiAppGetDeviceId() -> ipmi::RspType<uint8_t, // Device ID
                                            uint8_t, // Device Revision
                                            uint8_t, // Firmware Revision Major
@@ -552,8 +603,10 @@ auto ipmiAppGetDeviceId() -> ipmi::RspType<uint8_t, // Device ID
     constexpr auto ipmiDevIdStateShift = 7;
     constexpr auto ipmiDevIdFw1Mask = ~(1 << ipmiDevIdStateShift);
 
-    if (!dev_id_initialized)
+    if (!dev_id::versionValid)
     {
+        // watch before the lookup, so that a change during it isn't missed
+        bool keep = dev_id::watch();
         try
         {
             auto version = getActiveSoftwareVersionInfo();
@@ -576,9 +629,18 @@ auto ipmiAppGetDeviceId() -> ipmi::RspType<uint8_t, // Device ID
 
             rev.minor = (rev.minor > 99 ? 99 : rev.minor);
             devId.fw[1] = rev.minor % 10 + (rev.minor / 10) * 16;
-            std::memcpy(&devId.aux, rev.d, 4);
+            if (!dev_id_initialized)
+            {
+                std::memcpy(&devId.aux, rev.d, 4);
+            }
         }
+        // a failed lookup is also kept; it is tried again once a software
+        // image shows up or changes
+        dev_id::versionValid = keep;
+    }
 
+    if (!dev_id_initialized)
+    {
         // IPMI Spec version 2.0
         devId.ipmiVer = 2;
 
@@ -789,7 +851,7 @@ ipmi_ret_t ipmi_app_get_sys_guid(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
 {
     ipmi_ret_t rc = IPMI_CC_OK;
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     try
     {
@@ -850,6 +912,11 @@ ipmi_ret_t ipmi_app_get_sys_guid(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
 static std::unique_ptr<SysInfoParamStore> sysInfoParamStore;
 
+/* The value of each parameter as of the read of its first chunk. The later
+ * chunks are sliced out of it, which keeps the chunks of one read coherent
+ * and saves calling the parameter's callback for every chunk. */
+static std::map<uint8_t, std::string> sysInfoSnapshots;
+
 static std::string sysInfoReadSystemName()
 {
     // Use the BMC hostname as the "System Name."
@@ -899,28 +966,22 @@ static int splitStringParam(const std::string& fullString, int chunkIndex,
     {
         return -EINVAL;
     }
-    try
+    size_t offset = 0;
+    size_t length = smallChunk; // Output must have 14 byte capacity.
+    if (chunkIndex != 0)
     {
-        std::string output;
-        if (chunkIndex == 0)
-        {
-            // Output must have 14 byte capacity.
-            output = fullString.substr(0, smallChunk);
-        }
-        else
-        {
-            // Output must have 16 byte capacity.
-            output = fullString.substr((chunkIndex * chunkSize) - 2, chunkSize);
-        }
-
-        std::memcpy(chunk, output.c_str(), output.length());
-        return output.length();
+        offset = (chunkIndex * chunkSize) - 2;
+        length = chunkSize; // Output must have 16 byte capacity.
     }
-    catch (const std::out_of_range& e)
+    if (offset > fullString.length())
     {
         // The position was beyond the end.
         return -EINVAL;
     }
+    length = std::min(length, fullString.length() - offset);
+
+    std::memcpy(chunk, fullString.data() + offset, length);
+    return length;
 }
 
 /**
@@ -954,7 +1015,7 @@ ipmi_ret_t ipmi_app_get_system_info(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     IpmiSysInfoResp resp = {};
     size_t respLen = 0;
     uint8_t* const reqData = static_cast<uint8_t*>(request);
-    std::string paramString;
+    std::map<uint8_t, std::string>::iterator snapshot;
     bool found;
     std::tuple<bool, std::string> ret;
     constexpr int minRequestSize = 4;
@@ -994,20 +1055,23 @@ ipmi_ret_t ipmi_app_get_system_info(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                   sysInfoReadSystemName);
     }
 
-    // Parameters other than Set In Progress are assumed to be strings.
-    ret = sysInfoParamStore->lookup(paramRequested);
-    found = std::get<0>(ret);
-    paramString = std::get<1>(ret);
-    if (!found)
+    // Parameters other than Set In Progress are assumed to be strings. A read
+    // starts over at the first chunk, so that is when the value is fetched.
+    snapshot = sysInfoSnapshots.find(paramRequested);
+    if (reqData[2] == 0 || snapshot == sysInfoSnapshots.end())
     {
-        return IPMI_CC_SYSTEM_INFO_PARAMETER_NOT_SUPPORTED;
+        ret = sysInfoParamStore->lookup(paramRequested);
+        found = std::get<0>(ret);
+        if (!found)
+        {
+            return IPMI_CC_SYSTEM_INFO_PARAMETER_NOT_SUPPORTED;
+        }
+        snapshot = sysInfoSnapshots
+                       .insert_or_assign(paramRequested,
+                                         std::move(std::get<1>(ret)))
+                       .first;
     }
-    // TODO: Cache each parameter across multiple calls, until the whole string
-    // has been read out. Otherwise, it's possible for a parameter to change
-    // between requests for its chunks, returning chunks incoherent with each
-    // other. For now, the parameter store is simply required to have only
-    // idempotent callbacks.
-    rc = packGetSysInfoResp(paramString, reqData[2], &resp);
+    rc = packGetSysInfoResp(snapshot->second, reqData[2], &resp);
     if (rc == -EINVAL)
     {
         return IPMI_CC_RESPONSE_ERROR;
@@ -1023,15 +1087,32 @@ writeResponse:
 
 void register_netfn_app_functions()
 {
+    namespace rules = sdbusplus::bus::match::rules;
+    const auto propertiesChanged = [](const char* interface) {
+        return rules::type::signal() + rules::member("PropertiesChanged") +
+               rules::interface("org.freedesktop.DBus.Properties") +
+               rules::argN(0, interface);
+    };
+
     // <Get Device ID>
     ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
                           ipmi::app::cmdGetDeviceId, ipmi::Privilege::User,
                           ipmiAppGetDeviceId);
+    // the availability bit follows the BMC state and the firmware revision
+    // follows the active software image
+    ipmi::registerResponseCache(
+        ipmi::netFnApp, ipmi::app::cmdGetDeviceId, std::chrono::seconds(60),
+        {propertiesChanged(bmc_state_interface),
+         propertiesChanged(activationIntf), propertiesChanged(redundancyIntf)});
 
     // <Get BT Interface Capabilities>
     ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
                           ipmi::app::cmdGetBtIfaceCapabilities,
-                          ipmi::Privilege::User, ipmiAppGetBtCapabilities);
+                          ipmi::Privilege::User, ipmiAppGetBtCapabilities,
+                          ipmi::HandlerFlags::threadSafe);
+    ipmi::registerResponseCache(ipmi::netFnApp,
+                                ipmi::app::cmdGetBtIfaceCapabilities,
+                                std::chrono::milliseconds::zero());
 
     // <Reset Watchdog Timer>
     ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
@@ -1039,21 +1120,33 @@ void register_netfn_app_functions()
                           ipmi::Privilege::Operator, ipmiAppResetWatchdogTimer);
 
     // <Set Watchdog Timer>
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_SET_WD, NULL,
-                           ipmi_app_watchdog_set, PRIVILEGE_OPERATOR);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
+                          ipmi::app::cmdSetWatchdogTimer,
+                          ipmi::Privilege::Operator, ipmiSetWatchdogTimer);
 
     // <Get Watchdog Timer>
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_GET_WD, NULL,
-                           ipmi_app_watchdog_get, PRIVILEGE_OPERATOR);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
+                          ipmi::app::cmdGetWatchdogTimer,
+                          ipmi::Privilege::Operator, ipmiGetWatchdogTimer);
 
     // <Get Self Test Results>
     ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
                           ipmi::app::cmdGetSelfTestResults,
-                          ipmi::Privilege::User, ipmiAppGetSelfTestResults);
+                          ipmi::Privilege::User, ipmiAppGetSelfTestResults,
+                          ipmi::HandlerFlags::threadSafe);
+    ipmi::registerResponseCache(ipmi::netFnApp,
+                                ipmi::app::cmdGetSelfTestResults,
+                                std::chrono::milliseconds::zero());
 
     // <Get Device GUID>
     ipmi_register_callback(NETFUN_APP, IPMI_CMD_GET_DEVICE_GUID, NULL,
                            ipmi_app_get_device_guid, PRIVILEGE_USER);
+    // the GUIDs only change with their properties, so the cached responses
+    // don't have to expire
+    ipmi::registerResponseCache(
+        ipmi::netFnApp, ipmi::app::cmdGetDeviceGuid,
+        std::chrono::milliseconds::zero(),
+        {propertiesChanged("org.openbmc.control.Chassis")});
 
     // <Set ACPI Power State>
     ipmi_register_callback(NETFUN_APP, IPMI_CMD_SET_ACPI, NULL,
@@ -1066,6 +1159,9 @@ void register_netfn_app_functions()
     // <Get System GUID Command>
     ipmi_register_callback(NETFUN_APP, IPMI_CMD_GET_SYS_GUID, NULL,
                            ipmi_app_get_sys_guid, PRIVILEGE_USER);
+    ipmi::registerResponseCache(ipmi::netFnApp, ipmi::app::cmdGetSystemGuid,
+                                std::chrono::milliseconds::zero(),
+                                {propertiesChanged(bmc_guid_interface)});
 
     // <Get Channel Cipher Suites Command>
     ipmi_register_callback(NETFUN_APP, IPMI_CMD_GET_CHAN_CIPHER_SUITES, NULL,
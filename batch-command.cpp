@@ -0,0 +1,156 @@
+#include "batch-command.hpp"
+
+#include "dispatcher.hpp"
+
+#include <cstdint>
+#include <ipmid/api.hpp>
+#include <ipmid/oemopenbmc.hpp>
+#include <memory>
+#include <user_channel/channel_layer.hpp>
+#include <vector>
+
+namespace ipmi
+{
+namespace batch
+{
+
+namespace
+{
+
+/* netFn, cmd and data length lead each sub-request; the completion code
+ * and data length lead each sub-response */
+constexpr size_t requestHeaderSize = 3;
+constexpr size_t responseHeaderSize = 2;
+
+struct SubRequest
+{
+    NetFn netFn;
+    Cmd cmd;
+    const uint8_t* data;
+    size_t size;
+};
+
+/* split the batch into its sub-requests; false if it is malformed */
+bool parse(const std::vector<uint8_t>& batch, std::vector<SubRequest>& subs)
+{
+    size_t offset = 0;
+    while (offset < batch.size())
+    {
+        if (batch.size() - offset < requestHeaderSize)
+        {
+            return false;
+        }
+        SubRequest sub{batch[offset], batch[offset + 1], nullptr,
+                       batch[offset + 2]};
+        offset += requestHeaderSize;
+        if (batch.size() - offset < sub.size)
+        {
+            return false;
+        }
+        sub.data = batch.data() + offset;
+        offset += sub.size;
+        subs.push_back(sub);
+    }
+    return true;
+}
+
+/* a batch inside a batch would let one request run without bound */
+bool isBatch(const SubRequest& sub)
+{
+    if (sub.netFn != netFnOem || sub.cmd != oem::batchCmd || sub.size < 3)
+    {
+        return false;
+    }
+    uint32_t iana = sub.data[0] | (sub.data[1] << 8) | (sub.data[2] << 16);
+    return iana == oem::obmcOemNumber;
+}
+
+} // namespace
+
+/** @brief implements the OpenBMC OEM Execute Batch command
+ *
+ *  @param[in] ctx - context of the batch; the sub-requests run with its
+ *                   channel, user and privilege
+ *  @param[in] oen - OEM number; must be the OpenBMC OEM number
+ *  @param[in] batch - the sub-requests, back to back
+ *
+ *  @returns IPMI completion code plus response data
+ *   - OEM number
+ *   - for each sub-request, in order: its completion code, the length of
+ *     its response data and the data
+ */
+ipmi::RspType<uint24_t,            // OEM number
+              std::vector<uint8_t> // responses
+              >
+    ipmiOemExecuteBatch(ipmi::Context::ptr ctx, uint24_t oen,
+                        std::vector<uint8_t> batch)
+{
+    if (oen != oem::obmcOemNumber)
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+    std::vector<SubRequest> subs;
+    if (!parse(batch, subs) || subs.empty())
+    {
+        return ipmi::responseReqDataLenInvalid();
+    }
+
+    // the completion code and the OEM number share the response
+    constexpr size_t headerSize = 1 + 3;
+    size_t maxSize = ipmi::getChannelMaxTransferSize(ctx->channel);
+    size_t room = maxSize > headerSize ? maxSize - headerSize : 0;
+    if (subs.size() * responseHeaderSize > room)
+    {
+        return ipmi::responseReqDataLenExceeded();
+    }
+
+    std::vector<uint8_t> responses;
+    responses.reserve(room);
+    for (size_t i = 0; i < subs.size(); i++)
+    {
+        const SubRequest& sub = subs[i];
+        Cc cc;
+        std::vector<uint8_t> data;
+        if (sub.netFn & 1 || isBatch(sub))
+        {
+            cc = ccInvalidFieldRequest;
+        }
+        else
+        {
+            auto subCtx = std::make_shared<Context>(*ctx);
+            subCtx->netFn = sub.netFn;
+            subCtx->cmd = sub.cmd;
+            subCtx->extension = 0;
+            auto request = std::make_shared<message::Request>(
+                subCtx, std::vector<uint8_t>(sub.data, sub.data + sub.size));
+            message::Response::ptr response = executeIpmiCommand(request);
+            cc = response->cc;
+            data = std::move(response->payload.raw);
+        }
+
+        // keep room for the headers of the sub-requests still to run
+        size_t reserved = (subs.size() - i - 1) * responseHeaderSize;
+        if (responses.size() + responseHeaderSize + data.size() + reserved >
+                room ||
+            data.size() > UINT8_MAX)
+        {
+            cc = ccRetBytesUnavailable;
+            data.clear();
+        }
+        responses.push_back(cc);
+        responses.push_back(static_cast<uint8_t>(data.size()));
+        responses.insert(responses.end(), data.begin(), data.end());
+    }
+    return ipmi::responseSuccess(oen, responses);
+}
+
+void initialize()
+{
+    // <Execute Batch>
+    ipmi::registerOemHandler(ipmi::prioOpenBmcBase, oem::obmcOemNumber,
+                             oem::batchCmd, ipmi::Privilege::User,
+                             ipmiOemExecuteBatch);
+}
+
+} // namespace batch
+} // namespace ipmi
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace ipmi
+{
+namespace batch
+{
+
+/** @brief Register the OpenBMC OEM Execute Batch command */
+void initialize();
+
+} // namespace batch
+} // namespace ipmi
@@ -7,7 +7,6 @@
 #include <arpa/inet.h>
 #include <endian.h>
 #include <limits.h>
-#include <mapper.h>
 #include <netinet/in.h>
 
 #include <array>
@@ -17,9 +16,12 @@
 #include <fstream>
 #include <future>
 #include <ipmid/api.hpp>
+#include <ipmid/deferred.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
 #include <map>
+#include <memory>
+#include <optional>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
@@ -28,6 +30,8 @@
 #include <sdbusplus/timer.hpp>
 #include <sstream>
 #include <string>
+#include <variant>
+#include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
 #include <xyz/openbmc_project/Control/Boot/Mode/server.hpp>
 #include <xyz/openbmc_project/Control/Boot/Source/server.hpp>
@@ -65,7 +69,6 @@ static constexpr size_t MAC_OFFSET = 9;
 static constexpr size_t ADDRTYPE_OFFSET = 16;
 static constexpr size_t IPADDR_OFFSET = 17;
 
-static constexpr size_t encIdentifyObjectsSize = 1;
 static constexpr size_t chassisIdentifyReqLength = 2;
 static constexpr size_t identifyIntervalPos = 0;
 static constexpr size_t forceIdentifyPos = 1;
@@ -151,8 +154,12 @@ sdbusplus::bus::bus dbus(ipmid_get_sd_bus_connection());
 namespace cache
 {
 
-settings::Objects objects(dbus,
-                          {bootModeIntf, bootSourceIntf, powerRestoreIntf});
+/* the settings lookups are mapper calls; make them once ipmid is up */
+ipmi::Deferred<settings::Objects> objects([]() {
+    return std::make_unique<settings::Objects>(
+        dbus, std::vector<settings::Interface>(
+                  {bootModeIntf, bootSourceIntf, powerRestoreIntf}));
+});
 
 } // namespace cache
 } // namespace internal
@@ -201,7 +208,7 @@ int getHostNetworkData(get_sys_boot_options_response_t* respptr)
         //  as SETTINGS_MATCH.
         //  Later SETTINGS_MATCH will be replaced with busname.
 
-        sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+        sdbusplus::bus::bus& bus = getBus();
 
         auto ipObjectInfo = ipmi::getDbusObject(bus, IP_INTERFACE,
                                                 SETTINGS_ROOT, SETTINGS_MATCH);
@@ -454,7 +461,7 @@ int setHostNetworkData(set_sys_boot_options_t* reqptr)
                                ",mac="s + mac + ",addressOrigin="s +
                                addressOrigin;
 
-        sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+        sdbusplus::bus::bus& bus = getBus();
 
         auto ipObjectInfo = ipmi::getDbusObject(bus, IP_INTERFACE,
                                                 SETTINGS_ROOT, SETTINGS_MATCH);
@@ -490,17 +497,17 @@ int setHostNetworkData(set_sys_boot_options_t* reqptr)
 
 uint32_t getPOHCounter()
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     auto chassisStateObj =
         ipmi::getDbusObject(bus, chassisPOHStateIntf, chassisStateRoot, match);
 
-    auto service =
-        ipmi::getService(bus, chassisPOHStateIntf, chassisStateObj.first);
-
-    auto propValue =
-        ipmi::getDbusProperty(bus, service, chassisStateObj.first,
-                              chassisPOHStateIntf, pOHCounterProperty);
+    // the state manager counts the hours with a property that announces
+    // its updates with PropertiesChanged, so it is read through the
+    // ObjectCache rather than on every Get POH Counter
+    auto propValue = ipmi::getCachedDbusProperty(
+        bus, chassisStateObj.second, chassisStateObj.first,
+        chassisPOHStateIntf, pOHCounterProperty);
 
     return std::get<uint32_t>(propValue);
 }
@@ -537,7 +544,7 @@ ipmi_ret_t ipmi_get_chassis_cap(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     try
     {
-        sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+        sdbusplus::bus::bus& bus = getBus();
 
         ipmi::DbusObjectInfo chassisCapObject =
             ipmi::getDbusObject(bus, chassisCapIntf);
@@ -668,7 +675,7 @@ ipmi_ret_t ipmi_set_chassis_cap(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     try
     {
-        sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+        sdbusplus::bus::bus& bus = getBus();
         ipmi::DbusObjectInfo chassisCapObject =
             ipmi::getDbusObject(bus, chassisCapIntf);
 
@@ -717,54 +724,29 @@ int initiate_state_transition(State::Host::Transition transition)
     // OpenBMC Host State Manager dbus framework
     constexpr auto HOST_STATE_MANAGER_ROOT = "/xyz/openbmc_project/state/host0";
     constexpr auto HOST_STATE_MANAGER_IFACE = "xyz.openbmc_project.State.Host";
-    constexpr auto DBUS_PROPERTY_IFACE = "org.freedesktop.DBus.Properties";
     constexpr auto PROPERTY = "RequestedHostTransition";
 
-    // sd_bus error
-    int rc = 0;
-    char* busname = NULL;
-
-    // SD Bus error report mechanism.
-    sd_bus_error bus_error = SD_BUS_ERROR_NULL;
-
-    // Gets a hook onto either a SYSTEM or SESSION bus
-    sd_bus* bus_type = ipmid_get_sd_bus_connection();
-    rc = mapper_get_service(bus_type, HOST_STATE_MANAGER_ROOT, &busname);
-    if (rc < 0)
-    {
-        log<level::ERR>(
-            "Failed to get bus name",
-            entry("ERRNO=0x%X, OBJPATH=%s", -rc, HOST_STATE_MANAGER_ROOT));
-        return rc;
-    }
-
     // Convert to string equivalent of the passed in transition enum.
     auto request = State::convertForMessage(transition);
 
-    rc = sd_bus_call_method(bus_type,                // On the system bus
-                            busname,                 // Service to contact
-                            HOST_STATE_MANAGER_ROOT, // Object path
-                            DBUS_PROPERTY_IFACE,     // Interface name
-                            "Set",                   // Method to be called
-                            &bus_error,              // object to return error
-                            nullptr,                 // Response buffer if any
-                            "ssv",                   // Takes 3 arguments
-                            HOST_STATE_MANAGER_IFACE, PROPERTY, "s",
-                            request.c_str());
-    if (rc < 0)
+    try
     {
-        log<level::ERR>("Failed to initiate transition",
-                        entry("ERRNO=0x%X, REQUEST=%s", -rc, request.c_str()));
+        sdbusplus::bus::bus& bus = getBus();
+        auto service = ipmi::getService(bus, HOST_STATE_MANAGER_IFACE,
+                                        HOST_STATE_MANAGER_ROOT);
+        ipmi::setDbusProperty(bus, service, HOST_STATE_MANAGER_ROOT,
+                              HOST_STATE_MANAGER_IFACE, PROPERTY, request);
     }
-    else
+    catch (const std::exception& e)
     {
-        log<level::INFO>("Transition request initiated successfully");
+        log<level::ERR>("Failed to initiate transition",
+                        entry("EXCEPTION=%s", e.what()),
+                        entry("REQUEST=%s", request.c_str()));
+        return -1;
     }
+    log<level::INFO>("Transition request initiated successfully");
 
-    sd_bus_error_free(&bus_error);
-    free(busname);
-
-    return rc;
+    return 0;
 }
 
 namespace power_policy
@@ -785,6 +767,78 @@ static constexpr uint8_t policyBitMask = 0x07;
 static constexpr uint8_t setPolicyReqLen = 1;
 } // namespace power_policy
 
+namespace chassis_status
+{
+
+constexpr auto powerObj = "/org/openbmc/control/power0";
+constexpr auto powerIntf = "org.openbmc.control.Power";
+
+/* Get Chassis Status is polled all the time, so the response is kept
+ * ready until one of the properties it is built from changes */
+std::optional<ipmi_get_chassis_status_t> status;
+// the services the kept response was read from
+std::vector<std::string> services;
+
+std::unique_ptr<sdbusplus::bus::match::match> restorePolicyChanged;
+std::unique_ptr<sdbusplus::bus::match::match> pgoodChanged;
+std::unique_ptr<sdbusplus::bus::match::match> ownerChanged;
+
+/* a restarted service may come back with other values, so the response is
+ * dropped when one it was read from changes owner, but not for any other
+ * name on the bus */
+void ownerChange(sdbusplus::message::message& msg)
+{
+    std::string name;
+    std::string oldOwner;
+    std::string newOwner;
+    try
+    {
+        msg.read(name, oldOwner, newOwner);
+    }
+    catch (const std::exception& e)
+    {
+        status.reset();
+        return;
+    }
+    for (const std::string& service : services)
+    {
+        if (service == name || service == oldOwner)
+        {
+            status.reset();
+            return;
+        }
+    }
+}
+
+/* start dropping the response when its properties change; returns true if
+ * the response can be kept */
+bool watch(const std::string& powerRestoreSetting)
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto bus = ipmi::getSdBus();
+    if (!bus)
+    {
+        return false;
+    }
+    if (!restorePolicyChanged)
+    {
+        auto drop = [](sdbusplus::message::message&) { status.reset(); };
+        restorePolicyChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus,
+            rules::propertiesChanged(powerRestoreSetting,
+                                     chassis::internal::powerRestoreIntf),
+            drop);
+        pgoodChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::propertiesChanged(powerObj, powerIntf), drop);
+        ownerChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::nameOwnerChanged(), ownerChange);
+    }
+    return true;
+}
+
+} // namespace chassis_status
+
 //----------------------------------------------------------------------
 // Get Chassis Status commands
 //----------------------------------------------------------------------
@@ -794,71 +848,62 @@ ipmi_ret_t ipmi_get_chassis_status(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                    ipmi_data_len_t data_len,
                                    ipmi_context_t context)
 {
-    const char* objname = "/org/openbmc/control/power0";
-    const char* intf = "org.openbmc.control.Power";
+    using namespace chassis::internal;
+    using namespace chassis::internal::cache;
+    using namespace chassis_status;
+    using namespace power_policy;
 
-    sd_bus* bus = NULL;
-    sd_bus_message* reply = NULL;
-    int r = 0;
-    int pgood = 0;
-    char* busname = NULL;
-    ipmi_ret_t rc = IPMI_CC_OK;
-    ipmi_get_chassis_status_t chassis_status{};
+    if (status)
+    {
+        *data_len = sizeof(*status);
+        std::memcpy(response, &*status, *data_len);
+        return IPMI_CC_OK;
+    }
 
+    ipmi_get_chassis_status_t chassis_status{};
     uint8_t s = 0;
 
-    using namespace chassis::internal;
-    using namespace chassis::internal::cache;
-    using namespace power_policy;
+    const auto& powerRestoreSetting = objects->map.at(powerRestoreIntf).front();
+    // watch before reading, so that a change that arrives while the values
+    // are read drops the response again
+    bool keep = watch(powerRestoreSetting);
 
-    const auto& powerRestoreSetting = objects.map.at(powerRestoreIntf).front();
-    auto method = dbus.new_method_call(
-        objects.service(powerRestoreSetting, powerRestoreIntf).c_str(),
-        powerRestoreSetting.c_str(), ipmi::PROP_INTF, "Get");
-    method.append(powerRestoreIntf, "PowerRestorePolicy");
-    auto resp = dbus.call(method);
-    if (resp.is_method_error())
+    ipmi::Value result;
+    std::string settingsService;
+    try
+    {
+        settingsService =
+            objects->service(powerRestoreSetting, powerRestoreIntf);
+        result = ipmi::getCachedDbusProperty(
+            dbus, settingsService, powerRestoreSetting, powerRestoreIntf,
+            "PowerRestorePolicy");
+    }
+    catch (const std::exception& e)
     {
         log<level::ERR>("Error in PowerRestorePolicy Get");
         report<InternalFailure>();
         *data_len = 0;
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
-    sdbusplus::message::variant<std::string> result;
-    resp.read(result);
     auto powerRestore =
         RestorePolicy::convertPolicyFromString(std::get<std::string>(result));
 
-    *data_len = 4;
-
-    bus = ipmid_get_sd_bus_connection();
-
-    r = mapper_get_service(bus, objname, &busname);
-    if (r < 0)
-    {
-        log<level::ERR>("Failed to get bus name", entry("ERRNO=0x%X", -r));
-        rc = IPMI_CC_UNSPECIFIED_ERROR;
-        goto finish;
-    }
-
-    r = sd_bus_get_property(bus, busname, objname, intf, "pgood", NULL, &reply,
-                            "i");
-    if (r < 0)
+    int pgood = 0;
+    std::string pgoodService;
+    try
     {
-        log<level::ERR>("Failed to call sd_bus_get_property",
-                        entry("PROPERTY=%s", "pgood"), entry("ERRNO=0x%X", -r),
-                        entry("BUS=%s", busname), entry("PATH=%s", objname),
-                        entry("INTERFACE=%s", intf));
-        rc = IPMI_CC_UNSPECIFIED_ERROR;
-        goto finish;
+        pgoodService = ipmi::getService(dbus, powerIntf, powerObj);
+        pgood = std::get<int32_t>(ipmi::getCachedDbusProperty(
+            dbus, pgoodService, powerObj, powerIntf, "pgood"));
     }
-
-    r = sd_bus_message_read(reply, "i", &pgood);
-    if (r < 0)
+    catch (const std::exception& e)
     {
-        log<level::ERR>("Failed to read sensor:", entry("ERRNO=0x%X", -r));
-        rc = IPMI_CC_UNSPECIFIED_ERROR;
-        goto finish;
+        log<level::ERR>("Failed to get the pgood property",
+                        entry("PATH=%s", powerObj),
+                        entry("INTERFACE=%s", powerIntf),
+                        entry("ERROR=%s", e.what()));
+        *data_len = 0;
+        return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
     s = dbusToIpmi.at(powerRestore);
@@ -935,14 +980,17 @@ ipmi_ret_t ipmi_get_chassis_status(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     //  set to 0,  for we don't support them.
     chassis_status.front_panel_button_cap_status = 0;
 
+    if (keep)
+    {
+        status = chassis_status;
+        services = {settingsService, pgoodService};
+    }
+
     // Pack the actual response
+    *data_len = sizeof(chassis_status);
     std::memcpy(response, &chassis_status, *data_len);
 
-finish:
-    free(busname);
-    reply = sd_bus_message_unref(reply);
-
-    return rc;
+    return IPMI_CC_OK;
 }
 
 //-------------------------------------------------------------
@@ -950,7 +998,6 @@ finish:
 //-------------------------------------------------------------
 int stop_soft_off_timer()
 {
-    constexpr auto iface = "org.freedesktop.DBus.Properties";
     constexpr auto soft_off_iface = "xyz.openbmc_project.Ipmi.Internal."
                                     "SoftPowerOff";
 
@@ -958,38 +1005,24 @@ int stop_soft_off_timer()
     constexpr auto value = "xyz.openbmc_project.Ipmi.Internal."
                            "SoftPowerOff.HostResponse.HostShutdown";
 
-    // Get the system bus where most system services are provided.
-    auto bus = ipmid_get_sd_bus_connection();
-
     // Get the service name
     // TODO openbmc/openbmc#1661 - Mapper refactor
     //
     // See openbmc/openbmc#1743 for some details but high level summary is that
     // for now the code will directly call the soft off interface due to a
     // race condition with mapper usage
-    //
-    // char *busname = nullptr;
-    // auto r = mapper_get_service(bus, SOFTOFF_OBJPATH, &busname);
-    // if (r < 0)
-    //{
-    //    fprintf(stderr, "Failed to get %s bus name: %s\n",
-    //            SOFTOFF_OBJPATH, -r);
-    //    return r;
-    //}
-
-    // No error object or reply expected.
-    int rc = sd_bus_call_method(bus, SOFTOFF_BUSNAME, SOFTOFF_OBJPATH, iface,
-                                "Set", nullptr, nullptr, "ssv", soft_off_iface,
-                                property, "s", value);
-    if (rc < 0)
+    try
+    {
+        ipmi::setDbusProperty(getBus(), SOFTOFF_BUSNAME, SOFTOFF_OBJPATH,
+                              soft_off_iface, property, std::string(value));
+    }
+    catch (const std::exception& e)
     {
         log<level::ERR>("Failed to set property in SoftPowerOff object",
-                        entry("ERRNO=0x%X", -rc));
+                        entry("EXCEPTION=%s", e.what()));
+        return -1;
     }
-
-    // TODO openbmc/openbmc#1661 - Mapper refactor
-    // free(busname);
-    return rc;
+    return 0;
 }
 
 //----------------------------------------------------------------------
@@ -1104,94 +1137,87 @@ ipmi_ret_t ipmi_chassis_control(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return ((rc < 0) ? IPMI_CC_INVALID : IPMI_CC_OK);
 }
 
-/** @brief Return D-Bus connection string to enclosure identify LED object
- *
- *  @param[in, out] connection - connection to D-Bus object
- *  @return a IPMI return code
- */
-std::string getEnclosureIdentifyConnection()
+namespace identify
 {
-    // lookup enclosure_identify group owner(s) in mapper
-    auto mapperCall = chassis::internal::dbus.new_method_call(
-        ipmi::MAPPER_BUS_NAME, ipmi::MAPPER_OBJ, ipmi::MAPPER_INTF,
-        "GetObject");
-
-    mapperCall.append(identify_led_object_name);
-    static const std::vector<std::string> interfaces = {
-        "xyz.openbmc_project.Led.Group"};
-    mapperCall.append(interfaces);
-    auto mapperReply = chassis::internal::dbus.call(mapperCall);
-    if (mapperReply.is_method_error())
-    {
-        log<level::ERR>("Chassis Identify: Error communicating to mapper.");
-        elog<InternalFailure>();
-    }
-    std::vector<std::pair<std::string, std::vector<std::string>>> mapperResp;
-    mapperReply.read(mapperResp);
 
-    if (mapperResp.size() != encIdentifyObjectsSize)
-    {
-        log<level::ERR>(
-            "Invalid number of enclosure identify objects.",
-            entry("ENC_IDENTITY_OBJECTS_SIZE=%d", mapperResp.size()));
-        elog<InternalFailure>();
-    }
-    auto pair = mapperResp[encIdentifyObjectsSize - 1];
-    return pair.first;
-}
+constexpr auto ledGroupIntf = "xyz.openbmc_project.Led.Group";
+
+/* owner of the LED group as of the last write that went through; the timer
+ * turns the LED off there without going back to the mapper */
+std::string ledService;
 
-/** @brief Turn On/Off enclosure identify LED
+/** @brief Turn On/Off enclosure identify LED from a request
  *
+ *  The owner of the LED group comes from the mapper cache, so only the first
+ *  request looks it up; the write yields to the main loop while the LED
+ *  manager answers.
+ *
+ *  @param[in] ctx - context of the request
  *  @param[in] flag - true to turn on LED, false to turn off
- *  @return a IPMI return code
+ *  @return the error of the lookup or of the write
  */
-void enclosureIdentifyLed(bool flag)
+boost::system::error_code setLed(ipmi::Context::ptr ctx, bool flag)
 {
-    using namespace chassis::internal;
-    std::string connection = std::move(getEnclosureIdentifyConnection());
-    auto msg = std::string("enclosureIdentifyLed(") +
-               boost::lexical_cast<std::string>(flag) + ")";
-    log<level::DEBUG>(msg.c_str());
-    auto led =
-        dbus.new_method_call(connection.c_str(), identify_led_object_name,
-                             "org.freedesktop.DBus.Properties", "Set");
-    led.append("xyz.openbmc_project.Led.Group", "Asserted",
-               sdbusplus::message::variant<bool>(flag));
-    auto ledReply = dbus.call(led);
-    if (ledReply.is_method_error())
+    std::string service;
+    boost::system::error_code ec = ipmi::getService(
+        ctx, ledGroupIntf, identify_led_object_name, service);
+    if (!ec)
     {
-        log<level::ERR>("Chassis Identify: Error Setting State On/Off\n",
-                        entry("LED_STATE=%d", flag));
-        elog<InternalFailure>();
+        ec = ipmi::setDbusProperty(ctx, service, identify_led_object_name,
+                                   ledGroupIntf, "Asserted", flag);
+    }
+    if (ec)
+    {
+        log<level::ERR>("Chassis Identify: Error Setting State On/Off",
+                        entry("LED_STATE=%d", flag),
+                        entry("ERROR=%s", ec.message().c_str()));
+        ledService.clear();
+        return ec;
     }
+    ledService = std::move(service);
+    return ec;
 }
 
 /** @brief Callback method to turn off LED
+ *
+ *  Runs from the main loop when the identify interval is over; nothing waits
+ *  for the LED manager to answer.
  */
-void enclosureIdentifyLedOff()
+void ledOff()
 {
-    try
+    auto sdbus = ipmi::getSdBus();
+    if (!sdbus || ledService.empty())
     {
-        enclosureIdentifyLed(false);
-    }
-    catch (const InternalFailure& e)
-    {
-        report<InternalFailure>();
+        return;
     }
+    sdbus->async_method_call(
+        [](const boost::system::error_code ec) {
+            if (ec)
+            {
+                log<level::ERR>("Chassis Identify: Error Setting State Off",
+                                entry("ERROR=%s", ec.message().c_str()));
+                ledService.clear();
+                report<InternalFailure>();
+            }
+        },
+        ledService, identify_led_object_name, "org.freedesktop.DBus.Properties",
+        "Set", ledGroupIntf, "Asserted", std::variant<bool>(false));
 }
 
+} // namespace identify
+
 /** @brief Create timer to turn on and off the enclosure LED
  */
 void createIdentifyTimer()
 {
     if (!identifyTimer)
     {
-        identifyTimer =
-            std::make_unique<phosphor::Timer>(enclosureIdentifyLedOff);
+        identifyTimer = std::make_unique<phosphor::Timer>(identify::ledOff);
     }
 }
 
-ipmi::RspType<> ipmiChassisIdentify(std::optional<uint8_t> interval,
+ipmi::RspType<> ipmiChassisIdentify(ipmi::Context::ptr ctx,
+                                    std::optional<uint8_t> interval,
                                     std::optional<uint8_t> force)
 {
     uint8_t identifyInterval = interval.value_or(DEFAULT_IDENTIFY_TIME_OUT);
@@ -1202,11 +1228,7 @@ ipmi::RspType<> ipmiChassisIdentify(std::optional<uint8_t> interval,
         // stop the timer if already started;
         // for force identify we should not turn off LED
         identifyTimer->stop();
-        try
-        {
-            enclosureIdentifyLed(true);
-        }
-        catch (const InternalFailure& e)
+        if (identify::setLed(ctx, true))
         {
             report<InternalFailure>();
             return ipmi::responseResponseError();
@@ -1224,7 +1246,10 @@ ipmi::RspType<> ipmiChassisIdentify(std::optional<uint8_t> interval,
     else if (!identifyInterval)
     {
         identifyTimer->stop();
-        enclosureIdentifyLedOff();
+        if (identify::setLed(ctx, false))
+        {
+            report<InternalFailure>();
+        }
     }
     return ipmi::responseSuccess();
 }
@@ -1260,57 +1285,94 @@ std::map<Mode::Modes, IpmiValue> modeDbusToIpmi = {
 
 } // namespace boot_options
 
-/** @brief Set the property value for boot source
- *  @param[in] source - boot source value
- *  @return On failure return IPMI error.
+/** @brief Get a boot setting property through the property cache
+ *  @param[in] path - boot setting object
+ *  @param[in] intf - boot setting interface
+ *  @param[in] property - name of the property
+ *  @return The value of the property; throws InternalFailure on failure.
  */
-static ipmi_ret_t setBootSource(const Source::Sources& source)
+static std::string getBootProperty(const settings::Path& path,
+                                   const char* intf, const char* property)
 {
     using namespace chassis::internal;
     using namespace chassis::internal::cache;
-    sdbusplus::message::variant<std::string> property =
-        convertForMessage(source);
-    auto bootSetting = settings::boot::setting(objects, bootSourceIntf);
-    const auto& bootSourceSetting = std::get<settings::Path>(bootSetting);
-    auto method = dbus.new_method_call(
-        objects.service(bootSourceSetting, bootSourceIntf).c_str(),
-        bootSourceSetting.c_str(), ipmi::PROP_INTF, "Set");
-    method.append(bootSourceIntf, "BootSource", property);
-    auto reply = dbus.call(method);
-    if (reply.is_method_error())
+    std::string value;
+    try
     {
-        log<level::ERR>("Error in BootSource Set");
-        report<InternalFailure>();
-        return IPMI_CC_UNSPECIFIED_ERROR;
+        value = std::get<std::string>(ipmi::getCachedDbusProperty(
+            dbus, objects->service(path, intf), path, intf, property));
     }
-    return IPMI_CC_OK;
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Error in boot setting Get",
+                        entry("PROPERTY=%s", property),
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", e.what()));
+        elog<InternalFailure>();
+    }
+    return value;
 }
 
-/** @brief Set the property value for boot mode
- *  @param[in] mode - boot mode value
+/** @brief Set a boot setting property unless it already has the value
+ *  @param[in] path - boot setting object
+ *  @param[in] intf - boot setting interface
+ *  @param[in] property - name of the property
+ *  @param[in] value - value to set
  *  @return On failure return IPMI error.
  */
-static ipmi_ret_t setBootMode(const Mode::Modes& mode)
+static ipmi_ret_t setBootProperty(const settings::Path& path,
+                                  const char* intf, const char* property,
+                                  const std::string& value)
 {
     using namespace chassis::internal;
     using namespace chassis::internal::cache;
-    sdbusplus::message::variant<std::string> property = convertForMessage(mode);
-    auto bootSetting = settings::boot::setting(objects, bootModeIntf);
-    const auto& bootModeSetting = std::get<settings::Path>(bootSetting);
-    auto method = dbus.new_method_call(
-        objects.service(bootModeSetting, bootModeIntf).c_str(),
-        bootModeSetting.c_str(), ipmi::PROP_INTF, "Set");
-    method.append(bootModeIntf, "BootMode", property);
-    auto reply = dbus.call(method);
-    if (reply.is_method_error())
+    try
+    {
+        // provisioning sets the same boot options over and over, and every
+        // Set makes the settings daemon write its persistent file
+        if (getBootProperty(path, intf, property) == value)
+        {
+            return IPMI_CC_OK;
+        }
+        ipmi::setDbusProperty(dbus, objects->service(path, intf), path, intf,
+                              property, value);
+    }
+    catch (const std::exception& e)
     {
-        log<level::ERR>("Error in BootMode Set");
+        log<level::ERR>("Error in boot setting Set",
+                        entry("PROPERTY=%s", property),
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", e.what()));
         report<InternalFailure>();
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
     return IPMI_CC_OK;
 }
 
+/** @brief Set the property value for boot source
+ *  @param[in] path - boot source setting object
+ *  @param[in] source - boot source value
+ *  @return On failure return IPMI error.
+ */
+static ipmi_ret_t setBootSource(const settings::Path& path,
+                                const Source::Sources& source)
+{
+    return setBootProperty(path, chassis::internal::bootSourceIntf,
+                           "BootSource", convertForMessage(source));
+}
+
+/** @brief Set the property value for boot mode
+ *  @param[in] path - boot mode setting object
+ *  @param[in] mode - boot mode value
+ *  @return On failure return IPMI error.
+ */
+static ipmi_ret_t setBootMode(const settings::Path& path,
+                              const Mode::Modes& mode)
+{
+    return setBootProperty(path, chassis::internal::bootModeIntf, "BootMode",
+                           convertForMessage(mode));
+}
+
 ipmi_ret_t ipmi_chassis_get_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                              ipmi_request_t request,
                                              ipmi_response_t response,
@@ -1344,45 +1406,20 @@ ipmi_ret_t ipmi_chassis_get_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
         try
         {
-            auto bootSetting = settings::boot::setting(objects, bootSourceIntf);
+            auto bootSetting =
+                settings::boot::setting(*objects, bootSourceIntf);
             const auto& bootSourceSetting =
                 std::get<settings::Path>(bootSetting);
             auto oneTimeEnabled =
                 std::get<settings::boot::OneTimeEnabled>(bootSetting);
-            auto method = dbus.new_method_call(
-                objects.service(bootSourceSetting, bootSourceIntf).c_str(),
-                bootSourceSetting.c_str(), ipmi::PROP_INTF, "Get");
-            method.append(bootSourceIntf, "BootSource");
-            auto reply = dbus.call(method);
-            if (reply.is_method_error())
-            {
-                log<level::ERR>("Error in BootSource Get");
-                report<InternalFailure>();
-                *data_len = 0;
-                return IPMI_CC_UNSPECIFIED_ERROR;
-            }
-            sdbusplus::message::variant<std::string> result;
-            reply.read(result);
-            auto bootSource =
-                Source::convertSourcesFromString(std::get<std::string>(result));
-
-            bootSetting = settings::boot::setting(objects, bootModeIntf);
-            const auto& bootModeSetting = std::get<settings::Path>(bootSetting);
-            method = dbus.new_method_call(
-                objects.service(bootModeSetting, bootModeIntf).c_str(),
-                bootModeSetting.c_str(), ipmi::PROP_INTF, "Get");
-            method.append(bootModeIntf, "BootMode");
-            reply = dbus.call(method);
-            if (reply.is_method_error())
-            {
-                log<level::ERR>("Error in BootMode Get");
-                report<InternalFailure>();
-                *data_len = 0;
-                return IPMI_CC_UNSPECIFIED_ERROR;
-            }
-            reply.read(result);
-            auto bootMode =
-                Mode::convertModesFromString(std::get<std::string>(result));
+            auto bootSource = Source::convertSourcesFromString(getBootProperty(
+                bootSourceSetting, bootSourceIntf, "BootSource"));
+
+            // the same one-time Enabled property picks the boot mode object
+            const auto& bootModeSetting =
+                settings::boot::setting(*objects, bootModeIntf, oneTimeEnabled);
+            auto bootMode = Mode::convertModesFromString(
+                getBootProperty(bootModeSetting, bootModeIntf, "BootMode"));
 
             bootOption = sourceDbusToIpmi.at(bootSource);
             if ((Mode::Modes::Regular == bootMode) &&
@@ -1486,7 +1523,8 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                 (reqptr->data[0] & SET_PARM_BOOT_FLAGS_PERMANENT) ==
                 SET_PARM_BOOT_FLAGS_PERMANENT;
 
-            auto bootSetting = settings::boot::setting(objects, bootSourceIntf);
+            auto bootSetting =
+                settings::boot::setting(*objects, bootSourceIntf);
 
             oneTimeEnabled =
                 std::get<settings::boot::OneTimeEnabled>(bootSetting);
@@ -1509,11 +1547,19 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                       "Enabled", !permanent);
             }
 
+            // The objects to update follow from the request rather than from
+            // reading Enabled back, whose cached value is only updated once
+            // the PropertiesChanged signal of the write is processed.
+            const auto& bootSourceSetting =
+                settings::boot::setting(*objects, bootSourceIntf, !permanent);
+            const auto& bootModeSetting =
+                settings::boot::setting(*objects, bootModeIntf, !permanent);
+
             auto modeItr = modeIpmiToDbus.find(bootOption);
             auto sourceItr = sourceIpmiToDbus.find(bootOption);
             if (sourceIpmiToDbus.end() != sourceItr)
             {
-                rc = setBootSource(sourceItr->second);
+                rc = setBootSource(bootSourceSetting, sourceItr->second);
                 if (rc != IPMI_CC_OK)
                 {
                     *data_len = 0;
@@ -1525,12 +1571,12 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                 // at the default value
                 if (sourceItr->second != Source::Sources::Default)
                 {
-                    setBootMode(Mode::Modes::Regular);
+                    setBootMode(bootModeSetting, Mode::Modes::Regular);
                 }
             }
             if (modeIpmiToDbus.end() != modeItr)
             {
-                rc = setBootMode(modeItr->second);
+                rc = setBootMode(bootModeSetting, modeItr->second);
                 if (rc != IPMI_CC_OK)
                 {
                     *data_len = 0;
@@ -1542,7 +1588,7 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                 // at the default value
                 if (modeItr->second != Mode::Modes::Regular)
                 {
-                    setBootSource(Source::Sources::Default);
+                    setBootSource(bootSourceSetting, Source::Sources::Default);
                 }
             }
         }
@@ -1662,7 +1708,7 @@ ipmi_ret_t ipmi_chassis_set_power_restore_policy(
     try
     {
         const settings::Path& powerRestoreSetting =
-            chassis::internal::cache::objects.map
+            chassis::internal::cache::objects->map
                 .at(chassis::internal::powerRestoreIntf)
                 .front();
         sdbusplus::message::variant<std::string> property =
@@ -1670,8 +1716,8 @@ ipmi_ret_t ipmi_chassis_set_power_restore_policy(
 
         auto method = chassis::internal::dbus.new_method_call(
             chassis::internal::cache::objects
-                .service(powerRestoreSetting,
-                         chassis::internal::powerRestoreIntf)
+                ->service(powerRestoreSetting,
+                          chassis::internal::powerRestoreIntf)
                 .c_str(),
             powerRestoreSetting.c_str(), ipmi::PROP_INTF, "Set");
 
@@ -1700,6 +1746,7 @@ ipmi_ret_t ipmi_chassis_set_power_restore_policy(
 void register_netfn_chassis_functions()
 {
     createIdentifyTimer();
+    chassis::internal::cache::objects.prefetch("chassis settings");
 
     // <Wildcard Command>
     ipmi_register_callback(NETFUN_CHASSIS, IPMI_CMD_WILDCARD, NULL,
@@ -0,0 +1,452 @@
+#include "config.h"
+
+#include "command-stats.hpp"
+
+#include "host-cmd-manager.hpp"
+#include "request-scheduler.hpp"
+#include "request-trace.hpp"
+#include "startup-profile.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
+#include <ipmid/dbus-stats.hpp>
+#include <ipmid/oemopenbmc.hpp>
+#include <limits>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+extern std::unique_ptr<phosphor::host::command::Manager>&
+    ipmid_get_host_cmd_manager(size_t host);
+
+namespace ipmi
+{
+namespace stats
+{
+
+namespace
+{
+
+constexpr auto statsObjPath = "/xyz/openbmc_project/Ipmi/Statistics";
+constexpr auto statsIntf = "xyz.openbmc_project.Ipmi.Statistics";
+
+/* map of statistics; key is NetFn/Cmd/channel */
+std::unordered_map<uint32_t, CommandStats> commandStats;
+
+std::shared_ptr<sdbusplus::asio::dbus_interface> statsIface;
+
+CoroutineUsage coroutines;
+
+DeadlineStats deadlines;
+
+inline uint32_t makeStatsKey(NetFn netFn, Cmd cmd, uint8_t channel)
+{
+    return (static_cast<uint32_t>(netFn) << 16) |
+           (static_cast<uint32_t>(cmd) << 8) | channel;
+}
+
+inline uint64_t toMicroseconds(Clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+inline size_t bucketIndex(uint64_t us)
+{
+    if (us == 0)
+    {
+        return 0;
+    }
+    // floor(log2(us)), clamped to the last bucket
+    size_t bucket = (sizeof(us) * CHAR_BIT) - 1 - __builtin_clzll(us);
+    return std::min(bucket, histogramBuckets - 1);
+}
+
+/* narrow a 64 bit counter for the IPMI response, saturating on overflow */
+inline uint32_t saturate(uint64_t value)
+{
+    return static_cast<uint32_t>(std::min<uint64_t>(
+        value, std::numeric_limits<uint32_t>::max()));
+}
+
+using StatsEntry = std::tuple<uint8_t,  // NetFn
+                              uint8_t,  // Cmd
+                              uint8_t,  // channel
+                              uint64_t, // count
+                              uint64_t, // filter time
+                              uint64_t, // handler time
+                              uint64_t, // total time
+                              uint64_t, // max time
+                              std::vector<uint32_t>>; // histogram
+
+using QueueEntry = std::tuple<uint8_t,  // channel
+                              uint32_t, // queued
+                              uint32_t, // peak
+                              uint64_t, // delayed
+                              uint64_t>; // rejected
+
+/* queue counters of the channels that have queued or refused a request */
+std::vector<QueueEntry> getChannelQueueStats()
+{
+    std::vector<QueueEntry> entries;
+    const scheduler::Stats& stats = scheduler::getStats();
+    for (size_t channel = 0; channel < stats.size(); channel++)
+    {
+        const scheduler::ChannelStats& queue = stats[channel];
+        if (!queue.delayed && !queue.rejected)
+        {
+            continue;
+        }
+        entries.emplace_back(static_cast<uint8_t>(channel),
+                             static_cast<uint32_t>(queue.queued),
+                             static_cast<uint32_t>(queue.peak), queue.delayed,
+                             queue.rejected);
+    }
+    return entries;
+}
+
+using HostCommandEntry = std::tuple<uint8_t,  // host
+                                    uint64_t, // commands read by the host
+                                    uint64_t, // coalesced
+                                    uint32_t, // peak depth
+                                    uint64_t, // total latency
+                                    uint64_t>; // max latency
+
+/* counters of the command queue of each host */
+std::vector<HostCommandEntry> getHostCommandStats()
+{
+    std::vector<HostCommandEntry> entries;
+    for (size_t host = 0; host < IPMI_HOST_INSTANCES; host++)
+    {
+        const phosphor::host::command::QueueStats& queue =
+            ipmid_get_host_cmd_manager(host)->getStats();
+        entries.emplace_back(static_cast<uint8_t>(host), queue.commands,
+                             queue.coalesced,
+                             static_cast<uint32_t>(queue.peakDepth),
+                             queue.totalLatency.count(),
+                             queue.maxLatency.count());
+    }
+    return entries;
+}
+
+using PhaseEntry = std::tuple<std::string, // name
+                              uint64_t,    // from process start
+                              uint64_t>;   // duration
+
+std::vector<PhaseEntry> getStartupPhases()
+{
+    std::vector<PhaseEntry> entries;
+    for (const startup::Phase& phase : startup::getPhases())
+    {
+        entries.emplace_back(phase.name, toMicroseconds(phase.at),
+                             toMicroseconds(phase.duration));
+    }
+    return entries;
+}
+
+using ProviderEntry = std::tuple<std::string, // path
+                                 uint64_t,    // from process start
+                                 uint64_t,    // duration
+                                 uint32_t,    // registrations
+                                 uint64_t,    // longest wait for one
+                                 std::string>; // registration after it
+
+std::vector<ProviderEntry> getProviderLoadTimes()
+{
+    std::vector<ProviderEntry> entries;
+    for (const startup::Provider& provider : startup::getProviders())
+    {
+        entries.emplace_back(provider.name, toMicroseconds(provider.start),
+                             toMicroseconds(provider.duration),
+                             static_cast<uint32_t>(provider.registrations),
+                             toMicroseconds(provider.slowest),
+                             provider.slowestAt);
+    }
+    return entries;
+}
+
+std::vector<StatsEntry> getCommandStats()
+{
+    std::vector<StatsEntry> entries;
+    entries.reserve(commandStats.size());
+    for (const auto& [key, stats] : commandStats)
+    {
+        entries.emplace_back(
+            static_cast<uint8_t>(key >> 16), static_cast<uint8_t>(key >> 8),
+            static_cast<uint8_t>(key), stats.count, stats.filterTime,
+            stats.handlerTime, stats.totalTime, stats.maxTime,
+            std::vector<uint32_t>(stats.histogram.begin(),
+                                  stats.histogram.end()));
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+/** @brief implements the OpenBMC OEM Get Command Statistics command
+ *
+ *  @param[in] oen - OEM number; must be the OpenBMC OEM number
+ *  @param[in] netFn - NetFn of the command to report
+ *  @param[in] cmd - Cmd of the command to report
+ *  @param[in] channel - channel of the command to report
+ *
+ *  @returns IPMI completion code plus response data
+ *   - OEM number
+ *   - number of requests
+ *   - average time from entry to response in microseconds
+ *   - average time in the handler in microseconds
+ *   - average time in the filters in microseconds
+ *   - maximum time from entry to response in microseconds
+ *   - histogram of the time from entry to response
+ */
+ipmi::RspType<uint24_t,  // OEM number
+              uint32_t,  // count
+              uint32_t,  // average total time
+              uint32_t,  // average handler time
+              uint32_t,  // average filter time
+              uint32_t,  // max time
+              Histogram> // histogram
+    ipmiOemGetCommandStats(uint24_t oen, uint8_t netFn, uint8_t cmd,
+                           uint8_t channel)
+{
+    if (oen != oem::obmcOemNumber)
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+
+    const CommandStats* stats = find(netFn, cmd, channel);
+    if (!stats || !stats->count)
+    {
+        return ipmi::responseSuccess(oen, 0, 0, 0, 0, 0, Histogram{});
+    }
+    return ipmi::responseSuccess(
+        oen, saturate(stats->count), saturate(stats->totalTime / stats->count),
+        saturate(stats->handlerTime / stats->count),
+        saturate(stats->filterTime / stats->count), saturate(stats->maxTime),
+        stats->histogram);
+}
+
+/** @brief implements the OpenBMC OEM Get Cache Usage command
+ *
+ *  @param[in] oen - OEM number; must be the OpenBMC OEM number
+ *  @param[in] index - which of the caches to report, in name order
+ *
+ *  @returns IPMI completion code plus response data
+ *   - OEM number
+ *   - number of caches
+ *   - name of the cache
+ *   - number of entries
+ *   - estimated heap bytes
+ *   - most entries kept, 0 if not limited
+ *   - number of entries evicted for the limit
+ */
+ipmi::RspType<uint24_t,    // OEM number
+              uint8_t,     // count
+              std::string, // name
+              uint32_t,    // entries
+              uint32_t,    // bytes
+              uint32_t,    // limit
+              uint32_t>    // evictions
+    ipmiOemGetCacheUsage(uint24_t oen, uint8_t index)
+{
+    if (oen != oem::obmcOemNumber)
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+
+    std::vector<cache_stats::Entry> caches = cache_stats::get();
+    if (index >= caches.size())
+    {
+        return ipmi::responseParmOutOfRange();
+    }
+    const auto& [name, entries, bytes, limit, evictions] = caches[index];
+    return ipmi::responseSuccess(
+        oen, static_cast<uint8_t>(std::min<size_t>(caches.size(), 0xff)),
+        name, entries, saturate(bytes), limit, saturate(evictions));
+}
+
+/** @brief log all of the statistics, on SIGUSR1 */
+SignalResponse dump(int)
+{
+    using namespace phosphor::logging;
+
+    log<level::INFO>("IPMI coroutine usage",
+                     entry("IN_USE=%zu", coroutines.inUse),
+                     entry("PEAK=%zu", coroutines.peak),
+                     entry("QUEUED=%zu", coroutines.queued));
+    const scheduler::InFlightStats& inFlight = scheduler::getInFlightStats();
+    log<level::INFO>(
+        "IPMI requests in flight", entry("IN_FLIGHT=%zu", inFlight.inFlight),
+        entry("PEAK=%zu", inFlight.peak),
+        entry("QUEUED_PEAK=%zu", inFlight.queuedPeak),
+        entry("SENDER_PEAK=%zu", inFlight.senderPeak),
+        entry("REJECTED=%llu", (unsigned long long)inFlight.rejected),
+        entry("SENDER_REJECTED=%llu",
+              (unsigned long long)inFlight.senderRejected));
+    log<level::INFO>(
+        "IPMI requests past their deadline",
+        entry("DROPPED=%llu", (unsigned long long)deadlines.dropped),
+        entry("LATE=%llu", (unsigned long long)deadlines.late));
+    for (const auto& [channel, queued, peak, delayed, rejected] :
+         getChannelQueueStats())
+    {
+        log<level::INFO>("IPMI channel queue", entry("CHANNEL=%u", channel),
+                         entry("QUEUED=%u", queued), entry("PEAK=%u", peak),
+                         entry("DELAYED=%llu", (unsigned long long)delayed),
+                         entry("REJECTED=%llu", (unsigned long long)rejected));
+    }
+    for (const auto& [host, commands, coalesced, peak, totalLatency,
+                      maxLatency] : getHostCommandStats())
+    {
+        log<level::INFO>(
+            "IPMI host command queue", entry("HOST=%u", host),
+            entry("COMMANDS=%llu", (unsigned long long)commands),
+            entry("COALESCED=%llu", (unsigned long long)coalesced),
+            entry("PEAK=%u", peak),
+            entry("TOTAL_LATENCY_US=%llu", (unsigned long long)totalLatency),
+            entry("MAX_LATENCY_US=%llu", (unsigned long long)maxLatency));
+    }
+    for (const auto& [name, entries, bytes, limit, evictions] :
+         cache_stats::get())
+    {
+        log<level::INFO>(
+            "IPMI cache usage", entry("CACHE=%s", name.c_str()),
+            entry("ENTRIES=%u", entries),
+            entry("BYTES=%llu", (unsigned long long)bytes),
+            entry("LIMIT=%u", limit),
+            entry("EVICTIONS=%llu", (unsigned long long)evictions));
+    }
+    for (const auto& [netFn, cmd, channel, count, filterTime, handlerTime,
+                      totalTime, maxTime, histogram] : getCommandStats())
+    {
+        log<level::INFO>("IPMI command statistics",
+                         entry("NETFN=0x%02x", netFn),
+                         entry("CMD=0x%02x", cmd),
+                         entry("CHANNEL=%u", channel),
+                         entry("COUNT=%llu", (unsigned long long)count),
+                         entry("FILTER_US=%llu",
+                               (unsigned long long)filterTime),
+                         entry("HANDLER_US=%llu",
+                               (unsigned long long)handlerTime),
+                         entry("TOTAL_US=%llu", (unsigned long long)totalTime),
+                         entry("MAX_US=%llu", (unsigned long long)maxTime));
+    }
+    for (const auto& [netFn, cmd, service, member, count, errors, totalTime,
+                      maxTime, histogram] : dbus_stats::get())
+    {
+        log<level::INFO>("IPMI D-Bus call statistics",
+                         entry("NETFN=0x%02x", netFn),
+                         entry("CMD=0x%02x", cmd),
+                         entry("SERVICE=%s", service.c_str()),
+                         entry("MEMBER=%s", member.c_str()),
+                         entry("COUNT=%llu", (unsigned long long)count),
+                         entry("ERRORS=%llu", (unsigned long long)errors),
+                         entry("TOTAL_US=%llu", (unsigned long long)totalTime),
+                         entry("MAX_US=%llu", (unsigned long long)maxTime));
+    }
+    return SignalResponse::continueExecution;
+}
+
+} // namespace
+
+void record(NetFn netFn, Cmd cmd, uint8_t channel, const Timing& timing,
+            Clock::duration total)
+{
+    CommandStats& stats = commandStats[makeStatsKey(netFn, cmd, channel)];
+    uint64_t totalUs = toMicroseconds(total);
+
+    deadlines.dropped += timing.dropped;
+    deadlines.late += timing.late;
+
+    stats.count++;
+    stats.filterTime += toMicroseconds(timing.filter);
+    stats.handlerTime += toMicroseconds(timing.handler);
+    stats.totalTime += totalUs;
+    stats.maxTime = std::max(stats.maxTime, totalUs);
+
+    uint32_t& bucket = stats.histogram[bucketIndex(totalUs)];
+    if (bucket < std::numeric_limits<uint32_t>::max())
+    {
+        bucket++;
+    }
+}
+
+const CommandStats* find(NetFn netFn, Cmd cmd, uint8_t channel)
+{
+    auto iter = commandStats.find(makeStatsKey(netFn, cmd, channel));
+    if (iter == commandStats.end())
+    {
+        return nullptr;
+    }
+    return &iter->second;
+}
+
+CoroutineUsage& coroutineUsage()
+{
+    return coroutines;
+}
+
+const DeadlineStats& getDeadlineStats()
+{
+    return deadlines;
+}
+
+void reset()
+{
+    commandStats.clear();
+    deadlines = DeadlineStats();
+    dbus_stats::reset();
+}
+
+void initialize(sdbusplus::asio::object_server& server)
+{
+    statsIface = server.add_interface(statsObjPath, statsIntf);
+    statsIface->register_method("GetCommandStats", getCommandStats);
+    statsIface->register_method("GetDbusCallStats", dbus_stats::get);
+    statsIface->register_method("Reset", reset);
+    statsIface->register_method("GetCoroutineUsage", []() {
+        return std::make_tuple(static_cast<uint32_t>(coroutines.inUse),
+                               static_cast<uint32_t>(coroutines.peak),
+                               static_cast<uint32_t>(coroutines.queued));
+    });
+    statsIface->register_method("GetChannelQueueStats", getChannelQueueStats);
+    statsIface->register_method("GetDeadlineStats", []() {
+        return std::make_tuple(deadlines.dropped, deadlines.late);
+    });
+    statsIface->register_method("GetHostCommandStats", getHostCommandStats);
+    statsIface->register_method("GetStartupPhases", getStartupPhases);
+    statsIface->register_method("GetCacheUsage", cache_stats::get);
+    statsIface->register_method("GetProviderLoadTimes", getProviderLoadTimes);
+    statsIface->register_method("GetInFlightStats", []() {
+        const scheduler::InFlightStats& inFlight =
+            scheduler::getInFlightStats();
+        return std::make_tuple(static_cast<uint32_t>(inFlight.inFlight),
+                               static_cast<uint32_t>(inFlight.peak),
+                               static_cast<uint32_t>(inFlight.queuedPeak),
+                               static_cast<uint32_t>(inFlight.senderPeak),
+                               inFlight.rejected, inFlight.senderRejected);
+    });
+    // record the requests for ipmi_replay
+    statsIface->register_method("StartTrace", trace::start);
+    statsIface->register_method("StopTrace", trace::stop);
+    statsIface->initialize();
+
+    // <Get Command Statistics>
+    ipmi::registerOemHandler(ipmi::prioOpenBmcBase, oem::obmcOemNumber,
+                             oem::ipmiStatsCmd, ipmi::Privilege::User,
+                             ipmiOemGetCommandStats);
+
+    // <Get Cache Usage>
+    ipmi::registerOemHandler(ipmi::prioOpenBmcBase, oem::obmcOemNumber,
+                             oem::cacheUsageCmd, ipmi::Privilege::User,
+                             ipmiOemGetCacheUsage);
+
+    // kill -USR1 logs everything to the journal
+    registerDeferredSignalHandler(ipmi::prioOpenBmcBase, SIGUSR1, dump);
+}
+
+} // namespace stats
+} // namespace ipmi
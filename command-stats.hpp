@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ipmid/api-types.hpp>
+#include <sdbusplus/asio/object_server.hpp>
+
+namespace ipmi
+{
+namespace stats
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* Bucket N counts requests that took [2^N, 2^(N+1)) microseconds; bucket 0
+ * also holds anything faster than that and the last bucket holds anything
+ * slower, which covers everything up to the 5s D-Bus timeout. */
+constexpr size_t histogramBuckets = 24;
+
+using Histogram = std::array<uint32_t, histogramBuckets>;
+
+/** @struct Timing
+ *  @brief Time spent in each stage of the dispatcher for a single request
+ */
+struct Timing
+{
+    Clock::duration filter{};
+    Clock::duration handler{};
+    // not run, its deadline had passed before the handler was called
+    bool dropped = false;
+    // run, but answered after its deadline
+    bool late = false;
+};
+
+/** @struct CommandStats
+ *  @brief Accumulated statistics for one NetFn/Cmd/channel
+ *
+ *  All times are in microseconds.
+ */
+struct CommandStats
+{
+    uint64_t count = 0;
+    uint64_t filterTime = 0;
+    uint64_t handlerTime = 0;
+    uint64_t totalTime = 0;
+    uint64_t maxTime = 0;
+    Histogram histogram{};
+};
+
+/** @struct CoroutineUsage
+ *  @brief Usage of the coroutines (and their stacks) that run requests
+ */
+struct CoroutineUsage
+{
+    size_t inUse = 0;
+    size_t peak = 0;
+    size_t queued = 0;
+};
+
+/** @brief Get the coroutine usage counters for the dispatcher to update */
+CoroutineUsage& coroutineUsage();
+
+/** @struct DeadlineStats
+ *  @brief Requests that missed the deadline of their channel
+ */
+struct DeadlineStats
+{
+    uint64_t dropped = 0;
+    uint64_t late = 0;
+};
+
+/** @brief Get the counters of the requests that missed their deadline */
+const DeadlineStats& getDeadlineStats();
+
+/** @brief Add the timing of one completed request to the statistics
+ *
+ *  @param[in] netFn - NetFn of the request
+ *  @param[in] cmd - Cmd of the request
+ *  @param[in] channel - channel the request came in on
+ *  @param[in] timing - time spent in the filters and the handler
+ *  @param[in] total - time from request entry to response
+ */
+void record(NetFn netFn, Cmd cmd, uint8_t channel, const Timing& timing,
+            Clock::duration total);
+
+/** @brief Look up the statistics of one NetFn/Cmd/channel
+ *
+ *  @return pointer to the statistics or nullptr if none were recorded
+ */
+const CommandStats* find(NetFn netFn, Cmd cmd, uint8_t channel);
+
+/** @brief Drop all of the recorded statistics, including the D-Bus calls */
+void reset();
+
+/** @brief Publish the statistics on D-Bus and register the OEM command
+ *
+ *  @param[in] server - object server to add the statistics interface to
+ */
+void initialize(sdbusplus::asio::object_server& server);
+
+} // namespace stats
+} // namespace ipmi
@@ -4,12 +4,25 @@
 
 #include "user_channel/channel_layer.hpp"
 
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
 #include <bitset>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <cmath>
+#include <ctime>
+#include <deque>
 #include <fstream>
+#include <iterator>
 #include <ipmid/api.hpp>
+#include <ipmid/log-limit.hpp>
+#include <ipmid/sensor-metadata.hpp>
 #include <ipmid/utils.hpp>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
@@ -51,7 +64,6 @@ constexpr auto DHCP_OPT12_ENABLED = "SendHostNameEnabled";
 
 constexpr auto SENSOR_VALUE_INTF = "xyz.openbmc_project.Sensor.Value";
 constexpr auto SENSOR_VALUE_PROP = "Value";
-constexpr auto SENSOR_SCALE_PROP = "Scale";
 
 using namespace phosphor::logging;
 
@@ -65,87 +77,84 @@ static const std::map<uint8_t, std::string> entityIdToName{
 
 bool isDCMIPowerMgmtSupported()
 {
-    auto data = parseJSONConfig(gDCMICapabilitiesConfig);
+    auto caps = getCapabilitiesConfig();
+    auto cap = caps->find(gDCMIPowerMgmtCapability);
 
-    return (gDCMIPowerMgmtSupported == data.value(gDCMIPowerMgmtCapability, 0));
+    return cap != caps->end() && gDCMIPowerMgmtSupported == cap->second;
 }
 
-uint32_t getPcap(sdbusplus::bus::bus& bus)
+namespace
 {
-    auto settingService = ipmi::getService(bus, PCAP_INTERFACE, PCAP_PATH);
-
-    auto method = bus.new_method_call(settingService.c_str(), PCAP_PATH,
-                                      "org.freedesktop.DBus.Properties", "Get");
-
-    method.append(PCAP_INTERFACE, POWER_CAP_PROP);
-    auto reply = bus.call(method);
 
-    if (reply.is_method_error())
-    {
-        log<level::ERR>("Error in getPcap prop");
-        elog<InternalFailure>();
-    }
-    sdbusplus::message::variant<uint32_t> pcap;
-    reply.read(pcap);
-
-    return std::get<uint32_t>(pcap);
+/** @brief The service that owns the power cap, looked up once */
+ipmi::ServiceCache& pcapService()
+{
+    static ipmi::ServiceCache service(PCAP_INTERFACE, PCAP_PATH);
+    return service;
 }
 
-bool getPcapEnabled(sdbusplus::bus::bus& bus)
+template <typename T>
+void setPcapProperty(sdbusplus::bus::bus& bus, const char* property, T value)
 {
-    auto settingService = ipmi::getService(bus, PCAP_INTERFACE, PCAP_PATH);
-
-    auto method = bus.new_method_call(settingService.c_str(), PCAP_PATH,
-                                      "org.freedesktop.DBus.Properties", "Get");
+    auto method = pcapService().newMethodCall(
+        bus, "org.freedesktop.DBus.Properties", "Set");
+    method.append(PCAP_INTERFACE, property);
+    method.append(sdbusplus::message::variant<T>(value));
 
-    method.append(PCAP_INTERFACE, POWER_CAP_ENABLE_PROP);
     auto reply = bus.call(method);
-
     if (reply.is_method_error())
     {
-        log<level::ERR>("Error in getPcapEnabled prop");
+        log<level::ERR>("Error in setting the power cap",
+                        entry("PROPERTY=%s", property));
         elog<InternalFailure>();
     }
-    sdbusplus::message::variant<bool> pcapEnabled;
-    reply.read(pcapEnabled);
-
-    return std::get<bool>(pcapEnabled);
 }
 
-void setPcap(sdbusplus::bus::bus& bus, const uint32_t powerCap)
-{
-    auto service = ipmi::getService(bus, PCAP_INTERFACE, PCAP_PATH);
-
-    auto method = bus.new_method_call(service.c_str(), PCAP_PATH,
-                                      "org.freedesktop.DBus.Properties", "Set");
-
-    method.append(PCAP_INTERFACE, POWER_CAP_PROP);
-    method.append(sdbusplus::message::variant<uint32_t>(powerCap));
+} // namespace
 
-    auto reply = bus.call(method);
-
-    if (reply.is_method_error())
+PowerCap getPowerCap(sdbusplus::bus::bus& bus)
+{
+    PowerCap pcap;
+    try
+    {
+        // the first property fetches the whole interface into the cache,
+        // so the second one is answered from memory
+        const std::string& service = pcapService().getService(bus);
+        pcap.limit = std::get<uint32_t>(ipmi::getCachedDbusProperty(
+            bus, service, PCAP_PATH, PCAP_INTERFACE, POWER_CAP_PROP));
+        pcap.enabled = std::get<bool>(ipmi::getCachedDbusProperty(
+            bus, service, PCAP_PATH, PCAP_INTERFACE, POWER_CAP_ENABLE_PROP));
+    }
+    catch (const std::exception& e)
     {
-        log<level::ERR>("Error in setPcap property");
+        pcapService().invalidate();
+        log<level::ERR>("Error in reading the power cap",
+                        entry("ERROR=%s", e.what()));
         elog<InternalFailure>();
     }
+    return pcap;
 }
 
-void setPcapEnable(sdbusplus::bus::bus& bus, bool enabled)
+void setPowerCap(sdbusplus::bus::bus& bus, std::optional<uint32_t> limit,
+                 std::optional<bool> enabled)
 {
-    auto service = ipmi::getService(bus, PCAP_INTERFACE, PCAP_PATH);
-
-    auto method = bus.new_method_call(service.c_str(), PCAP_PATH,
-                                      "org.freedesktop.DBus.Properties", "Set");
-
-    method.append(PCAP_INTERFACE, POWER_CAP_ENABLE_PROP);
-    method.append(sdbusplus::message::variant<bool>(enabled));
-
-    auto reply = bus.call(method);
-
-    if (reply.is_method_error())
+    PowerCap current = getPowerCap(bus);
+    try
+    {
+        if (limit && *limit != current.limit)
+        {
+            setPcapProperty(bus, POWER_CAP_PROP, *limit);
+        }
+        if (enabled && *enabled != current.enabled)
+        {
+            setPcapProperty(bus, POWER_CAP_ENABLE_PROP, *enabled);
+        }
+    }
+    catch (const std::exception& e)
     {
-        log<level::ERR>("Error in setPcapEnabled property");
+        pcapService().invalidate();
+        log<level::ERR>("Error in setting the power cap",
+                        entry("ERROR=%s", e.what()));
         elog<InternalFailure>();
     }
 }
@@ -157,7 +166,7 @@ void readAssetTagObjectTree(dcmi::assettag::ObjectTree& objectTree)
     static constexpr auto mapperIface = "xyz.openbmc_project.ObjectMapper";
     static constexpr auto inventoryRoot = "/xyz/openbmc_project/inventory/";
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     auto depth = 0;
 
     auto mapperCall = bus.new_method_call(mapperBusName, mapperObjPath,
@@ -183,9 +192,59 @@ void readAssetTagObjectTree(dcmi::assettag::ObjectTree& objectTree)
     }
 }
 
+namespace cache
+{
+
+// The asset tag is read in chunks and the host name is part of every
+// discovery, so both are kept until their properties change.
+std::optional<std::string> assetTag;
+std::optional<std::string> hostName;
+
+std::unique_ptr<sdbusplus::bus::match::match> assetTagChanged;
+std::unique_ptr<sdbusplus::bus::match::match> assetTagRemoved;
+std::unique_ptr<sdbusplus::bus::match::match> hostNameChanged;
+
+/* start dropping the cached values when they change; returns true if the
+ * values can be cached */
+bool watch()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+    static constexpr auto inventoryRoot = "/xyz/openbmc_project/inventory";
+
+    auto bus = ipmi::getSdBus();
+    if (!bus)
+    {
+        return false;
+    }
+    if (!assetTagChanged)
+    {
+        assetTagChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus,
+            rules::type::signal() + rules::member("PropertiesChanged") +
+                rules::interface(propIntf) +
+                rules::path_namespace(inventoryRoot) +
+                rules::argN(0, assetTagIntf),
+            [](sdbusplus::message::message&) { assetTag.reset(); });
+        assetTagRemoved = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::interfacesRemoved(inventoryRoot),
+            [](sdbusplus::message::message&) { assetTag.reset(); });
+        hostNameChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::propertiesChanged(networkConfigObj, networkConfigIntf),
+            [](sdbusplus::message::message&) { hostName.reset(); });
+    }
+    return true;
+}
+
+} // namespace cache
+
 std::string readAssetTag()
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    if (cache::assetTag)
+    {
+        return *cache::assetTag;
+    }
+
+    sdbusplus::bus::bus& bus = getBus();
     dcmi::assettag::ObjectTree objectTree;
 
     // Read the object tree with the inventory root to figure out the object
@@ -208,12 +267,16 @@ std::string readAssetTag()
     sdbusplus::message::variant<std::string> assetTag;
     reply.read(assetTag);
 
+    if (cache::watch())
+    {
+        cache::assetTag = std::get<std::string>(assetTag);
+    }
     return std::get<std::string>(assetTag);
 }
 
 void writeAssetTag(const std::string& assetTag)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     dcmi::assettag::ObjectTree objectTree;
 
     // Read the object tree with the inventory root to figure out the object
@@ -227,6 +290,8 @@ void writeAssetTag(const std::string& assetTag)
     method.append(dcmi::assetTagProp);
     method.append(sdbusplus::message::variant<std::string>(assetTag));
 
+    // read it back next time, the inventory may not store it as written
+    cache::assetTag.reset();
     auto reply = bus.call(method);
     if (reply.is_method_error())
     {
@@ -237,44 +302,64 @@ void writeAssetTag(const std::string& assetTag)
 
 std::string getHostName(void)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    if (cache::hostName)
+    {
+        return *cache::hostName;
+    }
+
+    sdbusplus::bus::bus& bus = getBus();
 
     auto service = ipmi::getService(bus, networkConfigIntf, networkConfigObj);
     auto value = ipmi::getDbusProperty(bus, service, networkConfigObj,
                                        networkConfigIntf, hostNameProp);
 
+    if (cache::watch())
+    {
+        cache::hostName = std::get<std::string>(value);
+    }
     return std::get<std::string>(value);
 }
 
 bool getDHCPEnabled()
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
+    // the network daemon announces its changes with PropertiesChanged, so
+    // the properties are read through the ObjectCache
     auto ethdevice = ipmi::getChannelName(ethernetDefaultChannelNum);
     auto ethernetObj =
         ipmi::getDbusObject(bus, ethernetIntf, networkRoot, ethdevice);
-    auto service = ipmi::getService(bus, ethernetIntf, ethernetObj.first);
-    auto value = ipmi::getDbusProperty(bus, service, ethernetObj.first,
-                                       ethernetIntf, "DHCPEnabled");
+    auto value = ipmi::getCachedDbusProperty(
+        bus, ethernetObj.second, ethernetObj.first, ethernetIntf,
+        "DHCPEnabled");
 
     return std::get<bool>(value);
 }
 
 bool getDHCPOption(std::string prop)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     auto service = ipmi::getService(bus, dhcpIntf, dhcpObj);
-    auto value = ipmi::getDbusProperty(bus, service, dhcpObj, dhcpIntf, prop);
+    auto value =
+        ipmi::getCachedDbusProperty(bus, service, dhcpObj, dhcpIntf, prop);
 
     return std::get<bool>(value);
 }
 
 void setDHCPOption(std::string prop, bool value)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     auto service = ipmi::getService(bus, dhcpIntf, dhcpObj);
+    // every write makes the network daemon rewrite its config and restart
+    // the network, so don't write what is already set
+    auto current =
+        ipmi::getCachedDbusProperty(bus, service, dhcpObj, dhcpIntf, prop);
+    if (std::get<bool>(current) == value)
+    {
+        return;
+    }
     ipmi::setDbusProperty(bus, service, dhcpObj, dhcpIntf, prop, value);
 }
 
@@ -297,6 +382,142 @@ Json parseJSONConfig(const std::string& configFile)
     return data;
 }
 
+namespace config
+{
+
+// directory of both config files
+constexpr auto configDir = "/usr/share/ipmi-providers";
+
+// the parsed configs are only kept while the config directory is watched
+std::shared_ptr<const SensorsConfig> sensors;
+std::shared_ptr<const CapabilitiesConfig> capabilities;
+
+std::unique_ptr<boost::asio::posix::stream_descriptor> changes;
+
+void waitChanges()
+{
+    changes->async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        [](const boost::system::error_code& ec) {
+            if (ec || !changes)
+            {
+                return;
+            }
+            // any change in the directory parses both files again
+            alignas(inotify_event) char events[4096];
+            while (read(changes->native_handle(), events, sizeof(events)) > 0)
+            {
+            }
+            sensors.reset();
+            capabilities.reset();
+            waitChanges();
+        });
+}
+
+bool watch()
+{
+    if (changes)
+    {
+        return true;
+    }
+    auto io = getIoContext();
+    if (!io)
+    {
+        return false;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to create the DCMI config watch",
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+    if (inotify_add_watch(fd, configDir,
+                          IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                              IN_MOVED_FROM | IN_MOVED_TO) < 0)
+    {
+        log<level::ERR>("Failed to watch the DCMI config",
+                        entry("DIR=%s", configDir), entry("ERRNO=%d", errno));
+        close(fd);
+        return false;
+    }
+    changes =
+        std::make_unique<boost::asio::posix::stream_descriptor>(*io, fd);
+    waitChanges();
+    return true;
+}
+
+SensorsConfig parseSensors(const Json& data)
+{
+    SensorsConfig config;
+    for (const auto& type : data.items())
+    {
+        if (!type.value().is_array())
+        {
+            continue;
+        }
+        auto& sensors = config[type.key()];
+        for (const auto& reading : type.value())
+        {
+            sensors.push_back({reading.value("instance", uint8_t{0}),
+                               reading.value("dbus", ""),
+                               reading.value("record_id", uint16_t{0})});
+        }
+        // so that instance ranges can be looked up instead of searched for
+        std::stable_sort(sensors.begin(), sensors.end(),
+                         [](const SensorConfig& a, const SensorConfig& b) {
+                             return a.instance < b.instance;
+                         });
+    }
+    return config;
+}
+
+CapabilitiesConfig parseCapabilities(const Json& data)
+{
+    CapabilitiesConfig config;
+    for (const auto& cap : data.items())
+    {
+        if (cap.value().is_number())
+        {
+            config.emplace(cap.key(), cap.value().get<int>());
+        }
+    }
+    return config;
+}
+
+} // namespace config
+
+std::shared_ptr<const SensorsConfig> getSensorsConfig()
+{
+    if (config::sensors)
+    {
+        return config::sensors;
+    }
+    auto parsed = std::make_shared<const SensorsConfig>(
+        config::parseSensors(parseJSONConfig(gDCMISensorsConfig)));
+    if (config::watch())
+    {
+        config::sensors = parsed;
+    }
+    return parsed;
+}
+
+std::shared_ptr<const CapabilitiesConfig> getCapabilitiesConfig()
+{
+    if (config::capabilities)
+    {
+        return config::capabilities;
+    }
+    auto parsed = std::make_shared<const CapabilitiesConfig>(
+        config::parseCapabilities(parseJSONConfig(gDCMICapabilitiesConfig)));
+    if (config::watch())
+    {
+        config::capabilities = parsed;
+    }
+    return parsed;
+}
+
 } // namespace dcmi
 
 ipmi_ret_t getPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
@@ -306,7 +527,7 @@ ipmi_ret_t getPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     if (!dcmi::isDCMIPowerMgmtSupported())
     {
         *data_len = 0;
-        log<level::ERR>("DCMI Power management is unsupported!");
+        ipmi::logLimited<level::ERR>("DCMI Power management is unsupported!");
         return IPMI_CC_INVALID;
     }
 
@@ -322,14 +543,12 @@ ipmi_ret_t getPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
-    sdbusplus::bus::bus sdbus{ipmid_get_sd_bus_connection()};
-    uint32_t pcapValue = 0;
-    bool pcapEnable = false;
+    sdbusplus::bus::bus& sdbus = getBus();
+    dcmi::PowerCap pcap;
 
     try
     {
-        pcapValue = dcmi::getPcap(sdbus);
-        pcapEnable = dcmi::getPcapEnabled(sdbus);
+        pcap = dcmi::getPowerCap(sdbus);
     }
     catch (InternalFailure& e)
     {
@@ -347,7 +566,7 @@ ipmi_ret_t getPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     constexpr auto exception = 0x01;
     responseData->exceptionAction = exception;
 
-    responseData->powerLimit = static_cast<uint16_t>(pcapValue);
+    responseData->powerLimit = static_cast<uint16_t>(pcap.limit);
 
     /*
      * Correction time limit and Statistics sampling period is currently not
@@ -357,7 +576,7 @@ ipmi_ret_t getPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     *data_len = outPayload.size();
     memcpy(response, outPayload.data(), *data_len);
 
-    if (pcapEnable)
+    if (pcap.enabled)
     {
         return IPMI_CC_OK;
     }
@@ -374,7 +593,7 @@ ipmi_ret_t setPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     if (!dcmi::isDCMIPowerMgmtSupported())
     {
         *data_len = 0;
-        log<level::ERR>("DCMI Power management is unsupported!");
+        ipmi::logLimited<level::ERR>("DCMI Power management is unsupported!");
         return IPMI_CC_INVALID;
     }
 
@@ -390,12 +609,12 @@ ipmi_ret_t setPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
-    sdbusplus::bus::bus sdbus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& sdbus = getBus();
 
     // Only process the power limit requested in watts.
     try
     {
-        dcmi::setPcap(sdbus, requestData->powerLimit);
+        dcmi::setPowerCap(sdbus, requestData->powerLimit, std::nullopt);
     }
     catch (InternalFailure& e)
     {
@@ -420,7 +639,7 @@ ipmi_ret_t applyPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     if (!dcmi::isDCMIPowerMgmtSupported())
     {
         *data_len = 0;
-        log<level::ERR>("DCMI Power management is unsupported!");
+        ipmi::logLimited<level::ERR>("DCMI Power management is unsupported!");
         return IPMI_CC_INVALID;
     }
 
@@ -436,12 +655,12 @@ ipmi_ret_t applyPowerLimit(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
-    sdbusplus::bus::bus sdbus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& sdbus = getBus();
 
     try
     {
-        dcmi::setPcapEnable(sdbus,
-                            static_cast<bool>(requestData->powerLimitAction));
+        dcmi::setPowerCap(sdbus, std::nullopt,
+                          static_cast<bool>(requestData->powerLimitAction));
     }
     catch (InternalFailure& e)
     {
@@ -687,7 +906,8 @@ ipmi_ret_t setMgmntCtrlIdStr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                             requestData->data + requestData->bytes, '\0');
         if (it != requestData->data + requestData->bytes)
         {
-            sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+            sdbusplus::bus::bus& bus = getBus();
+            dcmi::cache::hostName.reset();
             ipmi::setDbusProperty(bus, dcmi::networkServiceName,
                                   dcmi::networkConfigObj,
                                   dcmi::networkConfigIntf, dcmi::hostNameProp,
@@ -740,20 +960,19 @@ ipmi_ret_t getDCMICapabilities(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                ipmi_request_t request, ipmi_response_t response,
                                ipmi_data_len_t data_len, ipmi_context_t context)
 {
-
-    std::ifstream dcmiCapFile(dcmi::gDCMICapabilitiesConfig);
-    if (!dcmiCapFile.is_open())
+    std::shared_ptr<const dcmi::CapabilitiesConfig> data;
+    try
     {
-        log<level::ERR>("DCMI Capabilities file not found");
-        return IPMI_CC_UNSPECIFIED_ERROR;
+        data = dcmi::getCapabilitiesConfig();
     }
-
-    auto data = nlohmann::json::parse(dcmiCapFile, nullptr, false);
-    if (data.is_discarded())
+    catch (const InternalFailure& e)
     {
-        log<level::ERR>("DCMI Capabilities JSON parser failure");
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
+    auto capValue = [&data](const std::string& name) {
+        auto cap = data->find(name);
+        return cap != data->end() ? cap->second : 0;
+    };
 
     auto requestData =
         reinterpret_cast<const dcmi::GetDCMICapRequest*>(request);
@@ -763,7 +982,7 @@ ipmi_ret_t getDCMICapabilities(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         dcmiCaps.find(static_cast<dcmi::DCMICapParameters>(requestData->param));
     if (caps == dcmiCaps.end())
     {
-        log<level::ERR>("Invalid input parameter");
+        ipmi::logLimited<level::ERR>("Invalid input parameter");
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
@@ -784,7 +1003,7 @@ ipmi_ret_t getDCMICapabilities(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         // in 12bits.
         if ((cap.length + cap.position) > dcmi::gByteBitSize)
         {
-            uint16_t val = data.value(cap.name.c_str(), 0);
+            uint16_t val = capValue(cap.name);
             // According to DCMI spec v1.5, max number of SEL entries is
             // 4096, but bit 12b of DCMI capabilities Mandatory Platform
             // Attributes field is reserved and therefore we can use only
@@ -803,7 +1022,7 @@ ipmi_ret_t getDCMICapabilities(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         else
         {
             responseData->data[cap.bytePosition - 1] |=
-                data.value(cap.name.c_str(), 0) << cap.position;
+                capValue(cap.name) << cap.position;
         }
     }
 
@@ -821,18 +1040,18 @@ namespace dcmi
 namespace temp_readings
 {
 
-Temperature readTemp(const std::string& dbusService,
-                     const std::string& dbusPath)
+namespace
+{
+
+/** @brief Convert the properties of a Sensor.Value interface into a
+ *         temperature reading.
+ */
+Temperature toTemperature(const ipmi::FlatPropertyMap& result)
 {
-    // Read the temperature value from d-bus object. Need some conversion.
     // As per the interface xyz.openbmc_project.Sensor.Value, the temperature
     // is an double and in degrees C. It needs to be scaled by using the
     // formula Value * 10^Scale. The ipmi spec has the temperature as a uint8_t,
     // with a separate single bit for the sign.
-
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-    auto result = ipmi::getAllDbusProperties(
-        bus, dbusService, dbusPath, "xyz.openbmc_project.Sensor.Value");
     auto temperature =
         std::visit(ipmi::VariantToDoubleVisitor(), result.at("Value"));
     double absTemp = std::abs(temperature);
@@ -856,11 +1075,41 @@ Temperature readTemp(const std::string& dbusService,
                            (temperature < 0));
 }
 
-std::tuple<Response, NumInstances> read(const std::string& type,
+} // namespace
+
+Temperature readTemp(ipmi::Context::ptr ctx, const std::string& dbusService,
+                     const std::string& dbusPath)
+{
+    // Read the temperature value from d-bus object, or from the cache which
+    // the PropertiesChanged signals of the sensor keep current.
+    ipmi::ObjectCache& cache = ipmi::ObjectCache::instance();
+    if (auto cached = cache.find(dbusService, dbusPath, SENSOR_VALUE_INTF))
+    {
+        return toTemperature(*cached);
+    }
+
+    uint64_t token = cache.watch(dbusService, dbusPath, SENSOR_VALUE_INTF);
+    ipmi::FlatPropertyMap result;
+    boost::system::error_code ec = ipmi::getAllDbusProperties(
+        ctx, dbusService, dbusPath, SENSOR_VALUE_INTF, result);
+    if (ec)
+    {
+        ipmi::logLimited<level::ERR>("Failed to read the temperature",
+                                     entry("PATH=%s", dbusPath.c_str()),
+                                     entry("ERROR=%s", ec.message().c_str()));
+        elog<InternalFailure>();
+    }
+    Temperature temperature = toTemperature(result);
+    cache.fill(dbusService, dbusPath, SENSOR_VALUE_INTF, token,
+               std::move(result));
+    return temperature;
+}
+
+std::tuple<Response, NumInstances> read(ipmi::Context::ptr ctx,
+                                        const std::string& type,
                                         uint8_t instance)
 {
     Response response{};
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
 
     if (!instance)
     {
@@ -868,36 +1117,34 @@ std::tuple<Response, NumInstances> read(const std::string& type,
         elog<InternalFailure>();
     }
 
-    auto data = parseJSONConfig(gDCMISensorsConfig);
-    static const std::vector<Json> empty{};
-    std::vector<Json> readings = data.value(type, empty);
+    auto config = getSensorsConfig();
+    static const std::vector<SensorConfig> empty{};
+    auto sensors = config->find(type);
+    const auto& readings = sensors != config->end() ? sensors->second : empty;
     size_t numInstances = readings.size();
     for (const auto& j : readings)
     {
-        uint8_t instanceNum = j.value("instance", 0);
+        uint8_t instanceNum = j.instance;
         // Not the instance we're interested in
         if (instanceNum != instance)
         {
             continue;
         }
 
-        std::string path = j.value("dbus", "");
+        const std::string& path = j.dbusPath;
         std::string service;
-        try
-        {
-            service =
-                ipmi::getService(bus, "xyz.openbmc_project.Sensor.Value", path);
-        }
-        catch (std::exception& e)
+        boost::system::error_code ec =
+            ipmi::getService(ctx, SENSOR_VALUE_INTF, path, service);
+        if (ec)
         {
-            log<level::DEBUG>(e.what());
+            log<level::DEBUG>(ec.message().c_str());
             return std::make_tuple(response, numInstances);
         }
 
         response.instance = instance;
         uint8_t temp{};
         bool sign{};
-        std::tie(temp, sign) = readTemp(service, path);
+        std::tie(temp, sign) = readTemp(ctx, service, path);
         response.temperature = temp;
         response.sign = sign;
 
@@ -912,51 +1159,128 @@ std::tuple<Response, NumInstances> read(const std::string& type,
     return std::make_tuple(response, numInstances);
 }
 
-std::tuple<ResponseList, NumInstances> readAll(const std::string& type,
+std::tuple<ResponseList, NumInstances> readAll(ipmi::Context::ptr ctx,
+                                               const std::string& type,
                                                uint8_t instanceStart)
 {
     ResponseList response{};
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
 
     size_t numInstances = 0;
-    auto data = parseJSONConfig(gDCMISensorsConfig);
-    static const std::vector<Json> empty{};
-    std::vector<Json> readings = data.value(type, empty);
+    auto config = getSensorsConfig();
+    static const std::vector<SensorConfig> empty{};
+    auto sensors = config->find(type);
+    const auto& readings = sensors != config->end() ? sensors->second : empty;
     numInstances = readings.size();
-    for (const auto& j : readings)
+
+    /* a sensor whose reading isn't cached and is fetched in the batch */
+    struct Fetch
     {
-        try
+        size_t slot;
+        std::string service;
+        const SensorConfig* sensor;
+        uint64_t token;
+    };
+
+    ipmi::ObjectCache& cache = ipmi::ObjectCache::instance();
+    auto next = readings.begin();
+    // Max of 8 response data sets; another round only runs when sensors of
+    // the previous one failed and there are more in the range
+    while (response.size() < maxDataSets && next != readings.end())
+    {
+        // The readings that aren't cached are fetched in one batch, so the
+        // response takes as long as the slowest sensor rather than all of
+        // them in turn.
+        std::vector<std::optional<Response>> slots;
+        std::vector<Fetch> fetches;
+        std::vector<sdbusplus::message::message> methods;
+        for (; next != readings.end() &&
+               response.size() + slots.size() < maxDataSets;
+             ++next)
         {
-            // Max of 8 response data sets
-            if (response.size() == maxDataSets)
+            // Not in the instance range we're interested in
+            if (next->instance < instanceStart)
             {
-                break;
+                continue;
             }
 
-            uint8_t instanceNum = j.value("instance", 0);
-            // Not in the instance range we're interested in
-            if (instanceNum < instanceStart)
+            std::string service;
+            boost::system::error_code ec = ipmi::getService(
+                ctx, SENSOR_VALUE_INTF, next->dbusPath, service);
+            if (ec)
             {
+                log<level::DEBUG>(ec.message().c_str());
                 continue;
             }
 
-            std::string path = j.value("dbus", "");
-            auto service =
-                ipmi::getService(bus, "xyz.openbmc_project.Sensor.Value", path);
-
             Response r{};
-            r.instance = instanceNum;
-            uint8_t temp{};
-            bool sign{};
-            std::tie(temp, sign) = readTemp(service, path);
-            r.temperature = temp;
-            r.sign = sign;
-            response.push_back(r);
+            r.instance = next->instance;
+            if (auto cached =
+                    cache.find(service, next->dbusPath, SENSOR_VALUE_INTF))
+            {
+                try
+                {
+                    auto [temp, sign] = toTemperature(*cached);
+                    r.temperature = temp;
+                    r.sign = sign;
+                    slots.emplace_back(r);
+                }
+                catch (std::exception& e)
+                {
+                    log<level::DEBUG>(e.what());
+                }
+                continue;
+            }
+
+            slots.emplace_back(r);
+            uint64_t token =
+                cache.watch(service, next->dbusPath, SENSOR_VALUE_INTF);
+            auto method = ipmi::getSdBus()->new_method_call(
+                service.c_str(), next->dbusPath.c_str(),
+                "org.freedesktop.DBus.Properties", "GetAll");
+            method.append(SENSOR_VALUE_INTF);
+            methods.push_back(std::move(method));
+            fetches.push_back({slots.size() - 1, std::move(service), &*next,
+                               token});
         }
-        catch (std::exception& e)
+
+        std::vector<ipmi::BatchReply> replies = ipmi::callBatch(ctx, methods);
+        for (size_t i = 0; i < replies.size(); i++)
         {
-            log<level::DEBUG>(e.what());
-            continue;
+            Fetch& fetch = fetches[i];
+            std::optional<Response>& slot = slots[fetch.slot];
+            if (replies[i].ec)
+            {
+                log<level::DEBUG>(replies[i].ec.message().c_str());
+                slot.reset();
+                continue;
+            }
+            try
+            {
+                ipmi::FlatPropertyMap properties;
+                ipmi::readProperties(replies[i].reply, properties);
+                auto [temp, sign] = toTemperature(properties);
+                slot->temperature = temp;
+                slot->sign = sign;
+                cache.fill(fetch.service, fetch.sensor->dbusPath,
+                           SENSOR_VALUE_INTF, fetch.token,
+                           std::move(properties));
+            }
+            catch (std::exception& e)
+            {
+                log<level::DEBUG>("Failed to read the temperature",
+                                  entry("PATH=%s",
+                                        fetch.sensor->dbusPath.c_str()),
+                                  entry("ERROR=%s", e.what()));
+                slot.reset();
+            }
+        }
+
+        for (const auto& slot : slots)
+        {
+            if (slot)
+            {
+                response.push_back(*slot);
+            }
         }
     }
 
@@ -970,83 +1294,91 @@ std::tuple<ResponseList, NumInstances> readAll(const std::string& type,
 } // namespace temp_readings
 } // namespace dcmi
 
-ipmi_ret_t getTempReadings(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                           ipmi_request_t request, ipmi_response_t response,
-                           ipmi_data_len_t data_len, ipmi_context_t context)
+/** @brief implements the DCMI Get Temperature Readings command
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] groupID - group extension identification
+ *  @param[in] sensorType - type of the sensor
+ *  @param[in] entityId - entity ID
+ *  @param[in] entityInstance - entity instance (0 means all instances)
+ *  @param[in] instanceStart - instance start (used if instance is 0)
+ *
+ *  @returns IPMI completion code plus response data
+ *   - groupID - group extension identification
+ *   - numInstances - no. of instances for requested id
+ *   - numDataSets - no. of sets of temperature data
+ *   - temperature data sets
+ */
+ipmi::RspType<uint8_t,             // group ID
+              uint8_t,             // number of instances
+              uint8_t,             // number of data sets
+              std::vector<uint8_t> // temperature data
+              >
+    getTempReadings(ipmi::Context::ptr ctx, uint8_t groupID,
+                    uint8_t sensorType, uint8_t entityId,
+                    uint8_t entityInstance, uint8_t instanceStart)
 {
-    auto requestData =
-        reinterpret_cast<const dcmi::GetTempReadingsRequest*>(request);
-    auto responseData =
-        reinterpret_cast<dcmi::GetTempReadingsResponseHdr*>(response);
-
-    if (*data_len != sizeof(dcmi::GetTempReadingsRequest))
-    {
-        log<level::ERR>("Malformed request data",
-                        entry("DATA_SIZE=%d", *data_len));
-        return IPMI_CC_REQ_DATA_LEN_INVALID;
-    }
-    *data_len = 0;
-
-    auto it = dcmi::entityIdToName.find(requestData->entityId);
+    auto it = dcmi::entityIdToName.find(entityId);
     if (it == dcmi::entityIdToName.end())
     {
-        log<level::ERR>("Unknown Entity ID",
-                        entry("ENTITY_ID=%d", requestData->entityId));
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        ipmi::logLimited<level::ERR>("Unknown Entity ID",
+                                     entry("ENTITY_ID=%d", entityId));
+        return ipmi::responseInvalidFieldRequest();
     }
 
-    if (requestData->groupID != dcmi::groupExtId)
+    if (groupID != dcmi::groupExtId)
     {
-        log<level::ERR>("Invalid Group ID",
-                        entry("GROUP_ID=%d", requestData->groupID));
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        ipmi::logLimited<level::ERR>("Invalid Group ID",
+                                     entry("GROUP_ID=%d", groupID));
+        return ipmi::responseInvalidFieldRequest();
     }
 
-    if (requestData->sensorType != dcmi::temperatureSensorType)
+    if (sensorType != dcmi::temperatureSensorType)
     {
-        log<level::ERR>("Invalid sensor type",
-                        entry("SENSOR_TYPE=%d", requestData->sensorType));
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        ipmi::logLimited<level::ERR>("Invalid sensor type",
+                                     entry("SENSOR_TYPE=%d", sensorType));
+        return ipmi::responseInvalidFieldRequest();
     }
 
     dcmi::temp_readings::ResponseList temps{};
+    uint8_t numInstances = 0;
     try
     {
-        if (!requestData->entityInstance)
+        if (!entityInstance)
         {
             // Read all instances
-            std::tie(temps, responseData->numInstances) =
-                dcmi::temp_readings::readAll(it->second,
-                                             requestData->instanceStart);
+            std::tie(temps, numInstances) =
+                dcmi::temp_readings::readAll(ctx, it->second, instanceStart);
         }
         else
         {
             // Read one instance
             temps.resize(1);
-            std::tie(temps[0], responseData->numInstances) =
-                dcmi::temp_readings::read(it->second,
-                                          requestData->entityInstance);
+            std::tie(temps[0], numInstances) =
+                dcmi::temp_readings::read(ctx, it->second, entityInstance);
         }
-        responseData->numDataSets = temps.size();
     }
     catch (InternalFailure& e)
     {
-        return IPMI_CC_UNSPECIFIED_ERROR;
+        return ipmi::responseUnspecifiedError();
     }
 
-    responseData->groupID = dcmi::groupExtId;
+    auto payload = reinterpret_cast<const uint8_t*>(temps.data());
     size_t payloadSize = temps.size() * sizeof(dcmi::temp_readings::Response);
-    if (!temps.empty())
-    {
-        memcpy(responseData + 1, // copy payload right after the response header
-               temps.data(), payloadSize);
-    }
-    *data_len = sizeof(dcmi::GetTempReadingsResponseHdr) + payloadSize;
+    std::vector<uint8_t> data(payload, payload + payloadSize);
 
-    return IPMI_CC_OK;
+    return ipmi::responseSuccess(dcmi::groupExtId, numInstances,
+                                 static_cast<uint8_t>(temps.size()), data);
 }
 
-int64_t getPowerReading(sdbusplus::bus::bus& bus)
+namespace
+{
+
+/** @brief Read the D-Bus path of the power reading sensor from its config
+ *
+ *  @return the path; throws InternalFailure if it isn't configured
+ */
+std::string getPowerSensorPath()
 {
     std::ifstream sensorFile(POWER_READING_SENSOR);
     std::string objectPath;
@@ -1072,6 +1404,14 @@ int64_t getPowerReading(sdbusplus::bus::bus& bus)
                         entry("POWER_SENSOR_FILE=%s", POWER_READING_SENSOR));
         elog<InternalFailure>();
     }
+    return objectPath;
+}
+
+} // namespace
+
+int64_t getPowerReading(sdbusplus::bus::bus& bus)
+{
+    std::string objectPath = getPowerSensorPath();
 
     // Return default value if failed to read from D-Bus object
     int64_t power = 0;
@@ -1079,11 +1419,26 @@ int64_t getPowerReading(sdbusplus::bus::bus& bus)
     {
         auto service = ipmi::getService(bus, SENSOR_VALUE_INTF, objectPath);
 
-        // Read the sensor value and scale properties
-        auto properties = ipmi::getAllDbusProperties(bus, service, objectPath,
-                                                     SENSOR_VALUE_INTF);
-        auto value = std::get<int64_t>(properties[SENSOR_VALUE_PROP]);
-        auto scale = std::get<int64_t>(properties[SENSOR_SCALE_PROP]);
+        // Only the value is read once the scale is known; the metadata
+        // store follows the sensor if it is rescaled
+        double value = 0;
+        auto metadata = ipmi::sensor_metadata::find(objectPath);
+        if (metadata)
+        {
+            value = std::visit(ipmi::VariantToDoubleVisitor(),
+                               ipmi::getDbusProperty(bus, service, objectPath,
+                                                     SENSOR_VALUE_INTF,
+                                                     SENSOR_VALUE_PROP));
+        }
+        else
+        {
+            auto properties = ipmi::getAllDbusProperties(
+                bus, service, objectPath, SENSOR_VALUE_INTF);
+            value = std::visit(ipmi::VariantToDoubleVisitor(),
+                               properties.at(SENSOR_VALUE_PROP));
+            metadata = ipmi::sensor_metadata::update(objectPath, properties);
+        }
+        auto scale = metadata->scale;
 
         // Power reading needs to be scaled with the Scale value using the
         // formula Value * 10^Scale.
@@ -1098,6 +1453,242 @@ int64_t getPowerReading(sdbusplus::bus::bus& bus)
     return power;
 }
 
+namespace dcmi
+{
+namespace power
+{
+namespace
+{
+
+struct Sample
+{
+    uint16_t power;
+    uint32_t timeStamp;
+};
+
+// Sample N is kept in samples[N % maxSamples] until maxSamples later ones
+// were taken.
+std::array<Sample, maxSamples> samples;
+uint64_t taken = 0;
+
+// Running statistics over the kept samples: their sum, and the numbers of
+// the samples that are the minimum (maximum) of the samples after them, so
+// the front of each queue is the minimum (maximum) of all of them.
+uint64_t sum = 0;
+std::deque<uint64_t> minimums;
+std::deque<uint64_t> maximums;
+
+std::unique_ptr<boost::asio::steady_timer> timer;
+std::string sensorPath;
+std::string sensorService;
+
+size_t kept()
+{
+    return std::min<uint64_t>(taken, maxSamples);
+}
+
+void add(uint16_t power)
+{
+    Sample& slot = samples[taken % maxSamples];
+    if (taken >= maxSamples)
+    {
+        // the oldest sample leaves the window
+        uint64_t oldest = taken - maxSamples;
+        sum -= slot.power;
+        if (minimums.front() == oldest)
+        {
+            minimums.pop_front();
+        }
+        if (maximums.front() == oldest)
+        {
+            maximums.pop_front();
+        }
+    }
+
+    slot = {power, static_cast<uint32_t>(std::time(nullptr))};
+    sum += power;
+    while (!minimums.empty() &&
+           samples[minimums.back() % maxSamples].power >= power)
+    {
+        minimums.pop_back();
+    }
+    minimums.push_back(taken);
+    while (!maximums.empty() &&
+           samples[maximums.back() % maxSamples].power <= power)
+    {
+        maximums.pop_back();
+    }
+    maximums.push_back(taken);
+    taken++;
+}
+
+/* add a sample from a reading of the sensor */
+void add(double value, int64_t scale)
+{
+    // Power reading needs to be scaled with the Scale value using the
+    // formula Value * 10^Scale.
+    double power =
+        std::clamp(value * std::pow(10, scale), 0.0, double{UINT16_MAX});
+    add(static_cast<uint16_t>(power));
+}
+
+void read()
+{
+    if (auto metadata = ipmi::sensor_metadata::find(sensorPath))
+    {
+        // the scale is known; only the value is fetched
+        ipmi::getSdBus()->async_method_call(
+            [metadata](boost::system::error_code ec, const ipmi::Value& value) {
+                if (ec)
+                {
+                    sensorService.clear();
+                    return;
+                }
+                try
+                {
+                    add(std::visit(ipmi::VariantToDoubleVisitor(), value),
+                        metadata->scale);
+                }
+                catch (const std::exception& e)
+                {
+                    log<level::DEBUG>(
+                        "Failure to read power value",
+                        entry("OBJECT_PATH=%s", sensorPath.c_str()),
+                        entry("ERROR=%s", e.what()));
+                }
+            },
+            sensorService, sensorPath, "org.freedesktop.DBus.Properties",
+            "Get", SENSOR_VALUE_INTF, SENSOR_VALUE_PROP);
+        return;
+    }
+
+    ipmi::getSdBus()->async_method_call(
+        [](boost::system::error_code ec, const ipmi::PropertyMap& properties) {
+            if (ec)
+            {
+                // resolve the service again, the sensor may have moved
+                sensorService.clear();
+                return;
+            }
+            try
+            {
+                double value =
+                    std::visit(ipmi::VariantToDoubleVisitor(),
+                               properties.at(SENSOR_VALUE_PROP));
+                auto metadata =
+                    ipmi::sensor_metadata::update(sensorPath, properties);
+                add(value, metadata->scale);
+            }
+            catch (const std::exception& e)
+            {
+                log<level::DEBUG>("Failure to read power value",
+                                  entry("OBJECT_PATH=%s", sensorPath.c_str()),
+                                  entry("ERROR=%s", e.what()));
+            }
+        },
+        sensorService, sensorPath, "org.freedesktop.DBus.Properties",
+        "GetAll", SENSOR_VALUE_INTF);
+}
+
+void sample()
+{
+    if (!sensorService.empty())
+    {
+        read();
+        return;
+    }
+
+    using MapperResponse = std::map<std::string, std::vector<std::string>>;
+    ipmi::getSdBus()->async_method_call(
+        [](boost::system::error_code ec, const MapperResponse& objects) {
+            if (ec || objects.empty())
+            {
+                return;
+            }
+            sensorService = objects.begin()->first;
+            read();
+        },
+        "xyz.openbmc_project.ObjectMapper",
+        "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", "GetObject", sensorPath,
+        std::vector<std::string>({SENSOR_VALUE_INTF}));
+}
+
+void schedule()
+{
+    // at a fixed rate, however long the reads take
+    timer->expires_at(timer->expiry() + samplePeriod);
+    timer->async_wait([](const boost::system::error_code& ec) {
+        if (ec)
+        {
+            return;
+        }
+        sample();
+        schedule();
+    });
+}
+
+} // namespace
+
+void startSampling()
+{
+    if (timer || !ipmi::getSdBus())
+    {
+        return;
+    }
+    sensorPath = getPowerSensorPath();
+    timer = std::make_unique<boost::asio::steady_timer>(*getIoContext());
+    timer->expires_after(std::chrono::seconds(0));
+    sample();
+    schedule();
+}
+
+std::optional<Statistics> getStatistics(std::chrono::seconds period)
+{
+    if (!taken)
+    {
+        return std::nullopt;
+    }
+
+    Statistics stats{};
+    const Sample& last = samples[(taken - 1) % maxSamples];
+    stats.current = last.power;
+    stats.timeStamp = last.timeStamp;
+
+    size_t count = kept();
+    if (period.count() > 0)
+    {
+        count = std::min<size_t>(count, period / samplePeriod);
+        count = std::max<size_t>(count, 1);
+    }
+    if (count == kept())
+    {
+        stats.minimum = samples[minimums.front() % maxSamples].power;
+        stats.maximum = samples[maximums.front() % maxSamples].power;
+        stats.average = sum / count;
+    }
+    else
+    {
+        uint64_t total = 0;
+        stats.minimum = UINT16_MAX;
+        for (uint64_t i = taken - count; i < taken; i++)
+        {
+            uint16_t power = samples[i % maxSamples].power;
+            stats.minimum = std::min(stats.minimum, power);
+            stats.maximum = std::max(stats.maximum, power);
+            total += power;
+        }
+        stats.average = total / count;
+    }
+    stats.timeFrame = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          count * samplePeriod)
+                          .count();
+    return stats;
+}
+
+} // namespace power
+} // namespace dcmi
+
 ipmi_ret_t setDCMIConfParams(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                              ipmi_request_t request, ipmi_response_t response,
                              ipmi_data_len_t data_len, ipmi_context_t context)
@@ -1111,9 +1702,10 @@ ipmi_ret_t setDCMIConfParams(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         *data_len < DCMI_SET_CONF_PARAM_REQ_PACKET_MIN_SIZE ||
         *data_len > DCMI_SET_CONF_PARAM_REQ_PACKET_MAX_SIZE)
     {
-        log<level::ERR>("Invalid Group ID or Invalid Requested Packet size",
-                        entry("GROUP_ID=%d", requestData->groupID),
-                        entry("PACKET SIZE=%d", *data_len));
+        ipmi::logLimited<level::ERR>(
+            "Invalid Group ID or Invalid Requested Packet size",
+            entry("GROUP_ID=%d", requestData->groupID),
+            entry("PACKET SIZE=%d", *data_len));
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
@@ -1189,9 +1781,10 @@ ipmi_ret_t getDCMIConfParams(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     if (requestData->groupID != dcmi::groupExtId ||
         *data_len != sizeof(dcmi::GetConfParamsRequest))
     {
-        log<level::ERR>("Invalid Group ID or Invalid Requested Packet size",
-                        entry("GROUP_ID=%d", requestData->groupID),
-                        entry("PACKET SIZE=%d", *data_len));
+        ipmi::logLimited<level::ERR>(
+            "Invalid Group ID or Invalid Requested Packet size",
+            entry("GROUP_ID=%d", requestData->groupID),
+            entry("PACKET SIZE=%d", *data_len));
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
@@ -1255,7 +1848,7 @@ ipmi_ret_t getPowerReading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     if (!dcmi::isDCMIPowerMgmtSupported())
     {
         *data_len = 0;
-        log<level::ERR>("DCMI Power management is unsupported!");
+        ipmi::logLimited<level::ERR>("DCMI Power management is unsupported!");
         return IPMI_CC_INVALID;
     }
 
@@ -1271,11 +1864,38 @@ ipmi_ret_t getPowerReading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-    int64_t power = 0;
+    // The enhanced statistics mode asks for the statistics over a rolling
+    // period: bits 5:0 of the mode attribute are its duration and bits 7:6
+    // the unit of the duration (seconds, minutes, hours, days).
+    std::chrono::seconds period{0};
+    if (requestData->mode == dcmi::enhancedPowerStatistics)
+    {
+        static constexpr uint32_t units[] = {1, 60, 3600, 86400};
+        period = std::chrono::seconds((requestData->modeAttribute & 0x3F) *
+                                      units[requestData->modeAttribute >> 6]);
+    }
+
+    std::optional<dcmi::power::Statistics> stats;
     try
     {
-        power = getPowerReading(bus);
+        dcmi::power::startSampling();
+        stats = dcmi::power::getStatistics(period);
+        if (!stats)
+        {
+            // no sample taken yet; report the instantaneous reading
+            sdbusplus::bus::bus& bus = getBus();
+            uint16_t power = static_cast<uint16_t>(getPowerReading(bus));
+            stats = dcmi::power::Statistics{
+                power,
+                power,
+                power,
+                power,
+                static_cast<uint32_t>(std::time(nullptr)),
+                static_cast<uint32_t>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        dcmi::power::samplePeriod)
+                        .count())};
+        }
     }
     catch (InternalFailure& e)
     {
@@ -1286,15 +1906,13 @@ ipmi_ret_t getPowerReading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     }
     responseData->groupID = dcmi::groupExtId;
 
-    // TODO: openbmc/openbmc#2819
-    // Minimum, Maximum, Average power, TimeFrame, TimeStamp,
-    // PowerReadingState readings need to be populated
-    // after Telemetry changes.
-    uint16_t totalPower = static_cast<uint16_t>(power);
-    responseData->currentPower = totalPower;
-    responseData->minimumPower = totalPower;
-    responseData->maximumPower = totalPower;
-    responseData->averagePower = totalPower;
+    responseData->currentPower = stats->current;
+    responseData->minimumPower = stats->minimum;
+    responseData->maximumPower = stats->maximum;
+    responseData->averagePower = stats->average;
+    responseData->timeStamp = stats->timeStamp;
+    responseData->timeFrame = stats->timeFrame;
+    responseData->powerReadingState = dcmi::powerMeasurementActive;
 
     *data_len = sizeof(*responseData);
     return rc;
@@ -1305,96 +1923,88 @@ namespace dcmi
 namespace sensor_info
 {
 
-Response createFromJson(const Json& config)
+Response createFromConfig(const SensorConfig& config)
 {
     Response response{};
-    uint16_t recordId = config.value("record_id", 0);
+    uint16_t recordId = config.recordId;
     response.recordIdLsb = recordId & 0xFF;
     response.recordIdMsb = (recordId >> 8) & 0xFF;
     return response;
 }
 
-std::tuple<Response, NumInstances> read(const std::string& type,
-                                        uint8_t instance, const Json& config)
+namespace
 {
-    Response response{};
-
-    if (!instance)
-    {
-        log<level::ERR>("Expected non-zero instance");
-        elog<InternalFailure>();
-    }
 
-    static const std::vector<Json> empty{};
-    std::vector<Json> readings = config.value(type, empty);
-    size_t numInstances = readings.size();
-    for (const auto& reading : readings)
-    {
-        uint8_t instanceNum = reading.value("instance", 0);
-        // Not the instance we're interested in
-        if (instanceNum != instance)
-        {
-            continue;
-        }
-
-        response = createFromJson(reading);
+const std::vector<SensorConfig>& findSensors(const std::string& type,
+                                             const SensorsConfig& config)
+{
+    static const std::vector<SensorConfig> empty{};
+    auto sensors = config.find(type);
+    return sensors != config.end() ? sensors->second : empty;
+}
 
-        // Found the instance we're interested in
-        break;
-    }
+/** @brief First sensor with an instance number of at least instance */
+std::vector<SensorConfig>::const_iterator
+    lowerBound(const std::vector<SensorConfig>& sensors, uint8_t instance)
+{
+    return std::lower_bound(sensors.begin(), sensors.end(), instance,
+                            [](const SensorConfig& sensor, uint8_t value) {
+                                return sensor.instance < value;
+                            });
+}
 
+NumInstances trimInstances(size_t numInstances)
+{
     if (numInstances > maxInstances)
     {
         log<level::DEBUG>("Trimming IPMI num instances",
                           entry("NUM_INSTANCES=%d", numInstances));
         numInstances = maxInstances;
     }
-    return std::make_tuple(response, numInstances);
+    return numInstances;
 }
 
-std::tuple<ResponseList, NumInstances>
-    readAll(const std::string& type, uint8_t instanceStart, const Json& config)
+} // namespace
+
+std::tuple<Response, NumInstances> read(const std::string& type,
+                                        uint8_t instance,
+                                        const SensorsConfig& config)
 {
-    ResponseList responses{};
+    Response response{};
 
-    size_t numInstances = 0;
-    static const std::vector<Json> empty{};
-    std::vector<Json> readings = config.value(type, empty);
-    numInstances = readings.size();
-    for (const auto& reading : readings)
+    if (!instance)
     {
-        try
-        {
-            // Max of 8 records
-            if (responses.size() == maxRecords)
-            {
-                break;
-            }
-
-            uint8_t instanceNum = reading.value("instance", 0);
-            // Not in the instance range we're interested in
-            if (instanceNum < instanceStart)
-            {
-                continue;
-            }
-
-            Response response = createFromJson(reading);
-            responses.push_back(response);
-        }
-        catch (std::exception& e)
-        {
-            log<level::DEBUG>(e.what());
-            continue;
-        }
+        log<level::ERR>("Expected non-zero instance");
+        elog<InternalFailure>();
     }
 
-    if (numInstances > maxInstances)
+    const auto& sensors = findSensors(type, config);
+    auto sensor = lowerBound(sensors, instance);
+    if (sensor != sensors.end() && sensor->instance == instance)
     {
-        log<level::DEBUG>("Trimming IPMI num instances",
-                          entry("NUM_INSTANCES=%d", numInstances));
-        numInstances = maxInstances;
+        response = createFromConfig(*sensor);
     }
-    return std::make_tuple(responses, numInstances);
+
+    return std::make_tuple(response, trimInstances(sensors.size()));
+}
+
+std::tuple<ResponseList, NumInstances> readAll(const std::string& type,
+                                               uint8_t instanceStart,
+                                               const SensorsConfig& config)
+{
+    const auto& sensors = findSensors(type, config);
+    auto first = lowerBound(sensors, instanceStart);
+
+    // Max of 8 records
+    size_t count = std::min<size_t>(std::distance(first, sensors.end()),
+                                    maxRecords);
+    ResponseList responses;
+    responses.reserve(count);
+    std::transform(first, first + count, std::back_inserter(responses),
+                   createFromConfig);
+
+    return std::make_tuple(std::move(responses),
+                           trimInstances(sensors.size()));
 }
 
 } // namespace sensor_info
@@ -1420,43 +2030,38 @@ ipmi_ret_t getSensorInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     auto it = dcmi::entityIdToName.find(requestData->entityId);
     if (it == dcmi::entityIdToName.end())
     {
-        log<level::ERR>("Unknown Entity ID",
-                        entry("ENTITY_ID=%d", requestData->entityId));
+        ipmi::logLimited<level::ERR>(
+            "Unknown Entity ID", entry("ENTITY_ID=%d", requestData->entityId));
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
     if (requestData->groupID != dcmi::groupExtId)
     {
-        log<level::ERR>("Invalid Group ID",
-                        entry("GROUP_ID=%d", requestData->groupID));
+        ipmi::logLimited<level::ERR>(
+            "Invalid Group ID", entry("GROUP_ID=%d", requestData->groupID));
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
     if (requestData->sensorType != dcmi::temperatureSensorType)
     {
-        log<level::ERR>("Invalid sensor type",
-                        entry("SENSOR_TYPE=%d", requestData->sensorType));
+        ipmi::logLimited<level::ERR>(
+            "Invalid sensor type",
+            entry("SENSOR_TYPE=%d", requestData->sensorType));
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
     dcmi::sensor_info::ResponseList sensors{};
-    static dcmi::Json config{};
-    static bool parsed = false;
 
     try
     {
-        if (!parsed)
-        {
-            config = dcmi::parseJSONConfig(dcmi::gDCMISensorsConfig);
-            parsed = true;
-        }
+        auto config = dcmi::getSensorsConfig();
 
         if (!requestData->entityInstance)
         {
             // Read all instances
             std::tie(sensors, responseData->numInstances) =
                 dcmi::sensor_info::readAll(it->second,
-                                           requestData->instanceStart, config);
+                                           requestData->instanceStart, *config);
         }
         else
         {
@@ -1464,7 +2069,7 @@ ipmi_ret_t getSensorInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             sensors.resize(1);
             std::tie(sensors[0], responseData->numInstances) =
                 dcmi::sensor_info::read(it->second, requestData->entityInstance,
-                                        config);
+                                        *config);
         }
         responseData->numRecords = sensors.size();
     }
@@ -1526,8 +2131,9 @@ void register_netfn_dcmi_functions()
                            NULL, getDCMICapabilities, PRIVILEGE_USER);
 
     // <Get Temperature Readings>
-    ipmi_register_callback(NETFUN_GRPEXT, dcmi::Commands::GET_TEMP_READINGS,
-                           NULL, getTempReadings, PRIVILEGE_USER);
+    ipmi::registerGroupHandler(ipmi::prioOpenBmcBase, ipmi::groupDCMI,
+                               ipmi::dcmi::cmdGetTemperatureReadings,
+                               ipmi::Privilege::User, getTempReadings);
 
     // <Get Power Reading>
     ipmi_register_callback(NETFUN_GRPEXT, dcmi::Commands::GET_POWER_READING,
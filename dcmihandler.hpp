@@ -2,7 +2,11 @@
 
 #include "nlohmann/json.hpp"
 
+#include <chrono>
+#include <ipmid/api.hpp>
 #include <map>
+#include <memory>
+#include <optional>
 #include <sdbusplus/bus.hpp>
 #include <string>
 #include <vector>
@@ -118,6 +122,11 @@ using ResponseList = std::vector<Response>;
 
 static constexpr auto groupExtId = 0xDC;
 
+// Get Power Reading modes and power reading state
+static constexpr auto systemPowerStatistics = 0x01;
+static constexpr auto enhancedPowerStatistics = 0x02;
+static constexpr auto powerMeasurementActive = 0x40;
+
 static constexpr auto assetTagMaxOffset = 62;
 static constexpr auto assetTagMaxSize = 63;
 static constexpr auto maxBytes = 16;
@@ -194,22 +203,38 @@ std::string readAssetTag();
  */
 void writeAssetTag(const std::string& assetTag);
 
-/** @brief Read the current power cap value
+/** @struct PowerCap
+ *
+ *  State of the power capping of the host.
+ */
+struct PowerCap
+{
+    uint32_t limit = 0;   //!< Power cap value in watts.
+    bool enabled = false; //!< Power capping is enabled.
+};
+
+/** @brief Read the current power cap value and whether it is enabled
+ *
+ *  Both come from the one power cap interface, which is fetched with a
+ *  single GetAll and then kept current by the ObjectCache.
  *
  *  @param[in] bus - dbus connection
  *
- *  @return On success return the power cap value.
+ *  @return On success return the power cap state.
  */
-uint32_t getPcap(sdbusplus::bus::bus& bus);
+PowerCap getPowerCap(sdbusplus::bus::bus& bus);
 
-/** @brief Check if the power capping is enabled
+/** @brief Write the power cap value and/or whether it is enabled
  *
- *  @param[in] bus - dbus connection
+ *  Only the given properties that differ from the current state are
+ *  written, one after the other to the one service that owns them.
  *
- *  @return true if the powerCap is enabled and false if the powercap
- *          is disabled.
+ *  @param[in] bus - dbus connection
+ *  @param[in] limit - power cap value to set, if any
+ *  @param[in] enabled - enable/disable to set, if any
  */
-bool getPcapEnabled(sdbusplus::bus::bus& bus);
+void setPowerCap(sdbusplus::bus::bus& bus, std::optional<uint32_t> limit,
+                 std::optional<bool> enabled);
 
 /** @struct GetPowerLimitRequest
  *
@@ -236,13 +261,6 @@ struct GetPowerLimitResponse
     uint16_t samplingPeriod; //!< Statistics sampling period in seconds.
 } __attribute__((packed));
 
-/** @brief Set the power cap value
- *
- *  @param[in] bus - dbus connection
- *  @param[in] powerCap - power cap value
- */
-void setPcap(sdbusplus::bus::bus& bus, const uint32_t powerCap);
-
 /** @struct SetPowerLimitRequest
  *
  *  DCMI payload for Set Power Limit command request.
@@ -268,13 +286,6 @@ struct SetPowerLimitResponse
     uint8_t groupID; //!< Group extension identification.
 } __attribute__((packed));
 
-/** @brief Enable or disable the power capping
- *
- *  @param[in] bus - dbus connection
- *  @param[in] enabled - enable/disable
- */
-void setPcapEnable(sdbusplus::bus::bus& bus, bool enabled);
-
 /** @struct ApplyPowerLimitRequest
  *
  *  DCMI payload for Activate/Deactivate Power Limit command request.
@@ -400,87 +411,102 @@ struct DCMICapEntry
 
 using DCMICaps = std::map<DCMICapParameters, DCMICapEntry>;
 
-/** @struct GetTempReadingsRequest
+/** @brief Parse out JSON config file.
+ *
+ *  @param[in] configFile - JSON config file name
  *
- *  DCMI payload for Get Temperature Readings request
+ *  @return A json object
  */
-struct GetTempReadingsRequest
-{
-    uint8_t groupID;        //!< Group extension identification.
-    uint8_t sensorType;     //!< Type of the sensor
-    uint8_t entityId;       //!< Entity ID
-    uint8_t entityInstance; //!< Entity Instance (0 means all instances)
-    uint8_t instanceStart;  //!< Instance start (used if instance is 0)
-} __attribute__((packed));
+Json parseJSONConfig(const std::string& configFile);
 
-/** @struct GetTempReadingsResponse
+/** @struct SensorConfig
  *
- *  DCMI header for Get Temperature Readings response
+ *  One sensor of the DCMI sensors JSON config.
  */
-struct GetTempReadingsResponseHdr
+struct SensorConfig
 {
-    uint8_t groupID;      //!< Group extension identification.
-    uint8_t numInstances; //!< No. of instances for requested id
-    uint8_t numDataSets;  //!< No. of sets of temperature data
-} __attribute__((packed));
+    uint8_t instance;     //!< Entity instance number
+    std::string dbusPath; //!< D-Bus path of the sensor
+    uint16_t recordId;    //!< SDR record ID of the sensor
+};
 
-/** @brief Parse out JSON config file.
+/** @brief DCMI sensors by type, one of "inlet", "cpu", "baseboard"; the
+ *         sensors of a type are sorted by instance number.
+ */
+using SensorsConfig = std::map<std::string, std::vector<SensorConfig>>;
+
+/** @brief DCMI capability values by capability name */
+using CapabilitiesConfig = std::map<std::string, int>;
+
+/** @brief Get the DCMI sensors config. It is parsed once and parsed again
+ *         only after the config directory changed.
  *
- *  @param[in] configFile - JSON config file name
+ *  @return The sensors config; throws InternalFailure if it can't be read
+ */
+std::shared_ptr<const SensorsConfig> getSensorsConfig();
+
+/** @brief Get the DCMI capabilities config. It is parsed once and parsed
+ *         again only after the config directory changed.
  *
- *  @return A json object
+ *  @return The capabilities config; throws InternalFailure if it can't be
+ *          read
  */
-Json parseJSONConfig(const std::string& configFile);
+std::shared_ptr<const CapabilitiesConfig> getCapabilitiesConfig();
 
 namespace temp_readings
 {
 /** @brief Read temperature from a d-bus object, scale it as per dcmi
  *         get temperature reading requirements.
  *
+ *  @param[in] ctx - context of the request
  *  @param[in] dbusService - the D-Bus service
  *  @param[in] dbusPath - the D-Bus path
  *
  *  @return A temperature reading
  */
-Temperature readTemp(const std::string& dbusService,
+Temperature readTemp(ipmi::Context::ptr ctx, const std::string& dbusService,
                      const std::string& dbusPath);
 
 /** @brief Read temperatures and fill up DCMI response for the Get
  *         Temperature Readings command. This looks at a specific
  *         instance.
  *
+ *  @param[in] ctx - context of the request
  *  @param[in] type - one of "inlet", "cpu", "baseboard"
  *  @param[in] instance - A non-zero Entity instance number
  *
  *  @return A tuple, containing a temperature reading and the
  *          number of instances.
  */
-std::tuple<Response, NumInstances> read(const std::string& type,
+std::tuple<Response, NumInstances> read(ipmi::Context::ptr ctx,
+                                        const std::string& type,
                                         uint8_t instance);
 
 /** @brief Read temperatures and fill up DCMI response for the Get
  *         Temperature Readings command. This looks at a range of
  *         instances.
  *
+ *  @param[in] ctx - context of the request
  *  @param[in] type - one of "inlet", "cpu", "baseboard"
  *  @param[in] instanceStart - Entity instance start index
  *
  *  @return A tuple, containing a list of temperature readings and the
  *          number of instances.
  */
-std::tuple<ResponseList, NumInstances> readAll(const std::string& type,
+std::tuple<ResponseList, NumInstances> readAll(ipmi::Context::ptr ctx,
+                                               const std::string& type,
                                                uint8_t instanceStart);
 } // namespace temp_readings
 
 namespace sensor_info
 {
-/** @brief Create response from JSON config.
+/** @brief Create response from the sensor config.
  *
- *  @param[in] config - JSON config info about DCMI sensors
+ *  @param[in] config - config info about a DCMI sensor
  *
  *  @return Sensor info response
  */
-Response createFromJson(const Json& config);
+Response createFromConfig(const SensorConfig& config);
 
 /** @brief Read sensor info and fill up DCMI response for the Get
  *         Sensor Info command. This looks at a specific
@@ -488,13 +514,14 @@ Response createFromJson(const Json& config);
  *
  *  @param[in] type - one of "inlet", "cpu", "baseboard"
  *  @param[in] instance - A non-zero Entity instance number
- *  @param[in] config - JSON config info about DCMI sensors
+ *  @param[in] config - config info about DCMI sensors
  *
  *  @return A tuple, containing a sensor info response and
  *          number of instances.
  */
 std::tuple<Response, NumInstances> read(const std::string& type,
-                                        uint8_t instance, const Json& config);
+                                        uint8_t instance,
+                                        const SensorsConfig& config);
 
 /** @brief Read sensor info and fill up DCMI response for the Get
  *         Sensor Info command. This looks at a range of
@@ -502,13 +529,14 @@ std::tuple<Response, NumInstances> read(const std::string& type,
  *
  *  @param[in] type - one of "inlet", "cpu", "baseboard"
  *  @param[in] instanceStart - Entity instance start index
- *  @param[in] config - JSON config info about DCMI sensors
+ *  @param[in] config - config info about DCMI sensors
  *
  *  @return A tuple, containing a list of sensor info responses and the
  *          number of instances.
  */
-std::tuple<ResponseList, NumInstances>
-    readAll(const std::string& type, uint8_t instanceStart, const Json& config);
+std::tuple<ResponseList, NumInstances> readAll(const std::string& type,
+                                               uint8_t instanceStart,
+                                               const SensorsConfig& config);
 } // namespace sensor_info
 
 /** @brief Read power reading from power reading sensor object
@@ -519,6 +547,45 @@ std::tuple<ResponseList, NumInstances>
  */
 int64_t getPowerReading(sdbusplus::bus::bus& bus);
 
+namespace power
+{
+// the power reading sensor is sampled once a second and the last hour of
+// samples is kept for the statistics
+static constexpr auto samplePeriod = std::chrono::seconds(1);
+static constexpr size_t maxSamples = 3600;
+
+/** @struct Statistics
+ *
+ *  Power statistics over a period of the sampled power readings.
+ */
+struct Statistics
+{
+    uint16_t current;   //!< Last sampled power in watts
+    uint16_t minimum;   //!< Minimum power over the period in watts
+    uint16_t maximum;   //!< Maximum power over the period in watts
+    uint16_t average;   //!< Average power over the period in watts
+    uint32_t timeStamp; //!< Time of the last sample, seconds since epoch
+    uint32_t timeFrame; //!< Period covered by the samples in milliseconds
+};
+
+/** @brief Start sampling the power reading sensor in the background, if
+ *         it isn't sampled yet.
+ */
+void startSampling();
+
+/** @brief Get the power statistics over the most recent samples.
+ *
+ *  The statistics over all of the kept samples are maintained as the
+ *  samples are taken; those over a shorter period are computed from the
+ *  samples.
+ *
+ *  @param[in] period - period to report on; zero for all of the samples
+ *
+ *  @return The statistics, or std::nullopt if no sample was taken yet
+ */
+std::optional<Statistics> getStatistics(std::chrono::seconds period);
+} // namespace power
+
 /** @struct GetPowerReadingRequest
  *
  *  DCMI Get Power Reading command request.
@@ -0,0 +1,398 @@
+#include "dispatcher.hpp"
+
+#include "handler-threads.hpp"
+#include "response-cache.hpp"
+#include "startup-profile.hpp"
+
+#include <algorithm>
+#include <forward_list>
+#include <ipmid/dbus-stats.hpp>
+#include <ipmid/tracepoints.hpp>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ipmi
+{
+
+/* table to handle standard registered commands; only the even (request)
+ * NetFns are valid, so index by NetFn >> 1 and allocate rows on demand */
+static constexpr size_t netFnTableSize = (netFnOemEight >> 1) + 1;
+static std::array<std::unique_ptr<CmdTable>, /* index is NetFn >> 1 */
+                  netFnTableSize>
+    handlerTable;
+
+/* special table for decoding Group registered commands (NetFn 2Ch) */
+static std::array<std::unique_ptr<CmdTable>, /* index is Group */
+                  std::numeric_limits<Group>::max() + 1>
+    groupHandlerTable;
+
+/* special table for decoding OEM registered commands (NetFn 2Eh); the IANA
+ * space is too large to index directly, so keep a short list sorted by Iana */
+static std::vector<std::pair<Iana, std::unique_ptr<CmdTable>>>
+    oemHandlerTable;
+
+static std::unique_ptr<CmdTable>& getOemCmdTable(Iana iana)
+{
+    auto iter = std::lower_bound(
+        oemHandlerTable.begin(), oemHandlerTable.end(), iana,
+        [](const auto& item, Iana key) { return item.first < key; });
+    if (iter == oemHandlerTable.end() || iter->first != iana)
+    {
+        iter = oemHandlerTable.emplace(iter, iana, nullptr);
+    }
+    return iter->second;
+}
+
+static CmdTable* findOemCmdTable(Iana iana)
+{
+    auto iter = std::lower_bound(
+        oemHandlerTable.begin(), oemHandlerTable.end(), iana,
+        [](const auto& item, Iana key) { return item.first < key; });
+    if (iter == oemHandlerTable.end() || iter->first != iana)
+    {
+        return nullptr;
+    }
+    return iter->second.get();
+}
+
+using FilterTuple = std::tuple<int,            /* prio */
+                               FilterBase::ptr /* filter */
+                               >;
+
+/* list to hold all registered ipmi command filters */
+static std::forward_list<FilterTuple> filterList;
+
+/* the provider being opened, and what each provider registered; a table
+ * stays where it is once allocated, so it can be pointed to */
+static std::string registrant;
+static std::unordered_map<std::string, Registrations> registrations;
+
+void setRegistrant(const std::string& provider)
+{
+    registrant = provider;
+}
+
+namespace impl
+{
+/* common function to place a handler in a command table by priority */
+static bool registerTableHandler(std::unique_ptr<CmdTable>& table, int prio,
+                                 Cmd cmd, Privilege priv,
+                                 HandlerBase::ptr handler)
+{
+    if (!table)
+    {
+        table = std::make_unique<CmdTable>();
+    }
+    HandlerTuple item(prio, priv, handler);
+
+    // consult the handler table and look for a match
+    auto& mapCmd = (*table)[cmd];
+    if (!std::get<HandlerBase::ptr>(mapCmd) || std::get<int>(mapCmd) <= prio)
+    {
+        mapCmd = item;
+        if (!registrant.empty())
+        {
+            registrations[registrant].handlers.push_back(
+                Registrations::Handler{table.get(), cmd, item});
+        }
+        return true;
+    }
+    return false;
+}
+
+/* common function to register all standard IPMI handlers */
+bool registerHandler(int prio, NetFn netFn, Cmd cmd, Privilege priv,
+                     HandlerBase::ptr handler)
+{
+    // check for valid NetFn: even; 00-0Ch, 30-3Eh
+    if (netFn & 1 || (netFn > netFnTransport && netFn < netFnGroup) ||
+        netFn > netFnOemEight)
+    {
+        return false;
+    }
+
+    startup::registered("netfn", netFn, cmd);
+    return registerTableHandler(handlerTable[netFn >> 1], prio, cmd, priv,
+                                handler);
+}
+
+/* common function to register all Group IPMI handlers */
+bool registerGroupHandler(int prio, Group group, Cmd cmd, Privilege priv,
+                          HandlerBase::ptr handler)
+{
+    startup::registered("group", group, cmd);
+    return registerTableHandler(groupHandlerTable[group], prio, cmd, priv,
+                                handler);
+}
+
+/* common function to register all OEM IPMI handlers */
+bool registerOemHandler(int prio, Iana iana, Cmd cmd, Privilege priv,
+                        HandlerBase::ptr handler)
+{
+    startup::registered("iana", iana, cmd);
+    return registerTableHandler(getOemCmdTable(iana), prio, cmd, priv,
+                                handler);
+}
+
+/* common function to register all IPMI filter handlers */
+void registerFilter(int prio, FilterBase::ptr filter)
+{
+    startup::registered("filter", prio, 0);
+    if (!registrant.empty())
+    {
+        registrations[registrant].filters.emplace_back(prio, filter);
+    }
+    // check for initial placement
+    if (filterList.empty() || std::get<int>(filterList.front()) < prio)
+    {
+        filterList.emplace_front(std::make_tuple(prio, filter));
+    }
+    // walk the list and put it in the right place
+    auto j = filterList.begin();
+    for (auto i = j; i != filterList.end() && std::get<int>(*i) > prio; i++)
+    {
+        j = i;
+    }
+    filterList.emplace_after(j, std::make_tuple(prio, filter));
+}
+
+} // namespace impl
+
+message::Response::ptr filterIpmiCommand(message::Request::ptr request)
+{
+    // pass the command through the filter mechanism
+    // This can be the firmware firewall or any OEM mechanism like
+    // whitelist filtering based on operational mode
+    for (auto& item : filterList)
+    {
+        FilterBase::ptr filter = std::get<FilterBase::ptr>(item);
+        ipmi::Cc cc = filter->call(request);
+        IPMI_TRACEPOINT(filter_done, request->ctx->requestId,
+                        request->ctx->netFn, request->ctx->cmd,
+                        request->ctx->channel, std::get<int>(item), cc);
+        if (ipmi::ccSuccess != cc)
+        {
+            return errorResponse(request, cc);
+        }
+    }
+    return message::Response::ptr();
+}
+
+HandlerTuple* chooseHandler(CmdTable* handlers, Cmd cmd)
+{
+    HandlerTuple* chosen = &(*handlers)[cmd];
+    if (!std::get<HandlerBase::ptr>(*chosen))
+    {
+        chosen = &(*handlers)[cmdWildcard];
+    }
+    return chosen;
+}
+
+static message::Response::ptr
+    executeIpmiCommandCommon(CmdTable* handlers, message::Request::ptr request,
+                             stats::Timing* timing)
+{
+    // filter the command first; a non-null message::Response::ptr
+    // means that the message has been rejected for some reason
+    stats::Clock::time_point start = stats::Clock::now();
+    message::Response::ptr response = filterIpmiCommand(request);
+    if (timing)
+    {
+        timing->filter = stats::Clock::now() - start;
+    }
+    if (response)
+    {
+        return response;
+    }
+
+    if (handlers)
+    {
+        HandlerTuple* chosen = chooseHandler(handlers, request->ctx->cmd);
+        if (std::get<HandlerBase::ptr>(*chosen))
+        {
+            if (request->ctx->priv < std::get<Privilege>(*chosen))
+            {
+                return errorResponse(request, ccInsufficientPrivilege);
+            }
+            response = cache::lookup(request);
+            if (response)
+            {
+                return response;
+            }
+            if (request->ctx->expired())
+            {
+                // the client has given up on it; shed it while overloaded
+                if (timing)
+                {
+                    timing->dropped = true;
+                }
+                return errorResponse(request, ccBusy);
+            }
+            start = stats::Clock::now();
+            HandlerBase::ptr handler = std::get<HandlerBase::ptr>(*chosen);
+            IPMI_TRACEPOINT(handler_start, request->ctx->requestId,
+                            request->ctx->netFn, request->ctx->cmd,
+                            request->ctx->channel);
+            {
+                dbus_stats::CommandScope command(
+                    request->ctx->netFn, request->ctx->cmd,
+                    request->ctx->channel, request->ctx->requestId);
+                if (threads::offload(handler, request))
+                {
+                    response = threads::execute(handler, request);
+                }
+                else
+                {
+                    response = handler->call(request);
+                }
+            }
+            IPMI_TRACEPOINT(handler_end, request->ctx->requestId,
+                            request->ctx->netFn, request->ctx->cmd,
+                            request->ctx->channel, response->cc);
+            cache::store(request, response);
+            if (timing)
+            {
+                timing->handler = stats::Clock::now() - start;
+            }
+            return response;
+        }
+    }
+    return errorResponse(request, ccInvalidCommand);
+}
+
+/* size of the group extension or IANA that leads the request of a NetFn */
+static size_t extensionSize(NetFn netFn)
+{
+    switch (netFn)
+    {
+        case netFnGroup:
+            return sizeof(Group);
+        case netFnOem:
+            return 3; // the IANA is only three bytes on the wire
+        default:
+            return 0;
+    }
+}
+
+CmdTable* findCmdTable(NetFn netFn, uint32_t extension)
+{
+    switch (netFn)
+    {
+        case netFnGroup:
+            return groupHandlerTable[extension].get();
+        case netFnOem:
+            return findOemCmdTable(extension);
+        default:
+            if (!(netFn & 1) && (netFn >> 1) < netFnTableSize)
+            {
+                return handlerTable[netFn >> 1].get();
+            }
+            return nullptr;
+    }
+}
+
+message::Response::ptr executeIpmiCommand(message::Request::ptr request,
+                                          stats::Timing* timing)
+{
+    NetFn netFn = request->ctx->netFn;
+
+    // parse the group extension or IANA once; the handlers still find it at
+    // the start of the payload
+    size_t headerSize = extensionSize(netFn);
+    std::array<uint8_t, 3> header{};
+    if (headerSize)
+    {
+        if (request->payload.size() < headerSize)
+        {
+            return errorResponse(request, ccReqDataLenInvalid);
+        }
+        uint32_t extension = 0;
+        for (size_t i = 0; i < headerSize; i++)
+        {
+            header[i] = request->payload.raw[i];
+            extension |= static_cast<uint32_t>(header[i]) << (8 * i);
+        }
+        request->ctx->extension = extension;
+    }
+
+    message::Response::ptr response = executeIpmiCommandCommon(
+        findCmdTable(netFn, request->ctx->extension), request, timing);
+    // if the handler should add the header; executeIpmiCommandCommon does not
+    if (headerSize && response->cc != ccSuccess &&
+        response->payload.size() == 0)
+    {
+        response->payload.append(header.data(), header.data() + headerSize);
+    }
+    return response;
+}
+
+Registrations takeRegistrations(const std::string& provider)
+{
+    Registrations taken;
+    auto found = registrations.find(provider);
+    if (found == registrations.end())
+    {
+        return taken;
+    }
+    for (auto& registered : found->second.handlers)
+    {
+        // a handler replaced since is no longer the provider's to take
+        HandlerTuple& slot = (*registered.table)[registered.cmd];
+        if (std::get<HandlerBase::ptr>(slot) ==
+            std::get<HandlerBase::ptr>(registered.item))
+        {
+            slot = HandlerTuple();
+            taken.handlers.emplace_back(std::move(registered));
+        }
+    }
+    for (auto& registered : found->second.filters)
+    {
+        const FilterBase::ptr& filter = std::get<FilterBase::ptr>(registered);
+        filterList.remove_if([&filter](const FilterTuple& item) {
+            return std::get<FilterBase::ptr>(item) == filter;
+        });
+        taken.filters.emplace_back(std::move(registered));
+    }
+    registrations.erase(found);
+    return taken;
+}
+
+void restoreRegistrations(const std::string& provider, Registrations&& taken)
+{
+    std::string opened = std::move(registrant);
+    registrant = provider;
+    for (auto& registered : taken.handlers)
+    {
+        HandlerTuple& slot = (*registered.table)[registered.cmd];
+        if (!std::get<HandlerBase::ptr>(slot))
+        {
+            slot = registered.item;
+            registrations[provider].handlers.emplace_back(
+                std::move(registered));
+        }
+    }
+    for (auto& [prio, filter] : taken.filters)
+    {
+        impl::registerFilter(prio, std::move(filter));
+    }
+    registrant = std::move(opened);
+}
+
+void clearHandlers()
+{
+    for (auto& table : handlerTable)
+    {
+        table.reset();
+    }
+    for (auto& table : groupHandlerTable)
+    {
+        table.reset();
+    }
+    oemHandlerTable.clear();
+    filterList.clear();
+    registrations.clear();
+}
+
+} // namespace ipmi
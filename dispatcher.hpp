@@ -0,0 +1,113 @@
+#pragma once
+
+#include "command-stats.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ipmid/api-types.hpp>
+#include <ipmid/filter.hpp>
+#include <ipmid/handler.hpp>
+#include <ipmid/message.hpp>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ipmi
+{
+
+using HandlerTuple = std::tuple<int,                        /* prio */
+                                Privilege, HandlerBase::ptr /* handler */
+                                >;
+
+/* dense table of all the commands for a single NetFn, Group or Iana */
+using CmdTable = std::array<HandlerTuple, /* index is Cmd */
+                            std::numeric_limits<Cmd>::max() + 1>;
+
+/** @brief Run a request through the registered filters
+ *
+ *  @param[in] request - the request to check
+ *
+ *  @return the error response of the first filter that rejected the
+ *          request, or null if they all passed it
+ */
+message::Response::ptr filterIpmiCommand(message::Request::ptr request);
+
+/** @brief Filter a request and run it on the handler registered for it
+ *
+ *  @param[in] request - the request to run
+ *  @param[out] timing - if not null, filled in with the time spent in the
+ *                       filters and in the handler
+ *
+ *  @return the response to send back
+ */
+message::Response::ptr executeIpmiCommand(message::Request::ptr request,
+                                          stats::Timing* timing = nullptr);
+
+/** @brief Find the commands of a NetFn, or of its group extension or IANA
+ *
+ *  @param[in] netFn - NetFn of the request
+ *  @param[in] extension - Group or IANA for NetFn 2Ch and 2Eh, else ignored
+ *
+ *  @return the commands, or null if nothing was registered there
+ */
+CmdTable* findCmdTable(NetFn netFn, uint32_t extension);
+
+/** @brief Pick the handler for a command, falling back to the wildcard
+ *         handler if the command has none
+ */
+HandlerTuple* chooseHandler(CmdTable* handlers, Cmd cmd);
+
+/** @struct Registrations
+ *  @brief Handlers and filters of one provider, taken out of the tables
+ */
+struct Registrations
+{
+    struct Handler
+    {
+        CmdTable* table;
+        Cmd cmd;
+        HandlerTuple item;
+    };
+    std::vector<Handler> handlers;
+    std::vector<std::tuple<int, FilterBase::ptr>> filters;
+};
+
+/** @brief Note the provider the handlers and filters registered from now
+ *         on belong to, so that they can be taken out when it is reloaded
+ *
+ *  @param[in] provider - path of the provider being opened, or empty once
+ *                        it is open
+ */
+void setRegistrant(const std::string& provider);
+
+/** @brief Take the handlers and filters of a provider out of the tables
+ *
+ *  Requests for its commands get ccInvalidCommand from then on, or go to
+ *  the handler of another provider if one was registered later at a
+ *  higher priority. Requests already running keep their handler.
+ *
+ *  @param[in] provider - path the provider was opened from
+ *
+ *  @return what was taken out
+ */
+Registrations takeRegistrations(const std::string& provider);
+
+/** @brief Put back what takeRegistrations() took out
+ *
+ *  Used when the provider could not be unloaded after all. A command that
+ *  another provider registered in the meantime keeps that handler.
+ *
+ *  @param[in] provider - path the provider was opened from
+ *  @param[in] taken - what takeRegistrations() returned
+ */
+void restoreRegistrations(const std::string& provider, Registrations&& taken);
+
+/** @brief Destroy all the handlers and filters
+ *
+ *  Called before the providers are unloaded, so that none of their code
+ *  is left to run.
+ */
+void clearHandlers();
+
+} // namespace ipmi
@@ -2,25 +2,24 @@
 
 #include <systemd/sd-bus.h>
 
-#include <array>
-#include <map>
-#include <string>
-#include <vector>
+#include <ipmid/const-table.hpp>
+#include <string_view>
 
 struct IPMIFruData
 {
-    std::string section;
-    std::string property;
-    std::string delimiter;
+    std::string_view section;
+    std::string_view property;
+    std::string_view delimiter;
 };
 
-using DbusProperty = std::string;
-using DbusPropertyVec = std::vector<std::pair<DbusProperty, IPMIFruData>>;
+using DbusProperty = std::string_view;
+using DbusPropertyVec = ipmi::ConstTable<std::pair<DbusProperty, IPMIFruData>>;
 
-using DbusInterface = std::string;
-using DbusInterfaceVec = std::vector<std::pair<DbusInterface, DbusPropertyVec>>;
+using DbusInterface = std::string_view;
+using DbusInterfaceVec =
+    ipmi::ConstTable<std::pair<DbusInterface, DbusPropertyVec>>;
 
-using FruInstancePath = std::string;
+using FruInstancePath = std::string_view;
 
 struct FruInstance
 {
@@ -30,7 +29,7 @@ struct FruInstance
     DbusInterfaceVec interfaces;
 };
 
-using FruInstanceVec = std::vector<FruInstance>;
+using FruInstanceVec = ipmi::ConstTable<FruInstance>;
 
 using FruId = uint32_t;
-using FruMap = std::map<FruId, FruInstanceVec>;
+using FruMap = ipmi::ConstMap<FruId, FruInstanceVec>;
@@ -9,7 +9,7 @@ fi
 cat << EOF
 #include <ipmiwhitelist.hpp>
 
-const std::vector<netfncmd_pair> whitelist = {
+constexpr WhitelistBitmap whitelist = makeWhitelist({
 
 EOF
 
@@ -23,5 +23,5 @@ cat $* | sed "s/#.*//" | sed '/^$/d' | sort -n | uniq | sed "s/^/    { /" | \
     sed "s/\:\(....\)\(.*\)/ , \1 }, \2/"
 
 cat << EOF
-};
+});
 EOF
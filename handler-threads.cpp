@@ -0,0 +1,261 @@
+#include "config.h"
+
+#include "handler-threads.hpp"
+
+#include <exception>
+#include <ipmid/api.hpp>
+#include <ipmid/dbus-stats.hpp>
+#include <memory>
+#include <user_channel/channel_layer.hpp>
+
+#ifdef ENABLE_HANDLER_THREADS
+#include <array>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <system_error>
+#endif
+
+#ifdef ENABLE_HANDLER_THREADS
+// present in libipmid, but only for the worker threads to use
+extern void setWorkerThread(bool worker);
+#endif
+
+namespace ipmi
+{
+namespace threads
+{
+
+#ifdef ENABLE_HANDLER_THREADS
+
+namespace
+{
+
+using Strand = boost::asio::strand<boost::asio::thread_pool::executor_type>;
+
+std::unique_ptr<boost::asio::thread_pool> workers;
+
+/* one strand per channel keeps the requests of a channel in order while
+ * letting the channels run in parallel */
+std::array<std::unique_ptr<Strand>, maxIpmiChannels> strands;
+
+/* set on a worker while it runs a handler or blocking work */
+thread_local bool onWorker = false;
+
+/* private connection of a worker, for the legacy handlers that call
+ * ipmid_get_sd_bus_connection(); sd-bus connections can't be shared
+ * between threads */
+struct WorkerBus
+{
+    ~WorkerBus()
+    {
+        sd_bus_flush_close_unref(bus);
+    }
+    sd_bus* bus = nullptr;
+};
+thread_local WorkerBus workerBus;
+
+/* marks the worker for getWorkerBus() and getSdBus() while it runs work,
+ * and attributes its blocking calls to the command of the request */
+class Marked
+{
+  public:
+    explicit Marked(const Context& ctx) :
+        command(ctx.netFn, ctx.cmd, ctx.channel, ctx.requestId)
+    {
+        onWorker = true;
+        setWorkerThread(true);
+    }
+    ~Marked()
+    {
+        setWorkerThread(false);
+        onWorker = false;
+    }
+
+    Marked(const Marked&) = delete;
+    Marked& operator=(const Marked&) = delete;
+
+  private:
+    dbus_stats::CommandScope command;
+};
+
+Strand& getStrand(int channel)
+{
+    if (channel < 0 || channel >= static_cast<int>(strands.size()))
+    {
+        channel = 0;
+    }
+    return *strands[channel];
+}
+
+/* run work on the executor and suspend the coroutine until it is done */
+template <typename Executor>
+std::exception_ptr waitFor(Executor& executor,
+                           boost::asio::yield_context* yield,
+                           const std::function<void()>& work)
+{
+    std::shared_ptr<boost::asio::io_context> io = getIoContext();
+
+    // the timer never expires on its own; the worker cancels it from the
+    // main thread once the work has returned
+    boost::asio::steady_timer done(
+        *io, boost::asio::steady_timer::time_point::max());
+    std::exception_ptr error;
+
+    boost::asio::post(executor, [&]() {
+        try
+        {
+            work();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        boost::asio::post(*io, [&done]() { done.cancel(); });
+    });
+
+    boost::system::error_code ec;
+    done.async_wait((*yield)[ec]);
+    return error;
+}
+
+} // namespace
+
+void initialize(size_t count)
+{
+    if (!count)
+    {
+        return;
+    }
+    workers = std::make_unique<boost::asio::thread_pool>(count);
+    for (auto& strand : strands)
+    {
+        strand = std::make_unique<Strand>(workers->get_executor());
+    }
+}
+
+void shutdown()
+{
+    if (!workers)
+    {
+        return;
+    }
+    workers->join();
+    for (auto& strand : strands)
+    {
+        strand.reset();
+    }
+    workers.reset();
+}
+
+bool offload(const HandlerBase::ptr& handler,
+             const message::Request::ptr& request)
+{
+    return workers && (handler->threadSafe() || handler->blocking()) &&
+           request->ctx->yield;
+}
+
+message::Response::ptr execute(HandlerBase::ptr handler,
+                               message::Request::ptr request)
+{
+    boost::asio::yield_context* yield = request->ctx->yield;
+    message::Response::ptr response;
+
+    // the yield context belongs to the main thread; the handler must not
+    // use it, so hide it for the duration of the call
+    request->ctx->yield = nullptr;
+    std::exception_ptr error;
+    auto run = [&]() {
+        Marked marked(*request->ctx);
+        response = handler->call(request);
+    };
+    if (handler->blocking())
+    {
+        error = waitFor(*workers, yield, run);
+    }
+    else
+    {
+        error = waitFor(getStrand(request->ctx->channel), yield, run);
+    }
+    request->ctx->yield = yield;
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return response;
+}
+
+void runBlocking(const Context::ptr& ctx, const std::function<void()>& work)
+{
+    if (!workers || !ctx || !ctx->yield)
+    {
+        work();
+        return;
+    }
+    // not on a channel strand, so that the slow work doesn't hold up the
+    // thread-safe handlers of that channel
+    if (std::exception_ptr error = waitFor(*workers, ctx->yield, [&]() {
+            Marked marked(*ctx);
+            work();
+        }))
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+sd_bus* getWorkerBus()
+{
+    if (!onWorker)
+    {
+        return nullptr;
+    }
+    if (!workerBus.bus)
+    {
+        int r = sd_bus_open_system(&workerBus.bus);
+        if (r < 0)
+        {
+            workerBus.bus = nullptr;
+            throw std::system_error(-r, std::generic_category(),
+                                    "sd_bus_open_system");
+        }
+    }
+    return workerBus.bus;
+}
+
+#else // !ENABLE_HANDLER_THREADS
+
+void initialize(size_t)
+{
+}
+
+void shutdown()
+{
+}
+
+bool offload(const HandlerBase::ptr&, const message::Request::ptr&)
+{
+    return false;
+}
+
+message::Response::ptr execute(HandlerBase::ptr handler,
+                               message::Request::ptr request)
+{
+    return handler->call(request);
+}
+
+void runBlocking(const Context::ptr&, const std::function<void()>& work)
+{
+    work();
+}
+
+sd_bus* getWorkerBus()
+{
+    return nullptr;
+}
+
+#endif // ENABLE_HANDLER_THREADS
+
+} // namespace threads
+} // namespace ipmi
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <systemd/sd-bus.h>
+
+#include <cstddef>
+#include <functional>
+#include <ipmid/handler.hpp>
+#include <ipmid/message.hpp>
+
+namespace ipmi
+{
+namespace threads
+{
+
+/** @brief Start the worker threads for thread-safe handlers
+ *
+ *  Does nothing unless ipmid was built with --enable-handler-threads.
+ *
+ *  @param[in] count - number of worker threads; 0 keeps every handler on
+ *                     the main thread
+ */
+void initialize(size_t count);
+
+/** @brief Finish the outstanding work and join the worker threads */
+void shutdown();
+
+/** @brief Check if a handler should be run on a worker thread
+ *
+ *  @param[in] handler - the handler chosen for the request
+ *  @param[in] request - the request to run
+ *
+ *  @return true if the workers are running, the handler was registered as
+ *          thread-safe or blocking and the request has a coroutine to wait
+ *          in
+ */
+bool offload(const HandlerBase::ptr& handler,
+             const message::Request::ptr& request);
+
+/** @brief Run a handler on a worker thread
+ *
+ *  The calling coroutine is suspended until the handler finishes, so the
+ *  main thread keeps serving other requests in the meantime. Thread-safe
+ *  handlers run on the worker strand for the request channel, so requests
+ *  from the same channel run in order, one at a time. Blocking handlers
+ *  run on any free worker, so that they don't hold up the channel.
+ *
+ *  @param[in] handler - the handler chosen for the request
+ *  @param[in] request - the request to run
+ *
+ *  @return the response from the handler
+ */
+message::Response::ptr execute(HandlerBase::ptr handler,
+                               message::Request::ptr request);
+
+/** @brief Run blocking work of a handler on a worker thread
+ *
+ *  For handlers that stay on the main thread but have one slow step, such
+ *  as a PAM call. The request suspends until the work returns, so the main
+ *  thread keeps serving other requests in the meantime. The work must not
+ *  touch state shared with the main thread. Without worker threads, or
+ *  without a coroutine to wait in, the work runs in place.
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] work - the work to run; exceptions are passed on to the caller
+ */
+void runBlocking(const Context::ptr& ctx, const std::function<void()>& work);
+
+/** @brief Get the private D-Bus connection of the current worker thread
+ *
+ *  The connection is opened on first use and closed when the thread exits.
+ *
+ *  @return the connection, or nullptr when not called from a blocking
+ *          handler on a worker thread
+ */
+sd_bus* getWorkerBus();
+
+} // namespace threads
+} // namespace ipmi
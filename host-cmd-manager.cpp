@@ -4,6 +4,7 @@
 
 #include "systemintfcmds.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <ipmid/utils.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -23,7 +24,7 @@ namespace command
 constexpr auto MAPPER_BUSNAME = "xyz.openbmc_project.ObjectMapper";
 constexpr auto MAPPER_PATH = "/xyz/openbmc_project/object_mapper";
 constexpr auto MAPPER_INTERFACE = "xyz.openbmc_project.ObjectMapper";
-constexpr auto HOST_STATE_PATH = "/xyz/openbmc_project/state/host0";
+constexpr auto HOST_STATE_ROOT = "/xyz/openbmc_project/state/" HOST_NAME;
 constexpr auto HOST_STATE_INTERFACE = "xyz.openbmc_project.State.Host";
 constexpr auto HOST_TRANS_PROP = "RequestedHostTransition";
 
@@ -34,16 +35,42 @@ using InternalFailure =
 
 namespace sdbusRule = sdbusplus::bus::match::rules;
 
-Manager::Manager(sdbusplus::bus::bus& bus) :
-    bus(bus), timer(std::bind(&Manager::hostTimeout, this)),
+// the bridges of the hosts are numbered from 1
+Manager::Manager(sdbusplus::bus::bus& bus, size_t host) :
+    bus(bus), ipmiPath("/org/openbmc/HostIpmi/" + std::to_string(host + 1)),
+    hostStatePath(HOST_STATE_ROOT + std::to_string(host)),
+    timer(std::bind(&Manager::hostTimeout, this)),
     hostTransitionMatch(
         bus,
-        sdbusRule::propertiesChanged(HOST_STATE_PATH, HOST_STATE_INTERFACE),
+        sdbusRule::propertiesChanged(hostStatePath, HOST_STATE_INTERFACE),
         std::bind(&Manager::clearQueueOnPowerOn, this, std::placeholders::_1))
 {
     // Nothing to do here.
 }
 
+int Manager::priority(const IpmiCmdData& command)
+{
+    // the host must not be kept running by the commands queued ahead of a
+    // soft off, and a heartbeat only matters when nothing else is sent
+    switch (command.first)
+    {
+        case CMD_POWER:
+            return 0;
+        case CMD_HEARTBEAT:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+void Manager::complete(const Entry& entry, bool status)
+{
+    for (const auto& callback : entry.callbacks)
+    {
+        callback(entry.command, status);
+    }
+}
+
 // Called as part of READ_MSG_DATA command
 IpmiCmdData Manager::getNextCommand()
 {
@@ -64,17 +91,27 @@ IpmiCmdData Manager::getNextCommand()
         return std::make_pair(CMD_HEARTBEAT, 0x00);
     }
 
-    // Pop the processed entry off the queue
-    auto command = this->workQueue.front();
-    this->workQueue.pop();
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - alertTime);
+    stats.commands++;
+    stats.totalLatency += latency;
+    stats.maxLatency = std::max(stats.maxLatency, latency);
+    log<level::DEBUG>("Host read command",
+                      entry("LATENCY_US=%lld",
+                            static_cast<long long>(latency.count())),
+                      entry("QUEUED=%zu", this->workQueue.size() - 1));
 
-    // IPMI command is the first element in pair
-    auto ipmiCmdData = std::get<0>(command);
+    // Pop the processed entry off the queue
+    auto command = std::move(this->workQueue.front());
+    this->workQueue.pop_front();
 
     // Now, call the user registered functions so that
     // implementation specific CommandComplete signals
     // can be sent. `true` indicating Success.
-    std::get<CallBack>(command)(ipmiCmdData, true);
+    complete(command, true);
+
+    // IPMI command is the first element in pair
+    auto ipmiCmdData = command.command;
 
     // Check for another entry in the queue and kick it off
     this->checkQueueAndAlertHost();
@@ -96,15 +133,12 @@ void Manager::clearQueue()
     // Dequeue all entries and send fail signal
     while (!this->workQueue.empty())
     {
-        auto command = this->workQueue.front();
-        this->workQueue.pop();
-
-        // IPMI command is the first element in pair
-        auto ipmiCmdData = std::get<0>(command);
+        auto command = std::move(this->workQueue.front());
+        this->workQueue.pop_front();
 
         // Call the implementation specific Command Failure.
         // `false` indicating Failure
-        std::get<CallBack>(command)(ipmiCmdData, false);
+        complete(command, false);
     }
 }
 
@@ -115,11 +149,6 @@ void Manager::checkQueueAndAlertHost()
     {
         log<level::DEBUG>("Asserting SMS Attention");
 
-        std::string IPMI_PATH("/org/openbmc/HostIpmi/1");
-        std::string IPMI_INTERFACE("org.openbmc.HostIpmi");
-
-        auto host = ::ipmi::getService(this->bus, IPMI_INTERFACE, IPMI_PATH);
-
         // Start the timer for this transaction
         auto time = std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::seconds(IPMI_SMS_ATN_ACK_TIMEOUT_SECS));
@@ -130,28 +159,82 @@ void Manager::checkQueueAndAlertHost()
             log<level::ERR>("Error starting timer for control host");
             return;
         }
+        alertTime = Clock::now();
 
-        auto method =
-            this->bus.new_method_call(host.c_str(), IPMI_PATH.c_str(),
-                                      IPMI_INTERFACE.c_str(), "setAttention");
-        auto reply = this->bus.call(method);
+        setAttention();
+    }
+}
 
-        if (reply.is_method_error())
-        {
-            log<level::ERR>("Error in setting SMS attention");
-            elog<InternalFailure>();
-        }
-        log<level::DEBUG>("SMS Attention asserted");
+void Manager::setAttention()
+{
+    std::string IPMI_INTERFACE("org.openbmc.HostIpmi");
+
+    auto host = ::ipmi::getService(this->bus, IPMI_INTERFACE, ipmiPath);
+
+    auto method = this->bus.new_method_call(host.c_str(), ipmiPath.c_str(),
+                                            IPMI_INTERFACE.c_str(),
+                                            "setAttention");
+    auto reply = this->bus.call(method);
+
+    if (reply.is_method_error())
+    {
+        log<level::ERR>("Error in setting SMS attention");
+        elog<InternalFailure>();
+    }
+    log<level::DEBUG>("SMS Attention asserted");
+}
+
+void Manager::alertEvents()
+{
+    if (!this->workQueue.empty())
+    {
+        // the host reads the events once it has read the commands
+        return;
+    }
+    try
+    {
+        setAttention();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to alert the host of event messages",
+                        entry("PATH=%s", ipmiPath.c_str()),
+                        entry("ERROR=%s", e.what()));
     }
 }
 
 // Called by specific implementations that provide commands
 void Manager::execute(CommandHandler command)
 {
-    log<level::DEBUG>("Pushing cmd on to queue",
-                      entry("COMMAND=%d", std::get<0>(command).first));
+    const auto& ipmiCmdData = std::get<IpmiCmdData>(command);
+    auto& callback = std::get<CallBack>(command);
+
+    // the host hasn't read the same command yet, so let it carry this one
+    auto pending = std::find_if(
+        this->workQueue.begin(), this->workQueue.end(),
+        [&](const Entry& entry) { return entry.command == ipmiCmdData; });
+    if (pending != this->workQueue.end())
+    {
+        log<level::DEBUG>("Command already queued",
+                          entry("COMMAND=%d", ipmiCmdData.first));
+        pending->callbacks.emplace_back(std::move(callback));
+        stats.coalesced++;
+        return;
+    }
 
-    this->workQueue.emplace(command);
+    log<level::DEBUG>("Pushing cmd on to queue",
+                      entry("COMMAND=%d", ipmiCmdData.first));
+
+    // behind everything of the same or a higher priority
+    int cmdPriority = priority(ipmiCmdData);
+    auto position = std::find_if(
+        this->workQueue.begin(), this->workQueue.end(),
+        [&](const Entry& entry) {
+            return priority(entry.command) > cmdPriority;
+        });
+    this->workQueue.insert(position,
+                           Entry{ipmiCmdData, {std::move(callback)}});
+    stats.peakDepth = std::max(stats.peakDepth, this->workQueue.size());
 
     // Alert host if this is only command in queue otherwise host will
     // be notified of next message after processing the current one
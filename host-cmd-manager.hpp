@@ -1,11 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <deque>
 #include <ipmid-host/cmd-utils.hpp>
-#include <queue>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/timer.hpp>
+#include <string>
 #include <tuple>
+#include <vector>
 
 namespace phosphor
 {
@@ -14,8 +17,27 @@ namespace host
 namespace command
 {
 
+/** @struct QueueStats
+ *  @brief Counters of the commands that went through the Manager
+ *
+ *  The latencies are from asserting SMS_ATN to the host reading the command.
+ */
+struct QueueStats
+{
+    uint64_t commands = 0;
+    uint64_t coalesced = 0;
+    size_t peakDepth = 0;
+    std::chrono::microseconds totalLatency{};
+    std::chrono::microseconds maxLatency{};
+};
+
 /** @class
  *  @brief Manages commands that are to be sent to Host
+ *
+ *  The commands are sent in order of priority, a soft off before anything
+ *  else and heartbeats last, and in the order they came within a priority.
+ *  A command that is the same as one still waiting for the host is not
+ *  queued again; both callbacks get the result of the one that is sent.
  */
 class Manager
 {
@@ -30,9 +52,9 @@ class Manager
     /** @brief Constructs Manager object
      *
      *  @param[in] bus   - dbus handler
-     *  @param[in] event - pointer to sd_event
+     *  @param[in] host  - instance of the host the commands are for
      */
-    explicit Manager(sdbusplus::bus::bus& bus);
+    explicit Manager(sdbusplus::bus::bus& bus, size_t host = 0);
 
     /** @brief  Extracts the next entry in the queue and returns
      *          Command and data part of it.
@@ -51,16 +73,57 @@ class Manager
      *
      *  @detail If the queue is empty, then it alerts the Host. If not,
      *          then it returns and the API documented above will handle
-     *          the commands in Queue.
+     *          the commands in Queue. If the same command is already in
+     *          the queue, then the callback is added to that one instead.
      *
      *  @param[in] command - tuple of <IPMI command, data, callback>
      */
     void execute(CommandHandler command);
 
+    /** @brief true while commands are waiting for the host to read them */
+    bool hasCommands() const
+    {
+        return !workQueue.empty();
+    }
+
+    /** @brief Alert the host that event messages are waiting for it
+     *
+     *  @detail Asserts SMS_ATN, unless a queued command has it asserted
+     *          already. The host only gets the events when no command is
+     *          waiting, so there is no timeout for them.
+     */
+    void alertEvents();
+
+    /** @brief Get the counters of the commands sent to the host */
+    const QueueStats& getStats() const
+    {
+        return stats;
+    }
+
   private:
+    using Clock = std::chrono::steady_clock;
+
+    /** @struct Entry
+     *  @brief A queued command and everyone waiting for its result
+     */
+    struct Entry
+    {
+        IpmiCmdData command;
+        std::vector<CallBack> callbacks;
+    };
+
+    /** @brief Get the priority of a command, lower goes first */
+    static int priority(const IpmiCmdData& command);
+
+    /** @brief Call the callbacks of an entry with the result */
+    static void complete(const Entry& entry, bool status);
+
     /** @brief Check if anything in queue and alert host if so */
     void checkQueueAndAlertHost();
 
+    /** @brief Assert SMS_ATN through the bridge of the host */
+    void setAttention();
+
     /** @brief  Call back interface on message timeouts to host.
      *
      *  @detail When this happens, a failure message would be sent
@@ -97,8 +160,20 @@ class Manager
     /** @brief Reference to the dbus handler */
     sdbusplus::bus::bus& bus;
 
-    /** @brief Queue to store the requested commands */
-    std::queue<CommandHandler> workQueue{};
+    /** @brief Object of the bridge that raises SMS_ATN to the host */
+    std::string ipmiPath;
+
+    /** @brief Object of the state of the host */
+    std::string hostStatePath;
+
+    /** @brief Queue to store the requested commands, in priority order */
+    std::deque<Entry> workQueue{};
+
+    /** @brief When SMS_ATN was last asserted */
+    Clock::time_point alertTime{};
+
+    /** @brief Counters of the commands sent to the host */
+    QueueStats stats{};
 
     /** @brief Timer for commands to host */
     phosphor::Timer timer;
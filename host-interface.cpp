@@ -47,14 +47,15 @@ void Host::execute(Base::Host::Command command)
 
     log<level::DEBUG>(
         "Pushing cmd on to queue",
-        entry("CONTROL_HOST_CMD=%s", convertForMessage(command).c_str()));
+        entry("CONTROL_HOST_CMD=%s", convertForMessage(command).c_str()),
+        entry("HOST=%zu", host));
 
     auto cmd = std::make_tuple(ipmiCommand.at(command),
                                std::bind(&Host::commandStatusHandler, this,
                                          std::placeholders::_1,
                                          std::placeholders::_2));
 
-    return ipmid_send_cmd_to_host(std::move(cmd));
+    return ipmid_send_cmd_to_host(host, std::move(cmd));
 }
 
 // Called into by Command Manager
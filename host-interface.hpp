@@ -23,12 +23,13 @@ class Host : public sdbusplus::server::object::object<
      *
      *  @param[in] bus     - The Dbus bus object
      *  @param[in] objPath - The Dbus object path
+     *  @param[in] host    - Instance of the host the commands are for
      */
-    Host(sdbusplus::bus::bus& bus, const char* objPath) :
+    Host(sdbusplus::bus::bus& bus, const char* objPath, size_t host = 0) :
         sdbusplus::server::object::object<
             sdbusplus::xyz::openbmc_project::Control::server::Host>(bus,
                                                                     objPath),
-        bus(bus)
+        bus(bus), host(host)
     {
         // Nothing to do
     }
@@ -45,6 +46,9 @@ class Host : public sdbusplus::server::object::object<
     /** @brief sdbusplus DBus bus connection. */
     sdbusplus::bus::bus& bus;
 
+    /** @brief Instance of the host the commands are queued for */
+    size_t host;
+
     /** @brief  Callback function to be invoked by command manager
      *
      *  @detail Conveys the status of the last Host bound command.
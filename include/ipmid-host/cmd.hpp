@@ -1,8 +1,12 @@
+#include <cstddef>
 #include <ipmid-host/cmd-utils.hpp>
 #include <memory>
 #include <sdbusplus/asio/connection.hpp>
 
-// Global Host Bound Command manager
+// Global Host Bound Command manager, for host0
 extern void ipmid_send_cmd_to_host(phosphor::host::command::CommandHandler&&);
+// Host Bound Command manager of one host of a multi-host system
+extern void ipmid_send_cmd_to_host(size_t host,
+                                   phosphor::host::command::CommandHandler&&);
 extern std::unique_ptr<sdbusplus::asio::connection>&
     ipmid_get_sdbus_plus_handler();
@@ -32,9 +32,35 @@
 // any client can interact with the main asio context
 std::shared_ptr<boost::asio::io_context> getIoContext();
 
-// any client can interact with the main sdbus
+// any client on the main thread can interact with the main sdbus; it
+// throws std::logic_error on a handler worker thread, see HandlerFlags
 std::shared_ptr<sdbusplus::asio::connection> getSdBus();
 
+/**
+ * @brief get the connection for blocking D-Bus calls
+ *
+ * On the main thread this is the connection of getSdBus(), so the blocking
+ * calls share it with the async calls, the matches and the caches. A handler
+ * on a worker thread gets a connection of that thread instead, see
+ * HandlerFlags. Use it rather than wrapping ipmid_get_sd_bus_connection()
+ * in a new sdbusplus::bus::bus for every call.
+ */
+sdbusplus::bus::bus& getBus();
+
+/**
+ * @brief declare that a provider library may be reloaded
+ *
+ * Put it, at namespace scope, in a provider whose only registrations are
+ * its handlers, filters and cache_stats reporters, which a reload takes out
+ * before it unloads the library. D-Bus matches, signal handlers, oem::Router
+ * handlers, posted work and warm-up tasks would be left pointing into the
+ * unloaded code, so a provider that keeps any of them must not declare it;
+ * ipmid refuses to reload a provider that doesn't.
+ */
+#define IPMI_PROVIDER_RELOADABLE                                               \
+    extern "C" __attribute__((visibility("default"), used)) const int          \
+        ipmiProviderReloadable = 1
+
 /**
  * @brief post some work to the async exection queue
  *
@@ -84,3 +110,25 @@ enum class SignalResponse : int
  */
 void registerSignalHandler(int priority, int signalNumber,
                            const std::function<SignalResponse(int)>& handler);
+
+/**
+ * @brief add a signal handler that runs as its own job
+ *
+ * The same as registerSignalHandler, except that when the chain reaches this
+ * handler, the handler and the rest of the chain are posted to the execution
+ * queue instead of running right away, so that heavier work such as flushing
+ * state does not hold up everything else. The chain keeps its priority
+ * order.
+ *
+ * Once a chain has been running for longer than a second, the deferred
+ * handlers left in it are skipped, so that a slow one cannot hold up a
+ * shutdown; the others still run. Any handler that takes longer than 100ms
+ * is logged.
+ *
+ * @param int - priority of handler
+ * @param int - signal number to wait for
+ * @param handler - the callback function to be executed
+ */
+void registerDeferredSignalHandler(
+    int priority, int signalNumber,
+    const std::function<SignalResponse(int)>& handler);
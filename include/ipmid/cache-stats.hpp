@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ipmi
+{
+namespace cache_stats
+{
+
+/** @struct Usage
+ *  @brief Size of one cache
+ *
+ *  bytes estimates the heap the entries take: the container nodes, the
+ *  strings and buffers they own, but not what sd-bus keeps for a match.
+ */
+struct Usage
+{
+    size_t entries = 0;
+    size_t bytes = 0;
+    // most entries kept before the least recently used one is evicted;
+    // 0 if the cache is bounded by the configuration instead
+    size_t limit = 0;
+    uint64_t evictions = 0;
+};
+
+/* a plain function rather than a std::function, so that nothing of a
+ * provider is left in the registry to destroy once it has been unloaded */
+using Reporter = Usage (*)();
+
+using Entry = std::tuple<std::string, // name
+                         uint32_t,    // entries
+                         uint64_t,    // bytes
+                         uint32_t,    // limit
+                         uint64_t>;   // evictions
+
+/** @brief Register a cache to be reported
+ *
+ *  Registering the same name again replaces the reporter.
+ *
+ *  @param[in] name - name to report the cache under
+ *  @param[in] reporter - function that measures the cache
+ */
+void registerCache(const std::string& name, Reporter reporter);
+
+/** @brief Stop reporting the caches picked by their reporter
+ *
+ *  A provider that is unloaded while ipmid runs has its reporters taken
+ *  out first.
+ *
+ *  @param[in] pick - called for each reporter; true to take it out
+ *
+ *  @return how many were taken out
+ */
+size_t unregisterCaches(const std::function<bool(Reporter)>& pick);
+
+/** @brief Measure every registered cache, sorted by name */
+std::vector<Entry> get();
+
+/** @brief Heap bytes owned by a string, 0 if it is stored inline */
+inline size_t heapBytes(const std::string& s)
+{
+    const char* data = s.data();
+    const char* object = reinterpret_cast<const char*>(&s);
+    if (data >= object && data < object + sizeof(s))
+    {
+        return 0;
+    }
+    return s.capacity() + 1;
+}
+
+} // namespace cache_stats
+} // namespace ipmi
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace ipmi
+{
+
+/** @class ConstTable
+ *  @brief Read-only view of a table emitted by the code generators.
+ *  @details The entries are constant-initialized arrays in the generated
+ *           code, so the tables take no work at startup and no heap.
+ */
+template <typename T>
+class ConstTable
+{
+  public:
+    using value_type = T;
+    using const_iterator = const T*;
+    using iterator = const_iterator;
+
+    constexpr ConstTable() = default;
+
+    template <size_t N>
+    constexpr ConstTable(const T (&entries)[N]) : first(entries), length(N)
+    {
+    }
+
+    constexpr const_iterator begin() const
+    {
+        return first;
+    }
+
+    constexpr const_iterator end() const
+    {
+        return first + length;
+    }
+
+    constexpr size_t size() const
+    {
+        return length;
+    }
+
+    constexpr bool empty() const
+    {
+        return length == 0;
+    }
+
+    constexpr const T& operator[](size_t index) const
+    {
+        return first[index];
+    }
+
+  private:
+    const T* first = nullptr;
+    size_t length = 0;
+};
+
+/** @class ConstMap
+ *  @brief ConstTable of key/value pairs sorted by key.
+ *  @details Looked up like the std::map it stands in for, by a binary
+ *           search; the generators emit the entries in key order.
+ */
+template <typename Key, typename T>
+class ConstMap : public ConstTable<std::pair<const Key, T>>
+{
+  public:
+    using Base = ConstTable<std::pair<const Key, T>>;
+    using key_type = Key;
+    using mapped_type = T;
+    using typename Base::const_iterator;
+    using Base::Base;
+
+    const_iterator find(const Key& key) const
+    {
+        auto it = std::lower_bound(
+            this->begin(), this->end(), key,
+            [](const auto& entry, const Key& k) { return entry.first < k; });
+        if (it == this->end() || it->first != key)
+        {
+            return this->end();
+        }
+        return it;
+    }
+
+    size_t count(const Key& key) const
+    {
+        return find(key) != this->end() ? 1 : 0;
+    }
+
+    const T& at(const Key& key) const
+    {
+        auto it = find(key);
+        if (it == this->end())
+        {
+            throw std::out_of_range("ConstMap::at");
+        }
+        return it->second;
+    }
+};
+
+} // namespace ipmi
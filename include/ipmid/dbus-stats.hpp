@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ipmi
+{
+namespace dbus_stats
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* Bucket N counts calls that took [2^N, 2^(N+1)) microseconds, the same
+ * scale as the command statistics of ipmid. */
+constexpr size_t histogramBuckets = 24;
+
+using Histogram = std::array<uint32_t, histogramBuckets>;
+
+/* NetFn/Cmd of calls made outside of any IPMI command */
+constexpr uint8_t noCommand = 0xFF;
+
+using Entry = std::tuple<uint8_t,     // NetFn
+                         uint8_t,     // Cmd
+                         std::string, // destination service
+                         std::string, // member
+                         uint64_t,    // count
+                         uint64_t,    // errors
+                         uint64_t,    // total time
+                         uint64_t,    // max time
+                         std::vector<uint32_t>>; // histogram
+
+/** @struct Command
+ *  @brief The request that blocking calls are attributed to
+ */
+struct Command
+{
+    uint8_t netFn = noCommand;
+    uint8_t cmd = noCommand;
+    uint8_t channel = noCommand;
+    uint32_t requestId = 0;
+};
+
+/** @brief Set the IPMI command that blocking calls are attributed to
+ *
+ *  The dispatcher sets this around each handler, with a CommandScope;
+ *  calls that take the request context are attributed from the context
+ *  instead. Each thread has its own.
+ *
+ *  @param[in] netFn - NetFn of the command or noCommand
+ *  @param[in] cmd - Cmd of the command or noCommand
+ *  @param[in] channel - channel of the request, for the tracepoints
+ *  @param[in] requestId - ID of the request, for the tracepoints
+ */
+void setCommand(uint8_t netFn, uint8_t cmd, uint8_t channel = noCommand,
+                uint32_t requestId = 0);
+
+/** @brief Get the command set by setCommand() */
+Command getCommand();
+
+/** @class CommandScope
+ *  @brief Sets the command for as long as a handler runs, and clears it
+ *         again even if the handler throws
+ */
+class CommandScope
+{
+  public:
+    CommandScope(uint8_t netFn, uint8_t cmd, uint8_t channel = noCommand,
+                 uint32_t requestId = 0)
+    {
+        setCommand(netFn, cmd, channel, requestId);
+    }
+    ~CommandScope()
+    {
+        setCommand(noCommand, noCommand);
+    }
+
+    CommandScope(const CommandScope&) = delete;
+    CommandScope& operator=(const CommandScope&) = delete;
+};
+
+/** @brief Account one completed call to the current command
+ *
+ *  @param[in] service - destination of the call
+ *  @param[in] member - method that was called
+ *  @param[in] elapsed - time from sending the call to its reply
+ *  @param[in] failed - whether the call failed
+ */
+void record(const std::string& service, const std::string& member,
+            Clock::duration elapsed, bool failed);
+
+/** @brief Account one completed call to the given command
+ *
+ *  @param[in] netFn - NetFn of the command that made the call
+ *  @param[in] cmd - Cmd of the command that made the call
+ *  @param[in] service - destination of the call
+ *  @param[in] member - method that was called
+ *  @param[in] elapsed - time from sending the call to its reply
+ *  @param[in] failed - whether the call failed
+ */
+void record(uint8_t netFn, uint8_t cmd, const std::string& service,
+            const std::string& member, Clock::duration elapsed, bool failed);
+
+/** @brief Get the accounted calls, sorted by command, service and member
+ *
+ *  All times are in microseconds.
+ */
+std::vector<Entry> get();
+
+/** @brief Drop all of the accounted calls */
+void reset();
+
+} // namespace dbus_stats
+} // namespace ipmi
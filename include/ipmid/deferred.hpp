@@ -0,0 +1,83 @@
+#pragma once
+
+#include <functional>
+#include <ipmid/api.hpp>
+#include <ipmid/warmup.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace ipmi
+{
+
+/** @class Deferred
+ *  @brief Global state of a provider that is built on first use
+ *  @details A provider global whose constructor makes D-Bus calls (a
+ *           settings::Objects, say) would otherwise run them while the
+ *           provider is opened, before ipmid has claimed its bus name, and
+ *           a failure there takes the whole daemon down. A Deferred builds
+ *           the object on first use instead, or in the cache warm-up once
+ *           ipmid is running if prefetch() was called. If building it
+ *           throws, the caller gets the exception and the next use tries
+ *           again.
+ *
+ *           All use must be from the main thread.
+ */
+template <typename T>
+class Deferred
+{
+  public:
+    using Factory = std::function<std::unique_ptr<T>()>;
+
+    explicit Deferred(Factory factory) : factory(std::move(factory))
+    {
+    }
+
+    Deferred(const Deferred&) = delete;
+    Deferred& operator=(const Deferred&) = delete;
+
+    /** @brief get the object, building it if it doesn't exist yet */
+    T& get()
+    {
+        if (!object)
+        {
+            object = factory();
+        }
+        return *object;
+    }
+
+    T& operator*()
+    {
+        return get();
+    }
+
+    T* operator->()
+    {
+        return &get();
+    }
+
+    /** @brief true once the object has been built */
+    bool ready() const
+    {
+        return object != nullptr;
+    }
+
+    /** @brief build the object in the warm-up once ipmid is running
+     *
+     *  Typically called from the provider constructor, so that the first
+     *  request doesn't pay for it. A failure is logged and left for the
+     *  first use to retry.
+     *
+     *  @param[in] name - what the object is, for the log
+     */
+    void prefetch(const std::string& name = "provider state")
+    {
+        warmup::add(name, [this](Context::ptr) { get(); });
+    }
+
+  private:
+    Factory factory;
+    std::unique_ptr<T> object;
+};
+
+} // namespace ipmi
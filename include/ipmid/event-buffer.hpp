@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ipmid/cache-stats.hpp>
+
+namespace ipmi
+{
+namespace events
+{
+
+/** @brief Size of an event message, the SEL event record without its
+ *         next record ID */
+constexpr size_t messageSize = 16;
+
+/** @brief An event message for the host, as Read Event Message Buffer
+ *         returns it */
+using Message = std::array<uint8_t, messageSize>;
+
+/** @brief Called on the main thread when an event is waiting for a host that
+ *         had none; a plain function, since ipmid itself sets it */
+using Notifier = void (*)(size_t host);
+
+/** @brief Queue an event message for a host
+ *
+ *  Each host has a ring of IPMI_EVENT_BUFFER_ENTRIES messages that the host
+ *  drains with Read Event Message Buffer. May be called from any thread.
+ *
+ *  @param[in] host - the host the event is for
+ *  @param[in] message - the event message
+ *
+ *  @return false if the buffer of the host is disabled or full; an event
+ *          that finds it full is dropped and counted
+ */
+bool post(size_t host, const Message& message);
+
+/** @brief Take the oldest event message of a host
+ *
+ *  @param[in] host - the host that reads its buffer
+ *  @param[out] message - the event message
+ *
+ *  @return false if there is none
+ */
+bool take(size_t host, Message& message);
+
+/** @brief Number of event messages waiting for a host */
+size_t pending(size_t host);
+
+/** @brief Number of event messages dropped because the buffer of a host
+ *         was full */
+uint64_t overflows(size_t host);
+
+/** @brief Enable or disable the buffer of a host, as Set BMC Global Enables
+ *         asks; disabling it drops what is queued
+ */
+void setEnabled(size_t host, bool enable);
+
+/** @brief true if the buffer of a host takes events */
+bool enabled(size_t host);
+
+/** @brief Set the function that alerts a host of new events */
+void setNotifier(Notifier notifier);
+
+/** @brief Measure the buffers of all of the hosts for cache_stats */
+cache_stats::Usage usage();
+
+} // namespace events
+} // namespace ipmi
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <boost/asio/spawn.hpp>
 #include <boost/callable_traits.hpp>
+#include <chrono>
 #include <cstdint>
 #include <exception>
 #include <ipmid/api-types.hpp>
@@ -24,9 +25,11 @@
 #include <memory>
 #include <optional>
 #include <phosphor-logging/log.hpp>
+#include <string>
 #include <tuple>
 #include <user_channel/channel_layer.hpp>
 #include <utility>
+#include <vector>
 
 #ifdef ALLOW_DEPRECATED_API
 #include <ipmid/api.h>
@@ -54,6 +57,32 @@ static inline message::Response::ptr
     return response;
 }
 
+/**
+ * @brief Options for registering an IPMI handler
+ *
+ * threadSafe - the handler does not touch any state shared with the main
+ *              thread (the caches, the matches, the Context D-Bus helpers
+ *              or the request yield context), so when ipmid is built with
+ *              --enable-handler-threads it may run on a worker thread.
+ *              Requests from the same channel still run one at a time.
+ * blocking - the handler makes slow, synchronous calls (a PAM update or a
+ *            blocking D-Bus method call, say). With --enable-handler-threads
+ *            it runs on a worker thread of its own while the request waits,
+ *            so it only delays its own caller.
+ *
+ * On a worker thread, getBus() and ipmid_get_sd_bus_connection() return a
+ * private connection of that thread, and getSdBus() throws, so a handler
+ * that reaches for the shared connection fails instead of racing the main
+ * loop. Any other state the handler shares with the main thread is still
+ * its own responsibility.
+ */
+enum class HandlerFlags : uint8_t
+{
+    none = 0,
+    threadSafe = 1 << 0,
+    blocking = 1 << 1,
+};
+
 /**
  * @brief Handler base class for dealing with IPMI request/response
  *
@@ -86,6 +115,23 @@ class HandlerBase
         return executeCallback(request);
     }
 
+    /** @brief options the handler was registered with */
+    HandlerFlags flags = HandlerFlags::none;
+
+    /** @brief true if the handler may be run on a worker thread */
+    bool threadSafe() const
+    {
+        return static_cast<uint8_t>(flags) &
+               static_cast<uint8_t>(HandlerFlags::threadSafe);
+    }
+
+    /** @brief true if the handler should not run on the main thread */
+    bool blocking() const
+    {
+        return static_cast<uint8_t>(flags) &
+               static_cast<uint8_t>(HandlerFlags::blocking);
+    }
+
   private:
     /** @brief call the registered handler with the request
      *
@@ -253,7 +299,7 @@ class IpmiHandler final : public HandlerBase
         }
 
         response->cc = std::get<0>(result);
-        auto payload = std::get<1>(result);
+        auto& payload = std::get<1>(result);
         // check for optional payload
         if (payload)
         {
@@ -528,14 +574,16 @@ bool registerOemHandler(int prio, Iana iana, Cmd cmd, Privilege priv,
  * @param cmd - the IPMI command number to register
  * @param priv - the IPMI user privilige required for this command
  * @param handler - the callback function that will handle this request
+ * @param flags - options for running the handler; see HandlerFlags
  *
  * @return bool - success of registering the handler
  */
 template <typename Handler>
 bool registerHandler(int prio, NetFn netFn, Cmd cmd, Privilege priv,
-                     Handler&& handler)
+                     Handler&& handler, HandlerFlags flags = HandlerFlags::none)
 {
     auto h = ipmi::makeHandler(std::forward<Handler>(handler));
+    h->flags = flags;
     return impl::registerHandler(prio, netFn, cmd, priv, h);
 }
 
@@ -566,15 +614,18 @@ bool registerHandler(int prio, NetFn netFn, Cmd cmd, Privilege priv,
  * @param cmd - the IPMI command number to register
  * @param priv - the IPMI user privilige required for this command
  * @param handler - the callback function that will handle this request
+ * @param flags - options for running the handler; see HandlerFlags
  *
  * @return bool - success of registering the handler
  *
  */
 template <typename Handler>
 void registerGroupHandler(int prio, Group group, Cmd cmd, Privilege priv,
-                          Handler&& handler)
+                          Handler&& handler,
+                          HandlerFlags flags = HandlerFlags::none)
 {
     auto h = ipmi::makeHandler(handler);
+    h->flags = flags;
     impl::registerGroupHandler(prio, group, cmd, priv, h);
 }
 
@@ -601,18 +652,40 @@ void registerGroupHandler(int prio, Group group, Cmd cmd, Privilege priv,
  * @param cmd - the IPMI command number to register
  * @param priv - the IPMI user privilige required for this command
  * @param handler - the callback function that will handle this request
+ * @param flags - options for running the handler; see HandlerFlags
  *
  * @return bool - success of registering the handler
  *
  */
 template <typename Handler>
 void registerOemHandler(int prio, Iana iana, Cmd cmd, Privilege priv,
-                        Handler&& handler)
+                        Handler&& handler,
+                        HandlerFlags flags = HandlerFlags::none)
 {
     auto h = ipmi::makeHandler(handler);
+    h->flags = flags;
     impl::registerOemHandler(prio, iana, cmd, priv, h);
 }
 
+/**
+ * @brief cache the successful responses of an idempotent command
+ *
+ * Once registered, the dispatcher answers a repeated request (same channel
+ * and request data) from the cache instead of calling the handler again,
+ * until the entry expires or one of the matches fires. This works for
+ * legacy handlers as well. The privilege check and the filters still run on
+ * every request.
+ *
+ * @param netFn - the IPMI net function number of the command
+ * @param cmd - the IPMI command number
+ * @param ttl - how long a response stays valid; zero never expires
+ * @param matches - D-Bus match rules, typically PropertiesChanged signals
+ *                  of the data behind the response, that invalidate the
+ *                  cached responses
+ */
+void registerResponseCache(NetFn netFn, Cmd cmd, std::chrono::milliseconds ttl,
+                           const std::vector<std::string>& matches = {});
+
 } // namespace ipmi
 
 #ifdef ALLOW_DEPRECATED_API
@@ -634,4 +707,17 @@ void ipmi_register_callback(ipmi_netfn_t netFn, ipmi_cmd_t cmd,
                             ipmi_context_t context, ipmid_callback_t handler,
                             ipmi_cmd_privilege_t priv);
 
+/**
+ * @brief legacy IPMI handler registration function with options
+ *
+ * Same as above, but for handlers that need one of the HandlerFlags, such
+ * as a slow handler that should run with HandlerFlags::blocking.
+ *
+ * @param flags - options for running the handler; see HandlerFlags
+ */
+void ipmi_register_callback(ipmi_netfn_t netFn, ipmi_cmd_t cmd,
+                            ipmi_context_t context, ipmid_callback_t handler,
+                            ipmi_cmd_privilege_t priv,
+                            ipmi::HandlerFlags flags);
+
 #endif /* ALLOW_DEPRECATED_API */
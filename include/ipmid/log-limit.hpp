@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <phosphor-logging/log.hpp>
+#include <utility>
+
+namespace ipmi
+{
+namespace log_limit
+{
+
+/* each message site may log this many messages at once, and as many again
+ * every interval */
+constexpr size_t burst = 10;
+constexpr std::chrono::seconds interval(10);
+
+/** @brief Take a token from the bucket of a message site
+ *
+ *  @param[in] site - the message, which identifies the site
+ *  @param[out] suppressed - messages of the site dropped since the last one
+ *                           that was logged
+ *
+ *  @return true if the message is to be logged
+ */
+bool allow(const char* site, uint64_t& suppressed);
+
+} // namespace log_limit
+
+/** @brief log() for the error paths that a request can hit over and over
+ *
+ *  A host tool that keeps retrying a failing command would otherwise log a
+ *  message per request. Each message site gets a token bucket instead, and
+ *  the first message logged after some were dropped counts them in
+ *  SUPPRESSED.
+ *
+ *  The site is keyed by the address of msg, so msg must be a string
+ *  literal, never a formatted string or e.what().
+ *
+ *  @param[in] msg - the message, a string literal
+ *  @param[in] entries - the entry() metadata of the message
+ */
+template <phosphor::logging::level L, typename... Entries>
+void logLimited(const char* msg, Entries&&... entries)
+{
+    using namespace phosphor::logging;
+    uint64_t suppressed = 0;
+    if (!log_limit::allow(msg, suppressed))
+    {
+        return;
+    }
+    if (suppressed)
+    {
+        log<L>(msg, std::forward<Entries>(entries)...,
+               entry("SUPPRESSED=%llu",
+                     static_cast<unsigned long long>(suppressed)));
+    }
+    else
+    {
+        log<L>(msg, std::forward<Entries>(entries)...);
+    }
+}
+
+} // namespace ipmi
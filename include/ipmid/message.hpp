@@ -16,14 +16,23 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
 #include <boost/asio/spawn.hpp>
+#include <climits>
 #include <cstdint>
 #include <ipmid/api-types.hpp>
+#include <ipmid/message/pool.hpp>
 #include <ipmid/message/types.hpp>
 #include <memory>
+#include <optional>
 #include <phosphor-logging/log.hpp>
+#include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace ipmi
@@ -52,8 +61,29 @@ struct Context
     // srcAddr is only set on IPMB requests because
     // Platform Event Message needs it to determine the incoming format
     int rqSA = 0;
+    // instance of the host the request is for, on systems where one ipmid
+    // serves several hosts; the channel daemon states it with the hostId
+    // option, and it is 0 otherwise
+    size_t hostIdx = 0;
     // if non-null, use this to do blocking asynchronous asio calls
     boost::asio::yield_context* yield = nullptr;
+    // group extension (NetFn 2Ch) or IANA (NetFn 2Eh) of the request,
+    // parsed by the dispatcher; the payload still starts with it
+    uint32_t extension = 0;
+    // number of the request since ipmid started, for the tracepoints
+    uint32_t requestId = 0;
+    // when the client gives up waiting for the response; work done for the
+    // request after that is wasted, so the dispatcher and the D-Bus helpers
+    // stop there
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();
+
+    /** @brief true once the deadline of the request has passed */
+    bool expired() const
+    {
+        return deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= deadline;
+    }
 };
 
 namespace message
@@ -74,9 +104,279 @@ struct PackSingle;
 template <typename T>
 using PackSingle_t = PackSingle<utility::TypeIdDowncast_t<T>>;
 
+template <typename A>
+struct UnpackFixed;
+
+template <typename A>
+struct PackFixed;
+
+/** @struct FixedLayout
+ *  @brief Number of bytes a type occupies when it is made up entirely of
+ *         byte-aligned, fixed-width integers, or 0 if it is not
+ *
+ *  Tuples with a fixed layout are packed and unpacked as one block instead
+ *  of going through the bit stream one element at a time.
+ */
+template <typename T>
+struct FixedLayout
+{
+    static constexpr size_t size =
+        std::is_integral_v<T> && !std::is_same_v<T, bool> ? sizeof(T) : 0;
+};
+
+template <unsigned N>
+struct FixedLayout<fixed_uint_t<N>>
+{
+    static constexpr size_t size =
+        (N % CHAR_BIT || N > 64) ? 0 : N / CHAR_BIT;
+};
+
+template <typename T, size_t N>
+struct FixedLayout<std::array<T, N>>
+{
+    static constexpr size_t size = FixedLayout<T>::size * N;
+};
+
+template <typename... T>
+struct FixedLayout<std::tuple<T...>>
+{
+    static constexpr size_t size =
+        (FixedLayout<T>::size && ...) ? (FixedLayout<T>::size + ... + 0) : 0;
+};
+
+template <typename T>
+constexpr size_t fixedLayoutSize =
+    FixedLayout<utility::TypeIdDowncast_t<T>>::size;
+
+/* the longest run of bit-fields that is gathered into one word; up to
+ * CHAR_BIT - 1 bits may already be pending in the bit stream */
+static constexpr size_t maxBitRun = 64 - (CHAR_BIT - 1);
+
+/** @struct BitField
+ *  @brief Width of a type that is packed as a bit-field, or 0 if it is not,
+ *         plus the conversions to and from the bits of a word
+ */
+template <typename T>
+struct BitField
+{
+    static constexpr size_t bits = 0;
+};
+
+template <>
+struct BitField<bool>
+{
+    static constexpr size_t bits = 1;
+    static uint64_t get(bool t)
+    {
+        return t;
+    }
+    static void set(bool& t, uint64_t word)
+    {
+        t = word & 1;
+    }
+};
+
+template <unsigned N>
+struct BitField<fixed_uint_t<N>>
+{
+    static constexpr size_t bits = N;
+    static uint64_t get(const fixed_uint_t<N>& t)
+    {
+        return static_cast<uint64_t>(t);
+    }
+    static void set(fixed_uint_t<N>& t, uint64_t word)
+    {
+        t = word & ((uint64_t{1} << N) - 1);
+    }
+};
+
+template <size_t N>
+struct BitField<std::bitset<N>>
+{
+    static constexpr size_t bits = N;
+    static uint64_t get(const std::bitset<N>& t)
+    {
+        return t.to_ullong();
+    }
+    static void set(std::bitset<N>& t, uint64_t word)
+    {
+        t |= word & ((uint64_t{1} << N) - 1);
+    }
+};
+
+template <typename T>
+using BitField_t = BitField<utility::TypeIdDowncast_t<T>>;
+
+/** @struct BitRun
+ *  @brief Number of leading types that are bit-fields and fit together in
+ *         a word of at most budget bits, and their total width
+ */
+template <size_t budget, typename... T>
+struct BitRun
+{
+    static constexpr size_t length = 0;
+    static constexpr size_t bits = 0;
+};
+
+template <size_t budget, typename T, typename... Rest>
+struct BitRun<budget, T, Rest...>
+{
+    static constexpr size_t width = BitField_t<T>::bits;
+    static constexpr bool fits = width > 0 && width <= budget;
+    using Next = BitRun<fits ? budget - width : 0, Rest...>;
+    static constexpr size_t length = fits ? 1 + Next::length : 0;
+    static constexpr size_t bits = fits ? width + Next::bits : 0;
+};
+
 // size to hold 64 bits plus one (possibly-)partial byte
 static constexpr size_t bitStreamSize = ((sizeof(uint64_t) + 1) * CHAR_BIT);
 
+/** @struct PackedBits
+ *  @brief Number of bits a value takes once it is packed, so that a
+ *         response buffer can be sized once before packing
+ *
+ *  fixed is the width of every value of the type, known at compile time, or
+ *  0 if the width depends on the value; of() works out the width of a
+ *  value either way. A type with no PackSingle here counts as 0 bits, so
+ *  the buffer may still grow for it.
+ */
+template <typename T>
+struct PackedBits
+{
+    static constexpr size_t fixed =
+        std::is_same_v<T, bool>
+            ? 1
+            : (std::is_integral_v<T> ? sizeof(T) * CHAR_BIT : 0);
+    static size_t of(const T&)
+    {
+        return fixed;
+    }
+};
+
+template <typename T>
+using PackedBits_t = PackedBits<utility::TypeIdDowncast_t<T>>;
+
+template <unsigned N>
+struct PackedBits<fixed_uint_t<N>>
+{
+    static constexpr size_t fixed = N;
+    static size_t of(const fixed_uint_t<N>&)
+    {
+        return fixed;
+    }
+};
+
+template <size_t N>
+struct PackedBits<std::bitset<N>>
+{
+    static constexpr size_t fixed = N;
+    static size_t of(const std::bitset<N>&)
+    {
+        return fixed;
+    }
+};
+
+template <typename T, size_t N>
+struct PackedBits<std::array<T, N>>
+{
+    static constexpr size_t fixed = PackedBits_t<T>::fixed * N;
+    static size_t of(const std::array<T, N>& t)
+    {
+        if constexpr (fixed > 0)
+        {
+            return fixed;
+        }
+        size_t bits = 0;
+        for (const auto& v : t)
+        {
+            bits += PackedBits_t<T>::of(v);
+        }
+        return bits;
+    }
+};
+
+template <typename T>
+struct PackedBits<std::vector<T>>
+{
+    static constexpr size_t fixed = 0;
+    static size_t of(const std::vector<T>& t)
+    {
+        if constexpr (PackedBits_t<T>::fixed > 0)
+        {
+            return PackedBits_t<T>::fixed * t.size();
+        }
+        size_t bits = 0;
+        for (const auto& v : t)
+        {
+            bits += PackedBits_t<T>::of(v);
+        }
+        return bits;
+    }
+};
+
+template <>
+struct PackedBits<std::string>
+{
+    static constexpr size_t fixed = 0;
+    static size_t of(const std::string& t)
+    {
+        // UCSD-Pascal style, with a length byte
+        return (t.size() + 1) * CHAR_BIT;
+    }
+};
+
+template <typename T>
+struct PackedBits<std::optional<T>>
+{
+    static constexpr size_t fixed = 0;
+    static size_t of(const std::optional<T>& t)
+    {
+        return t ? PackedBits_t<T>::of(*t) : 0;
+    }
+};
+
+template <typename... T>
+struct PackedBits<std::variant<T...>>
+{
+    static constexpr size_t fixed = 0;
+    static size_t of(const std::variant<T...>& v)
+    {
+        return std::visit(
+            [](const auto& arg) {
+                return PackedBits_t<decltype(arg)>::of(arg);
+            },
+            v);
+    }
+};
+
+template <typename... T>
+struct PackedBits<std::tuple<T...>>
+{
+    static constexpr size_t fixed = (PackedBits_t<T>::fixed && ...)
+                                        ? (PackedBits_t<T>::fixed + ... + 0)
+                                        : 0;
+    static size_t of(const std::tuple<T...>& v)
+    {
+        if constexpr (fixed > 0)
+        {
+            return fixed;
+        }
+        return std::apply(
+            [](const T&... args) {
+                return (PackedBits_t<T>::of(args) + ... + 0);
+            },
+            v);
+    }
+};
+
+/** @brief Number of bytes a set of values takes once it is packed */
+template <typename... Args>
+size_t packedSize(const Args&... args)
+{
+    return ((PackedBits_t<Args>::of(args) + ... + 0) + CHAR_BIT - 1) /
+           CHAR_BIT;
+}
+
 } // namespace details
 
 /**
@@ -127,6 +427,16 @@ struct Payload
     {
         return raw.size();
     }
+    /**
+     * @brief make room for count more bytes, so that packing them does not
+     *        grow the buffer a step at a time
+     *
+     * @param count - number of bytes about to be packed
+     */
+    void reserve(size_t count)
+    {
+        raw.reserve(raw.size() + (bitCount + CHAR_BIT - 1) / CHAR_BIT + count);
+    }
     /**
      * @brief resize the underlying raw buffer to a new size
      *
@@ -200,6 +510,46 @@ struct Payload
         drain(true);
     }
 
+    /**
+     * @brief append up to maxBitRun bits to the buffer as one word
+     *
+     * The pending bits and the new ones are merged in a 64 bit accumulator
+     * and whole bytes are flushed straight into the buffer, instead of
+     * going through the bit stream a byte at a time.
+     *
+     * @param count - number of bits to append
+     * @param bits - a word with count significant bits to append
+     */
+    void appendWord(size_t count, uint64_t bits)
+    {
+        if (bitCount >= CHAR_BIT)
+        {
+            // more pending than a pack leaves behind; go a byte at a time
+            while (count > 0)
+            {
+                size_t n = std::min(count, static_cast<size_t>(CHAR_BIT));
+                appendBits(n, static_cast<uint8_t>(bits));
+                bits >>= n;
+                count -= n;
+            }
+            return;
+        }
+        uint64_t word = bits;
+        if (bitCount)
+        {
+            word = (word << bitCount) | bitStream.convert_to<uint64_t>();
+            count += bitCount;
+        }
+        while (count >= CHAR_BIT)
+        {
+            raw.push_back(static_cast<uint8_t>(word));
+            word >>= CHAR_BIT;
+            count -= CHAR_BIT;
+        }
+        bitStream = word;
+        bitCount = count;
+    }
+
     /**
      * @brief empty out the bucket and pack it as bytes LSB-first
      *
@@ -245,6 +595,14 @@ struct Payload
     template <typename Arg, typename... Args>
     int pack(Arg&& arg, Args&&... args)
     {
+        constexpr size_t run =
+            details::BitRun<details::maxBitRun, Arg, Args...>::length;
+        if constexpr (run > 1)
+        {
+            // adjacent bit-fields are gathered into one word
+            return packBitRun<run>(0, 0, std::forward<Arg>(arg),
+                                   std::forward<Args>(args)...);
+        }
         int packRet =
             details::PackSingle_t<Arg>::op(*this, std::forward<Arg>(arg));
         if (packRet)
@@ -256,6 +614,30 @@ struct Payload
         return packRet;
     }
 
+    /**
+     * @brief gather the next run bit-fields into a word, append it and then
+     *        pack the remaining arguments
+     */
+    template <size_t run, typename Arg, typename... Args>
+    int packBitRun(uint64_t word, size_t count, Arg&& arg, Args&&... args)
+    {
+        using Field = details::BitField_t<Arg>;
+        word |= Field::get(arg) << count;
+        count += Field::bits;
+        if constexpr (run > 1)
+        {
+            return packBitRun<run - 1>(word, count,
+                                       std::forward<Args>(args)...);
+        }
+        else
+        {
+            appendWord(count, word);
+            int packRet = pack(std::forward<Args>(args)...);
+            drain();
+            return packRet;
+        }
+    }
+
     /******************************************************************
      * Request operations
      *****************************************************************/
@@ -352,6 +734,42 @@ struct Payload
         return bits;
     }
 
+    /**
+     * @brief consume count bits as a single word, up to maxBitRun
+     *
+     * This is the word-level counterpart of fillBits and popBits; on
+     * failure the stream is left untouched.
+     *
+     * @param count - number of bits needed
+     * @param bits - the count bits from the stream
+     *
+     * @return - true if there were not enough bits
+     */
+    bool popWord(size_t count, uint64_t& bits)
+    {
+        if (bitCount >= CHAR_BIT)
+        {
+            return true;
+        }
+        uint64_t word = bitCount ? bitStream.convert_to<uint64_t>() : 0;
+        size_t have = bitCount;
+        size_t index = rawIndex;
+        while (have < count)
+        {
+            if (index >= raw.size())
+            {
+                return true;
+            }
+            word |= static_cast<uint64_t>(raw[index++]) << have;
+            have += CHAR_BIT;
+        }
+        rawIndex = index;
+        bits = word & ((uint64_t{1} << count) - 1);
+        bitStream = word >> count;
+        bitCount = have - count;
+        return false;
+    }
+
     /**
      * @brief discard all partial bits
      */
@@ -402,6 +820,19 @@ struct Payload
     template <typename Arg, typename... Args>
     int unpack(Arg&& arg, Args&&... args)
     {
+        using Run = details::BitRun<details::maxBitRun, Arg, Args...>;
+        if constexpr (Run::length > 1)
+        {
+            // adjacent bit-fields are taken from the stream as one word;
+            // if it is short, the fields are unpacked one at a time so
+            // that the error handling is unchanged
+            uint64_t word;
+            if (!popWord(Run::bits, word))
+            {
+                return unpackBitRun<Run::length>(word, std::forward<Arg>(arg),
+                                                 std::forward<Args>(args)...);
+            }
+        }
         int unpackRet =
             details::UnpackSingle_t<Arg>::op(*this, std::forward<Arg>(arg));
         if (unpackRet)
@@ -412,6 +843,26 @@ struct Payload
         return unpack(std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief scatter a word over the next run bit-fields and then unpack the
+     *        remaining arguments
+     */
+    template <size_t run, typename Arg, typename... Args>
+    int unpackBitRun(uint64_t word, Arg&& arg, Args&&... args)
+    {
+        using Field = details::BitField_t<Arg>;
+        Field::set(arg, word);
+        if constexpr (run > 1)
+        {
+            return unpackBitRun<run - 1>(word >> Field::bits,
+                                         std::forward<Args>(args)...);
+        }
+        else
+        {
+            return unpack(std::forward<Args>(args)...);
+        }
+    }
+
     /**
      * @brief unpack a tuple of values (of any supported type) from the buffer
      *
@@ -427,6 +878,24 @@ struct Payload
     template <typename... Types>
     int unpack(std::tuple<Types...>& t)
     {
+        constexpr size_t fixedSize =
+            details::fixedLayoutSize<std::tuple<Types...>>;
+        if constexpr (fixedSize > 0)
+        {
+            // byte-aligned fixed layout: one length check for the tuple
+            if (!bitCount && (raw.size() - rawIndex) >= fixedSize)
+            {
+                uint8_t* in = raw.data() + rawIndex;
+                std::apply(
+                    [&in](Types&... args) {
+                        (details::UnpackFixed<Types>::op(in, args), ...);
+                    },
+                    t);
+                rawIndex += fixedSize;
+                return 0;
+            }
+        }
+
         // roll back checkpoint so that unpacking a tuple is atomic
         size_t priorBitCount = bitCount;
         size_t priorIndex = rawIndex;
@@ -475,13 +944,20 @@ struct Response
     Response& operator=(const Response&) = default;
     Response(Response&&) = default;
     Response& operator=(Response&&) = default;
-    ~Response() = default;
+
+    ~Response()
+    {
+        // hand the payload buffer back for the next response to reuse
+        details::BufferPool::instance().recycle(std::move(payload.raw));
+    }
 
     using ptr = std::shared_ptr<Response>;
 
     explicit Response(Context::ptr& context) :
-        payload(), ctx(context), cc(ccSuccess)
+        payload(details::BufferPool::instance().take()), ctx(context),
+        cc(ccSuccess)
     {
+        payload.unpackCheck = true;
     }
 
     /**
@@ -496,6 +972,8 @@ struct Response
     template <typename... Args>
     int pack(Args&&... args)
     {
+        // size the buffer once for the whole response
+        payload.reserve(details::packedSize(args...));
         return payload.pack(std::forward<Args>(args)...);
     }
 
@@ -514,6 +992,7 @@ struct Response
     template <typename... Types>
     int pack(std::tuple<Types...>& t)
     {
+        payload.reserve(details::packedSize(t));
         return payload.pack(t);
     }
 
@@ -542,7 +1021,12 @@ struct Request
     Request& operator=(const Request&) = default;
     Request(Request&&) = default;
     Request& operator=(Request&&) = default;
-    ~Request() = default;
+
+    ~Request()
+    {
+        // the entry points read the request data into pooled buffers
+        details::BufferPool::instance().recycle(std::move(payload.raw));
+    }
 
     using ptr = std::shared_ptr<Request>;
 
@@ -563,20 +1047,7 @@ struct Request
     template <typename... Args>
     int unpack(Args&&... args)
     {
-        int unpackRet = payload.unpack(std::forward<Args>(args)...);
-        if (unpackRet == ipmi::ccSuccess)
-        {
-            if (!payload.trailingOk)
-            {
-                if (!payload.fullyUnpacked())
-                {
-                    // not all bits were consumed by requested parameters
-                    return ipmi::ccReqDataLenInvalid;
-                }
-                payload.unpackCheck = false;
-            }
-        }
-        return unpackRet;
+        return checkUnpacked(payload.unpack(std::forward<Args>(args)...));
     }
 
     /**
@@ -594,8 +1065,7 @@ struct Request
     template <typename... Types>
     int unpack(std::tuple<Types...>& t)
     {
-        return std::apply([this](Types&... args) { return unpack(args...); },
-                          t);
+        return checkUnpacked(payload.unpack(t));
     }
 
     /** @brief Create a response message that corresponds to this request
@@ -604,11 +1074,35 @@ struct Request
      */
     Response::ptr makeResponse()
     {
-        return std::make_shared<Response>(ctx);
+        return makeShared<Response>(ctx);
     }
 
     Payload payload;
     Context::ptr ctx;
+
+  private:
+    /** @brief check that a successful unpack consumed the whole request
+     *
+     * @param unpackRet - the result of the unpack
+     *
+     * @return int - non-zero for unpack error
+     */
+    int checkUnpacked(int unpackRet)
+    {
+        if (unpackRet == ipmi::ccSuccess)
+        {
+            if (!payload.trailingOk)
+            {
+                if (!payload.fullyUnpacked())
+                {
+                    // not all bits were consumed by requested parameters
+                    return ipmi::ccReqDataLenInvalid;
+                }
+                payload.unpackCheck = false;
+            }
+        }
+        return unpackRet;
+    }
 };
 
 } // namespace message
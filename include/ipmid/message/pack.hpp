@@ -58,6 +58,52 @@ void PackBytesUnaligned(Payload& p, const NumericType& i)
     }
 }
 
+/** @struct PackFixed
+ *  @brief Utility to store one element of a fixed layout tuple
+ *
+ *  @tparam T - Type of element to store; FixedLayout<T>::size must be
+ *              non-zero.
+ */
+template <typename T>
+struct PackFixed
+{
+    /** @brief Store the element and advance past it.
+     *
+     *  @param[in,out] out - where to store the element.
+     *  @param[in] t - The element to store.
+     */
+    static void op(uint8_t*& out, const T& t)
+    {
+        PackBytes<T>(out, t);
+        out += sizeof(T);
+    }
+};
+
+template <unsigned N>
+struct PackFixed<fixed_uint_t<N>>
+{
+    static void op(uint8_t*& out, const fixed_uint_t<N>& t)
+    {
+        uint64_t bits = static_cast<uint64_t>(t);
+        for (size_t i = 0; i < N / CHAR_BIT; i++)
+        {
+            *out++ = static_cast<uint8_t>(bits >> (CHAR_BIT * i));
+        }
+    }
+};
+
+template <typename T, size_t N>
+struct PackFixed<std::array<T, N>>
+{
+    static void op(uint8_t*& out, const std::array<T, N>& t)
+    {
+        for (const auto& v : t)
+        {
+            PackFixed<T>::op(out, v);
+        }
+    }
+};
+
 /** @struct PackSingle
  *  @brief Utility to pack a single C++ element into a Payload
  *
@@ -100,6 +146,24 @@ struct PackSingle<std::tuple<T...>>
 {
     static int op(Payload& p, const std::tuple<T...>& v)
     {
+        constexpr size_t fixedSize = fixedLayoutSize<std::tuple<T...>>;
+        if constexpr (fixedSize > 0)
+        {
+            // byte-aligned fixed layout: grow the buffer once and store
+            // each element in place
+            if (!p.bitCount)
+            {
+                size_t offset = p.raw.size();
+                p.raw.resize(offset + fixedSize);
+                uint8_t* out = p.raw.data() + offset;
+                std::apply(
+                    [&out](const T&... args) {
+                        (PackFixed<T>::op(out, args), ...);
+                    },
+                    v);
+                return 0;
+            }
+        }
         return std::apply([&p](const T&... args) { return p.pack(args...); },
                           v);
     }
@@ -137,7 +201,12 @@ struct PackSingle<fixed_uint_t<N>>
     {
         size_t count = N;
         static_assert(N <= (details::bitStreamSize - CHAR_BIT));
-        uint64_t bits = t;
+        uint64_t bits = static_cast<uint64_t>(t);
+        if constexpr (N <= maxBitRun)
+        {
+            p.appendWord(count, bits);
+            return 0;
+        }
         while (count > 0)
         {
             size_t appendCount = std::min(count, static_cast<size_t>(CHAR_BIT));
@@ -169,6 +238,11 @@ struct PackSingle<std::bitset<N>>
         size_t count = N;
         static_assert(N <= (details::bitStreamSize - CHAR_BIT));
         unsigned long long bits = t.to_ullong();
+        if constexpr (N <= maxBitRun)
+        {
+            p.appendWord(count, bits);
+            return 0;
+        }
         while (count > 0)
         {
             size_t appendCount = std::min(count, size_t(CHAR_BIT));
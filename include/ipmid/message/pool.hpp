@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ipmi
+{
+
+namespace message
+{
+
+namespace details
+{
+
+/**
+ * @brief a recycling free list of same-sized memory blocks
+ *
+ * Every request allocates a Context, a Request and a Response, each in a
+ * shared_ptr. The pool keeps the blocks released by finished requests so the
+ * next request can reuse them instead of going back to the heap. The pools
+ * are per-thread, so no locking is needed; a block released on a different
+ * thread simply joins that thread's pool.
+ *
+ * @tparam BlockSize - size in bytes of every block in the pool
+ */
+template <size_t BlockSize>
+class BlockPool
+{
+  public:
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+    BlockPool(BlockPool&&) = delete;
+    BlockPool& operator=(BlockPool&&) = delete;
+
+    ~BlockPool() = delete;
+
+    /**
+     * @brief the pool of the calling thread
+     *
+     * It is never destroyed: a Context or Response may be released by a
+     * thread_local or static destructor during teardown, after a
+     * thread_local pool would have gone, so each thread leaks its pool and
+     * whatever blocks it holds, at most maxFreeBlocks of them.
+     */
+    static BlockPool& instance()
+    {
+        static thread_local BlockPool* pool = new BlockPool();
+        return *pool;
+    }
+
+    void* allocate()
+    {
+        if (freeList)
+        {
+            Node* node = freeList;
+            freeList = node->next;
+            freeCount--;
+            return node;
+        }
+        return ::operator new(blockSize);
+    }
+
+    void deallocate(void* block)
+    {
+        if (freeCount >= maxFreeBlocks)
+        {
+            ::operator delete(block);
+            return;
+        }
+        Node* node = static_cast<Node*>(block);
+        node->next = freeList;
+        freeList = node;
+        freeCount++;
+    }
+
+  private:
+    BlockPool() = default;
+
+    struct Node
+    {
+        Node* next;
+    };
+
+    static constexpr size_t blockSize = std::max(BlockSize, sizeof(Node));
+    // enough for a burst of concurrently outstanding requests
+    static constexpr size_t maxFreeBlocks = 32;
+
+    Node* freeList = nullptr;
+    size_t freeCount = 0;
+};
+
+/**
+ * @brief an allocator that draws single objects from a BlockPool
+ *
+ * This is meant to be used with std::allocate_shared, which allocates the
+ * object and its control block together in a single block. Array allocations
+ * go straight to the heap.
+ *
+ * @tparam T - the type of object to allocate
+ */
+template <typename T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (n != 1)
+        {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(BlockPool<sizeof(T)>::instance().allocate());
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if (n != 1)
+        {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+        BlockPool<sizeof(T)>::instance().deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+/**
+ * @brief a recycling pool of byte buffers for response payloads
+ *
+ * The buffers keep their capacity, so once the pool is warmed up packing a
+ * response does not allocate. Buffers that grew unusually large are freed
+ * rather than kept around.
+ */
+class BufferPool
+{
+  public:
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    BufferPool(BufferPool&&) = delete;
+    BufferPool& operator=(BufferPool&&) = delete;
+    ~BufferPool() = delete;
+
+    /** @brief the pool of the calling thread; never destroyed, for the same
+     *         reason as a BlockPool
+     */
+    static BufferPool& instance()
+    {
+        static thread_local BufferPool* pool = new BufferPool();
+        return *pool;
+    }
+
+    std::vector<uint8_t> take()
+    {
+        if (buffers.empty())
+        {
+            std::vector<uint8_t> buffer;
+            buffer.reserve(initialCapacity);
+            return buffer;
+        }
+        std::vector<uint8_t> buffer = std::move(buffers.back());
+        buffers.pop_back();
+        return buffer;
+    }
+
+    void recycle(std::vector<uint8_t>&& buffer)
+    {
+        if (buffer.capacity() == 0 || buffer.capacity() > maxCapacity ||
+            buffers.size() >= maxBuffers)
+        {
+            return;
+        }
+        buffer.clear();
+        buffers.push_back(std::move(buffer));
+    }
+
+  private:
+    BufferPool()
+    {
+        buffers.reserve(maxBuffers);
+    }
+
+    // big enough for most responses on the system interfaces
+    static constexpr size_t initialCapacity = 64;
+    // legacy handlers size the buffer to the max channel transfer size
+    static constexpr size_t maxCapacity = 4096;
+    static constexpr size_t maxBuffers = 32;
+
+    std::vector<std::vector<uint8_t>> buffers;
+};
+
+} // namespace details
+
+/**
+ * @brief create a shared_ptr to a new object drawn from the message pools
+ *
+ * @tparam T - the type of object to create
+ * @tparam Args - the types of the arguments to the constructor of T
+ *
+ * @param args... - the arguments to pass to the constructor of T
+ *
+ * @return a shared_ptr to the new object
+ */
+template <typename T, typename... Args>
+inline std::shared_ptr<T> makeShared(Args&&... args)
+{
+    return std::allocate_shared<T>(details::PoolAllocator<T>(),
+                                   std::forward<Args>(args)...);
+}
+
+} // namespace message
+
+} // namespace ipmi
@@ -56,6 +56,56 @@ void UnpackBytesUnaligned(Payload& p, NumericType& i)
     }
 }
 
+/** @struct UnpackFixed
+ *  @brief Utility to load one element of a fixed layout tuple
+ *
+ *  The caller has already checked that the whole tuple is available.
+ *
+ *  @tparam T - Type of element to load; FixedLayout<T>::size must be
+ *              non-zero.
+ */
+template <typename T>
+struct UnpackFixed
+{
+    /** @brief Load the element and advance past it.
+     *
+     *  @param[in,out] in - where to load the element from.
+     *  @param[out] t - The reference to load the element into.
+     */
+    static void op(uint8_t*& in, T& t)
+    {
+        t = 0;
+        UnpackBytes<T>(in, t);
+        in += sizeof(T);
+    }
+};
+
+template <unsigned N>
+struct UnpackFixed<fixed_uint_t<N>>
+{
+    static void op(uint8_t*& in, fixed_uint_t<N>& t)
+    {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < N / CHAR_BIT; i++)
+        {
+            bits |= static_cast<uint64_t>(*in++) << (CHAR_BIT * i);
+        }
+        t = bits;
+    }
+};
+
+template <typename T, size_t N>
+struct UnpackFixed<std::array<T, N>>
+{
+    static void op(uint8_t*& in, std::array<T, N>& t)
+    {
+        for (auto& v : t)
+        {
+            UnpackFixed<T>::op(in, v);
+        }
+    }
+};
+
 /** @struct UnpackSingle
  *  @brief Utility to unpack a single C++ element from a Payload
  *
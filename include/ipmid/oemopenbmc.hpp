@@ -15,6 +15,11 @@ enum Cmd
     i2cCmd = 2,
     flashCmd = 3,
     fanManualCmd = 4,
+    ipmiStatsCmd = 5,
+    multiSensorReadingCmd = 6,
+    selExportCmd = 7,
+    cacheUsageCmd = 8,
+    batchCmd = 9,
     ethStatsCmd = 48,
     blobTransferCmd = 128,
 };
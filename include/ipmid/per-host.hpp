@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <ipmid/api.hpp>
+#include <ipmid/warmup.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ipmi
+{
+
+/** @class PerHost
+ *  @brief Provider state kept apart for each host of a multi-host system
+ *  @details One ipmid may serve several hosts, each on channels of its own,
+ *           and the dispatcher tells the request handlers which one through
+ *           Context::hostIdx. State that follows a host (its command queue,
+ *           its watchdog, its boot settings) is kept in a PerHost, so that
+ *           the activity of one host never drops what is cached for
+ *           another, and each host only pays for what it uses.
+ *
+ *           The state of a host is built on first use, like a Deferred; if
+ *           building it throws, the caller gets the exception and the next
+ *           use tries again. The dispatcher only passes on host indexes
+ *           below IPMI_HOST_INSTANCES.
+ *
+ *           All use must be from the main thread.
+ */
+template <typename T>
+class PerHost
+{
+  public:
+    using Factory = std::function<std::unique_ptr<T>(size_t host)>;
+
+    explicit PerHost(Factory factory) : factory(std::move(factory))
+    {
+    }
+
+    PerHost(const PerHost&) = delete;
+    PerHost& operator=(const PerHost&) = delete;
+
+    /** @brief get the state of a host, building it if it doesn't exist yet
+     *
+     *  The state stays where it is until ipmid exits, so a reference to it
+     *  may be kept across a yield.
+     */
+    T& get(size_t host)
+    {
+        if (host >= objects.size())
+        {
+            objects.resize(host + 1);
+        }
+        std::unique_ptr<T>& object = objects[host];
+        if (!object)
+        {
+            object = factory(host);
+        }
+        return *object;
+    }
+
+    T& operator[](size_t host)
+    {
+        return get(host);
+    }
+
+    /** @brief true once the state of the host has been built */
+    bool ready(size_t host) const
+    {
+        return host < objects.size() && objects[host] != nullptr;
+    }
+
+    /** @brief call a function for the state of each host built so far */
+    template <typename F>
+    void forEach(F&& f)
+    {
+        for (size_t host = 0; host < objects.size(); host++)
+        {
+            if (objects[host])
+            {
+                f(host, *objects[host]);
+            }
+        }
+    }
+
+    /** @brief build the state of the first hosts in the warm-up once
+     *         ipmid is running
+     *
+     *  A failure is logged and left for the first use to retry.
+     *
+     *  @param[in] hosts - how many hosts to build the state of
+     */
+    void prefetch(size_t hosts = 1)
+    {
+        for (size_t host = 0; host < hosts; host++)
+        {
+            warmup::add("host " + std::to_string(host) + " state",
+                        [this, host](Context::ptr) { get(host); });
+        }
+    }
+
+  private:
+    Factory factory;
+    std::vector<std::unique_ptr<T>> objects;
+};
+
+} // namespace ipmi
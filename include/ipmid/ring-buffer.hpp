@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace ipmi
+{
+
+/** @class RingBuffer
+ *  @brief A bounded queue that several threads may push to and pop from
+ *         without a lock
+ *
+ *  Each slot carries a sequence number that tells which turn of the ring it
+ *  is ready for, so a push and a pop only contend on the slot they claim.
+ *  A push to a full ring fails rather than overwrite what nobody has read.
+ *
+ *  @tparam T - type of the entries; copied in and out
+ *  @tparam N - number of entries; a power of two
+ */
+template <typename T, size_t N>
+class RingBuffer
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0,
+                  "RingBuffer size must be a power of two");
+
+  public:
+    RingBuffer()
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /** @brief add an entry at the tail
+     *
+     *  @return false if the ring is full
+     */
+    bool push(const T& value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = slots[pos & (N - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == pos)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < pos)
+            {
+                // the slot is still waiting for the pop of the last turn
+                return false;
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** @brief take the entry at the head
+     *
+     *  @return false if the ring is empty
+     */
+    bool pop(T& value)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = slots[pos & (N - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == pos + 1)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+                {
+                    value = slot.value;
+                    slot.sequence.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < pos + 1)
+            {
+                // nothing has been pushed to the slot this turn
+                return false;
+            }
+            else
+            {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** @brief number of entries; only a hint while others push or pop */
+    size_t size() const
+    {
+        size_t h = head.load(std::memory_order_acquire);
+        size_t t = tail.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Slot, N> slots;
+    // apart, so that pushing and popping don't share a cache line
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+} // namespace ipmi
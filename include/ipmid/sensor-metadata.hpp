@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <ipmid/cache-stats.hpp>
+#include <ipmid/types.hpp>
+#include <memory>
+#include <string>
+
+namespace ipmi
+{
+namespace sensor_metadata
+{
+
+/** @brief The interface the metadata is read from */
+constexpr auto interface = "xyz.openbmc_project.Sensor.Value";
+
+/** @struct Metadata
+ *  @brief What a reading of a sensor needs besides its value
+ *
+ *  A record is never changed once published; a rescaled sensor gets a new
+ *  record, so a reader that took one keeps a consistent view of it without
+ *  a lock, however long it holds on to it.
+ */
+struct Metadata
+{
+    int64_t scale = 0;
+    std::string unit;
+    double minValue = 0;
+    double maxValue = 0;
+    // the store version that published this record
+    uint64_t version = 0;
+};
+
+using Snapshot = std::shared_ptr<const Metadata>;
+
+/** @brief Get the metadata of a sensor
+ *
+ *  May be called from any thread.
+ *
+ *  @param[in] path - D-Bus object path of the sensor
+ *
+ *  @return the current record, or nullptr if the sensor hasn't been seen
+ */
+Snapshot find(const std::string& path);
+
+/** @brief Publish the metadata of a sensor from its Sensor.Value properties
+ *
+ *  From then on the record follows the PropertiesChanged signals of the
+ *  sensor, and is dropped when the sensor is removed or added again. A
+ *  sensor outside of /xyz/openbmc_project/sensors isn't watched, so its
+ *  record is returned but not kept. Main thread only: it throws
+ *  std::logic_error on a handler worker thread, like getSdBus().
+ *
+ *  A new record is only published, and the version bumped, when the sensor
+ *  is new or one of its metadata properties changed; an update that only
+ *  carries a new Value keeps the record there is. Properties missing from
+ *  the map keep what the record had.
+ *
+ *  @param[in] path - D-Bus object path of the sensor
+ *  @param[in] properties - some or all of its Sensor.Value properties
+ *
+ *  @return the record now current
+ */
+Snapshot update(const std::string& path, const FlatPropertyMap& properties);
+Snapshot update(const std::string& path, const PropertyMap& properties);
+
+/** @brief Forget a sensor, when the service that owns it went away */
+void remove(const std::string& path);
+
+/** @brief Version of the store; bumped each time a record is published or
+ *         removed, so a consumer that derived something from several
+ *         records can tell that it has to derive it again
+ */
+uint64_t version();
+
+/** @brief Measure the store for cache_stats */
+cache_stats::Usage usage();
+
+} // namespace sensor_metadata
+} // namespace ipmi
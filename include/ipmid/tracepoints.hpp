@@ -0,0 +1,36 @@
+#pragma once
+
+/* Static tracepoints on the path of a request, as USDT probes that perf,
+ * bpftrace and SystemTap can attach to on a running BMC:
+ *
+ *   bpftrace -e 'usdt:/usr/bin/ipmid:ipmid:handler_start { ... }'
+ *
+ * They are only built with --enable-tracepoints, which needs <sys/sdt.h>;
+ * otherwise IPMI_TRACEPOINT compiles to nothing, its arguments included.
+ * An unattached probe costs a nop and the setup of its arguments.
+ *
+ * Every probe starts with the request ID and the NetFn, Cmd and channel of
+ * the request. The request ID is 0 for D-Bus calls made outside of any
+ * request. The remaining arguments are:
+ *
+ *   ipmid:request_entry   - none
+ *   ipmid:filter_done     - priority of the filter, completion code
+ *   ipmid:handler_start   - none
+ *   ipmid:handler_end     - completion code
+ *   ipmid:dbus_call_start - destination service, member (strings)
+ *   ipmid:dbus_call_end   - destination service, member (strings), errno
+ *   ipmid:response_send   - completion code
+ *
+ * The D-Bus probes are in libipmid.so, the others in ipmid.
+ */
+
+#ifdef IPMI_TRACEPOINTS
+#include <sys/sdt.h>
+
+#define IPMI_TRACEPOINT(name, ...) STAP_PROBEV(ipmid, name, __VA_ARGS__)
+#else
+#define IPMI_TRACEPOINT(name, ...)                                             \
+    do                                                                         \
+    {                                                                          \
+    } while (0)
+#endif
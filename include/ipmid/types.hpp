@@ -2,13 +2,27 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <ipmid/const-table.hpp>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sdbusplus/server.hpp>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace ipmi
 {
 
+struct Context;
+
 using DbusObjectPath = std::string;
 using DbusService = std::string;
 using DbusInterface = std::string;
@@ -21,6 +35,176 @@ using Value = sdbusplus::message::variant<bool, uint8_t, int16_t, uint16_t,
 
 using PropertyMap = std::map<DbusProperty, Value>;
 
+/** @class InternedName
+ *  @brief A property or interface name stored once per process.
+ *  @details D-Bus replies repeat the same few names over and over; an
+ *           InternedName is a pointer to the single copy, so keeping many of
+ *           them costs no extra string allocations. They order by their
+ *           text, so containers of them can be searched by plain strings.
+ */
+class InternedName
+{
+  public:
+    InternedName() : name(intern({}))
+    {
+    }
+
+    explicit InternedName(std::string_view text) : name(intern(text))
+    {
+    }
+
+    const std::string& str() const
+    {
+        return *name;
+    }
+
+    operator const std::string&() const
+    {
+        return *name;
+    }
+
+    bool operator==(const InternedName& other) const
+    {
+        return name == other.name;
+    }
+
+    bool operator!=(const InternedName& other) const
+    {
+        return name != other.name;
+    }
+
+    bool operator<(const InternedName& other) const
+    {
+        return *name < *other.name;
+    }
+
+  private:
+    static const std::string* intern(std::string_view text)
+    {
+        // never destroyed; names may be used from static destructors
+        static auto* pool = new std::unordered_set<std::string>();
+        static std::mutex poolMutex;
+        std::lock_guard<std::mutex> lock(poolMutex);
+        return &*pool->emplace(text).first;
+    }
+
+    const std::string* name;
+};
+
+/** @class FlatPropertyMap
+ *  @brief PropertyMap kept in a sorted vector with interned names.
+ *  @details A drop-in for the lookups handlers do on a PropertyMap (find,
+ *           at, operator[] and iteration) that needs a single allocation
+ *           for all of the properties instead of a node and a name per
+ *           property.
+ */
+class FlatPropertyMap
+{
+  public:
+    using value_type = std::pair<InternedName, Value>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    FlatPropertyMap() = default;
+
+    explicit FlatPropertyMap(const PropertyMap& properties)
+    {
+        // a std::map is already sorted
+        entries.reserve(properties.size());
+        for (const auto& [name, value] : properties)
+        {
+            entries.emplace_back(InternedName(name), value);
+        }
+    }
+
+    iterator begin()
+    {
+        return entries.begin();
+    }
+    iterator end()
+    {
+        return entries.end();
+    }
+    const_iterator begin() const
+    {
+        return entries.begin();
+    }
+    const_iterator end() const
+    {
+        return entries.end();
+    }
+    size_t size() const
+    {
+        return entries.size();
+    }
+    bool empty() const
+    {
+        return entries.empty();
+    }
+    void clear()
+    {
+        entries.clear();
+    }
+    void reserve(size_t count)
+    {
+        entries.reserve(count);
+    }
+    size_t capacity() const
+    {
+        return entries.capacity();
+    }
+
+    iterator find(std::string_view name)
+    {
+        auto it = lowerBound(name);
+        return (it != entries.end() && it->first.str() == name) ? it
+                                                                : entries.end();
+    }
+
+    const_iterator find(std::string_view name) const
+    {
+        return const_cast<FlatPropertyMap*>(this)->find(name);
+    }
+
+    const Value& at(std::string_view name) const
+    {
+        auto it = find(name);
+        if (it == end())
+        {
+            throw std::out_of_range("FlatPropertyMap::at");
+        }
+        return it->second;
+    }
+
+    Value& operator[](std::string_view name)
+    {
+        auto it = lowerBound(name);
+        if (it == entries.end() || it->first.str() != name)
+        {
+            it = entries.emplace(it, InternedName(name), Value());
+        }
+        return it->second;
+    }
+
+    /** @brief Convert to a PropertyMap for the APIs that need one */
+    PropertyMap toPropertyMap() const
+    {
+        return PropertyMap(entries.begin(), entries.end());
+    }
+
+  private:
+    iterator lowerBound(std::string_view name)
+    {
+        return std::lower_bound(entries.begin(), entries.end(), name,
+                                [](const value_type& entry,
+                                   std::string_view key) {
+                                    return entry.first.str() < key;
+                                });
+    }
+
+    std::vector<value_type> entries;
+};
+
 using ObjectTree =
     std::map<DbusObjectPath, std::map<DbusService, std::vector<DbusInterface>>>;
 
@@ -157,15 +341,92 @@ struct Info
     bool hasScale;
     Scale scale;
     Unit unit;
-    std::function<uint8_t(SetSensorReadingReq&, const Info&)> updateFunc;
-    std::function<GetSensorResponse(const Info&)> getFunc;
+    // plain function pointers; the generator only binds free functions
+    uint8_t (*updateFunc)(const SetSensorReadingReq&, const Info&);
+    GetSensorResponse (*getFunc)(const std::shared_ptr<Context>&,
+                                 const Info&);
     Mutability mutability;
-    std::function<SensorName(const Info&)> sensorNameFunc;
+    SensorName (*sensorNameFunc)(const Info&);
     DbusInterfaceMap propertyInterfaces;
 };
 
 using Id = uint8_t;
-using IdInfoMap = std::map<Id, Info>;
+
+/** @class IdInfoTable
+ *  @brief The sensors of a provider, indexed directly by sensor number.
+ *  @details Supports the lookups the handlers do on a std::map<Id, Info>
+ *           (find, iteration in sensor number order and size). The sensors
+ *           are kept in one vector, so a find is a single index into a
+ *           256 entry table and an SDR walk touches contiguous memory.
+ */
+class IdInfoTable
+{
+  public:
+    using value_type = std::pair<const Id, Info>;
+    using const_iterator = const value_type*;
+    using iterator = const_iterator;
+
+    IdInfoTable(std::initializer_list<value_type> init)
+    {
+        std::array<const value_type*, slots> byId{};
+        for (const auto& sensor : init)
+        {
+            byId[sensor.first] = &sensor;
+        }
+
+        entries.reserve(init.size());
+        index.fill(none);
+        for (size_t id = 0; id < slots; id++)
+        {
+            if (byId[id])
+            {
+                index[id] = entries.size();
+                entries.emplace_back(*byId[id]);
+            }
+        }
+    }
+
+    const_iterator begin() const
+    {
+        return entries.data();
+    }
+    const_iterator end() const
+    {
+        return entries.data() + entries.size();
+    }
+    size_t size() const
+    {
+        return entries.size();
+    }
+    bool empty() const
+    {
+        return entries.empty();
+    }
+
+    const_iterator find(Id id) const
+    {
+        return index[id] == none ? end() : begin() + index[id];
+    }
+
+    const Info& at(Id id) const
+    {
+        auto it = find(id);
+        if (it == end())
+        {
+            throw std::out_of_range("IdInfoTable::at");
+        }
+        return it->second;
+    }
+
+  private:
+    static constexpr size_t slots = std::numeric_limits<Id>::max() + 1;
+    static constexpr uint16_t none = std::numeric_limits<uint16_t>::max();
+
+    std::vector<value_type> entries;
+    std::array<uint16_t, slots> index;
+};
+
+using IdInfoMap = IdInfoTable;
 
 using PropertyMap = ipmi::PropertyMap;
 
@@ -184,9 +445,9 @@ struct SelData
     Offset eventOffset;
 };
 
-using InventoryPath = std::string;
+using InventoryPath = std::string_view;
 
-using InvObjectIDMap = std::map<InventoryPath, SelData>;
+using InvObjectIDMap = ConstMap<InventoryPath, SelData>;
 
 enum class ThresholdMask
 {
@@ -209,7 +470,7 @@ struct EntityInfo
     ContainedEntitiesArray containedEntities;
 };
 
-using EntityInfoMap = std::map<Id, EntityInfo>;
+using EntityInfoMap = ConstMap<Id, EntityInfo>;
 
 } // namespace sensor
 
@@ -1,9 +1,21 @@
 #pragma once
 
+#include <boost/system/error_code.hpp>
 #include <chrono>
+#include <functional>
+#include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
+#include <ipmid/dbus-stats.hpp>
+#include <ipmid/message.hpp>
 #include <ipmid/types.hpp>
+#include <map>
+#include <memory>
 #include <optional>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/server.hpp>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace ipmi
 {
@@ -28,6 +40,68 @@ constexpr auto METHOD_SET = "Set";
  * than the default 25s D-Bus timeout. */
 constexpr std::chrono::microseconds IPMI_DBUS_TIMEOUT = 5s;
 
+namespace detail
+{
+
+/** @brief Make a blocking call on the shared connection
+ *
+ *  Used by the context overloads when there is no yield context.
+ *
+ *  @param[in] method - the method call to make
+ *  @param[in] readReply - reads the reply on success
+ *  @return ec - boost error code
+ */
+boost::system::error_code
+    callBlocking(sdbusplus::message::message& method,
+                 const std::function<void(sdbusplus::message::message&)>&
+                     readReply);
+
+/** @brief Refuse a call made for a request that is past its deadline
+ *
+ *  The client has given up on the request, so the reply would be thrown
+ *  away, and under load the call only delays the requests that can still
+ *  make it.
+ *
+ *  @param[in] ctx - context of the request that makes the call
+ *
+ *  @return timed_out if the deadline of the request has passed
+ */
+inline boost::system::error_code checkDeadline(const Context::ptr& ctx)
+{
+    if (ctx->expired())
+    {
+        return boost::system::errc::make_error_code(
+            boost::system::errc::timed_out);
+    }
+    return boost::system::error_code();
+}
+
+/** @brief Note the start of a call that will suspend a request
+ *
+ *  @param[in] ctx - context of the request that makes the call
+ *  @param[in] service - destination of the call
+ *  @param[in] member - method that is called
+ *
+ *  @return the start time to pass to recordCall()
+ */
+dbus_stats::Clock::time_point startCall(const Context::ptr& ctx,
+                                        const std::string& service,
+                                        const char* member);
+
+/** @brief Account a call that suspended a request in the D-Bus statistics
+ *
+ *  @param[in] ctx - context of the request that made the call
+ *  @param[in] service - destination of the call
+ *  @param[in] member - method that was called
+ *  @param[in] start - when the call was sent
+ *  @param[in] ec - outcome of the call
+ */
+void recordCall(const Context::ptr& ctx, const std::string& service,
+                const char* member, dbus_stats::Clock::time_point start,
+                const boost::system::error_code& ec);
+
+} // namespace detail
+
 /** @class ServiceCache
  *  @brief Caches lookups of service names from the object mapper.
  *  @details Most ipmi commands need to talk to other dbus daemons to perform
@@ -99,6 +173,25 @@ class ServiceCache
 std::string getService(sdbusplus::bus::bus& bus, const std::string& intf,
                        const std::string& path);
 
+/** @brief Record a service already known for a path and interface
+ *  @details For callers that learned it from a mapper call of their own
+ *           (GetSubTree, say), so that getService answers from memory. The
+ *           entry is dropped like the ones getService caches.
+ *  @param[in] path - DBUS Object Path
+ *  @param[in] intf - DBUS Interface
+ *  @param[in] service - the service implementing intf at path
+ */
+void cacheService(const std::string& path, const std::string& intf,
+                  const std::string& service);
+
+/** @brief Index the mapper subtree below a root in process
+ *  @details getDbusObject and getAllDbusObjects answer queries below an
+ *           indexed root from memory. The network, inventory, logging and
+ *           sensors roots are indexed by default.
+ *  @param[in] root - the root object path
+ */
+void registerSubtreeIndex(const std::string& root);
+
 /** @brief Gets the dbus object info implementing the given interface
  *         from the given subtree.
  *  @param[in] bus - DBUS Bus Object.
@@ -154,6 +247,28 @@ PropertyMap
                          const std::string& interface,
                          std::chrono::microseconds timeout = IPMI_DBUS_TIMEOUT);
 
+/** @brief Gets all the properties associated with the given object
+ *         and the interface into a FlatPropertyMap.
+ *  @param[in] bus - DBUS Bus Object.
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[out] properties - the properties.
+ */
+void getAllDbusProperties(
+    sdbusplus::bus::bus& bus, const std::string& service,
+    const std::string& objPath, const std::string& interface,
+    FlatPropertyMap& properties,
+    std::chrono::microseconds timeout = IPMI_DBUS_TIMEOUT);
+
+/** @brief Reads an a{sv} property dictionary, such as the reply of GetAll,
+ *         from the current position of a message.
+ *  @param[in] msg - the message to read from.
+ *  @param[out] properties - the properties; read ones are added to it.
+ */
+void readProperties(sdbusplus::message::message& msg,
+                    FlatPropertyMap& properties);
+
 /** @brief Gets all managed objects associated with the given object
  *         path and service.
  *  @param[in] bus - D-Bus Bus Object.
@@ -213,6 +328,422 @@ void deleteAllDbusObjects(sdbusplus::bus::bus& bus,
 ObjectTree getAllAncestors(sdbusplus::bus::bus& bus, const std::string& path,
                            InterfaceList&& interfaces);
 
+/* The overloads below take the request context. When the request runs in a
+ * coroutine they suspend it on ctx->yield while the D-Bus call is in
+ * flight, so the rest of ipmid keeps running; without a yield context they
+ * fall back to a blocking call on the shared connection. They report
+ * failures through the returned error code instead of throwing. */
+
+/** @brief Get the DBUS Service name for the input dbus path
+ *
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] intf - DBUS Interface
+ *  @param[in] path - DBUS Object Path
+ *  @param[out] service - requested service
+ *  @return ec - boost error code
+ */
+boost::system::error_code getService(Context::ptr ctx, const std::string& intf,
+                                     const std::string& path,
+                                     std::string& service);
+
+/** @brief Gets the dbus object info implementing the given interface
+ *         from the given subtree.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] subtreePath - subtree from where the search should start.
+ *  @param[in] match - identifier for object.
+ *  @param[out] dbusObject - the object having objectpath and servicename
+ *  @return ec - boost error code
+ */
+boost::system::error_code getDbusObject(Context::ptr ctx,
+                                        const std::string& interface,
+                                        const std::string& subtreePath,
+                                        const std::string& match,
+                                        DbusObjectInfo& dbusObject);
+
+/** @brief Gets the value associated with the given object
+ *         and the interface.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] property - name of the property.
+ *  @param[out] propertyValue - value of the property.
+ *  @return ec - boost error code
+ */
+template <typename Type>
+boost::system::error_code
+    getDbusProperty(Context::ptr ctx, const std::string& service,
+                    const std::string& objPath, const std::string& interface,
+                    const std::string& property, Type& propertyValue)
+{
+    boost::system::error_code ec = detail::checkDeadline(ctx);
+    if (ec)
+    {
+        return ec;
+    }
+    Value variant;
+    if (ctx->yield)
+    {
+        auto start = detail::startCall(ctx, service, METHOD_GET);
+        variant = getSdBus()->yield_method_call<Value>(
+            *ctx->yield, ec, service.c_str(), objPath.c_str(), PROP_INTF,
+            METHOD_GET, interface, property);
+        detail::recordCall(ctx, service, METHOD_GET, start, ec);
+    }
+    else
+    {
+        auto method = getSdBus()->new_method_call(
+            service.c_str(), objPath.c_str(), PROP_INTF, METHOD_GET);
+        method.append(interface, property);
+        ec = detail::callBlocking(method,
+                                  [&variant](sdbusplus::message::message& r) {
+                                      r.read(variant);
+                                  });
+    }
+    if (ec)
+    {
+        return ec;
+    }
+    if constexpr (std::is_same_v<Type, Value>)
+    {
+        propertyValue = std::move(variant);
+    }
+    else
+    {
+        Type* tmp = std::get_if<Type>(&variant);
+        if (!tmp)
+        {
+            // user requested incorrect type; make an error code for them
+            return boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+        }
+        propertyValue = *tmp;
+    }
+    return ec;
+}
+
+/** @brief Gets all the properties associated with the given object
+ *         and the interface.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[out] properties - map of name value pair.
+ *  @return ec - boost error code
+ */
+boost::system::error_code getAllDbusProperties(Context::ptr ctx,
+                                               const std::string& service,
+                                               const std::string& objPath,
+                                               const std::string& interface,
+                                               PropertyMap& properties);
+
+/** @brief Gets all the properties associated with the given object
+ *         and the interface into a FlatPropertyMap.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[out] properties - the properties.
+ *  @return ec - boost error code
+ */
+boost::system::error_code getAllDbusProperties(Context::ptr ctx,
+                                               const std::string& service,
+                                               const std::string& objPath,
+                                               const std::string& interface,
+                                               FlatPropertyMap& properties);
+
+/** @brief Sets the property value of the given object.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] property - name of the property.
+ *  @param[in] value - value which needs to be set.
+ *  @return ec - boost error code
+ */
+template <typename Type>
+boost::system::error_code
+    setDbusProperty(Context::ptr ctx, const std::string& service,
+                    const std::string& objPath, const std::string& interface,
+                    const std::string& property, const Type& value)
+{
+    boost::system::error_code ec = detail::checkDeadline(ctx);
+    if (ec)
+    {
+        return ec;
+    }
+    Value variant(value);
+    if (ctx->yield)
+    {
+        auto start = detail::startCall(ctx, service, METHOD_SET);
+        getSdBus()->yield_method_call(*ctx->yield, ec, service.c_str(),
+                                      objPath.c_str(), PROP_INTF, METHOD_SET,
+                                      interface, property, variant);
+        detail::recordCall(ctx, service, METHOD_SET, start, ec);
+    }
+    else
+    {
+        auto method = getSdBus()->new_method_call(
+            service.c_str(), objPath.c_str(), PROP_INTF, METHOD_SET);
+        method.append(interface, property, variant);
+        ec = detail::callBlocking(method, [](sdbusplus::message::message&) {});
+    }
+    return ec;
+}
+
+/** @brief Gets all managed objects associated with the given object
+ *         path and service.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - D-Bus service name.
+ *  @param[in] objPath - D-Bus object path.
+ *  @param[out] objects - map of name value pair.
+ *  @return ec - boost error code
+ */
+boost::system::error_code getManagedObjects(Context::ptr ctx,
+                                            const std::string& service,
+                                            const std::string& objPath,
+                                            ObjectValueTree& objects);
+
+/** @brief  Gets all the dbus objects from the given service root
+ *          which matches the object identifier.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] serviceRoot - Service root path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] match - Identifier for a path.
+ *  @param[out] objectTree - map of object path and service info.
+ *  @return ec - boost error code
+ */
+boost::system::error_code getAllDbusObjects(Context::ptr ctx,
+                                            const std::string& serviceRoot,
+                                            const std::string& interface,
+                                            const std::string& match,
+                                            ObjectTree& objectTree);
+
+/** @brief Gets the roots of the in-process subtree index
+ *  @return the object paths of the indexed roots.
+ */
+std::vector<std::string> getSubtreeIndexRoots();
+
+/** @brief Fetch an indexed root ahead of its first query, for the warm-up
+ *  @details Does nothing if the root is filled already. If the index can't
+ *           be kept current, queries keep going to the mapper.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] root - an object path from getSubtreeIndexRoots.
+ *  @return ec - boost error code
+ */
+boost::system::error_code warmSubtreeIndex(Context::ptr ctx,
+                                           const std::string& root);
+
+/** @struct BatchReply
+ *  @brief Outcome of one method call of a batch
+ */
+struct BatchReply
+{
+    boost::system::error_code ec;
+    sdbusplus::message::message reply;
+};
+
+/** @brief Send several method calls at once and wait for all of them
+ *
+ *  With a yield context every call is put on the bus before the request
+ *  suspends, so the whole batch costs about one round trip instead of one
+ *  per call. Without one the calls are made one after another.
+ *
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] methods - the method calls to make
+ *  @return The replies, in the same order as the method calls.
+ */
+std::vector<BatchReply>
+    callBatch(Context::ptr ctx,
+              std::vector<sdbusplus::message::message>& methods);
+
+/** @class ObjectCache
+ *  @brief Caches the properties of D-Bus interfaces.
+ *  @details The first lookup of a (service, path, interface) fetches all of
+ *           its properties with GetAll. The entry is then kept current from
+ *           the PropertiesChanged signals of the object and is dropped when
+ *           the owner of the service changes, so later lookups are answered
+ *           from memory. Only use it for properties that are announced with
+ *           PropertiesChanged; properties computed on every read (like a
+ *           timer's remaining time) would go stale. Past the entry limit,
+ *           the least recently used interface is dropped to make room.
+ */
+class ObjectCache
+{
+  public:
+    /** @brief Get the cache shared by all of ipmid and its providers */
+    static ObjectCache& instance();
+
+    /** @brief Look up the cached properties of an interface
+     *
+     *  @param[in] service - Dbus service name.
+     *  @param[in] objPath - Dbus object path.
+     *  @param[in] interface - Dbus interface.
+     *  @return The cached properties or nullptr if they are not cached.
+     */
+    const FlatPropertyMap* find(const std::string& service,
+                                const std::string& objPath,
+                                const std::string& interface) const;
+
+    /** @brief Start watching an interface ahead of fetching its properties
+     *
+     *  @param[in] service - Dbus service name.
+     *  @param[in] objPath - Dbus object path.
+     *  @param[in] interface - Dbus interface.
+     *  @return A token to pass to fill once the properties are fetched.
+     */
+    uint64_t watch(const std::string& service, const std::string& objPath,
+                   const std::string& interface);
+
+    /** @brief Store the fetched properties of a watched interface
+     *
+     *  The properties are dropped if the interface changed after the token
+     *  was handed out, since the fetched values may already be stale.
+     *
+     *  @param[in] service - Dbus service name.
+     *  @param[in] objPath - Dbus object path.
+     *  @param[in] interface - Dbus interface.
+     *  @param[in] token - token returned by watch.
+     *  @param[in] properties - the properties from GetAll.
+     */
+    void fill(const std::string& service, const std::string& objPath,
+              const std::string& interface, uint64_t token,
+              FlatPropertyMap properties);
+
+    /** @brief Drop every cached entry */
+    void clear();
+
+    /** @brief Set the most interfaces kept; 0 keeps every one of them
+     *
+     *  @param[in] entries - the limit; lower than the current number of
+     *                       entries, the next watch evicts down to it
+     */
+    void setLimit(size_t entries);
+
+    /** @brief Measure the cache for cache_stats */
+    cache_stats::Usage usage() const;
+
+  private:
+    using Key = std::tuple<std::string, std::string, std::string>;
+
+    struct Entry
+    {
+        FlatPropertyMap properties;
+        bool valid = false;
+        uint64_t generation = 0;
+        mutable uint64_t lastUsed = 0;
+        std::unique_ptr<sdbusplus::bus::match::match> changed;
+    };
+
+    void propertiesChanged(const Key& key, sdbusplus::message::message& msg);
+    void nameOwnerChanged(sdbusplus::message::message& msg);
+    void evict();
+
+    std::map<Key, Entry> entries;
+    uint64_t nextGeneration = 0;
+    mutable uint64_t useClock = 0;
+    size_t limit = 1024;
+    uint64_t evictions = 0;
+    std::unique_ptr<sdbusplus::bus::match::match> ownerChanged;
+};
+
+/** @brief Gets the value of a property through the ObjectCache,
+ *         fetching the interface when it is not cached yet.
+ *  @param[in] bus - DBUS Bus Object.
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] property - name of the property.
+ *  @return On success returns the value of the property.
+ */
+Value getCachedDbusProperty(sdbusplus::bus::bus& bus,
+                            const std::string& service,
+                            const std::string& objPath,
+                            const std::string& interface,
+                            const std::string& property);
+
+/** @brief Gets all the properties of an interface through the ObjectCache,
+ *         fetching the interface when it is not cached yet.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[out] properties - map of name value pair.
+ *  @return ec - boost error code
+ */
+boost::system::error_code getCachedAllDbusProperties(
+    Context::ptr ctx, const std::string& service, const std::string& objPath,
+    const std::string& interface, PropertyMap& properties);
+
+/** @brief Gets all the properties of an interface through the ObjectCache,
+ *         fetching the interface when it is not cached yet.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[out] properties - the properties.
+ *  @return ec - boost error code
+ */
+boost::system::error_code getCachedAllDbusProperties(
+    Context::ptr ctx, const std::string& service, const std::string& objPath,
+    const std::string& interface, FlatPropertyMap& properties);
+
+namespace detail
+{
+
+/** @brief Look up one property through the ObjectCache without copying
+ *         the rest of the interface.
+ *  @return ec - boost error code
+ */
+boost::system::error_code
+    getCachedValue(Context::ptr ctx, const std::string& service,
+                   const std::string& objPath, const std::string& interface,
+                   const std::string& property, Value& value);
+
+} // namespace detail
+
+/** @brief Gets the value of a property through the ObjectCache,
+ *         fetching the interface when it is not cached yet.
+ *  @param[in] ctx - ipmi::Context::ptr
+ *  @param[in] service - Dbus service name.
+ *  @param[in] objPath - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] property - name of the property.
+ *  @param[out] propertyValue - value of the property.
+ *  @return ec - boost error code
+ */
+template <typename Type>
+boost::system::error_code getCachedDbusProperty(
+    Context::ptr ctx, const std::string& service, const std::string& objPath,
+    const std::string& interface, const std::string& property,
+    Type& propertyValue)
+{
+    Value value;
+    boost::system::error_code ec = detail::getCachedValue(
+        ctx, service, objPath, interface, property, value);
+    if (ec)
+    {
+        return ec;
+    }
+    if constexpr (std::is_same_v<Type, Value>)
+    {
+        propertyValue = std::move(value);
+    }
+    else
+    {
+        Type* tmp = std::get_if<Type>(&value);
+        if (!tmp)
+        {
+            // user requested incorrect type; make an error code for them
+            return boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+        }
+        propertyValue = std::move(*tmp);
+    }
+    return ec;
+}
+
 /** @struct VariantToDoubleVisitor
  *  @brief Visitor to convert variants to doubles
  *  @details Performs a static cast on the underlying type
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ipmid/message.hpp>
+#include <string>
+
+namespace ipmi
+{
+namespace warmup
+{
+
+/** @brief Fills one cache
+ *
+ *  Each task runs in a coroutine of its own, and ctx carries its yield, so
+ *  a task that makes its D-Bus calls through the Context helpers lets the
+ *  others run while it waits. A task that throws is logged and the cache is
+ *  left to fill on its first use.
+ */
+using Task = std::function<void(Context::ptr ctx)>;
+
+/** @struct Report
+ *  @brief How the tasks queued before the first wave finished went
+ */
+struct Report
+{
+    size_t tasks = 0;
+    size_t failed = 0;
+    std::chrono::steady_clock::duration duration{};
+};
+
+using Done = std::function<void(const Report& report)>;
+
+/** @brief Queue a cache to be filled once ipmid is running
+ *
+ *  Typically called from a provider constructor, in place of filling the
+ *  cache there. The caches keep answering while they are being filled:
+ *  a request for something not cached yet reads it from D-Bus as it would
+ *  without the warm-up. A task queued after the warm-up finished, by a
+ *  provider loaded in the background, still runs, within the same bound.
+ *
+ *  Main thread only.
+ *
+ *  @param[in] name - what the task fills, for the log
+ *  @param[in] task - the task
+ */
+void add(const std::string& name, Task task);
+
+/** @brief Start running the queued tasks, at most parallel at once
+ *
+ *  Called by ipmid once it owns its bus name and its providers are loaded.
+ *
+ *  @param[in] parallel - most tasks running at once; at least 1
+ *  @param[in] done - called once every task queued so far has finished
+ */
+void start(size_t parallel, Done done);
+
+/** @brief true once the tasks queued before start() have finished */
+bool complete();
+
+} // namespace warmup
+} // namespace ipmi
@@ -5,6 +5,7 @@
 #include <map>
 #include <numeric>
 #include <phosphor-logging/elog.hpp>
+#include <string_view>
 
 namespace ipmi
 {
@@ -79,11 +80,12 @@ void preFormatProcessing(bool langCode, FruAreaData& data)
 /**
  * @brief Append checksum of the FRU area data
  *
- * @param[in/out] data FRU area data
+ * @param[in/out] data FRU data
+ * @param[in] start offset of the area in the FRU data
  */
-void appendDataChecksum(FruAreaData& data)
+void appendDataChecksum(FruAreaData& data, size_t start)
 {
-    uint8_t checksumVal = std::accumulate(data.begin(), data.end(), 0);
+    uint8_t checksumVal = std::accumulate(data.begin() + start, data.end(), 0);
     // Push the Zero checksum as the last byte of this data
     // This appears to be a simple summation of all the bytes
     data.emplace_back(-checksumVal);
@@ -92,11 +94,13 @@ void appendDataChecksum(FruAreaData& data)
 /**
  * @brief Append padding bytes for the FRU area data
  *
- * @param[in/out] data FRU area data
+ * @param[in/out] data FRU data
+ * @param[in] start offset of the area in the FRU data
  */
-void padData(FruAreaData& data)
+void padData(FruAreaData& data, size_t start)
 {
-    uint8_t pad = (data.size() + checksumSize) % recordUnitOfMeasurement;
+    uint8_t pad =
+        (data.size() - start + checksumSize) % recordUnitOfMeasurement;
     if (pad)
     {
         data.resize((data.size() + recordUnitOfMeasurement - pad));
@@ -106,19 +110,20 @@ void padData(FruAreaData& data)
 /**
  * @brief Format End of Individual IPMI FRU Data Section
  *
- * @param[in/out] fruAreaData FRU area info data
+ * @param[in/out] data FRU data
+ * @param[in] start offset of the area in the FRU data
  */
-void postFormatProcessing(FruAreaData& data)
+void postFormatProcessing(FruAreaData& data, size_t start)
 {
     // This area needs to be padded to a multiple of 8 bytes (after checksum)
-    padData(data);
+    padData(data, start);
 
     // Set size of data info area
-    data.at(areaSizeOffset) =
-        (data.size() + checksumSize) / (recordUnitOfMeasurement);
+    data.at(start + areaSizeOffset) =
+        (data.size() - start + checksumSize) / (recordUnitOfMeasurement);
 
     // Finally add area checksum
-    appendDataChecksum(data);
+    appendDataChecksum(data, start);
 }
 
 /**
@@ -134,7 +139,7 @@ void appendChassisType(const PropertyMap& propMap, FruAreaData& data)
     auto iter = propMap.find(type);
     if (iter != propMap.end())
     {
-        auto value = iter->second;
+        const auto& value = iter->second;
         try
         {
             chassisType = std::stoi(value);
@@ -163,13 +168,13 @@ void appendData(const Property& key, const PropertyMap& propMap,
     auto iter = propMap.find(key);
     if (iter != propMap.end())
     {
-        auto value = iter->second;
+        std::string_view value = iter->second;
         // If starts with 0x or 0X remove them
         // ex: 0x123a just take 123a
         if ((value.compare(0, 2, "0x")) == 0 ||
             (value.compare(0, 2, "0X") == 0))
         {
-            value.erase(0, 2);
+            value.remove_prefix(2);
         }
 
         // 5 bits for length
@@ -183,8 +188,7 @@ void appendData(const Property& key, const PropertyMap& propMap,
         uint8_t typeLength = valueLength | ipmi::fru::typeASCII;
 
         data.emplace_back(typeLength);
-        std::copy(value.begin(), value.begin() + valueLength,
-                  std::back_inserter(data));
+        data.insert(data.end(), value.begin(), value.begin() + valueLength);
     }
     else
     {
@@ -234,45 +238,15 @@ void appendMfgDate(const PropertyMap& propMap, FruAreaData& data)
     data.emplace_back(0);
 }
 
-/**
- * @brief Builds a section of the common header
- *
- * @param[in] infoAreaSize size of the FRU area to write
- * @param[in] offset Current offset for data in overall record
- * @param[in/out] data Common Header section data container
- */
-void buildCommonHeaderSection(const uint32_t& infoAreaSize, uint16_t& offset,
-                              FruAreaData& data)
-{
-    // Check if data for internal use section populated
-    if (infoAreaSize == 0)
-    {
-        // Indicate record not present
-        data.emplace_back(recordNotPresent);
-    }
-    else
-    {
-        // offset should be multiple of 8.
-        auto remainder = offset % recordUnitOfMeasurement;
-        // add the padding bytes in the offset so that offset
-        // will be multiple of 8 byte.
-        offset += (remainder > 0) ? recordUnitOfMeasurement - remainder : 0;
-        // Place data to define offset to area data section
-        data.emplace_back(offset / recordUnitOfMeasurement);
-
-        offset += infoAreaSize;
-    }
-}
-
 /**
  * @brief Builds the Chassis info area data section
  *
  * @param[in] propMap map of properties for chassis info area
- * @return FruAreaData container with chassis info area
+ * @param[in/out] fruAreaData FRU data to append the chassis info area to
  */
-FruAreaData buildChassisInfoArea(const PropertyMap& propMap)
+void buildChassisInfoArea(const PropertyMap& propMap, FruAreaData& fruAreaData)
 {
-    FruAreaData fruAreaData;
+    size_t start = fruAreaData.size();
     if (!propMap.empty())
     {
         // Set formatting data that goes at the beginning of the record
@@ -291,20 +265,19 @@ FruAreaData buildChassisInfoArea(const PropertyMap& propMap)
         fruAreaData.emplace_back(endOfCustomFields);
 
         // Complete record data formatting
-        postFormatProcessing(fruAreaData);
+        postFormatProcessing(fruAreaData, start);
     }
-    return fruAreaData;
 }
 
 /**
  * @brief Builds the Board info area data section
  *
  * @param[in] propMap map of properties for board info area
- * @return FruAreaData container with board info area
+ * @param[in/out] fruAreaData FRU data to append the board info area to
  */
-FruAreaData buildBoardInfoArea(const PropertyMap& propMap)
+void buildBoardInfoArea(const PropertyMap& propMap, FruAreaData& fruAreaData)
 {
-    FruAreaData fruAreaData;
+    size_t start = fruAreaData.size();
     if (!propMap.empty())
     {
         preFormatProcessing(true, fruAreaData);
@@ -333,20 +306,20 @@ FruAreaData buildBoardInfoArea(const PropertyMap& propMap)
         // End of custom fields
         fruAreaData.emplace_back(endOfCustomFields);
 
-        postFormatProcessing(fruAreaData);
+        postFormatProcessing(fruAreaData, start);
     }
-    return fruAreaData;
 }
 
 /**
  * @brief Builds the Product info area data section
  *
  * @param[in] propMap map of FRU properties for Board info area
- * @return FruAreaData container with product info area data
+ * @param[in/out] fruAreaData FRU data to append the product info area to
  */
-FruAreaData buildProductInfoArea(const PropertyMap& propMap)
+void buildProductInfoArea(const PropertyMap& propMap,
+                          FruAreaData& fruAreaData)
 {
-    FruAreaData fruAreaData;
+    size_t start = fruAreaData.size();
     if (!propMap.empty())
     {
         // Set formatting data that goes at the beginning of the record
@@ -379,73 +352,60 @@ FruAreaData buildProductInfoArea(const PropertyMap& propMap)
         // End of custom fields
         fruAreaData.emplace_back(endOfCustomFields);
 
-        postFormatProcessing(fruAreaData);
+        postFormatProcessing(fruAreaData, start);
     }
-    return fruAreaData;
 }
 
-FruAreaData buildFruAreaData(const FruInventoryData& inventory)
+/**
+ * @brief Builds one info area in place and points the common header at it
+ *
+ * @param[in] inventory FRU properties values read from inventory
+ * @param[in] section inventory section of the area
+ * @param[in] headerOffset offset of the area in the common header
+ * @param[in] build builder of the area
+ * @param[in/out] data FRU data to append the area to
+ */
+void buildInfoArea(const FruInventoryData& inventory, const char* section,
+                   size_t headerOffset,
+                   void (*build)(const PropertyMap&, FruAreaData&),
+                   FruAreaData& data)
 {
-    FruAreaData combFruArea{};
-    // Now build common header with data for this FRU Inv Record
-    // Use this variable to increment size of header as we go along to determine
-    // offset for the subsequent area offsets
-    uint16_t curDataOffset = commonHeaderFormatSize;
-    // First byte is id for version of FRU Info Storage Spec used
-    combFruArea.emplace_back(specVersion);
-
-    // 2nd byte is offset to internal use data
-    combFruArea.emplace_back(recordNotPresent);
-
-    // 3rd byte is offset to chassis data
-    FruAreaData chassisArea;
-    auto chassisIt = inventory.find(chassis);
-    if (chassisIt != inventory.end())
-    {
-        chassisArea = std::move(buildChassisInfoArea(chassisIt->second));
-    }
-    // update the offset to chassis data.
-    buildCommonHeaderSection(chassisArea.size(), curDataOffset, combFruArea);
-
-    // 4th byte is offset to board data
-    FruAreaData boardArea;
-    auto boardIt = inventory.find(board);
-    if (boardIt != inventory.end())
+    size_t start = data.size();
+    auto it = inventory.find(section);
+    if (it != inventory.end())
     {
-        boardArea = std::move(buildBoardInfoArea(boardIt->second));
+        build(it->second, data);
     }
-    // update the offset to the board data.
-    buildCommonHeaderSection(boardArea.size(), curDataOffset, combFruArea);
-
-    // 5th byte is offset to product data
-    FruAreaData prodArea;
-    auto prodIt = inventory.find(product);
-    if (prodIt != inventory.end())
-    {
-        prodArea = std::move(buildProductInfoArea(prodIt->second));
-    }
-    // update the offset to the product data.
-    buildCommonHeaderSection(prodArea.size(), curDataOffset, combFruArea);
-
-    // 6th byte is offset to multirecord data
-    combFruArea.emplace_back(recordNotPresent);
-
-    // 7th byte is PAD
-    combFruArea.emplace_back(recordNotPresent);
-
-    // 8th (Final byte of Header Format) is the checksum
-    appendDataChecksum(combFruArea);
-
-    // Combine everything into one full IPMI FRU specification Record
-    // add chassis use area data
-    combFruArea.insert(combFruArea.end(), chassisArea.begin(),
-                       chassisArea.end());
-
-    // add board area data
-    combFruArea.insert(combFruArea.end(), boardArea.begin(), boardArea.end());
+    // every area is a multiple of 8 bytes long, so each one starts on a
+    // multiple of 8 bytes
+    data[headerOffset] = data.size() > start
+                             ? start / recordUnitOfMeasurement
+                             : recordNotPresent;
+}
 
-    // add product use area data
-    combFruArea.insert(combFruArea.end(), prodArea.begin(), prodArea.end());
+FruAreaData buildFruAreaData(const FruInventoryData& inventory)
+{
+    // The areas are written one after the other right behind the common
+    // header, in a buffer sized for the final FRU data up front, so
+    // building it never reallocates.
+    FruAreaData combFruArea{};
+    combFruArea.reserve(fruMinSize);
+
+    // Common header: the 1st byte is the id for version of FRU Info Storage
+    // Spec used, the 2nd to 6th bytes are the offsets to the internal use,
+    // chassis, board, product and multirecord data, the 7th byte is PAD and
+    // the 8th is the checksum, set once the offsets are known
+    combFruArea.assign(commonHeaderFormatSize, recordNotPresent);
+    combFruArea[0] = specVersion;
+
+    buildInfoArea(inventory, chassis, 2, buildChassisInfoArea, combFruArea);
+    buildInfoArea(inventory, board, 3, buildBoardInfoArea, combFruArea);
+    buildInfoArea(inventory, product, 4, buildProductInfoArea, combFruArea);
+
+    uint8_t checksumVal =
+        std::accumulate(combFruArea.begin(),
+                        combFruArea.begin() + commonHeaderFormatSize - 1, 0);
+    combFruArea[commonHeaderFormatSize - 1] = -checksumVal;
 
     // If area is smaller than the minimum size, pad it. This enables ipmitool
     // to update the FRU blob with values longer than the original payload.
@@ -15,26 +15,54 @@
  */
 #include "config.h"
 
+#include "batch-command.hpp"
+#include "command-stats.hpp"
+#include "dispatcher.hpp"
+#include "handler-threads.hpp"
+#include "local-socket.hpp"
+#include "request-scheduler.hpp"
+#include "request-trace.hpp"
+#include "response-cache.hpp"
 #include "settings.hpp"
+#include "startup-profile.hpp"
 
 #include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <systemd/sd-bus.h>
 
 #include <algorithm>
 #include <any>
+#include <array>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/system_error.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <dcmihandler.hpp>
 #include <exception>
 #include <filesystem>
 #include <forward_list>
+#include <fstream>
 #include <host-cmd-manager.hpp>
 #include <ipmid-host/cmd.hpp>
 #include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
+#include <ipmid/event-buffer.hpp>
 #include <ipmid/handler.hpp>
+#include <ipmid/log-limit.hpp>
 #include <ipmid/message.hpp>
 #include <ipmid/oemrouter.hpp>
+#include <ipmid/tracepoints.hpp>
 #include <ipmid/types.hpp>
+#include <ipmid/utils.hpp>
+#include <ipmid/warmup.hpp>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <nlohmann/json.hpp>
 #include <optional>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/asio/connection.hpp>
@@ -42,6 +70,7 @@
 #include <sdbusplus/asio/sd_event.hpp>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/server/interface.hpp>
 #include <sdbusplus/timer.hpp>
 #include <tuple>
 #include <unordered_map>
@@ -91,253 +120,62 @@ sd_event* ipmid_get_sd_event_connection(void)
 }
 sd_bus* ipmid_get_sd_bus_connection(void)
 {
-    return bus;
-}
-
-namespace ipmi
-{
-
-static inline unsigned int makeCmdKey(unsigned int cluster, unsigned int cmd)
-{
-    return (cluster << 8) | cmd;
-}
-
-using HandlerTuple = std::tuple<int,                        /* prio */
-                                Privilege, HandlerBase::ptr /* handler */
-                                >;
-
-/* map to handle standard registered commands */
-static std::unordered_map<unsigned int, /* key is NetFn/Cmd */
-                          HandlerTuple>
-    handlerMap;
-
-/* special map for decoding Group registered commands (NetFn 2Ch) */
-static std::unordered_map<unsigned int, /* key is Group/Cmd (NetFn is 2Ch) */
-                          HandlerTuple>
-    groupHandlerMap;
-
-/* special map for decoding OEM registered commands (NetFn 2Eh) */
-static std::unordered_map<unsigned int, /* key is Iana/Cmd (NetFn is 2Eh) */
-                          HandlerTuple>
-    oemHandlerMap;
-
-using FilterTuple = std::tuple<int,            /* prio */
-                               FilterBase::ptr /* filter */
-                               >;
-
-/* list to hold all registered ipmi command filters */
-static std::forward_list<FilterTuple> filterList;
-
-namespace impl
-{
-/* common function to register all standard IPMI handlers */
-bool registerHandler(int prio, NetFn netFn, Cmd cmd, Privilege priv,
-                     HandlerBase::ptr handler)
-{
-    // check for valid NetFn: even; 00-0Ch, 30-3Eh
-    if (netFn & 1 || (netFn > netFnTransport && netFn < netFnGroup) ||
-        netFn > netFnOemEight)
-    {
-        return false;
-    }
-
-    // create key and value for this handler
-    unsigned int netFnCmd = makeCmdKey(netFn, cmd);
-    HandlerTuple item(prio, priv, handler);
-
-    // consult the handler map and look for a match
-    auto& mapCmd = handlerMap[netFnCmd];
-    if (!std::get<HandlerBase::ptr>(mapCmd) || std::get<int>(mapCmd) <= prio)
-    {
-        mapCmd = item;
-        return true;
-    }
-    return false;
-}
-
-/* common function to register all Group IPMI handlers */
-bool registerGroupHandler(int prio, Group group, Cmd cmd, Privilege priv,
-                          HandlerBase::ptr handler)
-{
-    // create key and value for this handler
-    unsigned int netFnCmd = makeCmdKey(group, cmd);
-    HandlerTuple item(prio, priv, handler);
-
-    // consult the handler map and look for a match
-    auto& mapCmd = groupHandlerMap[netFnCmd];
-    if (!std::get<HandlerBase::ptr>(mapCmd) || std::get<int>(mapCmd) <= prio)
-    {
-        mapCmd = item;
-        return true;
-    }
-    return false;
-}
-
-/* common function to register all OEM IPMI handlers */
-bool registerOemHandler(int prio, Iana iana, Cmd cmd, Privilege priv,
-                        HandlerBase::ptr handler)
-{
-    // create key and value for this handler
-    unsigned int netFnCmd = makeCmdKey(iana, cmd);
-    HandlerTuple item(prio, priv, handler);
-
-    // consult the handler map and look for a match
-    auto& mapCmd = oemHandlerMap[netFnCmd];
-    if (!std::get<HandlerBase::ptr>(mapCmd) || std::get<int>(mapCmd) <= prio)
-    {
-        mapCmd = item;
-        return true;
-    }
-    return false;
-}
-
-/* common function to register all IPMI filter handlers */
-void registerFilter(int prio, FilterBase::ptr filter)
-{
-    // check for initial placement
-    if (filterList.empty() || std::get<int>(filterList.front()) < prio)
-    {
-        filterList.emplace_front(std::make_tuple(prio, filter));
-    }
-    // walk the list and put it in the right place
-    auto j = filterList.begin();
-    for (auto i = j; i != filterList.end() && std::get<int>(*i) > prio; i++)
+    // the main connection must not be used from the worker threads
+    if (sd_bus* workerBus = ipmi::threads::getWorkerBus())
     {
-        j = i;
+        return workerBus;
     }
-    filterList.emplace_after(j, std::make_tuple(prio, filter));
+    return bus;
 }
 
-} // namespace impl
-
-message::Response::ptr filterIpmiCommand(message::Request::ptr request)
+namespace ipmi
 {
-    // pass the command through the filter mechanism
-    // This can be the firmware firewall or any OEM mechanism like
-    // whitelist filtering based on operational mode
-    for (auto& item : filterList)
-    {
-        FilterBase::ptr filter = std::get<FilterBase::ptr>(item);
-        ipmi::Cc cc = filter->call(request);
-        if (ipmi::ccSuccess != cc)
-        {
-            return errorResponse(request, cc);
-        }
-    }
-    return message::Response::ptr();
-}
 
-message::Response::ptr executeIpmiCommandCommon(
-    std::unordered_map<unsigned int, HandlerTuple>& handlers,
-    unsigned int keyCommon, message::Request::ptr request)
+namespace utils
 {
-    // filter the command first; a non-null message::Response::ptr
-    // means that the message has been rejected for some reason
-    message::Response::ptr response = filterIpmiCommand(request);
-    if (response)
-    {
-        return response;
-    }
-
-    Cmd cmd = request->ctx->cmd;
-    unsigned int key = makeCmdKey(keyCommon, cmd);
-    auto cmdIter = handlers.find(key);
-    if (cmdIter != handlers.end())
-    {
-        HandlerTuple& chosen = cmdIter->second;
-        if (request->ctx->priv < std::get<Privilege>(chosen))
-        {
-            return errorResponse(request, ccInsufficientPrivilege);
-        }
-        return std::get<HandlerBase::ptr>(chosen)->call(request);
-    }
-    else
-    {
-        unsigned int wildcard = makeCmdKey(keyCommon, cmdWildcard);
-        cmdIter = handlers.find(wildcard);
-        if (cmdIter != handlers.end())
-        {
-            HandlerTuple& chosen = cmdIter->second;
-            if (request->ctx->priv < std::get<Privilege>(chosen))
-            {
-                return errorResponse(request, ccInsufficientPrivilege);
-            }
-            return std::get<HandlerBase::ptr>(chosen)->call(request);
-        }
-    }
-    return errorResponse(request, ccInvalidCommand);
-}
-
-message::Response::ptr executeIpmiGroupCommand(message::Request::ptr request)
+template <typename AssocContainer, typename UnaryPredicate>
+void assoc_erase_if(AssocContainer& c, UnaryPredicate p)
 {
-    // look up the group for this request
-    Group group;
-    if (0 != request->payload.unpack(group))
-    {
-        return errorResponse(request, ccReqDataLenInvalid);
-    }
-    // The handler will need to unpack group as well; we just need it for lookup
-    request->payload.reset();
-    message::Response::ptr response =
-        executeIpmiCommandCommon(groupHandlerMap, group, request);
-    // if the handler should add the group; executeIpmiCommandCommon does not
-    if (response->cc != ccSuccess && response->payload.size() == 0)
+    typename AssocContainer::iterator next = c.begin();
+    typename AssocContainer::iterator last = c.end();
+    while ((next = std::find_if(next, last, p)) != last)
     {
-        response->pack(group);
+        c.erase(next++);
     }
-    return response;
 }
+} // namespace utils
 
-message::Response::ptr executeIpmiOemCommand(message::Request::ptr request)
+namespace
 {
-    // look up the iana for this request
-    Iana iana;
-    if (0 != request->payload.unpack(iana))
-    {
-        return errorResponse(request, ccReqDataLenInvalid);
-    }
-    request->payload.reset();
-    message::Response::ptr response =
-        executeIpmiCommandCommon(oemHandlerMap, iana, request);
-    // if the handler should add the iana; executeIpmiCommandCommon does not
-    if (response->cc != ccSuccess && response->payload.size() == 0)
-    {
-        response->pack(iana);
-    }
-    return response;
-}
+/* D-Bus unique names are ":<major>.<minor>"; interning them as a single
+ * number keeps the per-request sender lookup free of string handling */
+using SenderId = uint64_t;
+constexpr SenderId invalidSenderId = scheduler::unknownSender;
 
-message::Response::ptr executeIpmiCommand(message::Request::ptr request)
+SenderId internSender(const char* name)
 {
-    NetFn netFn = request->ctx->netFn;
-    if (netFnGroup == netFn)
+    if (!name || name[0] != ':')
     {
-        return executeIpmiGroupCommand(request);
+        return invalidSenderId;
     }
-    else if (netFnOem == netFn)
+    char* end = nullptr;
+    unsigned long major = std::strtoul(name + 1, &end, 10);
+    if (*end != '.')
     {
-        return executeIpmiOemCommand(request);
+        return invalidSenderId;
     }
-    return executeIpmiCommandCommon(handlerMap, netFn, request);
-}
-
-namespace utils
-{
-template <typename AssocContainer, typename UnaryPredicate>
-void assoc_erase_if(AssocContainer& c, UnaryPredicate p)
-{
-    typename AssocContainer::iterator next = c.begin();
-    typename AssocContainer::iterator last = c.end();
-    while ((next = std::find_if(next, last, p)) != last)
+    unsigned long minor = std::strtoul(end + 1, &end, 10);
+    if (*end != '\0')
     {
-        c.erase(next++);
+        return invalidSenderId;
     }
+    // major is always small; keep the minor whole and offset both so that
+    // no unique name maps to invalidSenderId
+    return ((static_cast<SenderId>(major) + 1) << 32) |
+           static_cast<uint32_t>(minor);
 }
-} // namespace utils
 
-namespace
-{
-std::unordered_map<std::string, uint8_t> uniqueNameToChannelNumber;
+std::unordered_map<SenderId, uint8_t> uniqueNameToChannelNumber;
 
 // sdbusplus::bus::match::rules::arg0namespace() wants the prefix
 // to match without any trailing '.'
@@ -360,7 +198,8 @@ void updateOwners(sdbusplus::asio::connection& conn, const std::string& name)
             try
             {
                 uint8_t channel = getChannelByName(chName);
-                uniqueNameToChannelNumber[nameOwner] = channel;
+                uniqueNameToChannelNumber[internSender(nameOwner.c_str())] =
+                    channel;
                 log<level::INFO>("New interface mapping",
                                  entry("INTERFACE=%s", name.c_str()),
                                  entry("CHANNEL=%u", channel));
@@ -416,7 +255,8 @@ void nameChangeHandler(sdbusplus::message::message& message)
         if (boost::starts_with(oldOwner, ":"))
         {
             // Connection removed
-            auto it = uniqueNameToChannelNumber.find(oldOwner);
+            auto it =
+                uniqueNameToChannelNumber.find(internSender(oldOwner.c_str()));
             if (it != uniqueNameToChannelNumber.end())
             {
                 uniqueNameToChannelNumber.erase(it);
@@ -430,7 +270,8 @@ void nameChangeHandler(sdbusplus::message::message& message)
         try
         {
             uint8_t channel = getChannelByName(chName);
-            uniqueNameToChannelNumber[newOwner] = channel;
+            uniqueNameToChannelNumber[internSender(newOwner.c_str())] =
+                channel;
             log<level::INFO>("New interface mapping",
                              entry("INTERFACE=%s", name.c_str()),
                              entry("CHANNEL=%u", channel));
@@ -449,8 +290,8 @@ static constexpr const char intraBmcName[] = "INTRABMC";
 uint8_t channelFromMessage(sdbusplus::message::message& msg)
 {
     // channel name for ipmitool to resolve to
-    std::string sender = msg.get_sender();
-    auto chIter = uniqueNameToChannelNumber.find(sender);
+    auto chIter =
+        uniqueNameToChannelNumber.find(internSender(msg.get_sender()));
     if (chIter != uniqueNameToChannelNumber.end())
     {
         return chIter->second;
@@ -464,38 +305,125 @@ uint8_t channelFromMessage(sdbusplus::message::message& msg)
     {
         return invalidChannel;
     }
-} // namespace ipmi
+}
+
+/** @struct ChannelDescriptor
+ *
+ *  The parts of the channel configuration that every request needs
+ */
+struct ChannelDescriptor
+{
+    bool valid = false;
+    EChannelMediumType mediumType = EChannelMediumType::reserved;
+    EChannelSessSupported sessionSupport = EChannelSessSupported::none;
+    // privilege of requests on a session-less channel
+    Privilege maxPrivilege = Privilege::None;
+    size_t maxTransferSize = 0;
+    // how long the client waits for a response; zero for no deadline
+    std::chrono::milliseconds deadline{0};
+};
+
+/* how long the clients of a kind of channel wait for a response */
+static std::chrono::milliseconds deadlineOf(EChannelMediumType mediumType)
+{
+    switch (mediumType)
+    {
+        case EChannelMediumType::lan8032:
+        case EChannelMediumType::otherLan:
+            return std::chrono::milliseconds(IPMI_DEADLINE_LAN_MS);
+        case EChannelMediumType::ipmb:
+            return std::chrono::milliseconds(IPMI_DEADLINE_IPMB_MS);
+        default:
+            return std::chrono::milliseconds(IPMI_DEADLINE_MS);
+    }
+}
+
+static std::array<ChannelDescriptor, maxIpmiChannels> channelDescriptors;
+static std::optional<uint32_t> channelDescriptorGeneration;
+
+/* get the descriptor of a channel, rebuilding the table if the channel
+ * configuration was reloaded since it was last built */
+static const ChannelDescriptor& getChannelDescriptor(uint8_t channel)
+{
+    uint32_t generation = getChannelConfigGeneration();
+    if (channelDescriptorGeneration != generation)
+    {
+        for (uint8_t chNum = 0; chNum < maxIpmiChannels; chNum++)
+        {
+            ChannelDescriptor& desc = channelDescriptors[chNum];
+            ChannelInfo chInfo;
+            desc.valid = (getChannelInfo(chNum, chInfo) == IPMI_CC_OK);
+            if (!desc.valid)
+            {
+                continue;
+            }
+            desc.mediumType =
+                static_cast<EChannelMediumType>(chInfo.mediumType);
+            desc.sessionSupport =
+                static_cast<EChannelSessSupported>(chInfo.sessionSupported);
+            // For now, there is not a way to configure this, default to Admin
+            desc.maxPrivilege = Privilege::Admin;
+            desc.maxTransferSize = getChannelMaxTransferSize(chNum);
+            desc.deadline = deadlineOf(desc.mediumType);
+        }
+        channelDescriptorGeneration = generation;
+    }
+    static const ChannelDescriptor invalidDescriptor;
+    if (channel >= channelDescriptors.size())
+    {
+        return invalidDescriptor;
+    }
+    return channelDescriptors[channel];
+}
+
+/* numbers the requests for the tracepoints; 0 means no request */
+static uint32_t lastRequestId = 0;
+
+static uint32_t nextRequestId()
+{
+    if (++lastRequestId == 0)
+    {
+        lastRequestId = 1;
+    }
+    return lastRequestId;
+}
 
 /* called from sdbus async server context */
 auto executionEntry(boost::asio::yield_context yield,
                     sdbusplus::message::message& m, NetFn netFn, uint8_t lun,
                     Cmd cmd, std::vector<uint8_t>& data,
-                    std::map<std::string, ipmi::Value>& options)
+                    std::map<std::string, ipmi::Value>& options,
+                    stats::Clock::time_point received)
 {
-    const auto dbusResponse =
-        [netFn, lun, cmd](Cc cc, const std::vector<uint8_t>& data = {}) {
-            constexpr uint8_t netFnResponse = 0x01;
-            uint8_t retNetFn = netFn | netFnResponse;
-            return std::make_tuple(retNetFn, lun, cmd, cc, data);
-        };
-    std::string sender = m.get_sender();
+    const auto dbusResponse = [netFn, lun, cmd](
+                                  Cc cc, std::vector<uint8_t>&& data = {}) {
+        constexpr uint8_t netFnResponse = 0x01;
+        uint8_t retNetFn = netFn | netFnResponse;
+        return std::make_tuple(retNetFn, lun, cmd, cc, std::move(data));
+    };
+    stats::Clock::time_point entry = stats::Clock::now();
+    const char* sender = m.get_sender();
     Privilege privilege = Privilege::None;
     int rqSA = 0;
     uint8_t userId = 0; // undefined user
 
     // figure out what channel the request came in on
     uint8_t channel = channelFromMessage(m);
+    uint32_t requestId = nextRequestId();
+    IPMI_TRACEPOINT(request_entry, requestId, netFn, cmd, channel);
     if (channel == invalidChannel)
     {
         // unknown sender channel; refuse to service the request
         log<level::ERR>("ERROR determining source IPMI channel",
-                        entry("SENDER=%s", sender.c_str()),
+                        entry("SENDER=%s", sender),
                         entry("NETFN=0x%X", netFn), entry("CMD=0x%X", cmd));
         return dbusResponse(ipmi::ccDestinationUnavailable);
     }
 
+    const ChannelDescriptor& desc = getChannelDescriptor(channel);
+
     // session-based channels are required to provide userId/privilege
-    if (getChannelSessionSupport(channel) != EChannelSessSupported::none)
+    if (desc.sessionSupport != EChannelSessSupported::none)
     {
         try
         {
@@ -515,14 +443,10 @@ auto executionEntry(boost::asio::yield_context yield,
     else
     {
         // get max privilege for session-less channels
-        // For now, there is not a way to configure this, default to Admin
-        privilege = Privilege::Admin;
+        privilege = desc.maxPrivilege;
 
         // ipmb should supply rqSA
-        ChannelInfo chInfo;
-        getChannelInfo(channel, chInfo);
-        if (static_cast<EChannelMediumType>(chInfo.mediumType) ==
-            EChannelMediumType::ipmb)
+        if (desc.mediumType == EChannelMediumType::ipmb)
         {
             const auto iter = options.find("rqSA");
             if (iter != options.end())
@@ -534,22 +458,357 @@ auto executionEntry(boost::asio::yield_context yield,
             }
         }
     }
+    // a multi-host system states the host; there is only host0 otherwise
+    size_t hostIdx = 0;
+    const auto host = options.find("hostId");
+    if (host != options.end() && std::holds_alternative<int>(host->second))
+    {
+        int id = std::get<int>(host->second);
+        if (id < 0 || id >= IPMI_HOST_INSTANCES)
+        {
+            ipmi::logLimited<level::ERR>(
+                "Request for an unknown host", entry("SENDER=%s", sender),
+                entry("HOST=%d", id), entry("CHANNEL=%u", channel));
+            return dbusResponse(ipmi::ccDestinationUnavailable);
+        }
+        hostIdx = static_cast<size_t>(id);
+    }
     // check to see if the requested priv/username is valid
-    log<level::DEBUG>("Set up ipmi context", entry("SENDER=%s", sender.c_str()),
+    log<level::DEBUG>("Set up ipmi context", entry("SENDER=%s", sender),
                       entry("NETFN=0x%X", netFn), entry("CMD=0x%X", cmd),
                       entry("CHANNEL=%u", channel), entry("USERID=%u", userId),
                       entry("PRIVILEGE=%u", static_cast<uint8_t>(privilege)),
-                      entry("RQSA=%x", rqSA));
+                      entry("RQSA=%x", rqSA), entry("HOST=%zu", hostIdx));
 
-    auto ctx = std::make_shared<ipmi::Context>(netFn, cmd, channel, userId,
-                                               privilege, rqSA, &yield);
-    auto request = std::make_shared<ipmi::message::Request>(
+    // the request takes the data, so keep a copy of it for the trace
+    std::optional<trace::Record> traced;
+    if (trace::active())
+    {
+        traced.emplace();
+        traced->netFn = netFn;
+        traced->lun = lun;
+        traced->cmd = cmd;
+        traced->channel = channel;
+        traced->data = data;
+        traced->options = options;
+    }
+
+    auto ctx = message::makeShared<ipmi::Context>(netFn, cmd, channel, userId,
+                                                  privilege, rqSA, &yield);
+    ctx->requestId = requestId;
+    ctx->hostIdx = hostIdx;
+    // the client has been waiting since the call arrived, queued or not
+    if (desc.deadline.count())
+    {
+        ctx->deadline = received + desc.deadline;
+    }
+    // the request takes over the buffer sdbusplus read the array into
+    auto request = message::makeShared<ipmi::message::Request>(
         ctx, std::forward<std::vector<uint8_t>>(data));
-    message::Response::ptr response = executeIpmiCommand(request);
+    stats::Timing timing;
+    message::Response::ptr response = executeIpmiCommand(request, &timing);
+    stats::Clock::duration latency = stats::Clock::now() - entry;
+    timing.late = !timing.dropped && ctx->expired();
+    stats::record(netFn, cmd, channel, timing, latency);
+    if (traced)
+    {
+        traced->cc = response->cc;
+        traced->latency = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(latency)
+                .count());
+        trace::record(entry, *traced);
+    }
+
+    // the caller sends the reply right away, without yielding
+    IPMI_TRACEPOINT(response_send, requestId, netFn, cmd, channel,
+                    response->cc);
+    // sdbusplus appends the reply straight from the returned tuple, so hand it
+    // the payload buffer rather than a copy of it
+    return dbusResponse(response->cc, std::move(response->payload.raw));
+}
+
+namespace
+{
+
+/* read a byte array of a call into a pooled buffer in one copy; sdbusplus
+ * would read it a byte at a time */
+void readBytes(sdbusplus::message::message& m, std::vector<uint8_t>& data)
+{
+    const void* bytes = nullptr;
+    size_t size = 0;
+    int r = sd_bus_message_read_array(m.get(), SD_BUS_TYPE_BYTE, &bytes, &size);
+    if (r < 0)
+    {
+        throw sdbusplus::exception::SdBusError(-r, "reading the request data");
+    }
+    data = message::details::BufferPool::instance().take();
+    const uint8_t* first = static_cast<const uint8_t*>(bytes);
+    data.assign(first, first + size);
+}
+
+/* append a byte array to a message in one copy, then hand its buffer back
+ * to the pool */
+void appendBytes(sdbusplus::message::message& m, std::vector<uint8_t>&& data)
+{
+    int r = sd_bus_message_append_array(m.get(), SD_BUS_TYPE_BYTE, data.data(),
+                                        data.size());
+    message::details::BufferPool::instance().recycle(std::move(data));
+    if (r < 0)
+    {
+        throw sdbusplus::exception::SdBusError(-r,
+                                               "appending the response data");
+    }
+}
+
+boost::coroutines::attributes coroutineAttributes()
+{
+    if (IPMI_COROUTINE_STACK_SIZE)
+    {
+        return boost::coroutines::attributes(IPMI_COROUTINE_STACK_SIZE);
+    }
+    return boost::coroutines::attributes();
+}
+
+/* read an execute call, run it and send back the reply */
+void executeRequest(boost::asio::yield_context yield,
+                    sdbusplus::message::message& m,
+                    stats::Clock::time_point received)
+{
+    try
+    {
+        NetFn netFn;
+        uint8_t lun;
+        Cmd cmd;
+        std::vector<uint8_t> data;
+        std::map<std::string, ipmi::Value> options;
+        m.read(netFn, lun, cmd);
+        readBytes(m, data);
+        m.read(options);
+
+        auto [retNetFn, retLun, retCmd, cc, payload] = executionEntry(
+            yield, m, netFn, lun, cmd, data, options, received);
+        auto reply = m.new_method_return();
+        reply.append(retNetFn, retLun, retCmd, cc);
+        appendBytes(reply, std::move(payload));
+        reply.method_return();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("ERROR executing IPMI request",
+                        entry("ERROR=%s", e.what()));
+        sd_bus_reply_method_errorf(m.get(), SD_BUS_ERROR_INVALID_ARGS, "%s",
+                                   e.what());
+    }
+}
+
+/* answer an execute call with Node Busy without running it */
+void rejectRequest(sdbusplus::message::message& m)
+{
+    try
+    {
+        NetFn netFn;
+        uint8_t lun;
+        Cmd cmd;
+        m.read(netFn, lun, cmd);
+
+        constexpr uint8_t netFnResponse = 0x01;
+        auto reply = m.new_method_return();
+        reply.append(static_cast<uint8_t>(netFn | netFnResponse), lun, cmd,
+                     ccBusy, std::vector<uint8_t>{});
+        reply.method_return();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("ERROR rejecting IPMI request",
+                        entry("ERROR=%s", e.what()));
+        sd_bus_reply_method_errorf(m.get(), SD_BUS_ERROR_INVALID_ARGS, "%s",
+                                   e.what());
+    }
+}
+
+void finishRequest();
 
-    return dbusResponse(response->cc, response->payload.raw);
+/* run a request that has been counted in the coroutine usage */
+void spawnRequest(sdbusplus::message::message&& m,
+                  stats::Clock::time_point received)
+{
+    boost::asio::spawn(
+        *getIoContext(),
+        [m = std::move(m), received](boost::asio::yield_context yield) mutable {
+            executeRequest(yield, m, received);
+            scheduler::leave(internSender(m.get_sender()));
+            finishRequest();
+        },
+        coroutineAttributes());
+}
+
+/* a request counted in the coroutine usage is done; start the next one */
+void finishRequest()
+{
+    stats::CoroutineUsage& usage = stats::coroutineUsage();
+    usage.inUse--;
+    std::optional<scheduler::Pending> next = scheduler::pop(usage.inUse);
+    usage.queued = scheduler::queued();
+    if (next)
+    {
+        usage.inUse++;
+        boost::asio::post(*getIoContext(), [next = std::move(*next)]() mutable {
+            if (next.resume)
+            {
+                // a local request, waiting in its own coroutine
+                next.resume();
+                return;
+            }
+            spawnRequest(std::move(*next.call), next.received);
+        });
+    }
 }
 
+void startRequest(sdbusplus::message::message&& m)
+{
+    stats::Clock::time_point received = stats::Clock::now();
+    // the host's requests come first; see request-scheduler.hpp
+    uint8_t channel = channelFromMessage(m);
+    bool priority = channel != invalidChannel &&
+                    getChannelDescriptor(channel).mediumType ==
+                        EChannelMediumType::systemInterface;
+
+    SenderId sender = internSender(m.get_sender());
+    if (!scheduler::enter(sender, priority))
+    {
+        scheduler::reject(channel);
+        rejectRequest(m);
+        return;
+    }
+
+    stats::CoroutineUsage& usage = stats::coroutineUsage();
+    if (!scheduler::admit(channel, priority, usage.inUse))
+    {
+        // bound the number of live stacks; run this one when a stack frees
+        if (!scheduler::push(channel, priority, std::move(m), received))
+        {
+            scheduler::leave(sender);
+            scheduler::reject(channel);
+            rejectRequest(m);
+        }
+        usage.queued = scheduler::queued();
+        return;
+    }
+    usage.inUse++;
+    usage.peak = std::max(usage.peak, usage.inUse);
+    spawnRequest(std::move(m), received);
+}
+
+/* local clients are counted by process id; the interned D-Bus names are
+ * all above it */
+constexpr SenderId localSender(uint32_t pid)
+{
+    return pid;
+}
+
+/* run a request from an in-box client of the local socket
+ *
+ * It is admitted the way startRequest() admits an execute call, except
+ * that the coroutine of the connection waits in the queue rather than a
+ * new one being spawned for it later. */
+std::tuple<Cc, std::vector<uint8_t>>
+    executeLocalRequest(boost::asio::yield_context yield, local::Frame& frame)
+{
+    stats::Clock::time_point entry = stats::Clock::now();
+    uint32_t requestId = nextRequestId();
+    IPMI_TRACEPOINT(request_entry, requestId, frame.netFn, frame.cmd,
+                    frame.channel);
+    if (frame.channel >= maxIpmiChannels ||
+        !getChannelDescriptor(frame.channel).valid)
+    {
+        return std::make_tuple(ccDestinationUnavailable,
+                               std::vector<uint8_t>());
+    }
+    const ChannelDescriptor& desc = getChannelDescriptor(frame.channel);
+    bool priority = desc.mediumType == EChannelMediumType::systemInterface;
+
+    SenderId sender = localSender(frame.client);
+    if (!scheduler::enter(sender, priority))
+    {
+        scheduler::reject(frame.channel);
+        return std::make_tuple(ccBusy, std::vector<uint8_t>());
+    }
+    stats::CoroutineUsage& usage = stats::coroutineUsage();
+    if (!scheduler::admit(frame.channel, priority, usage.inUse))
+    {
+        // never fires; finishRequest() cancels it once this may start
+        boost::asio::steady_timer turn(
+            *getIoContext(), boost::asio::steady_timer::time_point::max());
+        if (!scheduler::push(
+                frame.channel, priority, [&turn]() { turn.cancel(); },
+                entry))
+        {
+            scheduler::leave(sender);
+            scheduler::reject(frame.channel);
+            return std::make_tuple(ccBusy, std::vector<uint8_t>());
+        }
+        usage.queued = scheduler::queued();
+        boost::system::error_code ec;
+        turn.async_wait(yield[ec]);
+    }
+    else
+    {
+        usage.inUse++;
+        usage.peak = std::max(usage.peak, usage.inUse);
+    }
+    // counted until the response is back, even if the handler threw
+    struct Admitted
+    {
+        SenderId sender;
+        ~Admitted()
+        {
+            scheduler::leave(sender);
+            finishRequest();
+        }
+    } admitted{sender};
+
+    // the client was checked to be trusted when it connected
+    auto ctx = message::makeShared<ipmi::Context>(
+        frame.netFn, frame.cmd, frame.channel, frame.userId, frame.privilege,
+        frame.rqSA, &yield);
+    ctx->requestId = requestId;
+    // the deadline counts the time spent in the queue
+    if (desc.deadline.count())
+    {
+        ctx->deadline = entry + desc.deadline;
+    }
+    auto request = message::makeShared<ipmi::message::Request>(
+        ctx, std::move(frame.data));
+    stats::Timing timing;
+    message::Response::ptr response = executeIpmiCommand(request, &timing);
+    timing.late = !timing.dropped && ctx->expired();
+    stats::record(frame.netFn, frame.cmd, frame.channel, timing,
+                  stats::Clock::now() - entry);
+
+    IPMI_TRACEPOINT(response_send, requestId, frame.netFn, frame.cmd,
+                    frame.channel, response->cc);
+    return std::make_tuple(response->cc, std::move(response->payload.raw));
+}
+
+/* sd-bus method callback for xyz.openbmc_project.Ipmi.Server.execute
+ *
+ * The reply is sent from the request coroutine, so just hold a reference to
+ * the call and tell sd-bus it has been taken care of.
+ */
+int executeMethod(sd_bus_message* msg, void*, sd_bus_error*)
+{
+    startRequest(sdbusplus::message::message(msg));
+    return 1;
+}
+
+const sd_bus_vtable executeVtable[] = {
+    SD_BUS_VTABLE_START(0),
+    SD_BUS_METHOD("execute", "yyyaya{sv}", "yyyyay", executeMethod,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_VTABLE_END};
+
+} // namespace
+
 /** @struct IpmiProvider
  *
  *  RAII wrapper for dlopen so that dlclose gets called on exit
@@ -571,6 +830,17 @@ struct IpmiProvider
      *  @param[in]  filename - path of shared object to open
      */
     explicit IpmiProvider(const char* fname) : addr(nullptr), name(fname)
+    {
+        open();
+    }
+
+    ~IpmiProvider()
+    {
+        close();
+    }
+
+    /** @brief dlopen the library; its constructors register its handlers */
+    void open()
     {
         log<level::DEBUG>("Open IPMI provider library",
                           entry("PROVIDER=%s", name.c_str()));
@@ -606,23 +876,239 @@ struct IpmiProvider
         }
     }
 
-    ~IpmiProvider()
+    /** @brief dlclose the library; nothing of it may be registered still */
+    void close()
     {
         if (isOpen())
         {
             dlclose(addr);
+            addr = nullptr;
         }
     }
+
     bool isOpen() const
     {
         return (nullptr != addr);
     }
 };
 
+/* open a provider and log how long it took, including the time its
+ * constructors spent registering handlers */
+static void openProvider(std::forward_list<IpmiProvider>& handles,
+                         const fs::path& lib)
+{
+    startup::beginProvider(lib);
+    setRegistrant(lib);
+    handles.emplace_front(lib.c_str());
+    setRegistrant({});
+    startup::endProvider();
+}
+
+/** @struct LazyProvider
+ *
+ *  A provider listed in the manifest. It is opened on the first request for
+ *  one of its commands, or in the background once ipmid is answering
+ *  requests.
+ */
+struct LazyProvider
+{
+    fs::path path;
+    bool background = true;
+    bool loaded = false;
+};
+
+static std::vector<std::unique_ptr<LazyProvider>> lazyProviders;
+static std::forward_list<IpmiProvider> lazyHandles;
+
+/* the providers opened at startup */
+static std::forward_list<IpmiProvider> providers;
+
+static void loadLazyProvider(LazyProvider& provider)
+{
+    if (provider.loaded)
+    {
+        return;
+    }
+    provider.loaded = true;
+    openProvider(lazyHandles, provider.path);
+}
+
+/** @class LazyProviderHandler
+ *
+ *  Stands in for the commands of a provider that has not been opened yet.
+ *  It is registered at the lowest priority, so the handlers the provider
+ *  registers as it is opened replace it.
+ */
+class LazyProviderHandler final : public HandlerBase
+{
+  public:
+    explicit LazyProviderHandler(LazyProvider& provider) : provider(provider)
+    {
+    }
+
+  private:
+    LazyProvider& provider;
+
+    message::Response::ptr
+        executeCallback(message::Request::ptr request) override;
+};
+
+static constexpr int prioLazyProvider = std::numeric_limits<int>::min();
+
+/* run a request on the handler that replaced a LazyProviderHandler; the
+ * request has already been through the filters */
+static message::Response::ptr
+    executeLoadedHandler(message::Request::ptr request)
+{
+    // the dispatcher parsed the group extension or the three byte IANA
+    CmdTable* handlers =
+        findCmdTable(request->ctx->netFn, request->ctx->extension);
+    if (!handlers)
+    {
+        return errorResponse(request, ccInvalidCommand);
+    }
+    HandlerTuple* chosen = chooseHandler(handlers, request->ctx->cmd);
+    HandlerBase::ptr handler = std::get<HandlerBase::ptr>(*chosen);
+    if (!handler || dynamic_cast<LazyProviderHandler*>(handler.get()))
+    {
+        // the provider did not register the command it was listed for
+        return errorResponse(request, ccInvalidCommand);
+    }
+    if (request->ctx->priv < std::get<Privilege>(*chosen))
+    {
+        return errorResponse(request, ccInsufficientPrivilege);
+    }
+    if (threads::offload(handler, request))
+    {
+        return threads::execute(handler, request);
+    }
+    return handler->call(request);
+}
+
+message::Response::ptr
+    LazyProviderHandler::executeCallback(message::Request::ptr request)
+{
+    loadLazyProvider(provider);
+    return executeLoadedHandler(request);
+}
+
+/** @struct LazyCommand
+ *
+ *  One command listed for a provider in the manifest
+ */
+struct LazyCommand
+{
+    NetFn netFn;
+    Cmd cmd;
+    std::optional<Group> group;
+    std::optional<Iana> iana;
+};
+
+/* register the stand-in handlers for one manifest entry; the whole entry is
+ * parsed first so a malformed entry leaves nothing behind */
+static void registerLazyProvider(const fs::path& lib,
+                                 const nlohmann::json& listing)
+{
+    std::vector<LazyCommand> commands;
+    for (const auto& command : listing.at("commands"))
+    {
+        LazyCommand& item = commands.emplace_back();
+        item.cmd = command.at("cmd").get<Cmd>();
+        if (command.contains("group"))
+        {
+            item.netFn = netFnGroup;
+            item.group = command.at("group").get<Group>();
+        }
+        else if (command.contains("iana"))
+        {
+            item.netFn = netFnOem;
+            item.iana = command.at("iana").get<Iana>();
+        }
+        else
+        {
+            item.netFn = command.at("netfn").get<NetFn>();
+        }
+    }
+
+    auto& provider =
+        lazyProviders.emplace_back(std::make_unique<LazyProvider>());
+    provider->path = lib;
+    provider->background = listing.value("background", true);
+    HandlerBase::ptr stub = std::make_shared<LazyProviderHandler>(*provider);
+
+    for (const LazyCommand& item : commands)
+    {
+        if (item.group)
+        {
+            impl::registerGroupHandler(prioLazyProvider, *item.group, item.cmd,
+                                       Privilege::None, stub);
+        }
+        else if (item.iana)
+        {
+            impl::registerOemHandler(prioLazyProvider, *item.iana, item.cmd,
+                                     Privilege::None, stub);
+        }
+        else if (!impl::registerHandler(prioLazyProvider, item.netFn, item.cmd,
+                                        Privilege::None, stub))
+        {
+            log<level::ERR>("Invalid command in IPMI provider manifest",
+                            entry("PROVIDER=%s", lib.c_str()),
+                            entry("NETFN=0x%X", item.netFn),
+                            entry("CMD=0x%X", item.cmd));
+        }
+    }
+}
+
+/* read the provider manifest; the keys are provider file names */
+static nlohmann::json readProviderManifest()
+{
+    std::ifstream manifestFile(IPMI_PROVIDER_MANIFEST);
+    if (!manifestFile.is_open())
+    {
+        return nlohmann::json::object();
+    }
+    auto manifest = nlohmann::json::parse(manifestFile, nullptr, false);
+    if (manifest.is_discarded() || !manifest.is_object())
+    {
+        log<level::ERR>("IPMI provider manifest parser failure",
+                        entry("MANIFEST=%s", IPMI_PROVIDER_MANIFEST));
+        return nlohmann::json::object();
+    }
+    return manifest;
+}
+
+/* open the remaining lazy providers one at a time, so requests keep being
+ * answered in between */
+static void loadProvidersInBackground(boost::asio::io_context& io,
+                                      stats::Clock::time_point startup)
+{
+    for (auto& provider : lazyProviders)
+    {
+        if (!provider->loaded && provider->background)
+        {
+            boost::asio::post(io, [&io, &provider, startup]() {
+                loadLazyProvider(*provider);
+                loadProvidersInBackground(io, startup);
+            });
+            return;
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        stats::Clock::now() - startup);
+    startup::phase("background providers loaded");
+    log<level::INFO>("All IPMI providers loaded",
+                     entry("DURATION_MS=%lld",
+                           static_cast<long long>(elapsed.count())));
+}
+
 // Plugin libraries need to contain .so either at the end or in the middle
 constexpr const char ipmiPluginExtn[] = ".so";
 
-/* return a list of self-closing library handles */
+/* return a list of self-closing library handles
+ *
+ * Providers listed in the manifest are not opened here; their commands are
+ * registered to stand-in handlers that open them on demand.
+ */
 std::forward_list<IpmiProvider> loadProviders(const fs::path& ipmiLibsPath)
 {
     std::vector<fs::path> libs;
@@ -648,6 +1134,7 @@ std::forward_list<IpmiProvider> loadProviders(const fs::path& ipmiLibsPath)
     }
     std::sort(libs.begin(), libs.end());
 
+    nlohmann::json manifest = readProviderManifest();
     std::forward_list<IpmiProvider> handles;
     for (auto& lib : libs)
     {
@@ -655,11 +1142,346 @@ std::forward_list<IpmiProvider> loadProviders(const fs::path& ipmiLibsPath)
         log<level::DEBUG>("Registering handler",
                           entry("HANDLER=%s", lib.c_str()));
 #endif
-        handles.emplace_front(lib.c_str());
+        auto listing = manifest.find(lib.filename().string());
+        if (listing != manifest.end())
+        {
+            try
+            {
+                registerLazyProvider(lib, *listing);
+                continue;
+            }
+            catch (const std::exception& e)
+            {
+                log<level::ERR>("Invalid IPMI provider manifest entry",
+                                entry("PROVIDER=%s", lib.c_str()),
+                                entry("ERROR=%s", e.what()));
+            }
+        }
+        openProvider(handles, lib);
     }
     return handles;
 }
 
+/* how long a reload waits for the requests still running on the handlers
+ * of the provider before it gives up */
+constexpr auto reloadDrainTimeout = std::chrono::seconds(10);
+
+/* true once no request holds a handler or filter taken out of the tables;
+ * a handler registered for several commands was taken out once for each */
+static bool drained(const Registrations& taken)
+{
+    std::unordered_map<const HandlerBase*, long> held;
+    for (const auto& registered : taken.handlers)
+    {
+        held[std::get<HandlerBase::ptr>(registered.item).get()]++;
+    }
+    for (const auto& registered : taken.handlers)
+    {
+        const HandlerBase::ptr& handler =
+            std::get<HandlerBase::ptr>(registered.item);
+        if (handler.use_count() > held[handler.get()])
+        {
+            return false;
+        }
+    }
+    for (const auto& [prio, filter] : taken.filters)
+    {
+        if (filter.use_count() > 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* glibc never unloads a library that defines unique symbols, so its
+ * constructors would not run again; a provider is built with
+ * -fno-gnu-unique to be reloadable */
+static bool definesUniqueSymbols(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> image((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    if (image.size() < sizeof(ElfW(Ehdr)))
+    {
+        return true;
+    }
+    const auto* header = reinterpret_cast<const ElfW(Ehdr)*>(image.data());
+    if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 ||
+        header->e_shoff > image.size() ||
+        header->e_shnum > (image.size() - header->e_shoff) / sizeof(ElfW(Shdr)))
+    {
+        return true;
+    }
+    const auto* sections =
+        reinterpret_cast<const ElfW(Shdr)*>(image.data() + header->e_shoff);
+    for (size_t i = 0; i < header->e_shnum; i++)
+    {
+        const ElfW(Shdr)& section = sections[i];
+        if (section.sh_type != SHT_DYNSYM)
+        {
+            continue;
+        }
+        if (section.sh_offset > image.size() ||
+            section.sh_size > image.size() - section.sh_offset)
+        {
+            return true;
+        }
+        const auto* symbols = reinterpret_cast<const ElfW(Sym)*>(
+            image.data() + section.sh_offset);
+        size_t count = section.sh_size / sizeof(ElfW(Sym));
+        for (size_t j = 0; j < count; j++)
+        {
+            if (ELFW(ST_BIND)(symbols[j].st_info) == STB_GNU_UNIQUE &&
+                symbols[j].st_shndx != SHN_UNDEF)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* an address out of the dynamic section of a loaded object; glibc
+ * relocates them in place on most targets, but not on all */
+static const char* dynamicString(const link_map* object, ElfW(Addr) strtab,
+                                 ElfW(Xword) offset)
+{
+    if (strtab < object->l_addr)
+    {
+        strtab += object->l_addr;
+    }
+    return reinterpret_cast<const char*>(strtab) + offset;
+}
+
+/* the strings an object lists under tag in its dynamic section */
+static std::vector<std::string> dynamicNames(const link_map* object,
+                                             ElfW(Sxword) tag)
+{
+    std::vector<std::string> names;
+    if (!object->l_ld)
+    {
+        return names;
+    }
+    ElfW(Addr) strtab = 0;
+    for (const ElfW(Dyn)* dyn = object->l_ld; dyn->d_tag != DT_NULL; dyn++)
+    {
+        if (dyn->d_tag == DT_STRTAB)
+        {
+            strtab = dyn->d_un.d_ptr;
+        }
+    }
+    if (!strtab)
+    {
+        return names;
+    }
+    for (const ElfW(Dyn)* dyn = object->l_ld; dyn->d_tag != DT_NULL; dyn++)
+    {
+        if (dyn->d_tag == tag)
+        {
+            names.emplace_back(dynamicString(object, strtab, dyn->d_un.d_val));
+        }
+    }
+    return names;
+}
+
+/* true if closing the provider would leave it mapped, because it is
+ * marked nodelete or another loaded library needs it; its constructors
+ * would not run again when it is opened */
+static bool staysResident(void* handle)
+{
+    link_map* provider = nullptr;
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &provider) != 0 || !provider)
+    {
+        return true;
+    }
+    for (const ElfW(Dyn)* dyn = provider->l_ld; dyn && dyn->d_tag != DT_NULL;
+         dyn++)
+    {
+        if (dyn->d_tag == DT_FLAGS_1 && (dyn->d_un.d_val & DF_1_NODELETE))
+        {
+            return true;
+        }
+    }
+
+    // the other libraries name it by its soname, or by its file name
+    std::vector<std::string> names = dynamicNames(provider, DT_SONAME);
+    names.emplace_back(fs::path(provider->l_name).filename());
+    const link_map* object = provider;
+    while (object->l_prev)
+    {
+        object = object->l_prev;
+    }
+    for (; object; object = object->l_next)
+    {
+        if (object == provider)
+        {
+            continue;
+        }
+        for (const std::string& needed : dynamicNames(object, DT_NEEDED))
+        {
+            if (std::find(names.begin(), names.end(), needed) != names.end())
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* only root may swap the code ipmid runs */
+static bool callerIsRoot(sdbusplus::message::message& msg)
+{
+    sd_bus_creds* creds = nullptr;
+    uid_t uid = 0;
+    bool root = sd_bus_query_sender_creds(msg.get(), SD_BUS_CREDS_EUID,
+                                          &creds) >= 0 &&
+                sd_bus_creds_get_euid(creds, &uid) >= 0 && uid == 0;
+    sd_bus_creds_unref(creds);
+    return root;
+}
+
+/** @brief Unload a provider and open it again, while ipmid keeps running
+ *
+ *  Its handlers and filters are taken out, the requests still running on
+ *  them are waited for, and the library is closed and opened again so its
+ *  constructors register the new handlers. The caches of ipmid and libipmid
+ *  stay as they are; the response cache of a command is emptied when the
+ *  new handler registers it again.
+ *
+ *  Only a provider that declares IPMI_PROVIDER_RELOADABLE is unloaded; what
+ *  else a library registers (matches, signal handlers, oem::Router handlers,
+ *  posted work, warm-up tasks) can't be taken out, and would be left
+ *  pointing into the unloaded code.
+ *
+ *  @param[in] yield - the coroutine of the D-Bus method call
+ *  @param[in] msg - the method call, for the credentials of its sender
+ *  @param[in] name - file name of the provider, as installed
+ *
+ *  @return true if the provider was opened again
+ */
+static bool reloadProvider(boost::asio::yield_context yield,
+                           sdbusplus::message::message& msg,
+                           const std::string& name)
+{
+    static bool reloading = false;
+    if (!callerIsRoot(msg))
+    {
+        log<level::ERR>("IPMI provider reload refused; caller is not root",
+                        entry("PROVIDER=%s", name.c_str()),
+                        entry("SENDER=%s", msg.get_sender()));
+        return false;
+    }
+    IpmiProvider* provider = nullptr;
+    for (auto* handles : {&providers, &lazyHandles})
+    {
+        for (IpmiProvider& handle : *handles)
+        {
+            if (fs::path(handle.name).filename() == name)
+            {
+                provider = &handle;
+            }
+        }
+    }
+    if (!provider || !provider->isOpen())
+    {
+        log<level::ERR>("No such IPMI provider to reload",
+                        entry("PROVIDER=%s", name.c_str()));
+        return false;
+    }
+    if (reloading)
+    {
+        log<level::ERR>("An IPMI provider is already being reloaded",
+                        entry("PROVIDER=%s", name.c_str()));
+        return false;
+    }
+    if (definesUniqueSymbols(provider->name))
+    {
+        log<level::ERR>("IPMI provider defines unique symbols and can't be "
+                        "unloaded; build it with -fno-gnu-unique",
+                        entry("PROVIDER=%s", name.c_str()));
+        return false;
+    }
+    if (!dlsym(provider->addr, "ipmiProviderReloadable"))
+    {
+        log<level::ERR>("IPMI provider isn't declared reloadable",
+                        entry("PROVIDER=%s", name.c_str()));
+        return false;
+    }
+    reloading = true;
+
+    Registrations taken = takeRegistrations(provider->name);
+    boost::asio::steady_timer timer(*getIoContext());
+    auto giveUp = stats::Clock::now() + reloadDrainTimeout;
+    while (!drained(taken))
+    {
+        boost::system::error_code ec;
+        timer.expires_after(std::chrono::milliseconds(10));
+        timer.async_wait(yield[ec]);
+        if (ec || stats::Clock::now() >= giveUp)
+        {
+            log<level::ERR>("IPMI provider still busy; not reloaded",
+                            entry("PROVIDER=%s", name.c_str()));
+            restoreRegistrations(provider->name, std::move(taken));
+            reloading = false;
+            return false;
+        }
+    }
+
+    // checked once drained, since a provider loaded meanwhile may need it
+    if (staysResident(provider->addr))
+    {
+        log<level::ERR>("IPMI provider is needed by another library or "
+                        "can't be unloaded; not reloaded",
+                        entry("PROVIDER=%s", name.c_str()));
+        restoreRegistrations(provider->name, std::move(taken));
+        reloading = false;
+        return false;
+    }
+
+    // no request holds the old handlers now, so they can go before the
+    // code they run does
+    size_t handlers = taken.handlers.size();
+    taken = Registrations();
+    provider->close();
+    if (void* resident =
+            dlopen(provider->name.c_str(), RTLD_NOW | RTLD_NOLOAD))
+    {
+        // something staysResident() can't see, such as another dlopen of
+        // it with RTLD_NODELETE, kept it loaded, so its constructors won't
+        // register its handlers again
+        log<level::ERR>("IPMI provider stayed loaded; restart ipmid to "
+                        "restore its commands",
+                        entry("PROVIDER=%s", name.c_str()));
+        provider->addr = resident;
+        reloading = false;
+        return false;
+    }
+    // the reporters of its caches went with the library
+    size_t caches = cache_stats::unregisterCaches([](cache_stats::Reporter r) {
+        Dl_info info;
+        return dladdr(reinterpret_cast<void*>(r), &info) == 0;
+    });
+
+    startup::beginProvider(provider->name);
+    setRegistrant(provider->name);
+    provider->open();
+    setRegistrant({});
+    startup::endProvider();
+    reloading = false;
+    if (!provider->isOpen())
+    {
+        return false;
+    }
+    log<level::INFO>("IPMI provider reloaded",
+                     entry("PROVIDER=%s", name.c_str()),
+                     entry("HANDLERS=%zu", handlers),
+                     entry("REGISTRATIONS=%zu",
+                           startup::getProviders().back().registrations),
+                     entry("CACHES=%zu", caches));
+    return true;
+}
+
 } // namespace ipmi
 
 #ifdef ALLOW_DEPRECATED_API
@@ -667,8 +1489,17 @@ std::forward_list<IpmiProvider> loadProviders(const fs::path& ipmiLibsPath)
 void ipmi_register_callback(ipmi_netfn_t netFn, ipmi_cmd_t cmd,
                             ipmi_context_t context, ipmid_callback_t handler,
                             ipmi_cmd_privilege_t priv)
+{
+    ipmi_register_callback(netFn, cmd, context, handler, priv,
+                           ipmi::HandlerFlags::none);
+}
+
+void ipmi_register_callback(ipmi_netfn_t netFn, ipmi_cmd_t cmd,
+                            ipmi_context_t context, ipmid_callback_t handler,
+                            ipmi_cmd_privilege_t priv, ipmi::HandlerFlags flags)
 {
     auto h = ipmi::makeLegacyHandler(handler, context);
+    h->flags = flags;
     // translate priv from deprecated enum to current
     ipmi::Privilege realPriv;
     switch (priv)
@@ -747,11 +1578,12 @@ void handleLegacyIpmiCommand(sdbusplus::message::message& m)
     unsigned char seq, netFn, lun, cmd;
     std::vector<uint8_t> data;
 
-    m.read(seq, netFn, lun, cmd, data);
+    m.read(seq, netFn, lun, cmd);
+    ipmi::readBytes(m, data);
 
-    auto ctx = std::make_shared<ipmi::Context>(netFn, cmd, 0, 0,
-                                               ipmi::Privilege::Admin);
-    auto request = std::make_shared<ipmi::message::Request>(
+    auto ctx = ipmi::message::makeShared<ipmi::Context>(
+        netFn, cmd, 0, 0, ipmi::Privilege::Admin);
+    auto request = ipmi::message::makeShared<ipmi::message::Request>(
         ctx, std::forward<std::vector<uint8_t>>(data));
     ipmi::message::Response::ptr response = ipmi::executeIpmiCommand(request);
 
@@ -763,25 +1595,40 @@ void handleLegacyIpmiCommand(sdbusplus::message::message& m)
 
     dest = m.get_sender();
     path = m.get_path();
-    getSdBus()->async_method_call([](boost::system::error_code ec) {}, dest,
-                                  path, DBUS_INTF, "sendMessage", seq, netFn,
-                                  lun, cmd, response->cc,
-                                  response->payload.raw);
+    auto call = getSdBus()->new_method_call(dest, path, DBUS_INTF,
+                                            "sendMessage");
+    call.append(seq, netFn, lun, cmd, response->cc);
+    ipmi::appendBytes(call, std::move(response->payload.raw));
+    getSdBus()->async_send(
+        call, [](boost::system::error_code, sdbusplus::message::message) {});
 }
 
 #endif /* ALLOW_DEPRECATED_API */
 
 // Calls host command manager to do the right thing for the command
 using CommandHandler = phosphor::host::command::CommandHandler;
-std::unique_ptr<phosphor::host::command::Manager> cmdManager;
+// one queue of commands for each host, so one host reading its commands
+// never holds up another
+std::vector<std::unique_ptr<phosphor::host::command::Manager>> cmdManagers;
+void ipmid_send_cmd_to_host(size_t host, CommandHandler&& cmd)
+{
+    return cmdManagers.at(host)->execute(std::forward<CommandHandler>(cmd));
+}
+
 void ipmid_send_cmd_to_host(CommandHandler&& cmd)
 {
-    return cmdManager->execute(std::forward<CommandHandler>(cmd));
+    return ipmid_send_cmd_to_host(0, std::forward<CommandHandler>(cmd));
+}
+
+std::unique_ptr<phosphor::host::command::Manager>&
+    ipmid_get_host_cmd_manager(size_t host)
+{
+    return cmdManagers.at(host);
 }
 
 std::unique_ptr<phosphor::host::command::Manager>& ipmid_get_host_cmd_manager()
 {
-    return cmdManager;
+    return ipmid_get_host_cmd_manager(0);
 }
 
 // These are symbols that are present in libipmid, but not expected
@@ -791,6 +1638,9 @@ extern void setSdBus(std::shared_ptr<sdbusplus::asio::connection>& newBus);
 
 int main(int argc, char* argv[])
 {
+    ipmi::stats::Clock::time_point startup = ipmi::stats::Clock::now();
+    ipmi::startup::phase("main");
+
     // Connect to system bus
     auto io = std::make_shared<boost::asio::io_context>();
     setIoContext(io);
@@ -804,7 +1654,22 @@ int main(int argc, char* argv[])
     }
     auto sdbusp = std::make_shared<sdbusplus::asio::connection>(*io, bus);
     setSdBus(sdbusp);
+    ipmi::startup::phase("bus connected");
     sdbusp->request_name("xyz.openbmc_project.Ipmi.Host");
+    ipmi::startup::phase("bus name requested");
+
+    // the mapper subtrees most handlers look up; the providers queue their
+    // own caches as they are opened
+    for (const std::string& root : ipmi::getSubtreeIndexRoots())
+    {
+        ipmi::warmup::add("subtree " + root, [root](ipmi::Context::ptr ctx) {
+            boost::system::error_code ec = ipmi::warmSubtreeIndex(ctx, root);
+            if (ec)
+            {
+                throw boost::system::system_error(ec);
+            }
+        });
+    }
 
     // TODO: Hack to keep the sdEvents running.... Not sure why the sd_event
     //       queue stops running if we don't have a timer that keeps re-arming
@@ -815,18 +1680,46 @@ int main(int argc, char* argv[])
     //       until that is done, add the sd_event wrapper to the io object
     sdbusplus::asio::sd_event_wrapper sdEvents(*io);
 
-    cmdManager = std::make_unique<phosphor::host::command::Manager>(*sdbusp);
+    ipmi::ObjectCache::instance().setLimit(IPMI_OBJECT_CACHE_LIMIT);
+
+    for (size_t host = 0; host < IPMI_HOST_INSTANCES; host++)
+    {
+        cmdManagers.emplace_back(
+            std::make_unique<phosphor::host::command::Manager>(*sdbusp, host));
+    }
+    // events for a host raise SMS_ATN through its command queue
+    ipmi::events::setNotifier(
+        [](size_t host) { cmdManagers.at(host)->alertEvents(); });
+    ipmi::startup::phase("host command manager");
 
     // Register all command providers and filters
-    std::forward_list<ipmi::IpmiProvider> providers =
-        ipmi::loadProviders(HOST_IPMI_LIB_PATH);
+    ipmi::providers = ipmi::loadProviders(HOST_IPMI_LIB_PATH);
+    ipmi::startup::phase("providers loaded");
 
     // Add bindings for inbound IPMI requests
+    // The execute method is served from a plain vtable rather than an
+    // sdbusplus::asio interface so ipmid owns the request coroutines and
+    // can bound their number and stack size.
+    sdbusplus::server::interface::interface executeIface(
+        *sdbusp, "/xyz/openbmc_project/Ipmi", "xyz.openbmc_project.Ipmi.Server",
+        ipmi::executeVtable, nullptr);
     auto server = sdbusplus::asio::object_server(sdbusp);
-    auto iface = server.add_interface("/xyz/openbmc_project/Ipmi",
-                                      "xyz.openbmc_project.Ipmi.Server");
-    iface->register_method("execute", ipmi::executionEntry);
-    iface->initialize();
+
+    // publish the per-command request statistics
+    ipmi::stats::initialize(server);
+
+    // run several requests in one, through the same dispatch
+    ipmi::batch::initialize();
+
+    // let an updated provider replace the running one
+    auto providersIface =
+        server.add_interface("/xyz/openbmc_project/Ipmi/Providers",
+                             "xyz.openbmc_project.Ipmi.Providers");
+    providersIface->register_method("Reload", ipmi::reloadProvider);
+    providersIface->initialize();
+
+    // in-box clients may skip the D-Bus hop
+    ipmi::local::initialize(*io, ipmi::executeLocalRequest);
 
 #ifdef ALLOW_DEPRECATED_API
     // listen on deprecated signal interface for kcs/bt commands
@@ -844,6 +1737,7 @@ int main(int argc, char* argv[])
                 ipmi::ipmiDbusChannelMatch),
         ipmi::nameChangeHandler);
     ipmi::doListNames(*io, *sdbusp);
+    ipmi::startup::phase("interfaces added");
 
     // set up boost::asio signal handling
     std::function<SignalResponse(int)> stopAsioRunLoop =
@@ -856,15 +1750,47 @@ int main(int argc, char* argv[])
     registerSignalHandler(ipmi::prioOpenBmcBase, SIGINT, stopAsioRunLoop);
     registerSignalHandler(ipmi::prioOpenBmcBase, SIGTERM, stopAsioRunLoop);
 
+    // run thread-safe handlers on the workers; everything else, including
+    // the legacy handlers, stays on this thread
+    ipmi::threads::initialize(IPMI_HANDLER_THREADS);
+    ipmi::startup::phase("ready");
+    ipmi::startup::report();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        ipmi::stats::Clock::now() - startup);
+    log<level::INFO>("IPMI daemon ready",
+                     entry("DURATION_MS=%lld",
+                           static_cast<long long>(elapsed.count())));
+    // fill the caches alongside the first requests, which read through to
+    // D-Bus for whatever isn't cached yet
+    ipmi::warmup::start(
+        IPMI_WARMUP_PARALLEL, [](const ipmi::warmup::Report& report) {
+            ipmi::startup::phase("caches warmed");
+            auto elapsed =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    report.duration);
+            log<level::INFO>("IPMI caches warmed",
+                             entry("DURATION_MS=%lld",
+                                   static_cast<long long>(elapsed.count())),
+                             entry("TASKS=%zu", report.tasks),
+                             entry("FAILED=%zu", report.failed));
+        });
+
+    // open the providers that were left for later once requests are flowing
+    ipmi::loadProvidersInBackground(*io, startup);
+
     io->run();
 
+    ipmi::local::shutdown();
+    ipmi::threads::shutdown();
+
     // destroy all the IPMI handlers so the providers can unload safely
-    ipmi::handlerMap.clear();
-    ipmi::groupHandlerMap.clear();
-    ipmi::oemHandlerMap.clear();
-    ipmi::filterList.clear();
+    ipmi::clearHandlers();
+    ipmi::cache::clear();
     // unload the provider libraries
-    providers.clear();
+    ipmi::providers.clear();
+    ipmi::lazyHandles.clear();
+    ipmi::lazyProviders.clear();
 
     return 0;
 }
@@ -2,6 +2,8 @@
 
 #include <malloc.h>
 
+#include <array>
+
 extern uint8_t find_type_for_sensor_number(uint8_t);
 
 struct sensorRES_t
@@ -49,7 +51,7 @@ struct event_data_t
     char text[64];
 };
 
-event_data_t g_fwprogress02h[] = {{0x00, "Unspecified"},
+constexpr event_data_t g_fwprogress02h[] = {{0x00, "Unspecified"},
                                   {0x01, "Memory Init"},
                                   {0x02, "HD Init"},
                                   {0x03, "Secondary Proc Init"},
@@ -77,7 +79,7 @@ event_data_t g_fwprogress02h[] = {{0x00, "Unspecified"},
                                   {0x19, "Primary Proc Init"},
                                   {0xFF, "Unknown"}};
 
-event_data_t g_fwprogress00h[] = {
+constexpr event_data_t g_fwprogress00h[] = {
     {0x00, "Unspecified."},
     {0x01, "No system memory detected"},
     {0x02, "No usable system memory"},
@@ -95,19 +97,11 @@ event_data_t g_fwprogress00h[] = {
     {0xFF, "unknown"},
 };
 
-char* event_data_lookup(event_data_t* p, uint8_t b)
+// The tables are indexed by their data byte and end with a catch-all entry
+template <size_t N>
+const char* event_data_lookup(const event_data_t (&p)[N], uint8_t b)
 {
-
-    while (p->data != 0xFF)
-    {
-        if (p->data == b)
-        {
-            break;
-        }
-        p++;
-    }
-
-    return p->text;
+    return b < N - 1 ? p[b].text : p[N - 1].text;
 }
 
 //  The fw progress sensor contains some additional information that needs to be
@@ -205,7 +199,7 @@ int set_sensor_dbus_state_system_event(const sensorRES_t* pRec,
 //  This table lists only senors we care about telling dbus about.
 //  Offset definition cab be found in section 42.2 of the IPMI 2.0
 //  spec.  Add more if/when there are more items of interest.
-lookup_t g_ipmidbuslookup[] = {
+constexpr lookup_t g_ipmidbuslookup[] = {
 
     {0xe9, 0x00, set_sensor_dbus_state_simple, "setValue", "Disabled",
      ""}, // OCC Inactive 0
@@ -249,36 +243,57 @@ lookup_t g_ipmidbuslookup[] = {
     {0xCA, 0x01, set_sensor_dbus_state_simple, "setValue", "Enabled", ""},
     {0xFF, 0xFF, NULL, "", "", ""}};
 
+/* maps a sensor type and event offset to the entry of g_ipmidbuslookup
+ * that reports it, or -1 when the event is not reported */
+using LookupIndex = std::array<std::array<int8_t, 16>, 256>;
+
+constexpr LookupIndex makeLookupIndex()
+{
+    LookupIndex index{};
+    for (auto& offsets : index)
+    {
+        for (auto& entry : offsets)
+        {
+            entry = -1;
+        }
+    }
+    for (size_t i = 0; g_ipmidbuslookup[i].sensor_type != 0xFF; i++)
+    {
+        const lookup_t& entry = g_ipmidbuslookup[i];
+        int8_t& slot = index[entry.sensor_type][entry.offset];
+        // the first entry wins, as it did for the linear search
+        if (slot < 0)
+        {
+            slot = i;
+        }
+    }
+    return index;
+}
+
+constexpr LookupIndex g_lookupIndex = makeLookupIndex();
+
+static_assert(sizeof(g_ipmidbuslookup) / sizeof(g_ipmidbuslookup[0]) <= 128,
+              "g_lookupIndex holds the entries as int8_t");
+
 void reportSensorEventAssert(const sensorRES_t* pRec, int index)
 {
-    lookup_t* pTable = &g_ipmidbuslookup[index];
+    const lookup_t* pTable = &g_ipmidbuslookup[index];
     (*pTable->func)(pRec, pTable, pTable->assertion);
 }
 void reportSensorEventDeassert(const sensorRES_t* pRec, int index)
 {
-    lookup_t* pTable = &g_ipmidbuslookup[index];
+    const lookup_t* pTable = &g_ipmidbuslookup[index];
     (*pTable->func)(pRec, pTable, pTable->deassertion);
 }
 
 int findindex(const uint8_t sensor_type, int offset, int* index)
 {
-
-    int i = 0, rc = 0;
-    lookup_t* pTable = g_ipmidbuslookup;
-
-    do
+    if (offset < 0 || offset >= 16 || g_lookupIndex[sensor_type][offset] < 0)
     {
-        if (((pTable + i)->sensor_type == sensor_type) &&
-            ((pTable + i)->offset == offset))
-        {
-            rc = 1;
-            *index = i;
-            break;
-        }
-        i++;
-    } while ((pTable + i)->sensor_type != 0xFF);
-
-    return rc;
+        return 0;
+    }
+    *index = g_lookupIndex[sensor_type][offset];
+    return 1;
 }
 
 bool shouldReport(uint8_t sensorType, int offset, int* index)
@@ -317,7 +332,8 @@ int updateSensorRecordFromSSRAESC(const void* record)
         shouldReport(stype, 0x00, &index);
         reportSensorEventAssert(pRec, index);
     }
-    else
+    else if (pRec->assert_state7_0 || pRec->assert_state14_8 ||
+             pRec->deassert_state7_0 || pRec->deassert_state14_8)
     {
         // Scroll through each bit position .  Determine
         // if any bit is either asserted or Deasserted.
@@ -1,8 +1,57 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <utility>
-#include <vector>
 
 using netfncmd_pair = std::pair<unsigned char, unsigned char>;
 
-extern const std::vector<netfncmd_pair> whitelist;
+/* one bit for every NetFn/Cmd; the NetFn is only 6 bits on the wire */
+constexpr size_t whitelistNetFnCount = 1 << 6;
+constexpr size_t whitelistBits = whitelistNetFnCount << 8;
+using WhitelistBitmap = std::array<uint64_t, whitelistBits / 64>;
+
+/** @brief Build the whitelist bitmap from a list of NetFn/Cmd pairs
+ *
+ *  This is constexpr so the generated whitelist is built by the compiler
+ *  and placed in read-only data instead of being built at static-init time.
+ *
+ *  @param[in] cmds - NetFn/Cmd pairs to allow
+ *  @return the bitmap with a bit set for each allowed NetFn/Cmd
+ */
+constexpr WhitelistBitmap
+    makeWhitelist(std::initializer_list<netfncmd_pair> cmds)
+{
+    WhitelistBitmap bitmap{};
+    for (const netfncmd_pair& item : cmds)
+    {
+        if (item.first < whitelistNetFnCount)
+        {
+            size_t bit = (static_cast<size_t>(item.first) << 8) | item.second;
+            bitmap[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+        }
+    }
+    return bitmap;
+}
+
+/** @brief Test if a NetFn/Cmd is set in the whitelist bitmap
+ *
+ *  @param[in] bitmap - whitelist bitmap to test
+ *  @param[in] netfn - NetFn of the command
+ *  @param[in] cmd - command number
+ *  @return true if the NetFn/Cmd is whitelisted
+ */
+constexpr bool isWhitelisted(const WhitelistBitmap& bitmap, unsigned char netfn,
+                             unsigned char cmd)
+{
+    if (netfn >= whitelistNetFnCount)
+    {
+        return false;
+    }
+    size_t bit = (static_cast<size_t>(netfn) << 8) | cmd;
+    return (bitmap[bit / 64] >> (bit % 64)) & 1;
+}
+
+extern const WhitelistBitmap whitelist;
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <ipmid/cache-stats.hpp>
+#include <limits>
+#include <map>
+
+namespace ipmi
+{
+namespace cache_stats
+{
+
+namespace
+{
+
+/* caches may register themselves during static initialization */
+std::map<std::string, Reporter>& reporters()
+{
+    static std::map<std::string, Reporter> registered;
+    return registered;
+}
+
+/* narrow a count for the report, saturating on overflow */
+inline uint32_t saturate(size_t value)
+{
+    return static_cast<uint32_t>(std::min<size_t>(
+        value, std::numeric_limits<uint32_t>::max()));
+}
+
+} // namespace
+
+void registerCache(const std::string& name, Reporter reporter)
+{
+    reporters()[name] = reporter;
+}
+
+size_t unregisterCaches(const std::function<bool(Reporter)>& pick)
+{
+    size_t taken = 0;
+    auto& registered = reporters();
+    for (auto iter = registered.begin(); iter != registered.end();)
+    {
+        if (pick(iter->second))
+        {
+            iter = registered.erase(iter);
+            taken++;
+        }
+        else
+        {
+            iter++;
+        }
+    }
+    return taken;
+}
+
+std::vector<Entry> get()
+{
+    std::vector<Entry> entries;
+    entries.reserve(reporters().size());
+    for (const auto& [name, reporter] : reporters())
+    {
+        Usage usage = reporter();
+        entries.emplace_back(name, saturate(usage.entries), usage.bytes,
+                             saturate(usage.limit), usage.evictions);
+    }
+    return entries;
+}
+
+} // namespace cache_stats
+} // namespace ipmi
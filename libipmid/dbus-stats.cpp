@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <climits>
+#include <ipmid/dbus-stats.hpp>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace ipmi
+{
+namespace dbus_stats
+{
+
+namespace
+{
+
+struct CallStats
+{
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t totalTime = 0;
+    uint64_t maxTime = 0;
+    Histogram histogram{};
+};
+
+using Key = std::tuple<uint8_t, uint8_t, std::string, std::string>;
+
+/* handlers on worker threads may make calls too */
+std::mutex statsMutex;
+std::map<Key, CallStats> callStats;
+
+/* per thread, so the workers attribute their calls to their own request */
+thread_local Command current;
+
+inline size_t bucketIndex(uint64_t us)
+{
+    if (us == 0)
+    {
+        return 0;
+    }
+    // floor(log2(us)), clamped to the last bucket
+    size_t bucket = (sizeof(us) * CHAR_BIT) - 1 - __builtin_clzll(us);
+    return std::min(bucket, histogramBuckets - 1);
+}
+
+} // namespace
+
+void setCommand(uint8_t netFn, uint8_t cmd, uint8_t channel,
+                uint32_t requestId)
+{
+    current = {netFn, cmd, channel, requestId};
+}
+
+Command getCommand()
+{
+    return current;
+}
+
+void record(const std::string& service, const std::string& member,
+            Clock::duration elapsed, bool failed)
+{
+    record(current.netFn, current.cmd, service, member, elapsed, failed);
+}
+
+void record(uint8_t netFn, uint8_t cmd, const std::string& service,
+            const std::string& member, Clock::duration elapsed, bool failed)
+{
+    uint64_t us =
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    CallStats& stats = callStats[Key(netFn, cmd, service, member)];
+    stats.count++;
+    if (failed)
+    {
+        stats.errors++;
+    }
+    stats.totalTime += us;
+    stats.maxTime = std::max(stats.maxTime, us);
+
+    uint32_t& bucket = stats.histogram[bucketIndex(us)];
+    if (bucket < std::numeric_limits<uint32_t>::max())
+    {
+        bucket++;
+    }
+}
+
+std::vector<Entry> get()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    std::vector<Entry> entries;
+    entries.reserve(callStats.size());
+    for (const auto& [key, stats] : callStats)
+    {
+        const auto& [netFn, cmd, service, member] = key;
+        entries.emplace_back(netFn, cmd, service, member, stats.count,
+                             stats.errors, stats.totalTime, stats.maxTime,
+                             std::vector<uint32_t>(stats.histogram.begin(),
+                                                   stats.histogram.end()));
+    }
+    return entries;
+}
+
+void reset()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    callStats.clear();
+}
+
+} // namespace dbus_stats
+} // namespace ipmi
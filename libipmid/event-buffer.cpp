@@ -0,0 +1,131 @@
+#include "config.h"
+
+#include <atomic>
+#include <ipmid/api.hpp>
+#include <ipmid/event-buffer.hpp>
+#include <ipmid/log-limit.hpp>
+#include <ipmid/ring-buffer.hpp>
+
+namespace ipmi
+{
+namespace events
+{
+
+namespace
+{
+
+struct Buffer
+{
+    RingBuffer<Message, IPMI_EVENT_BUFFER_ENTRIES> ring;
+    std::atomic<uint64_t> overflows{0};
+#ifdef IPMI_EVENT_BUFFER_AT_STARTUP
+    std::atomic<bool> enabled{true};
+#else
+    // until the host asks for it with Set BMC Global Enables
+    std::atomic<bool> enabled{false};
+#endif
+};
+
+std::array<Buffer, IPMI_HOST_INSTANCES> buffers;
+std::atomic<Notifier> notifier{nullptr};
+
+Buffer* bufferOf(size_t host)
+{
+    return host < buffers.size() ? &buffers[host] : nullptr;
+}
+
+} // namespace
+
+bool post(size_t host, const Message& message)
+{
+    Buffer* buffer = bufferOf(host);
+    if (!buffer || !buffer->enabled.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+    bool first = buffer->ring.empty();
+    if (!buffer->ring.push(message))
+    {
+        buffer->overflows.fetch_add(1, std::memory_order_relaxed);
+        using namespace phosphor::logging;
+        logLimited<level::WARNING>(
+            "Event message buffer full; event dropped",
+            entry("HOST=%zu", host),
+            entry("OVERFLOWS=%llu", static_cast<unsigned long long>(
+                                        buffer->overflows.load())));
+        return false;
+    }
+    if (first)
+    {
+        // the host is alerted once; it reads the buffer until it is empty
+        post_work([host]() {
+            if (Notifier notify = notifier.load())
+            {
+                notify(host);
+            }
+        });
+    }
+    return true;
+}
+
+bool take(size_t host, Message& message)
+{
+    Buffer* buffer = bufferOf(host);
+    return buffer && buffer->ring.pop(message);
+}
+
+size_t pending(size_t host)
+{
+    Buffer* buffer = bufferOf(host);
+    return buffer ? buffer->ring.size() : 0;
+}
+
+uint64_t overflows(size_t host)
+{
+    Buffer* buffer = bufferOf(host);
+    return buffer ? buffer->overflows.load(std::memory_order_relaxed) : 0;
+}
+
+void setEnabled(size_t host, bool enable)
+{
+    Buffer* buffer = bufferOf(host);
+    if (!buffer)
+    {
+        return;
+    }
+    buffer->enabled.store(enable, std::memory_order_relaxed);
+    if (!enable)
+    {
+        Message message;
+        while (buffer->ring.pop(message))
+        {
+        }
+    }
+}
+
+bool enabled(size_t host)
+{
+    Buffer* buffer = bufferOf(host);
+    return buffer && buffer->enabled.load(std::memory_order_relaxed);
+}
+
+void setNotifier(Notifier notify)
+{
+    notifier.store(notify);
+}
+
+cache_stats::Usage usage()
+{
+    cache_stats::Usage usage;
+    for (Buffer& buffer : buffers)
+    {
+        usage.entries += buffer.ring.size();
+        usage.bytes += sizeof(buffer.ring);
+        usage.limit += buffer.ring.capacity();
+        usage.evictions += buffer.overflows.load(std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+} // namespace events
+} // namespace ipmi
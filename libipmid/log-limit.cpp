@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <ipmid/log-limit.hpp>
+#include <mutex>
+#include <unordered_map>
+
+namespace ipmi
+{
+namespace log_limit
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Bucket
+{
+    double tokens = burst;
+    Clock::time_point refilled = Clock::now();
+    uint64_t suppressed = 0;
+};
+
+/* handlers on worker threads log too */
+std::mutex bucketsMutex;
+std::unordered_map<const char*, Bucket> buckets;
+
+} // namespace
+
+bool allow(const char* site, uint64_t& suppressed)
+{
+    std::lock_guard<std::mutex> lock(bucketsMutex);
+    Bucket& bucket = buckets[site];
+
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - bucket.refilled) /
+                     std::chrono::duration<double>(interval);
+    bucket.tokens = std::min<double>(burst, bucket.tokens + elapsed * burst);
+    bucket.refilled = now;
+
+    if (bucket.tokens < 1)
+    {
+        bucket.suppressed++;
+        return false;
+    }
+    bucket.tokens -= 1;
+    suppressed = bucket.suppressed;
+    bucket.suppressed = 0;
+    return true;
+}
+
+} // namespace log_limit
+} // namespace ipmi
@@ -1,6 +1,8 @@
 #include <boost/asio.hpp>
+#include <ipmid/api.h>
 #include <memory>
 #include <sdbusplus/asio/connection.hpp>
+#include <stdexcept>
 
 namespace
 {
@@ -8,8 +10,17 @@ namespace
 std::shared_ptr<boost::asio::io_context> ioCtx;
 std::shared_ptr<sdbusplus::asio::connection> sdbusp;
 
+/* set on the handler worker threads, which must not use the shared
+ * connection; sd-bus connections are not thread-safe */
+thread_local bool workerThread = false;
+
 } // namespace
 
+void setWorkerThread(bool worker)
+{
+    workerThread = worker;
+}
+
 void setIoContext(std::shared_ptr<boost::asio::io_context>& newIo)
 {
     ioCtx = newIo;
@@ -27,5 +38,26 @@ void setSdBus(std::shared_ptr<sdbusplus::asio::connection>& newBus)
 
 std::shared_ptr<sdbusplus::asio::connection> getSdBus()
 {
+    if (workerThread)
+    {
+        // fail the handler rather than race the main loop on the connection
+        throw std::logic_error("Shared D-Bus connection used from a worker");
+    }
     return sdbusp;
 }
+
+sdbusplus::bus::bus& getBus()
+{
+    sd_bus* current = ipmid_get_sd_bus_connection();
+    if (sdbusp && current == sdbusp->get())
+    {
+        return *sdbusp;
+    }
+    // the private connection of a worker thread, wrapped once per thread
+    thread_local std::unique_ptr<sdbusplus::bus::bus> local;
+    if (!local || local->get() != current)
+    {
+        local = std::make_unique<sdbusplus::bus::bus>(current);
+    }
+    return *local;
+}
@@ -0,0 +1,250 @@
+#include <atomic>
+#include <ipmid/api.hpp>
+#include <ipmid/sensor-metadata.hpp>
+#include <ipmid/utils.hpp>
+#include <memory>
+#include <mutex>
+#include <sdbusplus/bus/match.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+
+namespace ipmi
+{
+namespace sensor_metadata
+{
+
+namespace
+{
+
+std::mutex lock;
+std::unordered_map<std::string, Snapshot> records;
+std::atomic<uint64_t> currentVersion{0};
+uint64_t replaced = 0;
+
+/* the sensors are watched with one match per signal for all of them; a
+ * match per sensor would cost the bus daemon three rules for each */
+constexpr auto sensorsRoot = "/xyz/openbmc_project/sensors";
+
+// main thread only, like the matches themselves
+std::unique_ptr<sdbusplus::bus::match::match> changedMatch;
+std::unique_ptr<sdbusplus::bus::match::match> addedMatch;
+std::unique_ptr<sdbusplus::bus::match::match> removedMatch;
+
+/* true for the paths the matches cover */
+bool watched(std::string_view path)
+{
+    std::string_view root = sensorsRoot;
+    return path.size() > root.size() && path.substr(0, root.size()) == root &&
+           path[root.size()] == '/';
+}
+
+/* copy one property into a record; true if it changed the record */
+bool apply(Metadata& metadata, std::string_view name, const Value& value)
+{
+    try
+    {
+        if (name == "Unit")
+        {
+            const std::string& unit = std::get<std::string>(value);
+            if (unit == metadata.unit)
+            {
+                return false;
+            }
+            metadata.unit = unit;
+            return true;
+        }
+        if (name == "Scale")
+        {
+            auto scale = static_cast<int64_t>(
+                std::visit(VariantToDoubleVisitor(), value));
+            if (scale == metadata.scale)
+            {
+                return false;
+            }
+            metadata.scale = scale;
+            return true;
+        }
+        double* limit = name == "MinValue"   ? &metadata.minValue
+                        : name == "MaxValue" ? &metadata.maxValue
+                                             : nullptr;
+        if (!limit)
+        {
+            return false;
+        }
+        double bound = std::visit(VariantToDoubleVisitor(), value);
+        if (bound == *limit)
+        {
+            return false;
+        }
+        *limit = bound;
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        // a type the interface doesn't define; keep what there is
+        return false;
+    }
+}
+
+/* publish the record of a sensor; a signal only updates a record there is,
+ * since it needn't carry all of the metadata */
+template <typename Map>
+Snapshot publish(const std::string& path, const Map& properties,
+                 bool create = true)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!create && !records.count(path))
+    {
+        return nullptr;
+    }
+    Snapshot& record = records[path];
+    Metadata metadata = record ? *record : Metadata();
+    bool changed = !record;
+    for (const auto& [name, value] : properties)
+    {
+        const std::string& key = name;
+        changed |= apply(metadata, key, value);
+    }
+    if (!changed)
+    {
+        return record;
+    }
+    if (record)
+    {
+        replaced++;
+    }
+    metadata.version = ++currentVersion;
+    record = std::make_shared<const Metadata>(std::move(metadata));
+    return record;
+}
+
+void propertiesChanged(sdbusplus::message::message& msg)
+{
+    std::string path = msg.get_path();
+    std::string name;
+    FlatPropertyMap properties;
+    try
+    {
+        msg.read(name);
+        readProperties(msg, properties);
+    }
+    catch (const std::exception& e)
+    {
+        // a type outside of ipmi::Value; the next full read republishes it
+        remove(path);
+        return;
+    }
+    publish(path, properties, false);
+}
+
+/* a sensor that is added again may come with other metadata; it is read
+ * again on its next use rather than parsed out of the signal */
+void addedOrRemoved(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path path;
+    try
+    {
+        msg.read(path);
+    }
+    catch (const std::exception& e)
+    {
+        return;
+    }
+    remove(path.str);
+}
+
+/* keep the records current once they are published; throws
+ * std::logic_error off the main thread, through getSdBus() */
+void watch()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto bus = getSdBus();
+    if (!bus || changedMatch)
+    {
+        return;
+    }
+    cache_stats::registerCache("sensor-metadata", usage);
+    changedMatch = std::make_unique<sdbusplus::bus::match::match>(
+        *bus,
+        rules::type::signal() + rules::member("PropertiesChanged") +
+            rules::interface("org.freedesktop.DBus.Properties") +
+            rules::path_namespace(sensorsRoot) + rules::argN(0, interface),
+        propertiesChanged);
+    std::string objects = std::string(sensorsRoot) + "/";
+    addedMatch = std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesAdded() + rules::argNpath(0, objects),
+        addedOrRemoved);
+    removedMatch = std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesRemoved() + rules::argNpath(0, objects),
+        addedOrRemoved);
+}
+
+/* a record the matches can't keep current isn't stored */
+template <typename Map>
+Snapshot unwatched(const Map& properties)
+{
+    Metadata metadata;
+    for (const auto& [name, value] : properties)
+    {
+        const std::string& key = name;
+        apply(metadata, key, value);
+    }
+    metadata.version = currentVersion.load();
+    return std::make_shared<const Metadata>(std::move(metadata));
+}
+
+} // namespace
+
+Snapshot find(const std::string& path)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = records.find(path);
+    return it != records.end() ? it->second : nullptr;
+}
+
+Snapshot update(const std::string& path, const FlatPropertyMap& properties)
+{
+    watch();
+    return watched(path) ? publish(path, properties) : unwatched(properties);
+}
+
+Snapshot update(const std::string& path, const PropertyMap& properties)
+{
+    watch();
+    return watched(path) ? publish(path, properties) : unwatched(properties);
+}
+
+void remove(const std::string& path)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (records.erase(path))
+    {
+        ++currentVersion;
+    }
+}
+
+uint64_t version()
+{
+    return currentVersion.load();
+}
+
+cache_stats::Usage usage()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    cache_stats::Usage usage;
+    usage.entries = records.size();
+    for (const auto& [path, record] : records)
+    {
+        usage.bytes += sizeof(path) + path.capacity() + sizeof(Metadata) +
+                       record->unit.capacity();
+    }
+    // records replaced by a rescale, reported where evictions would be
+    usage.evictions = replaced;
+    return usage;
+}
+
+} // namespace sensor_metadata
+} // namespace ipmi
@@ -1,3 +1,5 @@
+#include <boost/asio/post.hpp>
+#include <chrono>
 #include <forward_list>
 #include <ipmid/api.hpp>
 #include <memory>
@@ -9,11 +11,19 @@ using namespace phosphor::logging;
 namespace
 {
 
+using Clock = std::chrono::steady_clock;
+
+/* deferred handlers are skipped once a chain has run for this long */
+constexpr auto deferredBudget = std::chrono::seconds(1);
+
+/* handlers that run for longer than this are logged */
+constexpr auto slowHandler = std::chrono::milliseconds(100);
+
 class SignalHandler
 {
   public:
     SignalHandler(std::shared_ptr<boost::asio::io_context>& io, int sigNum) :
-        signal(std::make_unique<boost::asio::signal_set>(*io, sigNum))
+        io(io), signal(std::make_unique<boost::asio::signal_set>(*io, sigNum))
     {
         asyncWait();
     }
@@ -26,21 +36,22 @@ class SignalHandler
     }
 
     void registerHandler(int prio,
-                         const std::function<SignalResponse(int)>& handler)
+                         const std::function<SignalResponse(int)>& handler,
+                         bool deferred)
     {
         // check for initial placement
-        if (handlers.empty() || std::get<0>(handlers.front()) < prio)
+        if (handlers.empty() || handlers.front().prio < prio)
         {
-            handlers.emplace_front(std::make_tuple(prio, handler));
+            handlers.emplace_front(Handler{prio, handler, deferred});
             return;
         }
         // walk the list and put it in the right place
         auto j = handlers.begin();
-        for (auto i = j; i != handlers.end() && std::get<0>(*i) > prio; i++)
+        for (auto i = j; i != handlers.end() && i->prio > prio; i++)
         {
             j = i;
         }
-        handlers.emplace_after(j, std::make_tuple(prio, handler));
+        handlers.emplace_after(j, Handler{prio, handler, deferred});
     }
 
     void handleSignal(const boost::system::error_code& ec, int sigNum)
@@ -52,27 +63,76 @@ class SignalHandler
                             entry("ERROR=%s", ec.message().c_str()));
             return;
         }
-        for (auto h = handlers.begin(); h != handlers.end(); h++)
-        {
-            std::function<SignalResponse(int)>& handler = std::get<1>(*h);
-            if (handler(sigNum) == SignalResponse::breakExecution)
-            {
-                break;
-            }
-        }
+        runChain(handlers.begin(), sigNum, Clock::now(), false);
         // start the wait for the next signal
         asyncWait();
     }
 
   protected:
+    struct Handler
+    {
+        int prio;
+        std::function<SignalResponse(int)> handler;
+        bool deferred;
+    };
+    using Handlers = std::forward_list<Handler>;
+
     void asyncWait()
     {
         signal->async_wait([this](const boost::system::error_code& ec,
                                   int sigNum) { handleSignal(ec, sigNum); });
     }
 
-    std::forward_list<std::tuple<int, std::function<SignalResponse(int)>>>
-        handlers;
+    /* run the chain from h on; posted is set when the job for the deferred
+     * handler h is running */
+    void runChain(Handlers::iterator h, int sigNum, Clock::time_point start,
+                  bool posted)
+    {
+        for (; h != handlers.end(); h++)
+        {
+            if (h->deferred && !posted)
+            {
+                if (Clock::now() - start > deferredBudget)
+                {
+                    log<level::WARNING>("Skipping deferred signal handler",
+                                        entry("SIGNAL=%d", sigNum),
+                                        entry("PRIORITY=%d", h->prio));
+                    continue;
+                }
+                boost::asio::post(*io, [this, h, sigNum, start]() {
+                    runChain(h, sigNum, start, true);
+                });
+                return;
+            }
+            posted = false;
+            if (call(*h, sigNum) == SignalResponse::breakExecution)
+            {
+                return;
+            }
+        }
+    }
+
+    SignalResponse call(Handler& h, int sigNum)
+    {
+        auto begin = Clock::now();
+        SignalResponse response = h.handler(sigNum);
+        auto elapsed = Clock::now() - begin;
+        if (elapsed > slowHandler)
+        {
+            log<level::WARNING>(
+                "Slow signal handler", entry("SIGNAL=%d", sigNum),
+                entry("PRIORITY=%d", h.prio),
+                entry("DURATION_MS=%lld",
+                      static_cast<long long>(
+                          std::chrono::duration_cast<std::chrono::milliseconds>(
+                              elapsed)
+                              .count())));
+        }
+        return response;
+    }
+
+    std::shared_ptr<boost::asio::io_context> io;
+    Handlers handlers;
     std::unique_ptr<boost::asio::signal_set> signal;
 };
 
@@ -81,10 +141,9 @@ class SignalHandler
 // first time it is needed
 std::vector<std::unique_ptr<SignalHandler>> signals;
 
-} // namespace
-
-void registerSignalHandler(int priority, int signalNumber,
-                           const std::function<SignalResponse(int)>& handler)
+void addSignalHandler(int priority, int signalNumber,
+                      const std::function<SignalResponse(int)>& handler,
+                      bool deferred)
 {
     if (signalNumber >= SIGRTMAX)
     {
@@ -102,5 +161,20 @@ void registerSignalHandler(int priority, int signalNumber,
         signals[signalNumber] =
             std::make_unique<SignalHandler>(io, signalNumber);
     }
-    signals[signalNumber]->registerHandler(priority, handler);
+    signals[signalNumber]->registerHandler(priority, handler, deferred);
+}
+
+} // namespace
+
+void registerSignalHandler(int priority, int signalNumber,
+                           const std::function<SignalResponse(int)>& handler)
+{
+    addSignalHandler(priority, signalNumber, handler, false);
+}
+
+void registerDeferredSignalHandler(
+    int priority, int signalNumber,
+    const std::function<SignalResponse(int)>& handler)
+{
+    addSignalHandler(priority, signalNumber, handler, true);
 }
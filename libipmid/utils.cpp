@@ -1,13 +1,25 @@
 #include <arpa/inet.h>
 #include <dirent.h>
 #include <net/if.h>
+#include <systemd/sd-bus.h>
 
 #include <algorithm>
+#include <boost/asio/steady_timer.hpp>
+#include <cerrno>
 #include <chrono>
+#include <ipmid/dbus-stats.hpp>
+#include <ipmid/sensor-metadata.hpp>
+#include <ipmid/tracepoints.hpp>
 #include <ipmid/utils.hpp>
+#include <map>
+#include <memory>
+#include <optional>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <sdbusplus/exception.hpp>
 #include <sdbusplus/message/types.hpp>
+#include <stdexcept>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 namespace ipmi
@@ -26,6 +38,561 @@ bool isLinkLocalIP(const std::string& ipaddress);
 
 } // namespace network
 
+namespace
+{
+
+/** @brief Get the destination service of a method call */
+std::string getDestination(sdbusplus::message::message& method)
+{
+    const char* destination = sd_bus_message_get_destination(method.get());
+    return destination ? destination : "";
+}
+
+/** @brief bus.call() that accounts the call in the D-Bus statistics */
+sdbusplus::message::message accountedCall(sdbusplus::bus::bus& bus,
+                                          sdbusplus::message::message& method,
+                                          uint64_t timeout = 0)
+{
+    std::string service = getDestination(method);
+    std::string member = method.get_member();
+    [[maybe_unused]] dbus_stats::Command command = dbus_stats::getCommand();
+    IPMI_TRACEPOINT(dbus_call_start, command.requestId, command.netFn,
+                    command.cmd, command.channel, service.c_str(),
+                    member.c_str());
+    auto start = dbus_stats::Clock::now();
+    try
+    {
+        auto reply = bus.call(method, timeout);
+        dbus_stats::record(service, member, dbus_stats::Clock::now() - start,
+                           reply.is_method_error());
+        IPMI_TRACEPOINT(dbus_call_end, command.requestId, command.netFn,
+                        command.cmd, command.channel, service.c_str(),
+                        member.c_str(),
+                        sd_bus_message_get_errno(reply.get()));
+        return reply;
+    }
+    catch (const std::exception& e)
+    {
+        dbus_stats::record(service, member, dbus_stats::Clock::now() - start,
+                           true);
+        IPMI_TRACEPOINT(dbus_call_end, command.requestId, command.netFn,
+                        command.cmd, command.channel, service.c_str(),
+                        member.c_str(), EIO);
+        throw;
+    }
+}
+
+/** @class MapperCache
+ *  @brief Process-wide cache of the mapper's (path, interface) -> service
+ *         answers.
+ *  @details Entries at a path are dropped when any service adds or removes
+ *           interfaces there, and entries of a service are dropped when its
+ *           owner changes, so the next lookup asks the mapper again. The
+ *           signals are only seen on the shared asio connection, so nothing
+ *           is cached in processes that don't set one up.
+ */
+class MapperCache
+{
+  public:
+    std::optional<std::string> find(const std::string& path,
+                                    const std::string& intf) const
+    {
+        auto it = services.find(Key(path, intf));
+        if (it == services.end())
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    void insert(const std::string& path, const std::string& intf,
+                const std::string& service)
+    {
+        if (!watch())
+        {
+            return;
+        }
+        services.insert_or_assign(Key(path, intf), service);
+    }
+
+  private:
+    using Key = std::pair<std::string, std::string>;
+
+    bool watch()
+    {
+        namespace rules = sdbusplus::bus::match::rules;
+
+        if (!matches.empty())
+        {
+            return true;
+        }
+        auto bus = getSdBus();
+        if (!bus)
+        {
+            return false;
+        }
+        auto pathChanged = [this](sdbusplus::message::message& msg) {
+            sdbusplus::message::object_path path;
+            try
+            {
+                msg.read(path);
+            }
+            catch (const std::exception& e)
+            {
+                services.clear();
+                return;
+            }
+            dropPath(path);
+        };
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::interfacesAdded(), pathChanged));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::interfacesRemoved(), pathChanged));
+        matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::nameOwnerChanged(),
+            [this](sdbusplus::message::message& msg) {
+                std::string name;
+                std::string oldOwner;
+                std::string newOwner;
+                try
+                {
+                    msg.read(name, oldOwner, newOwner);
+                }
+                catch (const std::exception& e)
+                {
+                    services.clear();
+                    return;
+                }
+                dropService(name, oldOwner);
+            }));
+        return true;
+    }
+
+    void dropPath(const std::string& path)
+    {
+        auto it = services.lower_bound(Key(path, std::string()));
+        while (it != services.end() && it->first.first == path)
+        {
+            it = services.erase(it);
+        }
+    }
+
+    void dropService(const std::string& name, const std::string& owner)
+    {
+        for (auto it = services.begin(); it != services.end();)
+        {
+            if (it->second == name || (!owner.empty() && it->second == owner))
+            {
+                it = services.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    std::map<Key, std::string> services;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+};
+
+MapperCache& mapperCache()
+{
+    // never destroyed; the matches must not outlive the bus connection
+    static MapperCache* cache = new MapperCache();
+    return *cache;
+}
+
+/** @brief Read the object path and interface names of InterfacesAdded
+ *
+ *  The properties are skipped rather than decoded, since they may use
+ *  types outside of ipmi::Value.
+ */
+bool readAddedInterfaces(sdbusplus::message::message& msg, std::string& path,
+                         std::vector<std::string>& interfaces)
+{
+    sd_bus_message* m = msg.get();
+    const char* objPath = nullptr;
+    if (sd_bus_message_read(m, "o", &objPath) < 0 ||
+        sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sa{sv}}") < 0)
+    {
+        return false;
+    }
+    path = objPath;
+
+    int r;
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sa{sv}")) > 0)
+    {
+        const char* interface = nullptr;
+        if (sd_bus_message_read(m, "s", &interface) < 0 ||
+            sd_bus_message_skip(m, "a{sv}") < 0 ||
+            sd_bus_message_exit_container(m) < 0)
+        {
+            return false;
+        }
+        interfaces.emplace_back(interface);
+    }
+    return r >= 0 && sd_bus_message_exit_container(m) >= 0;
+}
+
+/** @brief checks if path is root itself or one of its descendants */
+bool inSubtree(const std::string& path, const std::string& root)
+{
+    return path.compare(0, root.size(), root) == 0 &&
+           (path.size() == root.size() || path[root.size()] == '/');
+}
+
+/** @class SubtreeIndex
+ *  @brief In-process copy of the mapper subtree below a few roots.
+ *  @details A root is fetched from the mapper whole on its first query and
+ *           then kept current from InterfacesAdded, InterfacesRemoved and
+ *           NameOwnerChanged. A service that takes a well-known name may
+ *           not announce its objects, so that refetches every root on its
+ *           next query instead.
+ */
+class SubtreeIndex
+{
+  public:
+    struct Root
+    {
+        ObjectTree tree;
+        bool populated = false;
+    };
+
+    SubtreeIndex()
+    {
+        for (const char* root :
+             {"/xyz/openbmc_project/network", "/xyz/openbmc_project/inventory",
+              "/xyz/openbmc_project/logging", "/xyz/openbmc_project/sensors"})
+        {
+            roots.try_emplace(root);
+        }
+    }
+
+    void addRoot(const std::string& path)
+    {
+        roots.try_emplace(path);
+    }
+
+    std::vector<std::string> rootPaths() const
+    {
+        std::vector<std::string> paths;
+        for (const auto& [path, root] : roots)
+        {
+            paths.push_back(path);
+        }
+        return paths;
+    }
+
+    /** @brief Find the indexed root covering a query
+     *
+     *  @param[in] serviceRoot - root of the query
+     *  @param[out] root - path of the indexed root
+     *  @return the indexed root or nullptr if there is none
+     */
+    Root* find(const std::string& serviceRoot, std::string& root)
+    {
+        for (auto& [path, entry] : roots)
+        {
+            if (inSubtree(serviceRoot, path))
+            {
+                root = path;
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /** @brief Start watching the signals ahead of fetching a root
+     *
+     *  @return a token for populate or 0 if the index can't be kept current
+     */
+    uint64_t watch()
+    {
+        namespace rules = sdbusplus::bus::match::rules;
+
+        auto bus = getSdBus();
+        if (!bus)
+        {
+            return 0;
+        }
+        if (matches.empty())
+        {
+            matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+                *bus, rules::interfacesAdded(),
+                [this](sdbusplus::message::message& msg) {
+                    interfacesAdded(msg);
+                }));
+            matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+                *bus, rules::interfacesRemoved(),
+                [this](sdbusplus::message::message& msg) {
+                    interfacesRemoved(msg);
+                }));
+            matches.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+                *bus, rules::nameOwnerChanged(),
+                [this](sdbusplus::message::message& msg) {
+                    nameOwnerChanged(msg);
+                }));
+        }
+        return generation;
+    }
+
+    /** @brief Store a fetched root unless a signal arrived meanwhile */
+    void populate(Root& root, ObjectTree&& tree, uint64_t token)
+    {
+        if (token == 0 || token != generation)
+        {
+            return;
+        }
+        root.tree = std::move(tree);
+        root.populated = true;
+    }
+
+    /** @brief Select the objects below serviceRoot implementing interface,
+     *         the way GetSubTree does
+     */
+    static ObjectTree select(const ObjectTree& tree,
+                             const std::string& serviceRoot,
+                             const std::string& interface)
+    {
+        ObjectTree objectTree;
+        for (auto it = tree.lower_bound(serviceRoot);
+             it != tree.end() && it->first.compare(0, serviceRoot.size(),
+                                                   serviceRoot) == 0;
+             ++it)
+        {
+            if (!inSubtree(it->first, serviceRoot))
+            {
+                continue;
+            }
+            for (const auto& [service, interfaces] : it->second)
+            {
+                if (std::find(interfaces.begin(), interfaces.end(),
+                              interface) != interfaces.end())
+                {
+                    objectTree[it->first][service] = interfaces;
+                }
+            }
+        }
+        return objectTree;
+    }
+
+  private:
+    void interfacesAdded(sdbusplus::message::message& msg)
+    {
+        std::string path;
+        std::vector<std::string> added;
+        if (!readAddedInterfaces(msg, path, added))
+        {
+            invalidate();
+            return;
+        }
+        const char* sender = msg.get_sender();
+        if (!sender)
+        {
+            invalidate();
+            return;
+        }
+        generation++;
+        for (auto& [rootPath, root] : roots)
+        {
+            if (!root.populated || !inSubtree(path, rootPath))
+            {
+                continue;
+            }
+            auto& services = root.tree[path];
+            for (const auto& interface : added)
+            {
+                bool known = std::any_of(
+                    services.begin(), services.end(), [&](const auto& s) {
+                        return std::find(s.second.begin(), s.second.end(),
+                                         interface) != s.second.end();
+                    });
+                if (!known)
+                {
+                    services[sender].push_back(interface);
+                }
+            }
+        }
+    }
+
+    void interfacesRemoved(sdbusplus::message::message& msg)
+    {
+        sdbusplus::message::object_path objPath;
+        std::vector<std::string> removed;
+        try
+        {
+            msg.read(objPath, removed);
+        }
+        catch (const std::exception& e)
+        {
+            invalidate();
+            return;
+        }
+        generation++;
+        const std::string& path = objPath;
+        for (auto& [rootPath, root] : roots)
+        {
+            auto object = root.tree.find(path);
+            if (object == root.tree.end())
+            {
+                continue;
+            }
+            auto& services = object->second;
+            for (auto it = services.begin(); it != services.end();)
+            {
+                auto& interfaces = it->second;
+                for (const auto& interface : removed)
+                {
+                    interfaces.erase(std::remove(interfaces.begin(),
+                                                 interfaces.end(), interface),
+                                     interfaces.end());
+                }
+                it = interfaces.empty() ? services.erase(it) : std::next(it);
+            }
+            if (services.empty())
+            {
+                root.tree.erase(object);
+            }
+        }
+    }
+
+    void nameOwnerChanged(sdbusplus::message::message& msg)
+    {
+        std::string name;
+        std::string oldOwner;
+        std::string newOwner;
+        try
+        {
+            msg.read(name, oldOwner, newOwner);
+        }
+        catch (const std::exception& e)
+        {
+            invalidate();
+            return;
+        }
+        if (!newOwner.empty())
+        {
+            // a service that just started may not announce its objects
+            if (!name.empty() && name.front() != ':')
+            {
+                invalidate();
+            }
+            return;
+        }
+
+        generation++;
+        for (auto& [rootPath, root] : roots)
+        {
+            for (auto object = root.tree.begin(); object != root.tree.end();)
+            {
+                object->second.erase(name);
+                if (!oldOwner.empty())
+                {
+                    object->second.erase(oldOwner);
+                }
+                object = object->second.empty() ? root.tree.erase(object)
+                                                : std::next(object);
+            }
+        }
+    }
+
+    void invalidate()
+    {
+        generation++;
+        for (auto& [rootPath, root] : roots)
+        {
+            root.tree.clear();
+            root.populated = false;
+        }
+    }
+
+    std::map<std::string, Root> roots;
+    /* starts at 1 so that 0 can mean "not watched" */
+    uint64_t generation = 1;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+};
+
+SubtreeIndex& subtreeIndex()
+{
+    // never destroyed; the matches must not outlive the bus connection
+    static SubtreeIndex* index = new SubtreeIndex();
+    return *index;
+}
+
+/** @brief Answer GetSubTree(serviceRoot, {interface}) from the index
+ *
+ *  @param[in] serviceRoot - root of the query
+ *  @param[in] interface - interface the objects must implement
+ *  @param[in] fetchRoot - fetches the whole subtree of an indexed root from
+ *                         the mapper; returns false on failure
+ *  @return the objects or nullopt if the query has to go to the mapper
+ */
+template <typename Fetch>
+std::optional<ObjectTree> indexedSubTree(const std::string& serviceRoot,
+                                         const std::string& interface,
+                                         Fetch&& fetchRoot)
+{
+    std::string normalized = serviceRoot;
+    while (normalized.size() > 1 && normalized.back() == '/')
+    {
+        normalized.pop_back();
+    }
+
+    SubtreeIndex& index = subtreeIndex();
+    std::string rootPath;
+    SubtreeIndex::Root* root = index.find(normalized, rootPath);
+    if (!root)
+    {
+        return std::nullopt;
+    }
+    if (!root->populated)
+    {
+        uint64_t token = index.watch();
+        if (!token)
+        {
+            return std::nullopt;
+        }
+        ObjectTree tree;
+        if (!fetchRoot(rootPath, tree))
+        {
+            return std::nullopt;
+        }
+        ObjectTree objectTree =
+            SubtreeIndex::select(tree, normalized, interface);
+        index.populate(*root, std::move(tree), token);
+        return objectTree;
+    }
+    return SubtreeIndex::select(root->tree, normalized, interface);
+}
+
+/** @brief Fetch the whole subtree of an indexed root on the given bus */
+bool fetchSubTree(sdbusplus::bus::bus& bus, const std::string& root,
+                  ObjectTree& tree)
+{
+    try
+    {
+        auto mapperCall = bus.new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
+                                              MAPPER_INTF, "GetSubTree");
+        mapperCall.append(root, 0, std::vector<std::string>());
+        auto mapperReply = accountedCall(bus, mapperCall);
+        mapperReply.read(tree);
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        return false;
+    }
+}
+
+} // namespace
+
+void registerSubtreeIndex(const std::string& root)
+{
+    subtreeIndex().addRoot(root);
+}
+
 // TODO There may be cases where an interface is implemented by multiple
 //  objects,to handle such cases we are interested on that object
 //  which are on interested busname.
@@ -37,25 +604,37 @@ DbusObjectInfo getDbusObject(sdbusplus::bus::bus& bus,
                              const std::string& serviceRoot,
                              const std::string& match)
 {
-    std::vector<DbusInterface> interfaces;
-    interfaces.emplace_back(interface);
+    ObjectTree objectTree;
+    auto indexed = indexedSubTree(
+        serviceRoot, interface,
+        [&bus](const std::string& root, ObjectTree& tree) {
+            return fetchSubTree(bus, root, tree);
+        });
+    if (indexed)
+    {
+        objectTree = std::move(*indexed);
+    }
+    else
+    {
+        std::vector<DbusInterface> interfaces;
+        interfaces.emplace_back(interface);
 
-    auto depth = 0;
+        auto depth = 0;
 
-    auto mapperCall = bus.new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
-                                          MAPPER_INTF, "GetSubTree");
+        auto mapperCall = bus.new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
+                                              MAPPER_INTF, "GetSubTree");
 
-    mapperCall.append(serviceRoot, depth, interfaces);
+        mapperCall.append(serviceRoot, depth, interfaces);
 
-    auto mapperReply = bus.call(mapperCall);
-    if (mapperReply.is_method_error())
-    {
-        log<level::ERR>("Error in mapper call");
-        elog<InternalFailure>();
-    }
+        auto mapperReply = accountedCall(bus, mapperCall);
+        if (mapperReply.is_method_error())
+        {
+            log<level::ERR>("Error in mapper call");
+            elog<InternalFailure>();
+        }
 
-    ObjectTree objectTree;
-    mapperReply.read(objectTree);
+        mapperReply.read(objectTree);
+    }
 
     if (objectTree.empty())
     {
@@ -142,7 +721,7 @@ Value getDbusProperty(sdbusplus::bus::bus& bus, const std::string& service,
 
     method.append(interface, property);
 
-    auto reply = bus.call(method, timeout.count());
+    auto reply = accountedCall(bus, method, timeout.count());
 
     if (reply.is_method_error())
     {
@@ -171,7 +750,7 @@ PropertyMap getAllDbusProperties(sdbusplus::bus::bus& bus,
 
     method.append(interface);
 
-    auto reply = bus.call(method, timeout.count());
+    auto reply = accountedCall(bus, method, timeout.count());
 
     if (reply.is_method_error())
     {
@@ -185,6 +764,61 @@ PropertyMap getAllDbusProperties(sdbusplus::bus::bus& bus,
     return properties;
 }
 
+void getAllDbusProperties(sdbusplus::bus::bus& bus, const std::string& service,
+                          const std::string& objPath,
+                          const std::string& interface,
+                          FlatPropertyMap& properties,
+                          std::chrono::microseconds timeout)
+{
+    auto method = bus.new_method_call(service.c_str(), objPath.c_str(),
+                                      PROP_INTF, METHOD_GET_ALL);
+
+    method.append(interface);
+
+    auto reply = accountedCall(bus, method, timeout.count());
+
+    if (reply.is_method_error())
+    {
+        log<level::ERR>("Failed to get all properties",
+                        entry("PATH=%s", objPath.c_str()),
+                        entry("INTERFACE=%s", interface.c_str()));
+        elog<InternalFailure>();
+    }
+
+    readProperties(reply, properties);
+}
+
+void readProperties(sdbusplus::message::message& msg,
+                    FlatPropertyMap& properties)
+{
+    sd_bus_message* m = msg.get();
+    if (sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sv}") < 0)
+    {
+        throw std::runtime_error("ERROR in reading the properties");
+    }
+
+    int r;
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sv")) > 0)
+    {
+        const char* name = nullptr;
+        if (sd_bus_message_read(m, "s", &name) < 0)
+        {
+            throw std::runtime_error("ERROR in reading a property name");
+        }
+        Value& value = properties[name];
+        msg.read(value);
+        if (sd_bus_message_exit_container(m) < 0)
+        {
+            throw std::runtime_error("ERROR in reading a property");
+        }
+    }
+    if (r < 0 || sd_bus_message_exit_container(m) < 0)
+    {
+        throw std::runtime_error("ERROR in reading the properties");
+    }
+}
+
 ObjectValueTree getManagedObjects(sdbusplus::bus::bus& bus,
                                   const std::string& service,
                                   const std::string& objPath)
@@ -195,7 +829,7 @@ ObjectValueTree getManagedObjects(sdbusplus::bus::bus& bus,
                                       "org.freedesktop.DBus.ObjectManager",
                                       "GetManagedObjects");
 
-    auto reply = bus.call(method);
+    auto reply = accountedCall(bus, method);
 
     if (reply.is_method_error())
     {
@@ -218,7 +852,7 @@ void setDbusProperty(sdbusplus::bus::bus& bus, const std::string& service,
 
     method.append(interface, property, value);
 
-    if (!bus.call(method, timeout.count()))
+    if (!accountedCall(bus, method, timeout.count()))
     {
         log<level::ERR>("Failed to set property",
                         entry("PROPERTY=%s", property.c_str()),
@@ -269,9 +903,20 @@ bool ServiceCache::isValid(sdbusplus::bus::bus& bus) const
     return cachedService && cachedBusName == bus.get_unique_name();
 }
 
+void cacheService(const std::string& path, const std::string& intf,
+                  const std::string& service)
+{
+    mapperCache().insert(path, intf, service);
+}
+
 std::string getService(sdbusplus::bus::bus& bus, const std::string& intf,
                        const std::string& path)
 {
+    if (auto service = mapperCache().find(path, intf))
+    {
+        return *service;
+    }
+
     auto mapperCall =
         bus.new_method_call("xyz.openbmc_project.ObjectMapper",
                             "/xyz/openbmc_project/object_mapper",
@@ -280,7 +925,7 @@ std::string getService(sdbusplus::bus::bus& bus, const std::string& intf,
     mapperCall.append(path);
     mapperCall.append(std::vector<std::string>({intf}));
 
-    auto mapperResponseMsg = bus.call(mapperCall);
+    auto mapperResponseMsg = accountedCall(bus, mapperCall);
 
     if (mapperResponseMsg.is_method_error())
     {
@@ -295,6 +940,7 @@ std::string getService(sdbusplus::bus::bus& bus, const std::string& intf,
         throw std::runtime_error("ERROR in reading the mapper response");
     }
 
+    mapperCache().insert(path, intf, mapperResponse.begin()->first);
     return mapperResponse.begin()->first;
 }
 
@@ -303,28 +949,40 @@ ipmi::ObjectTree getAllDbusObjects(sdbusplus::bus::bus& bus,
                                    const std::string& interface,
                                    const std::string& match)
 {
-    std::vector<std::string> interfaces;
-    interfaces.emplace_back(interface);
+    ObjectTree objectTree;
+    auto indexed = indexedSubTree(
+        serviceRoot, interface,
+        [&bus](const std::string& root, ObjectTree& tree) {
+            return fetchSubTree(bus, root, tree);
+        });
+    if (indexed)
+    {
+        objectTree = std::move(*indexed);
+    }
+    else
+    {
+        std::vector<std::string> interfaces;
+        interfaces.emplace_back(interface);
 
-    auto depth = 0;
+        auto depth = 0;
 
-    auto mapperCall = bus.new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
-                                          MAPPER_INTF, "GetSubTree");
+        auto mapperCall = bus.new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
+                                              MAPPER_INTF, "GetSubTree");
 
-    mapperCall.append(serviceRoot, depth, interfaces);
+        mapperCall.append(serviceRoot, depth, interfaces);
 
-    auto mapperReply = bus.call(mapperCall);
-    if (mapperReply.is_method_error())
-    {
-        log<level::ERR>("Error in mapper call",
-                        entry("SERVICEROOT=%s", serviceRoot.c_str()),
-                        entry("INTERFACE=%s", interface.c_str()));
+        auto mapperReply = accountedCall(bus, mapperCall);
+        if (mapperReply.is_method_error())
+        {
+            log<level::ERR>("Error in mapper call",
+                            entry("SERVICEROOT=%s", serviceRoot.c_str()),
+                            entry("INTERFACE=%s", interface.c_str()));
 
-        elog<InternalFailure>();
-    }
+            elog<InternalFailure>();
+        }
 
-    ObjectTree objectTree;
-    mapperReply.read(objectTree);
+        mapperReply.read(objectTree);
+    }
 
     for (auto it = objectTree.begin(); it != objectTree.end();)
     {
@@ -382,7 +1040,7 @@ ObjectTree getAllAncestors(sdbusplus::bus::bus& bus, const std::string& path,
                                           MAPPER_INTF, "GetAncestors");
     mapperCall.append(path, interfaces);
 
-    auto mapperReply = bus.call(mapperCall);
+    auto mapperReply = accountedCall(bus, mapperCall);
     if (mapperReply.is_method_error())
     {
         log<level::ERR>(
@@ -407,6 +1065,747 @@ ObjectTree getAllAncestors(sdbusplus::bus::bus& bus, const std::string& path,
     return objectTree;
 }
 
+namespace detail
+{
+
+boost::system::error_code
+    callBlocking(sdbusplus::message::message& method,
+                 const std::function<void(sdbusplus::message::message&)>&
+                     readReply)
+{
+    try
+    {
+        auto reply = accountedCall(*getSdBus(), method,
+                                   IPMI_DBUS_TIMEOUT.count());
+        readReply(reply);
+    }
+    catch (const sdbusplus::exception::SdBusError& e)
+    {
+        return boost::system::error_code(e.get_errno(),
+                                         boost::system::system_category());
+    }
+    catch (const std::exception& e)
+    {
+        return boost::system::errc::make_error_code(
+            boost::system::errc::bad_message);
+    }
+    return boost::system::error_code();
+}
+
+dbus_stats::Clock::time_point startCall(const Context::ptr& ctx,
+                                        const std::string& service,
+                                        const char* member)
+{
+    IPMI_TRACEPOINT(dbus_call_start, ctx->requestId, ctx->netFn, ctx->cmd,
+                    ctx->channel, service.c_str(), member);
+    return dbus_stats::Clock::now();
+}
+
+void recordCall(const Context::ptr& ctx, const std::string& service,
+                const char* member, dbus_stats::Clock::time_point start,
+                const boost::system::error_code& ec)
+{
+    IPMI_TRACEPOINT(dbus_call_end, ctx->requestId, ctx->netFn, ctx->cmd,
+                    ctx->channel, service.c_str(), member, ec.value());
+    dbus_stats::record(ctx->netFn, ctx->cmd, service, member,
+                       dbus_stats::Clock::now() - start, !!ec);
+    // other requests ran while this one was suspended
+    dbus_stats::setCommand(ctx->netFn, ctx->cmd, ctx->channel, ctx->requestId);
+}
+
+} // namespace detail
+
+boost::system::error_code getService(Context::ptr ctx, const std::string& intf,
+                                     const std::string& path,
+                                     std::string& service)
+{
+    using MapperResponse = std::map<std::string, std::vector<std::string>>;
+    if (auto cached = mapperCache().find(path, intf))
+    {
+        service = std::move(*cached);
+        return boost::system::error_code();
+    }
+
+    boost::system::error_code ec = detail::checkDeadline(ctx);
+    if (ec)
+    {
+        return ec;
+    }
+    MapperResponse mapperResponse;
+    if (ctx->yield)
+    {
+        auto start = detail::startCall(ctx, MAPPER_BUS_NAME, "GetObject");
+        mapperResponse = getSdBus()->yield_method_call<MapperResponse>(
+            *ctx->yield, ec, MAPPER_BUS_NAME, MAPPER_OBJ, MAPPER_INTF,
+            "GetObject", path, std::vector<std::string>({intf}));
+        detail::recordCall(ctx, MAPPER_BUS_NAME, "GetObject", start, ec);
+    }
+    else
+    {
+        auto method = getSdBus()->new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
+                                                  MAPPER_INTF, "GetObject");
+        method.append(path, std::vector<std::string>({intf}));
+        ec = detail::callBlocking(
+            method, [&mapperResponse](sdbusplus::message::message& reply) {
+                reply.read(mapperResponse);
+            });
+    }
+
+    if (!ec)
+    {
+        if (mapperResponse.empty())
+        {
+            return boost::system::errc::make_error_code(
+                boost::system::errc::no_such_file_or_directory);
+        }
+        service = std::move(mapperResponse.begin()->first);
+        mapperCache().insert(path, intf, service);
+    }
+    return ec;
+}
+
+namespace
+{
+
+/** @brief GetSubTree through the Context, yielding if it can */
+boost::system::error_code subTree(const Context::ptr& ctx,
+                                  const std::string& root,
+                                  const std::vector<std::string>& interfaces,
+                                  ObjectTree& tree)
+{
+    boost::system::error_code ec = detail::checkDeadline(ctx);
+    if (ec)
+    {
+        return ec;
+    }
+    int32_t depth = 0;
+    if (ctx->yield)
+    {
+        auto start = detail::startCall(ctx, MAPPER_BUS_NAME, "GetSubTree");
+        tree = getSdBus()->yield_method_call<ObjectTree>(
+            *ctx->yield, ec, MAPPER_BUS_NAME, MAPPER_OBJ, MAPPER_INTF,
+            "GetSubTree", root, depth, interfaces);
+        detail::recordCall(ctx, MAPPER_BUS_NAME, "GetSubTree", start, ec);
+    }
+    else
+    {
+        auto method = getSdBus()->new_method_call(MAPPER_BUS_NAME, MAPPER_OBJ,
+                                                  MAPPER_INTF, "GetSubTree");
+        method.append(root, depth, interfaces);
+        ec = detail::callBlocking(method,
+                                  [&tree](sdbusplus::message::message& reply) {
+                                      reply.read(tree);
+                                  });
+    }
+    return ec;
+}
+
+} // namespace
+
+boost::system::error_code getAllDbusObjects(Context::ptr ctx,
+                                            const std::string& serviceRoot,
+                                            const std::string& interface,
+                                            const std::string& match,
+                                            ObjectTree& objectTree)
+{
+    boost::system::error_code ec;
+    auto indexed = indexedSubTree(
+        serviceRoot, interface,
+        [&ctx](const std::string& root, ObjectTree& tree) {
+            return !subTree(ctx, root, {}, tree);
+        });
+    if (indexed)
+    {
+        objectTree = std::move(*indexed);
+    }
+    else
+    {
+        ec = subTree(ctx, serviceRoot, {interface}, objectTree);
+    }
+    if (ec)
+    {
+        return ec;
+    }
+
+    for (auto it = objectTree.begin(); it != objectTree.end();)
+    {
+        if (it->first.find(match) == std::string::npos)
+        {
+            it = objectTree.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    return ec;
+}
+
+std::vector<std::string> getSubtreeIndexRoots()
+{
+    return subtreeIndex().rootPaths();
+}
+
+boost::system::error_code warmSubtreeIndex(Context::ptr ctx,
+                                           const std::string& root)
+{
+    SubtreeIndex& index = subtreeIndex();
+    std::string rootPath;
+    SubtreeIndex::Root* entry = index.find(root, rootPath);
+    if (!entry || entry->populated)
+    {
+        return {};
+    }
+    uint64_t token = index.watch();
+    if (!token)
+    {
+        return {};
+    }
+    ObjectTree tree;
+    boost::system::error_code ec = subTree(ctx, rootPath, {}, tree);
+    if (!ec)
+    {
+        // roots are never erased, so the entry outlived the yield; a
+        // signal that arrived meanwhile makes populate drop the tree
+        index.populate(*entry, std::move(tree), token);
+    }
+    return ec;
+}
+
+boost::system::error_code getDbusObject(Context::ptr ctx,
+                                        const std::string& interface,
+                                        const std::string& subtreePath,
+                                        const std::string& match,
+                                        DbusObjectInfo& dbusObject)
+{
+    ObjectTree objectTree;
+    boost::system::error_code ec =
+        getAllDbusObjects(ctx, subtreePath, interface, match, objectTree);
+    if (ec)
+    {
+        return ec;
+    }
+    // an empty match matches every path, so this is simply the first one
+    if (objectTree.empty())
+    {
+        return boost::system::errc::make_error_code(
+            boost::system::errc::no_such_file_or_directory);
+    }
+    dbusObject = std::make_pair(objectTree.begin()->first,
+                                objectTree.begin()->second.begin()->first);
+    return ec;
+}
+
+boost::system::error_code getAllDbusProperties(Context::ptr ctx,
+                                               const std::string& service,
+                                               const std::string& objPath,
+                                               const std::string& interface,
+                                               PropertyMap& properties)
+{
+    boost::system::error_code ec = detail::checkDeadline(ctx);
+    if (ec)
+    {
+        return ec;
+    }
+    if (ctx->yield)
+    {
+        auto start = detail::startCall(ctx, service, METHOD_GET_ALL);
+        properties = getSdBus()->yield_method_call<PropertyMap>(
+            *ctx->yield, ec, service.c_str(), objPath.c_str(), PROP_INTF,
+            METHOD_GET_ALL, interface);
+        detail::recordCall(ctx, service, METHOD_GET_ALL, start, ec);
+    }
+    else
+    {
+        auto method = getSdBus()->new_method_call(
+            service.c_str(), objPath.c_str(), PROP_INTF, METHOD_GET_ALL);
+        method.append(interface);
+        ec = detail::callBlocking(
+            method, [&properties](sdbusplus::message::message& reply) {
+                reply.read(properties);
+            });
+    }
+    return ec;
+}
+
+boost::system::error_code getAllDbusProperties(Context::ptr ctx,
+                                               const std::string& service,
+                                               const std::string& objPath,
+                                               const std::string& interface,
+                                               FlatPropertyMap& properties)
+{
+    if (boost::system::error_code ec = detail::checkDeadline(ctx))
+    {
+        return ec;
+    }
+    auto method = getSdBus()->new_method_call(service.c_str(), objPath.c_str(),
+                                              PROP_INTF, METHOD_GET_ALL);
+    method.append(interface);
+    if (!ctx->yield)
+    {
+        return detail::callBlocking(
+            method, [&properties](sdbusplus::message::message& reply) {
+                readProperties(reply, properties);
+            });
+    }
+
+    boost::system::error_code ec;
+    auto start = detail::startCall(ctx, service, METHOD_GET_ALL);
+    sdbusplus::message::message reply =
+        getSdBus()->async_send(method, (*ctx->yield)[ec]);
+    if (!ec && reply.is_method_error())
+    {
+        ec = boost::system::error_code(sd_bus_message_get_errno(reply.get()),
+                                       boost::system::system_category());
+    }
+    detail::recordCall(ctx, service, METHOD_GET_ALL, start, ec);
+    if (ec)
+    {
+        return ec;
+    }
+    try
+    {
+        readProperties(reply, properties);
+    }
+    catch (const std::exception& e)
+    {
+        ec = boost::system::errc::make_error_code(
+            boost::system::errc::bad_message);
+    }
+    return ec;
+}
+
+boost::system::error_code getManagedObjects(Context::ptr ctx,
+                                            const std::string& service,
+                                            const std::string& objPath,
+                                            ObjectValueTree& objects)
+{
+    boost::system::error_code ec = detail::checkDeadline(ctx);
+    if (ec)
+    {
+        return ec;
+    }
+    if (ctx->yield)
+    {
+        auto start = detail::startCall(ctx, service, "GetManagedObjects");
+        objects = getSdBus()->yield_method_call<ObjectValueTree>(
+            *ctx->yield, ec, service.c_str(), objPath.c_str(),
+            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+        detail::recordCall(ctx, service, "GetManagedObjects", start, ec);
+    }
+    else
+    {
+        auto method = getSdBus()->new_method_call(
+            service.c_str(), objPath.c_str(),
+            "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+        ec = detail::callBlocking(
+            method, [&objects](sdbusplus::message::message& reply) {
+                reply.read(objects);
+            });
+    }
+    return ec;
+}
+
+std::vector<BatchReply>
+    callBatch(Context::ptr ctx,
+              std::vector<sdbusplus::message::message>& methods)
+{
+    std::vector<BatchReply> replies(methods.size());
+    if (boost::system::error_code ec = detail::checkDeadline(ctx))
+    {
+        for (BatchReply& result : replies)
+        {
+            result.ec = ec;
+        }
+        return replies;
+    }
+    if (!ctx->yield)
+    {
+        for (size_t i = 0; i < methods.size(); i++)
+        {
+            BatchReply& result = replies[i];
+            result.ec = detail::callBlocking(
+                methods[i], [&result](sdbusplus::message::message& reply) {
+                    result.reply = reply;
+                });
+        }
+        return replies;
+    }
+    if (methods.empty())
+    {
+        return replies;
+    }
+
+    // the timer never expires on its own; the last reply cancels it
+    boost::asio::steady_timer done(
+        *getIoContext(), boost::asio::steady_timer::time_point::max());
+    size_t pending = methods.size();
+    auto start = dbus_stats::Clock::now();
+    auto onReply = [&ctx, &methods, &replies, &pending, &done,
+                    start](size_t i, boost::system::error_code ec,
+                           sdbusplus::message::message& reply) {
+        BatchReply& result = replies[i];
+        result.ec = ec;
+        if (!ec && reply.is_method_error())
+        {
+            result.ec =
+                boost::system::error_code(sd_bus_message_get_errno(reply.get()),
+                                          boost::system::system_category());
+        }
+        result.reply = reply;
+        dbus_stats::record(ctx->netFn, ctx->cmd, getDestination(methods[i]),
+                           methods[i].get_member(),
+                           dbus_stats::Clock::now() - start, !!result.ec);
+        IPMI_TRACEPOINT(dbus_call_end, ctx->requestId, ctx->netFn, ctx->cmd,
+                        ctx->channel, getDestination(methods[i]).c_str(),
+                        methods[i].get_member(), result.ec.value());
+        if (--pending == 0)
+        {
+            done.cancel();
+        }
+    };
+    for (size_t i = 0; i < methods.size(); i++)
+    {
+        IPMI_TRACEPOINT(dbus_call_start, ctx->requestId, ctx->netFn, ctx->cmd,
+                        ctx->channel, getDestination(methods[i]).c_str(),
+                        methods[i].get_member());
+        getSdBus()->async_send(
+            methods[i], [&onReply, i](boost::system::error_code ec,
+                                      sdbusplus::message::message reply) {
+                onReply(i, ec, reply);
+            });
+    }
+
+    boost::system::error_code ec;
+    done.async_wait((*ctx->yield)[ec]);
+    dbus_stats::setCommand(ctx->netFn, ctx->cmd, ctx->channel, ctx->requestId);
+    return replies;
+}
+
+ObjectCache& ObjectCache::instance()
+{
+    // never destroyed; the matches must not outlive the bus connection
+    static ObjectCache* cache = []() {
+        cache_stats::registerCache("dbus-objects", []() {
+            return ObjectCache::instance().usage();
+        });
+        return new ObjectCache();
+    }();
+    return *cache;
+}
+
+const FlatPropertyMap* ObjectCache::find(const std::string& service,
+                                         const std::string& objPath,
+                                         const std::string& interface) const
+{
+    auto it = entries.find(Key(service, objPath, interface));
+    if (it == entries.end() || !it->second.valid)
+    {
+        return nullptr;
+    }
+    it->second.lastUsed = ++useClock;
+    return &it->second.properties;
+}
+
+uint64_t ObjectCache::watch(const std::string& service,
+                            const std::string& objPath,
+                            const std::string& interface)
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto bus = getSdBus();
+    if (!bus)
+    {
+        // no signals without the shared connection; fill drops unknown keys
+        return 0;
+    }
+    if (!ownerChanged)
+    {
+        ownerChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::nameOwnerChanged(),
+            [this](sdbusplus::message::message& msg) {
+                nameOwnerChanged(msg);
+            });
+    }
+
+    Key key(service, objPath, interface);
+    if (limit && entries.size() >= limit && !entries.count(key))
+    {
+        evict();
+    }
+    auto [it, inserted] = entries.try_emplace(key);
+    Entry& entry = it->second;
+    entry.lastUsed = ++useClock;
+    if (inserted)
+    {
+        entry.generation = ++nextGeneration;
+        entry.changed = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::propertiesChanged(objPath, interface),
+            [this, key](sdbusplus::message::message& msg) {
+                propertiesChanged(key, msg);
+            });
+    }
+    return entry.generation;
+}
+
+void ObjectCache::fill(const std::string& service, const std::string& objPath,
+                       const std::string& interface, uint64_t token,
+                       FlatPropertyMap properties)
+{
+    auto it = entries.find(Key(service, objPath, interface));
+    if (it == entries.end() || it->second.generation != token)
+    {
+        return;
+    }
+    it->second.properties = std::move(properties);
+    it->second.valid = true;
+    if (interface == sensor_metadata::interface)
+    {
+        sensor_metadata::update(objPath, it->second.properties);
+    }
+}
+
+void ObjectCache::clear()
+{
+    entries.clear();
+}
+
+void ObjectCache::setLimit(size_t entries)
+{
+    limit = entries;
+}
+
+void ObjectCache::evict()
+{
+    // at most a few hundred entries, and only on a miss; not worth an
+    // LRU list that every hit would have to update
+    while (limit && entries.size() >= limit)
+    {
+        auto oldest = std::min_element(
+            entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) {
+                return a.second.lastUsed < b.second.lastUsed;
+            });
+        entries.erase(oldest);
+        evictions++;
+    }
+}
+
+cache_stats::Usage ObjectCache::usage() const
+{
+    using cache_stats::heapBytes;
+
+    // a map node holds the key and the entry next to the tree pointers
+    constexpr size_t nodeBytes = sizeof(Key) + sizeof(Entry) + 32;
+    cache_stats::Usage usage;
+    usage.entries = entries.size();
+    usage.limit = limit;
+    usage.evictions = evictions;
+    for (const auto& [key, entry] : entries)
+    {
+        usage.bytes += nodeBytes + heapBytes(std::get<0>(key)) +
+                       heapBytes(std::get<1>(key)) +
+                       heapBytes(std::get<2>(key)) +
+                       sizeof(sdbusplus::bus::match::match) +
+                       entry.properties.capacity() *
+                           sizeof(FlatPropertyMap::value_type);
+        for (const auto& [name, value] : entry.properties)
+        {
+            if (auto text = std::get_if<std::string>(&value))
+            {
+                usage.bytes += heapBytes(*text);
+            }
+        }
+    }
+    return usage;
+}
+
+void ObjectCache::propertiesChanged(const Key& key,
+                                    sdbusplus::message::message& msg)
+{
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        return;
+    }
+    Entry& entry = it->second;
+    // any fetch still in flight may have read the old values
+    entry.generation = ++nextGeneration;
+    if (!entry.valid)
+    {
+        return;
+    }
+
+    try
+    {
+        std::string interface;
+        std::vector<std::string> invalidated;
+        msg.read(interface);
+        // changed values are read straight into the cached entry
+        readProperties(msg, entry.properties);
+        msg.read(invalidated);
+        if (!invalidated.empty())
+        {
+            entry.valid = false;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        // a type outside of ipmi::Value; fetch it again on the next lookup
+        entry.valid = false;
+    }
+}
+
+void ObjectCache::nameOwnerChanged(sdbusplus::message::message& msg)
+{
+    std::string name;
+    std::string oldOwner;
+    std::string newOwner;
+    try
+    {
+        msg.read(name, oldOwner, newOwner);
+    }
+    catch (const std::exception& e)
+    {
+        return;
+    }
+
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        const std::string& service = std::get<0>(it->first);
+        if (service == name || service == oldOwner)
+        {
+            if (std::get<2>(it->first) == sensor_metadata::interface)
+            {
+                // the new owner may scale the sensor differently
+                sensor_metadata::remove(std::get<1>(it->first));
+            }
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+Value getCachedDbusProperty(sdbusplus::bus::bus& bus,
+                            const std::string& service,
+                            const std::string& objPath,
+                            const std::string& interface,
+                            const std::string& property)
+{
+    ObjectCache& cache = ObjectCache::instance();
+    const FlatPropertyMap* cached = cache.find(service, objPath, interface);
+    if (cached)
+    {
+        auto it = cached->find(property);
+        if (it != cached->end())
+        {
+            return it->second;
+        }
+    }
+
+    uint64_t token = cache.watch(service, objPath, interface);
+    FlatPropertyMap properties;
+    getAllDbusProperties(bus, service, objPath, interface, properties);
+
+    auto it = properties.find(property);
+    if (it == properties.end())
+    {
+        log<level::ERR>("Failed to get property",
+                        entry("PROPERTY=%s", property.c_str()),
+                        entry("PATH=%s", objPath.c_str()),
+                        entry("INTERFACE=%s", interface.c_str()));
+        elog<InternalFailure>();
+    }
+    Value value = it->second;
+    cache.fill(service, objPath, interface, token, std::move(properties));
+    return value;
+}
+
+boost::system::error_code getCachedAllDbusProperties(
+    Context::ptr ctx, const std::string& service, const std::string& objPath,
+    const std::string& interface, PropertyMap& properties)
+{
+    FlatPropertyMap flat;
+    boost::system::error_code ec =
+        getCachedAllDbusProperties(ctx, service, objPath, interface, flat);
+    if (!ec)
+    {
+        properties = flat.toPropertyMap();
+    }
+    return ec;
+}
+
+boost::system::error_code getCachedAllDbusProperties(
+    Context::ptr ctx, const std::string& service, const std::string& objPath,
+    const std::string& interface, FlatPropertyMap& properties)
+{
+    ObjectCache& cache = ObjectCache::instance();
+    const FlatPropertyMap* cached = cache.find(service, objPath, interface);
+    if (cached)
+    {
+        properties = *cached;
+        return boost::system::error_code();
+    }
+
+    uint64_t token = cache.watch(service, objPath, interface);
+    boost::system::error_code ec =
+        getAllDbusProperties(ctx, service, objPath, interface, properties);
+    if (!ec)
+    {
+        cache.fill(service, objPath, interface, token, properties);
+    }
+    return ec;
+}
+
+namespace detail
+{
+
+boost::system::error_code
+    getCachedValue(Context::ptr ctx, const std::string& service,
+                   const std::string& objPath, const std::string& interface,
+                   const std::string& property, Value& value)
+{
+    ObjectCache& cache = ObjectCache::instance();
+    const FlatPropertyMap* cached = cache.find(service, objPath, interface);
+    if (cached)
+    {
+        auto it = cached->find(property);
+        if (it == cached->end())
+        {
+            return boost::system::errc::make_error_code(
+                boost::system::errc::no_such_file_or_directory);
+        }
+        value = it->second;
+        return boost::system::error_code();
+    }
+
+    uint64_t token = cache.watch(service, objPath, interface);
+    FlatPropertyMap properties;
+    boost::system::error_code ec =
+        getAllDbusProperties(ctx, service, objPath, interface, properties);
+    if (ec)
+    {
+        return ec;
+    }
+    auto it = properties.find(property);
+    if (it == properties.end())
+    {
+        ec = boost::system::errc::make_error_code(
+            boost::system::errc::no_such_file_or_directory);
+    }
+    else
+    {
+        value = it->second;
+    }
+    cache.fill(service, objPath, interface, token, std::move(properties));
+    return ec;
+}
+
+} // namespace detail
+
 namespace method_no_args
 {
 
@@ -418,7 +1817,7 @@ void callDbusMethod(sdbusplus::bus::bus& bus, const std::string& service,
     auto busMethod = bus.new_method_call(service.c_str(), objPath.c_str(),
                                          interface.c_str(), method.c_str());
 
-    auto reply = bus.call(busMethod);
+    auto reply = accountedCall(bus, busMethod);
 
     if (reply.is_method_error())
     {
@@ -451,7 +1850,7 @@ void createIP(sdbusplus::bus::bus& bus, const std::string& service,
 
     busMethod.append(protocolType, ipaddress, prefix, gateway);
 
-    auto reply = bus.call(busMethod);
+    auto reply = accountedCall(bus, busMethod);
 
     if (reply.is_method_error())
     {
@@ -470,7 +1869,7 @@ void createVLAN(sdbusplus::bus::bus& bus, const std::string& service,
 
     busMethod.append(interfaceName, vlanID);
 
-    auto reply = bus.call(busMethod);
+    auto reply = accountedCall(bus, busMethod);
 
     if (reply.is_method_error())
     {
@@ -0,0 +1,148 @@
+#include "config.h"
+
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <boost/asio/spawn.hpp>
+#include <deque>
+#include <exception>
+#include <ipmid/api.hpp>
+#include <ipmid/warmup.hpp>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <utility>
+
+namespace ipmi
+{
+namespace warmup
+{
+
+namespace
+{
+
+using namespace phosphor::logging;
+using Clock = std::chrono::steady_clock;
+
+struct Pending
+{
+    std::string name;
+    Task task;
+    // queued before the warm-up finished, so it counts towards it
+    bool counted;
+};
+
+std::deque<Pending> queue;
+size_t limit = 0; // 0 until start()
+size_t running = 0;
+// counted tasks queued or running
+size_t outstanding = 0;
+bool finished = false;
+Report report;
+Clock::time_point began;
+Done done;
+
+boost::coroutines::attributes attributes()
+{
+    if (IPMI_COROUTINE_STACK_SIZE)
+    {
+        return boost::coroutines::attributes(IPMI_COROUTINE_STACK_SIZE);
+    }
+    return boost::coroutines::attributes();
+}
+
+void finish()
+{
+    finished = true;
+    report.duration = Clock::now() - began;
+    if (done)
+    {
+        done(report);
+        done = nullptr;
+    }
+}
+
+void run(Pending pending);
+
+/* start queued tasks until the bound is reached */
+void next()
+{
+    while (running < limit && !queue.empty())
+    {
+        running++;
+        // posted, so that a task never starts on the stack of another
+        boost::asio::post(*getIoContext(),
+                          [pending = std::move(queue.front())]() mutable {
+                              run(std::move(pending));
+                          });
+        queue.pop_front();
+    }
+}
+
+void run(Pending pending)
+{
+    boost::asio::spawn(
+        *getIoContext(),
+        [pending = std::move(pending)](boost::asio::yield_context yield) {
+            auto ctx = std::make_shared<Context>();
+            ctx->yield = &yield;
+            bool failed = false;
+            try
+            {
+                pending.task(ctx);
+            }
+            catch (const std::exception& e)
+            {
+                failed = true;
+                log<level::ERR>("Failed to warm up an IPMI cache",
+                                entry("CACHE=%s", pending.name.c_str()),
+                                entry("ERROR=%s", e.what()));
+            }
+            running--;
+            if (pending.counted)
+            {
+                report.failed += failed;
+                if (--outstanding == 0)
+                {
+                    finish();
+                }
+            }
+            next();
+        },
+        attributes());
+}
+
+} // namespace
+
+void add(const std::string& name, Task task)
+{
+    bool counted = !finished;
+    if (counted)
+    {
+        report.tasks++;
+        outstanding++;
+    }
+    queue.push_back({name, std::move(task), counted});
+    next();
+}
+
+void start(size_t parallel, Done onDone)
+{
+    limit = std::max<size_t>(parallel, 1);
+    began = Clock::now();
+    done = std::move(onDone);
+    // from the loop, in case nothing was queued
+    boost::asio::post(*getIoContext(), []() {
+        if (!outstanding && !finished)
+        {
+            finish();
+        }
+    });
+    next();
+}
+
+bool complete()
+{
+    return finished;
+}
+
+} // namespace warmup
+} // namespace ipmi
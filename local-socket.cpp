@@ -0,0 +1,300 @@
+#include "config.h"
+
+#include "local-socket.hpp"
+
+#ifdef ENABLE_LOCAL_SOCKET
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ipmid/log-limit.hpp>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#endif
+
+namespace ipmi
+{
+namespace local
+{
+
+#ifdef ENABLE_LOCAL_SOCKET
+
+namespace
+{
+
+using namespace phosphor::logging;
+using Socket = boost::asio::posix::stream_descriptor;
+
+constexpr size_t requestHeaderSize = 12;
+// more than the largest request of any channel
+constexpr size_t maxRequestSize = requestHeaderSize + 4096;
+constexpr auto acceptBackoff = std::chrono::milliseconds(100);
+
+std::unique_ptr<Socket> listener;
+std::unique_ptr<boost::asio::steady_timer> retry;
+Executor execute;
+size_t connections = 0;
+
+/* only root and ipmid's own user may state the channel and privilege */
+bool trusted(int fd, ucred& cred)
+{
+    socklen_t length = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) < 0)
+    {
+        return false;
+    }
+    return cred.uid == 0 || cred.uid == geteuid();
+}
+
+/* parse the header and data of a request; false if it is malformed */
+bool decode(const uint8_t* packet, size_t size, Frame& frame)
+{
+    if (size < requestHeaderSize || packet[0] != frameVersion ||
+        packet[5] > static_cast<uint8_t>(Privilege::Oem))
+    {
+        return false;
+    }
+    frame.netFn = packet[1];
+    frame.lun = packet[2];
+    frame.cmd = packet[3];
+    frame.channel = packet[4];
+    frame.privilege = static_cast<Privilege>(packet[5]);
+    frame.userId = packet[6];
+    frame.rqSA = packet[7];
+    std::memcpy(&frame.tag, packet + 8, sizeof(frame.tag));
+    frame.data.assign(packet + requestHeaderSize, packet + size);
+    return true;
+}
+
+void encode(std::vector<uint8_t>& packet, const Frame& frame, Cc cc,
+            const std::vector<uint8_t>& data)
+{
+    constexpr uint8_t netFnResponse = 0x01;
+    packet.clear();
+    packet.push_back(frameVersion);
+    packet.push_back(frame.netFn | netFnResponse);
+    packet.push_back(frame.lun);
+    packet.push_back(frame.cmd);
+    packet.push_back(cc);
+    const uint8_t* tag = reinterpret_cast<const uint8_t*>(&frame.tag);
+    packet.insert(packet.end(), tag, tag + sizeof(frame.tag));
+    packet.insert(packet.end(), data.begin(), data.end());
+}
+
+/* send a packet, waiting while the socket buffer is full */
+bool send(Socket& socket, const std::vector<uint8_t>& packet,
+          boost::asio::yield_context yield)
+{
+    while (::send(socket.native_handle(), packet.data(), packet.size(),
+                  MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            return false;
+        }
+        boost::system::error_code ec;
+        socket.async_wait(Socket::wait_write, yield[ec]);
+        if (ec)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* answer the requests of one client, in order, until it hangs up */
+void serve(boost::asio::io_context& io, int fd, pid_t client)
+{
+    connections++;
+    boost::asio::spawn(io, [&io, fd, client](boost::asio::yield_context yield) {
+        Socket socket(io, fd);
+        std::vector<uint8_t> in(maxRequestSize);
+        std::vector<uint8_t> out;
+        Frame frame;
+        frame.client = static_cast<uint32_t>(client);
+        while (true)
+        {
+            boost::system::error_code ec;
+            socket.async_wait(Socket::wait_read, yield[ec]);
+            if (ec)
+            {
+                break;
+            }
+            // MSG_TRUNC gives the size of the whole packet, even if it was
+            // cut short to fit
+            ssize_t n = ::recv(fd, in.data(), in.size(),
+                               MSG_DONTWAIT | MSG_TRUNC);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                          errno == EINTR))
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            size_t size = static_cast<size_t>(n);
+            if (!decode(in.data(), std::min(size, in.size()), frame))
+            {
+                // a client that doesn't speak the format is dropped
+                ipmi::logLimited<level::ERR>(
+                    "Malformed request on the local IPMI socket",
+                    entry("SIZE=%zu", size));
+                break;
+            }
+            if (size > in.size())
+            {
+                encode(out, frame, ccReqDataLenExceeded, {});
+            }
+            else
+            {
+                auto [cc, data] = execute(yield, frame);
+                encode(out, frame, cc, data);
+            }
+            if (!send(socket, out, yield))
+            {
+                break;
+            }
+        }
+        connections--;
+    });
+}
+
+void accept(boost::asio::io_context& io)
+{
+    listener->async_wait(
+        Socket::wait_read, [&io](const boost::system::error_code& ec) {
+            if (ec || !listener)
+            {
+                // closed by shutdown()
+                return;
+            }
+            while (true)
+            {
+                int fd = accept4(listener->native_handle(), nullptr, nullptr,
+                                 SOCK_CLOEXEC | SOCK_NONBLOCK);
+                if (fd < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (fd < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    // out of descriptors the listener stays readable, so
+                    // wait a while rather than spin on it
+                    ipmi::logLimited<level::ERR>(
+                        "Failed to accept a local IPMI client",
+                        entry("ERRNO=%d", errno));
+                    retry->expires_after(acceptBackoff);
+                    retry->async_wait(
+                        [&io](const boost::system::error_code& error) {
+                            if (!error && listener)
+                            {
+                                accept(io);
+                            }
+                        });
+                    return;
+                }
+                if (fd < 0)
+                {
+                    break;
+                }
+                ucred cred{};
+                if (!trusted(fd, cred))
+                {
+                    ipmi::logLimited<level::ERR>(
+                        "Refused an untrusted local IPMI client");
+                    close(fd);
+                }
+                else if (connections >= IPMI_LOCAL_SOCKET_CONNECTIONS)
+                {
+                    ipmi::logLimited<level::ERR>(
+                        "Refused a local IPMI client; too many connections",
+                        entry("CONNECTIONS=%zu", connections));
+                    close(fd);
+                }
+                else
+                {
+                    serve(io, fd, cred.pid);
+                }
+            }
+            accept(io);
+        });
+}
+
+} // namespace
+
+void initialize(boost::asio::io_context& io, Executor executor)
+{
+    constexpr const char* path = IPMI_LOCAL_SOCKET_PATH;
+    sockaddr_un addr{};
+    if (std::strlen(path) >= sizeof(addr.sun_path))
+    {
+        log<level::ERR>("Local IPMI socket path is too long",
+                        entry("PATH=%s", path));
+        return;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to create the local IPMI socket",
+                        entry("ERRNO=%d", errno));
+        return;
+    }
+    // a socket left behind by an earlier run would fail the bind
+    unlink(path);
+    // the socket is created owner only, rather than opened up to everyone
+    // until a chmod; this runs before the handler threads are started, so
+    // nothing else sees the umask
+    mode_t mask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+    int bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    umask(mask);
+    if (bound < 0 || listen(fd, SOMAXCONN) < 0)
+    {
+        log<level::ERR>("Failed to listen on the local IPMI socket",
+                        entry("PATH=%s", path), entry("ERRNO=%d", errno));
+        close(fd);
+        return;
+    }
+
+    execute = std::move(executor);
+    listener = std::make_unique<Socket>(io, fd);
+    retry = std::make_unique<boost::asio::steady_timer>(io);
+    accept(io);
+    log<level::INFO>("Listening for local IPMI clients",
+                     entry("PATH=%s", path));
+}
+
+void shutdown()
+{
+    if (listener)
+    {
+        listener.reset();
+        retry.reset();
+        unlink(IPMI_LOCAL_SOCKET_PATH);
+    }
+}
+
+#else // !ENABLE_LOCAL_SOCKET
+
+void initialize(boost::asio::io_context&, Executor)
+{
+}
+
+void shutdown()
+{
+}
+
+#endif // ENABLE_LOCAL_SOCKET
+
+} // namespace local
+} // namespace ipmi
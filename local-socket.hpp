@@ -0,0 +1,73 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/spawn.hpp>
+#include <cstdint>
+#include <functional>
+#include <ipmid/api-types.hpp>
+#include <tuple>
+#include <vector>
+
+namespace ipmi
+{
+namespace local
+{
+
+/** @brief Version of the frame format, leading every frame */
+constexpr uint8_t frameVersion = 1;
+
+/** @struct Frame
+ *  @brief A request from an in-box client on the local socket
+ *
+ *  On the socket a request is one packet of
+ *      uint8_t version, netFn, lun, cmd, channel, privilege, userId, rqSA,
+ *      uint32_t tag, data[]
+ *  and its response is one packet of
+ *      uint8_t version, netFn, lun, cmd, cc, uint32_t tag, data[]
+ *  where the response netFn has the response bit set and the tag is the
+ *  one of the request. The tag is in the byte order of the BMC, since both
+ *  ends run on it.
+ *
+ *  Only root and the user ipmid runs as may connect, so the channel,
+ *  privilege and user of the request are taken as the client states them,
+ *  the way the channel daemons state them in the execute options.
+ */
+struct Frame
+{
+    uint8_t netFn = 0;
+    uint8_t lun = 0;
+    uint8_t cmd = 0;
+    uint8_t channel = 0;
+    Privilege privilege = Privilege::None;
+    uint8_t userId = 0;
+    uint8_t rqSA = 0;
+    uint32_t tag = 0;
+    std::vector<uint8_t> data;
+    // not on the wire: the process id of the client, which its requests
+    // are counted against like those of a D-Bus sender
+    uint32_t client = 0;
+};
+
+/** @brief Runs a request; returns its completion code and response data */
+using Executor = std::function<std::tuple<Cc, std::vector<uint8_t>>(
+    boost::asio::yield_context, Frame&)>;
+
+/** @brief Listen for in-box clients on IPMI_LOCAL_SOCKET_PATH
+ *
+ *  Does nothing unless ipmid was built with --enable-local-socket. Each
+ *  connection is served by a coroutine of its own, one request at a time;
+ *  a client that wants requests in flight in parallel opens more
+ *  connections, up to IPMI_LOCAL_SOCKET_CONNECTIONS across all clients.
+ *  The executor admits the requests like the execute calls, so they are
+ *  subject to the same in-flight limits, queues and deadlines.
+ *
+ *  @param[in] io - the main loop
+ *  @param[in] executor - runs the requests through the dispatcher
+ */
+void initialize(boost::asio::io_context& io, Executor executor);
+
+/** @brief Stop listening and remove the socket */
+void shutdown();
+
+} // namespace local
+} // namespace ipmi
@@ -3,12 +3,19 @@
 #include "fruread.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
+#include <ipmid/warmup.hpp>
+#include <iterator>
 #include <map>
 #include <phosphor-logging/elog-errors.hpp>
 #include <sdbusplus/message/types.hpp>
+#include <set>
+#include <string>
+#include <tuple>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 extern const FruMap frus;
@@ -35,7 +42,76 @@ namespace cache
 // Caching the data which will be invalidated when ever there
 // is a change in FRU properties.
 FRUAreaMap fruMap;
+
+// A reader that hasn't asked for a chunk in this long is considered gone.
+constexpr auto readTimeout = std::chrono::seconds(5);
+
+/**
+ * @brief Image a read of the FRU runs on, so all of its chunks come from
+ *  the same image
+ */
+struct Read
+{
+    FruAreaPtr image;
+    std::chrono::steady_clock::time_point last;
+    // started by an Area Info that no chunk was read for yet
+    bool areaInfo;
+};
+std::map<std::tuple<Reader, FRUId>, Read> reads;
+
+// Generation of the last image built for each FRU
+std::map<FRUId, uint32_t> generations;
+
+// FRUs whose area is (re)built in the background, one per turn of the
+// event loop so the IPMI requests keep being served meanwhile.
+std::set<FRUId> pending;
+
+/**
+ * @brief Measure the FRU areas for cache_stats, including the older images
+ *  that reads in progress still hold
+ */
+cache_stats::Usage usage()
+{
+    // a map node holds the key and the pointer next to the tree pointers
+    constexpr size_t nodeBytes = sizeof(FRUId) + sizeof(FruAreaPtr) + 32;
+    cache_stats::Usage usage;
+    std::set<const FruAreaImage*> images;
+    for (const auto& [fruId, image] : fruMap)
+    {
+        usage.bytes += nodeBytes;
+        images.insert(image.get());
+    }
+    for (const auto& [key, read] : reads)
+    {
+        usage.bytes += sizeof(key) + sizeof(Read) + 32;
+        images.insert(read.image.get());
+    }
+    for (const FruAreaImage* image : images)
+    {
+        usage.bytes += sizeof(FruAreaImage) + image->data.capacity();
+    }
+    usage.entries = fruMap.size();
+    return usage;
+}
 } // namespace cache
+
+FruInventoryData readDataFromInventory(const FRUId& fruNum);
+
+/**
+ * @brief Build a new image of the FRU area from the inventory
+ *
+ * @param[in] fruNum FRU id
+ * @return the image, which is also the latest one in the cache
+ */
+FruAreaPtr buildImage(const FRUId& fruNum)
+{
+    auto image = std::make_shared<const FruAreaImage>(
+        FruAreaImage{++cache::generations[fruNum],
+                     buildFruAreaData(readDataFromInventory(fruNum))});
+    cache::fruMap[fruNum] = image;
+    return image;
+}
+
 /**
  * @brief Read all the property value's for the specified interface
  *  from Inventory.
@@ -48,7 +124,7 @@ ipmi::PropertyMap readAllProperties(const std::string& intf,
                                     const std::string& path)
 {
     ipmi::PropertyMap properties;
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     auto service = ipmi::getService(bus, INV_INTF, OBJ_PATH);
     std::string objPath = OBJ_PATH + path;
     auto method = bus.new_method_call(service.c_str(), objPath.c_str(),
@@ -67,12 +143,56 @@ ipmi::PropertyMap readAllProperties(const std::string& intf,
     return properties;
 }
 
-void processFruPropChange(sdbusplus::message::message& msg)
+/**
+ * @brief Build the area of the next pending FRU, unless a reader already
+ *  did so in the meantime
+ */
+void buildNext()
 {
-    if (cache::fruMap.empty())
+    if (cache::pending.empty())
     {
         return;
     }
+    FRUId fruNum = *cache::pending.begin();
+    cache::pending.erase(cache::pending.begin());
+
+    if (cache::fruMap.find(fruNum) == cache::fruMap.end())
+    {
+        try
+        {
+            buildImage(fruNum);
+        }
+        catch (const std::exception& e)
+        {
+            // left for getFruAreaData to retry on demand
+            log<level::ERR>("Failed to build the FRU area",
+                            entry("FRUID=%d", fruNum),
+                            entry("ERROR=%s", e.what()));
+        }
+    }
+
+    if (!cache::pending.empty())
+    {
+        post_work(buildNext);
+    }
+}
+
+/**
+ * @brief Queue the area of a FRU to be built in the background
+ *
+ * @param[in] fruNum FRU id
+ */
+void scheduleBuild(FRUId fruNum)
+{
+    if (cache::pending.empty())
+    {
+        post_work(buildNext);
+    }
+    cache::pending.insert(fruNum);
+}
+
+void processFruPropChange(sdbusplus::message::message& msg)
+{
     std::string path = msg.get_path();
     // trim the object base path, if found at the beginning
     if (path.compare(0, strlen(OBJ_PATH), OBJ_PATH) == 0)
@@ -85,10 +205,13 @@ void processFruPropChange(sdbusplus::message::message& msg)
             instanceList.begin(), instanceList.end(),
             [&path](const auto& iter) { return (iter.path == path); });
 
+        // an inventory object may be part of more than one FRU; drop each
+        // of their areas now so no reader sees stale data, and rebuild
+        // them ahead of the next read
         if (found != instanceList.end())
         {
             cache::fruMap.erase(fruId);
-            break;
+            scheduleBuild(fruId);
         }
     }
 }
@@ -99,12 +222,29 @@ int registerCallbackHandler()
     if (matchPtr == nullptr)
     {
         using namespace sdbusplus::bus::match::rules;
-        sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+        sdbusplus::bus::bus& bus = getBus();
         matchPtr = std::make_unique<sdbusplus::bus::match_t>(
             bus,
             path_namespace(OBJ_PATH) + type::signal() +
                 member("PropertiesChanged") + interface(PROP_INTF),
             std::bind(processFruPropChange, std::placeholders::_1));
+
+        cache_stats::registerCache("fru-areas", cache::usage);
+
+        // prefetch every FRU area so the first FRU read after startup
+        // doesn't have to wait for the inventory
+        for (const auto& fru : frus)
+        {
+            FRUId fruNum = fru.first;
+            warmup::add("fru " + std::to_string(fruNum),
+                        [fruNum](Context::ptr) {
+                            if (cache::fruMap.find(fruNum) ==
+                                cache::fruMap.end())
+                            {
+                                buildImage(fruNum);
+                            }
+                        });
+        }
     }
     return 0;
 }
@@ -130,16 +270,16 @@ FruInventoryData readDataFromInventory(const FRUId& fruNum)
     {
         for (auto& intf : instance.interfaces)
         {
-            ipmi::PropertyMap allProp =
-                readAllProperties(intf.first, instance.path);
+            ipmi::PropertyMap allProp = readAllProperties(
+                std::string(intf.first), std::string(instance.path));
             for (auto& properties : intf.second)
             {
-                auto iter = allProp.find(properties.first);
+                auto iter = allProp.find(std::string(properties.first));
                 if (iter != allProp.end())
                 {
-                    data[properties.second.section].emplace(
-                        properties.first, std::move(std::get<std::string>(
-                                              allProp[properties.first])));
+                    data[std::string(properties.second.section)].emplace(
+                        iter->first,
+                        std::move(std::get<std::string>(iter->second)));
                 }
             }
         }
@@ -147,19 +287,43 @@ FruInventoryData readDataFromInventory(const FRUId& fruNum)
     return data;
 }
 
-const FruAreaData& getFruAreaData(const FRUId& fruNum)
+FruAreaPtr getFruAreaData(const FRUId& fruNum, const Reader& reader,
+                          ReadStep step)
 {
+    auto now = std::chrono::steady_clock::now();
+    auto read = cache::reads.find({reader, fruNum});
+    if (read != cache::reads.end() &&
+        now - read->second.last < cache::readTimeout &&
+        (step == ReadStep::nextChunk ||
+         (step == ReadStep::firstChunk && read->second.areaInfo)))
+    {
+        read->second.last = now;
+        read->second.areaInfo = false;
+        return read->second.image;
+    }
+
+    // the readers that went away
+    for (auto it = cache::reads.begin(); it != cache::reads.end();)
+    {
+        it = now - it->second.last < cache::readTimeout
+                 ? std::next(it)
+                 : cache::reads.erase(it);
+    }
+
+    FruAreaPtr image;
     auto iter = cache::fruMap.find(fruNum);
     if (iter != cache::fruMap.end())
     {
-        return iter->second;
+        image = iter->second;
     }
-    auto invData = readDataFromInventory(fruNum);
-
-    // Build area info based on inventory data
-    FruAreaData newdata = buildFruAreaData(std::move(invData));
-    cache::fruMap.emplace(fruNum, std::move(newdata));
-    return cache::fruMap.at(fruNum);
+    else
+    {
+        // Build area info based on inventory data
+        image = buildImage(fruNum);
+    }
+    cache::reads[{reader, fruNum}] = {image, now,
+                                      step == ReadStep::areaInfo};
+    return image;
 }
 } // namespace fru
 } // namespace ipmi
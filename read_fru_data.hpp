@@ -1,23 +1,74 @@
 #pragma once
 #include "ipmi_fru_info_area.hpp"
 
+#include <memory>
 #include <sdbusplus/bus.hpp>
 #include <string>
+#include <tuple>
 
 namespace ipmi
 {
 namespace fru
 {
 using FRUId = uint8_t;
-using FRUAreaMap = std::map<FRUId, FruAreaData>;
+
+/**
+ * @brief FRU area data of one FRU; never modified once built, a change of
+ *  the inventory builds a new image with the next generation number
+ */
+struct FruAreaImage
+{
+    uint32_t generation;
+    FruAreaData data;
+};
+
+using FruAreaPtr = std::shared_ptr<const FruAreaImage>;
+using FRUAreaMap = std::map<FRUId, FruAreaPtr>;
+
+/**
+ * @brief The client a read of a FRU belongs to: the channel it came in on
+ *  and the user of its session, so that two clients reading the same FRU
+ *  each keep their own image
+ */
+struct Reader
+{
+    int channel;
+    int userId;
+
+    bool operator<(const Reader& other) const
+    {
+        return std::tie(channel, userId) <
+               std::tie(other.channel, other.userId);
+    }
+};
+
+/** @brief How a request relates to the read of a FRU */
+enum class ReadStep
+{
+    // Get FRU Inventory Area Info: a read starts from the latest image
+    areaInfo,
+    // Read FRU Data at offset 0: a read starts, unless the Area Info that
+    // began it was just answered, so the size and the data match
+    firstChunk,
+    // Read FRU Data further on: the read goes on
+    nextChunk,
+};
+
 /**
  * @brief Get fru area data as per IPMI specification
  *
+ * The FRU is read in small chunks, so the image a read started with is kept
+ * for the following chunks of that reader even if the FRU is rebuilt
+ * meanwhile.
+ *
  * @param[in] fruNum FRU ID
+ * @param[in] reader the client reading the FRU
+ * @param[in] step where the request is in the read
  *
  * @return FRU area data as per IPMI specification
  */
-const FruAreaData& getFruAreaData(const FRUId& fruNum);
+FruAreaPtr getFruAreaData(const FRUId& fruNum, const Reader& reader,
+                          ReadStep step);
 
 /**
  * @brief Register callback handler into DBUS for PropertyChange events
@@ -0,0 +1,210 @@
+#include "config.h"
+
+#include "request-scheduler.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+namespace ipmi
+{
+namespace scheduler
+{
+
+namespace
+{
+
+static_assert(IPMI_SCHEDULER_RESERVED < IPMI_COROUTINE_POOL_DEPTH,
+              "the reserved coroutines must leave some for the other "
+              "channels");
+
+struct Queue
+{
+    std::deque<Pending> requests;
+    bool priority = false;
+    // running credit of the smooth weighted round robin
+    int credit = 0;
+};
+
+std::array<Queue, maxIpmiChannels + 1> queues;
+
+Stats stats;
+
+size_t total = 0;
+
+/* requests in flight per sender; senders drop out when they reach zero */
+std::unordered_map<uint64_t, size_t> senders;
+
+InFlightStats inFlightStats;
+
+inline size_t queueIndex(uint8_t channel)
+{
+    return std::min<size_t>(channel, unknownChannel);
+}
+
+inline int weight(const Queue& queue)
+{
+    return queue.priority ? IPMI_SCHEDULER_SYSTEM_WEIGHT : 1;
+}
+
+inline bool mayStart(bool priority, size_t inUse)
+{
+    size_t limit = IPMI_COROUTINE_POOL_DEPTH;
+    if (!priority)
+    {
+        limit -= IPMI_SCHEDULER_RESERVED;
+    }
+    return inUse < limit;
+}
+
+bool full(uint8_t channel)
+{
+    return queues[queueIndex(channel)].requests.size() >=
+           IPMI_SCHEDULER_QUEUE_LIMIT;
+}
+
+void enqueue(uint8_t channel, bool priority, Pending&& pending)
+{
+    size_t index = queueIndex(channel);
+    Queue& queue = queues[index];
+    ChannelStats& channelStats = stats[index];
+    queue.priority = priority;
+    queue.requests.push_back(std::move(pending));
+    total++;
+    channelStats.queued = queue.requests.size();
+    channelStats.peak = std::max(channelStats.peak, channelStats.queued);
+    channelStats.delayed++;
+    inFlightStats.queuedPeak = std::max(inFlightStats.queuedPeak, total);
+}
+
+} // namespace
+
+bool admit(uint8_t channel, bool priority, size_t inUse)
+{
+    return queues[queueIndex(channel)].requests.empty() &&
+           mayStart(priority, inUse);
+}
+
+bool push(uint8_t channel, bool priority, sdbusplus::message::message&& m,
+          std::chrono::steady_clock::time_point received)
+{
+    if (full(channel))
+    {
+        return false;
+    }
+    enqueue(channel, priority, Pending{std::move(m), nullptr, received});
+    return true;
+}
+
+bool push(uint8_t channel, bool priority, std::function<void()>&& resume,
+          std::chrono::steady_clock::time_point received)
+{
+    if (full(channel))
+    {
+        return false;
+    }
+    enqueue(channel, priority,
+            Pending{std::nullopt, std::move(resume), received});
+    return true;
+}
+
+std::optional<Pending> pop(size_t inUse)
+{
+    // smooth weighted round robin over the channels that may start one:
+    // each gains its weight, the richest runs and pays the sum of them
+    Queue* chosen = nullptr;
+    int sum = 0;
+    for (Queue& queue : queues)
+    {
+        if (queue.requests.empty() || !mayStart(queue.priority, inUse))
+        {
+            continue;
+        }
+        queue.credit += weight(queue);
+        sum += weight(queue);
+        if (!chosen || queue.credit > chosen->credit)
+        {
+            chosen = &queue;
+        }
+    }
+    if (!chosen)
+    {
+        return std::nullopt;
+    }
+    chosen->credit -= sum;
+
+    std::optional<Pending> next(std::move(chosen->requests.front()));
+    chosen->requests.pop_front();
+    total--;
+    size_t index = chosen - queues.data();
+    stats[index].queued = chosen->requests.size();
+    if (chosen->requests.empty())
+    {
+        // an idle channel must not save up credit for later
+        chosen->credit = 0;
+    }
+    return next;
+}
+
+bool enter(uint64_t sender, bool priority)
+{
+    if (!priority && inFlightStats.inFlight >= IPMI_IN_FLIGHT_LIMIT)
+    {
+        inFlightStats.rejected++;
+        return false;
+    }
+    if (sender != unknownSender)
+    {
+        size_t& count = senders[sender];
+        if (count >= IPMI_SENDER_IN_FLIGHT_LIMIT)
+        {
+            inFlightStats.senderRejected++;
+            return false;
+        }
+        count++;
+        inFlightStats.senderPeak = std::max(inFlightStats.senderPeak, count);
+    }
+    inFlightStats.inFlight++;
+    inFlightStats.peak = std::max(inFlightStats.peak, inFlightStats.inFlight);
+    return true;
+}
+
+void leave(uint64_t sender)
+{
+    if (sender != unknownSender)
+    {
+        auto iter = senders.find(sender);
+        if (iter == senders.end())
+        {
+            return;
+        }
+        if (--iter->second == 0)
+        {
+            senders.erase(iter);
+        }
+    }
+    inFlightStats.inFlight--;
+}
+
+void reject(uint8_t channel)
+{
+    stats[queueIndex(channel)].rejected++;
+}
+
+size_t queued()
+{
+    return total;
+}
+
+const Stats& getStats()
+{
+    return stats;
+}
+
+const InFlightStats& getInFlightStats()
+{
+    return inFlightStats;
+}
+
+} // namespace scheduler
+} // namespace ipmi
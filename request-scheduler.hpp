@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <sdbusplus/message.hpp>
+#include <user_channel/channel_layer.hpp>
+
+namespace ipmi
+{
+namespace scheduler
+{
+
+/* requests from senders that don't map to a channel are counted here */
+constexpr size_t unknownChannel = maxIpmiChannels;
+
+/* a caller that can't be told apart from the others; its requests count
+ * towards IPMI_IN_FLIGHT_LIMIT only */
+constexpr uint64_t unknownSender = 0;
+
+/** @struct ChannelStats
+ *  @brief Queue counters of one channel
+ */
+struct ChannelStats
+{
+    size_t queued = 0;
+    size_t peak = 0;
+    uint64_t delayed = 0;
+    uint64_t rejected = 0;
+};
+
+using Stats = std::array<ChannelStats, maxIpmiChannels + 1>;
+
+/** @struct Pending
+ *  @brief A queued request and when it arrived
+ *
+ *  Either an execute call, which is started in a coroutine of its own, or
+ *  a request of the local socket, whose coroutine waits in the queue and is
+ *  resumed.
+ */
+struct Pending
+{
+    std::optional<sdbusplus::message::message> call;
+    std::function<void()> resume;
+    // the deadline of the request counts from here, not from when it starts
+    std::chrono::steady_clock::time_point received;
+};
+
+/** @struct InFlightStats
+ *  @brief Counters of the requests that are running or queued
+ */
+struct InFlightStats
+{
+    size_t inFlight = 0;
+    size_t peak = 0;
+    size_t queuedPeak = 0;
+    // most requests a single sender had in flight at once
+    size_t senderPeak = 0;
+    // refused for the global limit and for the per sender limit
+    uint64_t rejected = 0;
+    uint64_t senderRejected = 0;
+};
+
+/** @brief Count a new request as in flight until leave() is called
+ *
+ *  Requests from other channels are refused once IPMI_IN_FLIGHT_LIMIT
+ *  requests are running or queued; those from the system interface
+ *  channels only have to fit in the queue of their channel. Any single
+ *  sender is also refused once it has IPMI_SENDER_IN_FLIGHT_LIMIT requests
+ *  in flight, so that one misbehaving client can't take all of them. The
+ *  callers whose name doesn't parse are all unknownSender, so they are
+ *  not limited as if they were a single one.
+ *
+ *  @param[in] sender - interned unique name of the caller, or
+ *                      unknownSender
+ *  @param[in] priority - true for a system interface channel
+ *
+ *  @return false if the request must be refused with Node Busy
+ */
+bool enter(uint64_t sender, bool priority);
+
+/** @brief Count a request that enter() accepted as done
+ *
+ *  @param[in] sender - interned unique name of the caller
+ */
+void leave(uint64_t sender);
+
+/** @brief Check if a new request may start a coroutine right away
+ *
+ *  The system interface channels may use every coroutine. The other
+ *  channels leave IPMI_SCHEDULER_RESERVED of them free, so that requests
+ *  from the host get a coroutine no matter what the out-of-band load is.
+ *  A channel that has requests queued must queue the new one behind them.
+ *
+ *  @param[in] channel - channel the request came in on
+ *  @param[in] priority - true for a system interface channel
+ *  @param[in] inUse - number of coroutines running requests
+ *
+ *  @return true if the request may start
+ */
+bool admit(uint8_t channel, bool priority, size_t inUse);
+
+/** @brief Queue a request until a coroutine frees up
+ *
+ *  @param[in] channel - channel the request came in on
+ *  @param[in] priority - true for a system interface channel
+ *  @param[in] m - the execute call; only moved from if it was queued
+ *  @param[in] received - when the call arrived
+ *
+ *  @return false if the queue of the channel is full; the caller must
+ *          reply with Node Busy
+ */
+bool push(uint8_t channel, bool priority, sdbusplus::message::message&& m,
+          std::chrono::steady_clock::time_point received);
+
+/** @brief Queue a request of the local socket until a coroutine frees up
+ *
+ *  The same as the execute call variant, except that resume is called, and
+ *  the requests counted in the coroutine usage, when the request may start.
+ *
+ *  @param[in] channel - channel the request came in on
+ *  @param[in] priority - true for a system interface channel
+ *  @param[in] resume - resumes the coroutine of the request
+ *  @param[in] received - when the request arrived
+ *
+ *  @return false if the queue of the channel is full
+ */
+bool push(uint8_t channel, bool priority, std::function<void()>&& resume,
+          std::chrono::steady_clock::time_point received);
+
+/** @brief Take the next queued request to start
+ *
+ *  The channels share the freed coroutines by weight: every system
+ *  interface channel counts IPMI_SCHEDULER_SYSTEM_WEIGHT times as much as
+ *  any other channel. The requests of a channel start in order.
+ *
+ *  @param[in] inUse - number of coroutines running requests
+ *
+ *  @return the request or std::nullopt if none may start
+ */
+std::optional<Pending> pop(size_t inUse);
+
+/** @brief Count a request refused with Node Busy */
+void reject(uint8_t channel);
+
+/** @brief Number of requests queued across all of the channels */
+size_t queued();
+
+/** @brief Queue counters of every channel; the last entry is for requests
+ *         that don't map to a channel
+ */
+const Stats& getStats();
+
+/** @brief Counters of the requests in flight */
+const InFlightStats& getInFlightStats();
+
+} // namespace scheduler
+} // namespace ipmi
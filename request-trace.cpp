@@ -0,0 +1,113 @@
+#include "request-trace.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <phosphor-logging/log.hpp>
+
+namespace ipmi
+{
+namespace trace
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+FILE* file = nullptr;
+std::string filePath;
+uint64_t written = 0;
+Clock::time_point previous;
+
+/* reused for every record so that tracing doesn't allocate per request */
+std::vector<uint8_t> buffer;
+
+} // namespace
+
+bool start(const std::string& path)
+{
+    stop();
+    file = std::fopen(path.c_str(), "we");
+    if (!file)
+    {
+        log<level::ERR>("Failed to create IPMI trace",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+        return false;
+    }
+    if (std::fwrite(magic, sizeof(magic), 1, file) != 1)
+    {
+        log<level::ERR>("Failed to write IPMI trace",
+                        entry("PATH=%s", path.c_str()));
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    filePath = path;
+    written = 0;
+    previous = Clock::time_point{};
+    log<level::INFO>("Recording IPMI trace", entry("PATH=%s", path.c_str()));
+    return true;
+}
+
+uint64_t stop()
+{
+    if (!file)
+    {
+        return 0;
+    }
+    if (std::fclose(file) != 0)
+    {
+        log<level::ERR>("Failed to write IPMI trace",
+                        entry("PATH=%s", filePath.c_str()),
+                        entry("ERROR=%s", std::strerror(errno)));
+    }
+    file = nullptr;
+    log<level::INFO>("Finished IPMI trace", entry("PATH=%s", filePath.c_str()),
+                     entry("RECORDS=%llu",
+                           static_cast<unsigned long long>(written)));
+    return written;
+}
+
+bool active()
+{
+    return file != nullptr;
+}
+
+void record(Clock::time_point received, Record& record)
+{
+    if (!file)
+    {
+        return;
+    }
+    if (previous != Clock::time_point{})
+    {
+        auto delay = std::chrono::duration_cast<std::chrono::microseconds>(
+                         received - previous)
+                         .count();
+        // requests finish out of order, so one may have arrived earlier
+        record.delay = static_cast<uint32_t>(
+            std::clamp<decltype(delay)>(delay, 0, UINT32_MAX));
+    }
+    if (received > previous)
+    {
+        previous = received;
+    }
+
+    buffer.clear();
+    encode(buffer, record);
+    if (std::fwrite(buffer.data(), buffer.size(), 1, file) != 1)
+    {
+        log<level::ERR>("Failed to write IPMI trace",
+                        entry("PATH=%s", filePath.c_str()));
+        stop();
+        return;
+    }
+    if (++written >= IPMI_TRACE_RECORD_LIMIT)
+    {
+        stop();
+    }
+}
+
+} // namespace trace
+} // namespace ipmi
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ipmid/types.hpp>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace ipmi
+{
+namespace trace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/** @brief First bytes of a trace file
+ *
+ *  A trace is this magic followed by the records, back to back. The
+ *  numbers are in the byte order of the BMC that recorded the trace; it is
+ *  meant to be replayed on the same kind of machine.
+ */
+constexpr char magic[8] = {'I', 'P', 'M', 'I', 'T', 'R', 'C', '1'};
+
+/** @struct Record
+ *  @brief One request as ipmid received it, and how it was answered
+ *
+ *  On disk a record is
+ *      uint32_t delay, uint32_t latency,
+ *      uint8_t netFn, lun, cmd, channel, cc,
+ *      uint16_t size, data[size],
+ *      uint8_t count, count * { uint8_t length, name[length],
+ *                               uint8_t type, value }
+ *  where type is the index of the value in ipmi::Value and a string value
+ *  is a uint16_t length followed by the characters.
+ */
+struct Record
+{
+    // microseconds since the previous request of the trace
+    uint32_t delay = 0;
+    // microseconds from receiving the request to answering it
+    uint32_t latency = 0;
+    uint8_t netFn = 0;
+    uint8_t lun = 0;
+    uint8_t cmd = 0;
+    // channel the request came in on, for reference; a replay uses its own
+    uint8_t channel = 0;
+    uint8_t cc = 0;
+    std::vector<uint8_t> data;
+    std::map<std::string, Value> options;
+};
+
+namespace detail
+{
+
+template <typename T>
+inline void put(std::vector<uint8_t>& out, const T& value)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T>
+inline bool get(FILE* in, T& value)
+{
+    return std::fread(&value, sizeof(value), 1, in) == 1;
+}
+
+template <size_t index = 0>
+inline bool getValue(FILE* in, uint8_t type, Value& value)
+{
+    if constexpr (index < std::variant_size_v<Value>)
+    {
+        if (type != index)
+        {
+            return getValue<index + 1>(in, type, value);
+        }
+        using T = std::variant_alternative_t<index, Value>;
+        if constexpr (std::is_same_v<T, std::string>)
+        {
+            uint16_t length;
+            if (!get(in, length))
+            {
+                return false;
+            }
+            std::string s(length, '\0');
+            if (length && std::fread(s.data(), length, 1, in) != 1)
+            {
+                return false;
+            }
+            value = std::move(s);
+        }
+        else
+        {
+            T v;
+            if (!get(in, v))
+            {
+                return false;
+            }
+            value = v;
+        }
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+} // namespace detail
+
+/** @brief Append one record in the trace format
+ *
+ *  Request data and option strings longer than the format allows are
+ *  truncated; IPMI requests are far shorter than that.
+ *
+ *  @param[out] out - buffer to append to
+ *  @param[in] record - the record to encode
+ */
+inline void encode(std::vector<uint8_t>& out, const Record& record)
+{
+    using detail::put;
+    put(out, record.delay);
+    put(out, record.latency);
+    put(out, record.netFn);
+    put(out, record.lun);
+    put(out, record.cmd);
+    put(out, record.channel);
+    put(out, record.cc);
+    uint16_t size = static_cast<uint16_t>(
+        std::min<size_t>(record.data.size(), UINT16_MAX));
+    put(out, size);
+    out.insert(out.end(), record.data.begin(), record.data.begin() + size);
+
+    uint8_t count =
+        static_cast<uint8_t>(std::min<size_t>(record.options.size(), 255));
+    put(out, count);
+    for (const auto& [name, value] : record.options)
+    {
+        if (!count--)
+        {
+            break;
+        }
+        uint8_t length =
+            static_cast<uint8_t>(std::min<size_t>(name.size(), 255));
+        put(out, length);
+        out.insert(out.end(), name.begin(), name.begin() + length);
+        put(out, static_cast<uint8_t>(value.index()));
+        std::visit(
+            [&out](const auto& v) {
+                using T = std::decay_t<decltype(v)>;
+                if constexpr (std::is_same_v<T, std::string>)
+                {
+                    uint16_t length = static_cast<uint16_t>(
+                        std::min<size_t>(v.size(), UINT16_MAX));
+                    put(out, length);
+                    out.insert(out.end(), v.begin(), v.begin() + length);
+                }
+                else
+                {
+                    put(out, v);
+                }
+            },
+            value);
+    }
+}
+
+/** @brief Read the next record of a trace
+ *
+ *  @param[in] in - trace file, positioned after the magic
+ *  @param[out] record - the record read
+ *
+ *  @return false at the end of the trace or if the record is malformed
+ */
+inline bool read(FILE* in, Record& record)
+{
+    using detail::get;
+    uint16_t size;
+    if (!get(in, record.delay) || !get(in, record.latency) ||
+        !get(in, record.netFn) || !get(in, record.lun) ||
+        !get(in, record.cmd) || !get(in, record.channel) ||
+        !get(in, record.cc) || !get(in, size))
+    {
+        return false;
+    }
+    record.data.resize(size);
+    if (size && std::fread(record.data.data(), size, 1, in) != 1)
+    {
+        return false;
+    }
+
+    uint8_t count;
+    if (!get(in, count))
+    {
+        return false;
+    }
+    record.options.clear();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t length;
+        uint8_t type;
+        std::string name;
+        if (!get(in, length))
+        {
+            return false;
+        }
+        name.resize(length);
+        if (length && std::fread(name.data(), length, 1, in) != 1)
+        {
+            return false;
+        }
+        if (!get(in, type) ||
+            !detail::getValue(in, type, record.options[name]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Check the magic at the start of a trace file */
+inline bool readHeader(FILE* in)
+{
+    char header[sizeof(magic)];
+    return std::fread(header, sizeof(header), 1, in) == 1 &&
+           std::memcmp(header, magic, sizeof(magic)) == 0;
+}
+
+/** @brief Start recording the requests to a trace file
+ *
+ *  A trace already being recorded is finished first. Recording stops by
+ *  itself after IPMI_TRACE_RECORD_LIMIT records.
+ *
+ *  @param[in] path - file to write, replaced if it exists
+ *
+ *  @return false if the file could not be created
+ */
+bool start(const std::string& path);
+
+/** @brief Finish the trace being recorded
+ *
+ *  @return number of records written
+ */
+uint64_t stop();
+
+/** @brief true while a trace is being recorded */
+bool active();
+
+/** @brief Append a request to the trace being recorded
+ *
+ *  @param[in] received - when ipmid received the request
+ *  @param[in] record - the request; its delay is filled in here
+ */
+void record(Clock::time_point received, Record& record);
+
+} // namespace trace
+} // namespace ipmi
@@ -0,0 +1,185 @@
+#include "response-cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
+#include <memory>
+#include <phosphor-logging/log.hpp>
+#include <sdbusplus/bus/match.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ipmi
+{
+
+using namespace phosphor::logging;
+
+namespace cache
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* responses kept per command; enough for the handful of request variants
+ * a host polls with */
+constexpr size_t maxEntries = 8;
+
+struct Entry
+{
+    int channel;
+    // the handlers are per host, so are their responses
+    size_t hostIdx;
+    std::vector<uint8_t> request;
+    Cc cc;
+    std::vector<uint8_t> response;
+    Clock::time_point expires;
+};
+
+struct Policy
+{
+    Clock::duration ttl;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> matches;
+    std::vector<Entry> entries;
+};
+
+/* map of cache policies; key is NetFn/Cmd */
+std::unordered_map<uint16_t, Policy> policies;
+
+uint64_t evictions = 0;
+
+cache_stats::Usage usage()
+{
+    using cache_stats::heapBytes;
+
+    cache_stats::Usage usage;
+    usage.limit = policies.size() * maxEntries;
+    usage.evictions = evictions;
+    for (const auto& [key, policy] : policies)
+    {
+        usage.bytes += sizeof(key) + sizeof(policy) + 32 +
+                       policy.entries.capacity() * sizeof(Entry) +
+                       policy.matches.size() *
+                           sizeof(sdbusplus::bus::match::match);
+        for (const Entry& entry : policy.entries)
+        {
+            usage.bytes += entry.request.capacity() + entry.response.capacity();
+        }
+        usage.entries += policy.entries.size();
+    }
+    return usage;
+}
+
+inline uint16_t makeCacheKey(NetFn netFn, Cmd cmd)
+{
+    return (static_cast<uint16_t>(netFn) << 8) | cmd;
+}
+
+Policy* findPolicy(const message::Request::ptr& request)
+{
+    auto iter =
+        policies.find(makeCacheKey(request->ctx->netFn, request->ctx->cmd));
+    if (iter == policies.end())
+    {
+        return nullptr;
+    }
+    return &iter->second;
+}
+
+} // namespace
+
+message::Response::ptr lookup(const message::Request::ptr& request)
+{
+    Policy* policy = findPolicy(request);
+    if (!policy)
+    {
+        return nullptr;
+    }
+    Clock::time_point now = Clock::now();
+    auto iter = std::find_if(
+        policy->entries.begin(), policy->entries.end(), [&](const Entry& e) {
+            return e.channel == request->ctx->channel &&
+                   e.hostIdx == request->ctx->hostIdx &&
+                   e.request == request->payload.raw;
+        });
+    if (iter == policy->entries.end())
+    {
+        return nullptr;
+    }
+    if (policy->ttl.count() && now >= iter->expires)
+    {
+        policy->entries.erase(iter);
+        return nullptr;
+    }
+    message::Response::ptr response = request->makeResponse();
+    response->cc = iter->cc;
+    response->payload.raw.assign(iter->response.begin(), iter->response.end());
+    return response;
+}
+
+void store(const message::Request::ptr& request,
+           const message::Response::ptr& response)
+{
+    if (!response || response->cc != ccSuccess)
+    {
+        return;
+    }
+    Policy* policy = findPolicy(request);
+    if (!policy)
+    {
+        return;
+    }
+    if (policy->entries.size() >= maxEntries)
+    {
+        policy->entries.erase(policy->entries.begin());
+        evictions++;
+    }
+    policy->entries.push_back(Entry{
+        request->ctx->channel, request->ctx->hostIdx, request->payload.raw,
+        response->cc, response->payload.raw, Clock::now() + policy->ttl});
+}
+
+void clear()
+{
+    policies.clear();
+}
+
+} // namespace cache
+
+void registerResponseCache(NetFn netFn, Cmd cmd, std::chrono::milliseconds ttl,
+                           const std::vector<std::string>& matches)
+{
+    if (cache::policies.empty())
+    {
+        cache_stats::registerCache("responses", cache::usage);
+    }
+    cache::Policy& policy = cache::policies[cache::makeCacheKey(netFn, cmd)];
+    policy.ttl = ttl;
+    policy.entries.clear();
+    policy.matches.clear();
+
+    if (matches.empty())
+    {
+        return;
+    }
+    std::shared_ptr<sdbusplus::asio::connection> bus = getSdBus();
+    if (!bus)
+    {
+        log<level::ERR>("No D-Bus connection for response cache invalidation",
+                        entry("NETFN=0x%X", netFn), entry("CMD=0x%X", cmd));
+        return;
+    }
+    std::vector<cache::Entry>* entries = &policy.entries;
+    for (const std::string& rule : matches)
+    {
+        policy.matches.emplace_back(
+            std::make_unique<sdbusplus::bus::match::match>(
+                *bus, rule,
+                [entries](sdbusplus::message::message&) { entries->clear(); }));
+    }
+}
+
+} // namespace ipmi
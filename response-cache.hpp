@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ipmid/message.hpp>
+
+namespace ipmi
+{
+namespace cache
+{
+
+/** @brief Look for a cached response to a request
+ *
+ *  @param[in] request - the request about to be handed to its handler
+ *
+ *  @return a copy of the cached response or nullptr if there is none
+ */
+message::Response::ptr lookup(const message::Request::ptr& request);
+
+/** @brief Keep the response to a request if its command is cached
+ *
+ *  Only successful responses are kept.
+ *
+ *  @param[in] request - the request that was handled
+ *  @param[in] response - the response from the handler
+ */
+void store(const message::Request::ptr& request,
+           const message::Response::ptr& response);
+
+/** @brief Drop every cache policy along with its D-Bus matches */
+void clear();
+
+} // namespace cache
+} // namespace ipmi
@@ -6,9 +6,15 @@
 #include <ipmid/types.hpp>
 using namespace ipmi::sensor;
 
-extern const InvObjectIDMap invSensors = {
-% for key in sensorDict.iterkeys():
-   % if key:
+<%
+    paths = sorted(key for key in sensorDict.keys() if key)
+%>
+// The table is constant-initialized, in path order for the lookups.
+namespace
+{
+% if paths:
+constexpr InvObjectIDMap::value_type invSensorEntries[] = {
+% for key in paths:
 {"${key}",
     {
 <%
@@ -21,7 +27,13 @@ extern const InvObjectIDMap invSensors = {
         ${sensorID},${sensorType},${eventReadingType},${offset}
     }
 },
-   % endif
 % endfor
 };
+% endif
+} // namespace
 
+% if paths:
+extern const InvObjectIDMap invSensors = invSensorEntries;
+% else:
+extern const InvObjectIDMap invSensors{};
+% endif
@@ -1,42 +1,73 @@
 // !!! WARNING: This is a GENERATED Code..Please do NOT Edit !!!
-#include <iostream>
 #include "fruread.hpp"
 
-extern const FruMap frus = {
-% for key in fruDict.keys():
-   {${key},{
+// The tables are constant-initialized; the FRUs are in ID order for the
+// lookups and each level points into the arrays above it.
+namespace
+{
+% for key in sorted(fruDict.keys()):
 <%
     instanceList = fruDict[key]
-%>
-    % for instancePath,instanceInfo in instanceList.items():
+%>\
+    % for i, (instancePath, instanceInfo) in enumerate(instanceList.items()):
 <%
-        entityID = instanceInfo["entityID"]
-        entityInstance = instanceInfo["entityInstance"]
         interfaces = instanceInfo["interfaces"]
-%>
-         {${entityID}, ${entityInstance}, "${instancePath}",{
-         % for interface,properties in interfaces.items():
-             {"${interface}",{
+%>\
+        % for j, (interface, properties) in enumerate(interfaces.items()):
             % if properties:
+constexpr std::pair<DbusProperty, IPMIFruData> fru${key}_${i}_${j}[] = {
                 % for dbus_property,property_value in properties.items():
-                    {"${dbus_property}",{
-                        "${property_value.get("IPMIFruSection", "")}",
-                        "${property_value.get("IPMIFruProperty", "")}",\
 <%
     delimiter = property_value.get("IPMIFruValueDelimiter")
     if not delimiter:
         delimiter = ""
     else:
         delimiter = '\\' + hex(delimiter)[1:]
-%>
-                     "${delimiter}"
-                 }},
+%>\
+    {"${dbus_property}",
+     {"${property_value.get("IPMIFruSection", "")}",
+      "${property_value.get("IPMIFruProperty", "")}", "${delimiter}"}},
                 % endfor
-            %endif
-             }},
-         % endfor
-        }},
+};
+            % endif
+        % endfor
+        % if interfaces:
+
+constexpr std::pair<DbusInterface, DbusPropertyVec> fru${key}_${i}[] = {
+            % for j, (interface, properties) in enumerate(interfaces.items()):
+                % if properties:
+    {"${interface}", fru${key}_${i}_${j}},
+                % else:
+    {"${interface}", {}},
+                % endif
+            % endfor
+};
+        % endif
+    % endfor
+
+constexpr FruInstance fru${key}[] = {
+    % for i, (instancePath, instanceInfo) in enumerate(instanceList.items()):
+    {${instanceInfo["entityID"]}, ${instanceInfo["entityInstance"]}, "${instancePath}",
+        % if instanceInfo["interfaces"]:
+     fru${key}_${i}},
+        % else:
+     {}},
+        % endif
     % endfor
-   }},
+};
+
 % endfor
+% if fruDict:
+constexpr FruMap::value_type fruEntries[] = {
+    % for key in sorted(fruDict.keys()):
+    {${key}, fru${key}},
+    % endfor
 };
+% endif
+} // namespace
+
+% if fruDict:
+extern const FruMap frus = fruEntries;
+% else:
+extern const FruMap frus{};
+% endif
@@ -5,8 +5,12 @@
 #include <ipmid/types.hpp>
 using namespace ipmi::sensor;
 
-extern const EntityInfoMap entities = {
-% for key in entityDict.iterkeys():
+// The table is constant-initialized, in ID order for the lookups.
+namespace
+{
+% if entityDict:
+constexpr EntityInfoMap::value_type entityEntries[] = {
+% for key in sorted(entityDict.keys()):
 {${key},{
 <%
        entity = entityDict[key]
@@ -23,12 +27,20 @@ extern const EntityInfoMap entities = {
        entityId4 = entity["entityId4"]
        entityInstance4 = entity["entityInstance4"]
 %>
-        ${containerEntityId},${containerEntityInstance},${isList},${isLinked},{
-          std::make_pair(${entityId1}, ${entityInstance1}),
-          std::make_pair(${entityId2}, ${entityInstance2}),
-          std::make_pair(${entityId3}, ${entityInstance3}),
-          std::make_pair(${entityId4}, ${entityInstance4}) }
+        ${containerEntityId},${containerEntityInstance},${isList},${isLinked},{{
+          {${entityId1}, ${entityInstance1}},
+          {${entityId2}, ${entityInstance2}},
+          {${entityId3}, ${entityInstance3}},
+          {${entityId4}, ${entityInstance4}} }}
 
 }},
 % endfor
 };
+% endif
+} // namespace
+
+% if entityDict:
+extern const EntityInfoMap entities = entityEntries;
+% else:
+extern const EntityInfoMap entities{};
+% endif
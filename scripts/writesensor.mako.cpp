@@ -30,7 +30,7 @@ interfaceDict = {}
 using namespace ipmi::sensor;
 
 extern const IdInfoMap sensors = {
-% for key in sensorDict.iterkeys():
+% for key in sorted(sensorDict.iterkeys()):
    % if key:
 {${key},{
 <%
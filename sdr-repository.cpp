@@ -0,0 +1,438 @@
+#include "sdr-repository.hpp"
+
+#include "fruread.hpp"
+#include "sensorhandler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <ipmid/types.hpp>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <phosphor-logging/log.hpp>
+#include <set>
+#include <string>
+#include <xyz/openbmc_project/Sensor/Value/server.hpp>
+
+extern const ipmi::sensor::IdInfoMap sensors;
+extern const FruMap frus;
+extern const ipmi::sensor::EntityInfoMap entities;
+
+namespace ipmi
+{
+namespace sdr
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+constexpr uint8_t fruInventoryDevice = 0x10;
+constexpr uint8_t IPMIFruInventory = 0x02;
+constexpr uint8_t BMCSlaveAddress = 0x20;
+
+/* record IDs go up to the last entity association record */
+constexpr size_t maxRecordId = ENTITY_RECORD_ID_START + 0xFF;
+
+/* remembers the image last seen, so a restart without any change to the
+ * records keeps the timestamps the hosts have cached against */
+constexpr auto changesFile = "/var/lib/ipmi/sdr_changes.json";
+
+const std::set<std::string> analogSensorInterfaces = {
+    "xyz.openbmc_project.Sensor.Value",
+    "xyz.openbmc_project.Control.FanPwm",
+};
+
+bool isAnalogSensor(const std::string& interface)
+{
+    return (analogSensorInterfaces.count(interface));
+}
+
+void setUnitFieldsForObject(const ipmi::sensor::Info* info,
+                            get_sdr::SensorDataFullRecordBody* body)
+{
+    namespace server = sdbusplus::xyz::openbmc_project::Sensor::server;
+    try
+    {
+        auto unit = server::Value::convertUnitFromString(info->unit);
+        // Unit strings defined in
+        // phosphor-dbus-interfaces/xyz/openbmc_project/Sensor/Value.interface.yaml
+        switch (unit)
+        {
+            case server::Value::Unit::DegreesC:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_DEGREES_C;
+                break;
+            case server::Value::Unit::RPMS:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_RPM;
+                break;
+            case server::Value::Unit::Volts:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_VOLTS;
+                break;
+            case server::Value::Unit::Meters:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_METERS;
+                break;
+            case server::Value::Unit::Amperes:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_AMPERES;
+                break;
+            case server::Value::Unit::Joules:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_JOULES;
+                break;
+            case server::Value::Unit::Watts:
+                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_WATTS;
+                break;
+            default:
+                // Cannot be hit.
+                std::fprintf(stderr, "Unknown value unit type: = %s\n",
+                             info->unit.c_str());
+        }
+    }
+    catch (const sdbusplus::exception::InvalidEnumString& e)
+    {
+        log<level::WARNING>("Warning: no unit provided for sensor!");
+    }
+}
+
+void populateRecordBody(get_sdr::SensorDataFullRecordBody* body,
+                        const ipmi::sensor::Info* info)
+{
+    /* Functional sensor case */
+    if (isAnalogSensor(info->propertyInterfaces.begin()->first))
+    {
+
+        body->sensor_units_1 = 0; // unsigned, no rate, no modifier, not a %
+
+        /* Unit info */
+        setUnitFieldsForObject(info, body);
+
+        get_sdr::body::set_b(info->coefficientB, body);
+        get_sdr::body::set_m(info->coefficientM, body);
+        get_sdr::body::set_b_exp(info->exponentB, body);
+        get_sdr::body::set_r_exp(info->exponentR, body);
+
+        get_sdr::body::set_id_type(0b00, body); // 00 = unicode
+    }
+
+    /* ID string */
+    auto id_string = info->sensorNameFunc(*info);
+
+    if (id_string.length() > FULL_RECORD_ID_STR_MAX_LENGTH)
+    {
+        get_sdr::body::set_id_strlen(FULL_RECORD_ID_STR_MAX_LENGTH, body);
+    }
+    else
+    {
+        get_sdr::body::set_id_strlen(id_string.length(), body);
+    }
+    strncpy(body->id_string, id_string.c_str(),
+            get_sdr::body::get_id_strlen(body));
+}
+
+get_sdr::SensorDataFullRecord
+    fullRecord(const ipmi::sensor::IdInfoMap::value_type& sensor)
+{
+    get_sdr::SensorDataFullRecord record{};
+    uint8_t sensor_id = sensor.first;
+
+    /* Header */
+    get_sdr::header::set_record_id(sensor_id, &(record.header));
+    record.header.sdr_version = 0x51; // Based on IPMI Spec v2.0 rev 1.1
+    record.header.record_type = get_sdr::SENSOR_DATA_FULL_RECORD;
+    record.header.record_length = sizeof(get_sdr::SensorDataFullRecord);
+
+    /* Key */
+    get_sdr::key::set_owner_id_bmc(&(record.key));
+    record.key.sensor_number = sensor_id;
+
+    /* Body */
+    record.body.entity_id = sensor.second.entityType;
+    record.body.sensor_type = sensor.second.sensorType;
+    record.body.event_reading_type = sensor.second.sensorReadingType;
+    record.body.entity_instance = sensor.second.instance;
+    if (ipmi::sensor::Mutability::Write ==
+        (sensor.second.mutability & ipmi::sensor::Mutability::Write))
+    {
+        get_sdr::body::init_settable_state(true, &(record.body));
+    }
+
+    // Set the type-specific details given the DBus interface
+    populateRecordBody(&(record.body), &(sensor.second));
+    return record;
+}
+
+get_sdr::SensorDataFruRecord fruRecord(const FruMap::value_type& fru)
+{
+    get_sdr::SensorDataFruRecord record{};
+    uint8_t fruID = fru.first;
+
+    /* Header */
+    get_sdr::header::set_record_id(FRU_RECORD_ID_START + fruID,
+                                   &(record.header));
+    record.header.sdr_version = SDR_VERSION; // Based on IPMI Spec v2.0 rev 1.1
+    record.header.record_type = get_sdr::SENSOR_DATA_FRU_RECORD;
+    record.header.record_length = sizeof(record.key) + sizeof(record.body);
+
+    /* Key */
+    record.key.fruID = fruID;
+    record.key.accessLun |= IPMI_LOGICAL_FRU;
+    record.key.deviceAddress = BMCSlaveAddress;
+
+    /* Body */
+    record.body.entityID = fru.second[0].entityID;
+    record.body.entityInstance = fru.second[0].entityInstance;
+    record.body.deviceType = fruInventoryDevice;
+    record.body.deviceTypeModifier = IPMIFruInventory;
+
+    /* Device ID string */
+    auto deviceID =
+        fru.second[0].path.substr(fru.second[0].path.find_last_of('/') + 1,
+                                  fru.second[0].path.length());
+
+    if (deviceID.length() > get_sdr::FRU_RECORD_DEVICE_ID_MAX_LENGTH)
+    {
+        get_sdr::body::set_device_id_strlen(
+            get_sdr::FRU_RECORD_DEVICE_ID_MAX_LENGTH, &(record.body));
+    }
+    else
+    {
+        get_sdr::body::set_device_id_strlen(deviceID.length(), &(record.body));
+    }
+
+    std::memcpy(record.body.deviceID, deviceID.data(),
+                get_sdr::body::get_device_id_strlen(&(record.body)));
+    return record;
+}
+
+get_sdr::SensorDataEntityRecord
+    entityRecord(const ipmi::sensor::EntityInfoMap::value_type& entity)
+{
+    get_sdr::SensorDataEntityRecord record{};
+
+    /* Header */
+    get_sdr::header::set_record_id(ENTITY_RECORD_ID_START + entity.first,
+                                   &(record.header));
+    record.header.sdr_version = SDR_VERSION; // Based on IPMI Spec v2.0 rev 1.1
+    record.header.record_type = get_sdr::SENSOR_DATA_ENTITY_RECORD;
+    record.header.record_length = sizeof(record.key) + sizeof(record.body);
+
+    /* Key */
+    record.key.containerEntityId = entity.second.containerEntityId;
+    record.key.containerEntityInstance = entity.second.containerEntityInstance;
+    get_sdr::key::set_flags(entity.second.isList, entity.second.isLinked,
+                            &(record.key));
+    record.key.entityId1 = entity.second.containedEntities[0].first;
+    record.key.entityInstance1 = entity.second.containedEntities[0].second;
+
+    /* Body */
+    record.body.entityId2 = entity.second.containedEntities[1].first;
+    record.body.entityInstance2 = entity.second.containedEntities[1].second;
+    record.body.entityId3 = entity.second.containedEntities[2].first;
+    record.body.entityInstance3 = entity.second.containedEntities[2].second;
+    record.body.entityId4 = entity.second.containedEntities[3].first;
+    record.body.entityInstance4 = entity.second.containedEntities[3].second;
+    return record;
+}
+
+/* FNV-1a; only used to tell one image from another */
+uint32_t imageHash(const std::vector<uint8_t>& image)
+{
+    uint32_t hash = 2166136261u;
+    for (uint8_t byte : image)
+    {
+        hash = (hash ^ byte) * 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
+Repository& Repository::instance()
+{
+    static Repository repository;
+    return repository;
+}
+
+const Record* Repository::find(uint16_t recordId)
+{
+    if (!built)
+    {
+        build();
+    }
+    if (recordId == 0)
+    {
+        recordId = first;
+    }
+    if (recordId >= index.size() || !index[recordId].size)
+    {
+        return nullptr;
+    }
+    return &index[recordId];
+}
+
+void Repository::build()
+{
+    image.clear();
+    index.assign(maxRecordId + 1, Record{});
+
+    auto add = [this](uint16_t recordId, const auto& record, uint16_t next) {
+        if (recordId >= index.size())
+        {
+            return;
+        }
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+        index[recordId] = Record{image.size(), sizeof(record), next};
+        image.insert(image.end(), bytes, bytes + sizeof(record));
+    };
+
+    image.reserve(sensors.size() * sizeof(get_sdr::SensorDataFullRecord) +
+                  frus.size() * sizeof(get_sdr::SensorDataFruRecord) +
+                  entities.size() * sizeof(get_sdr::SensorDataEntityRecord));
+
+    // the records are chained sensors first, then the FRUs, then the
+    // entity associations, with each group ending the chain when the
+    // group after it is empty
+    for (auto sensor = sensors.begin(); sensor != sensors.end(); ++sensor)
+    {
+        auto next = std::next(sensor);
+        uint16_t nextId = next != sensors.end()
+                              ? next->first
+                              : (frus.size() ? frus.begin()->first +
+                                                   FRU_RECORD_ID_START
+                                             : END_OF_RECORD);
+        add(sensor->first, fullRecord(*sensor), nextId);
+    }
+    for (auto fru = frus.begin(); fru != frus.end(); ++fru)
+    {
+        auto next = std::next(fru);
+        uint16_t nextId =
+            next != frus.end()
+                ? FRU_RECORD_ID_START + next->first
+                : (entities.size()
+                       ? entities.begin()->first + ENTITY_RECORD_ID_START
+                       : END_OF_RECORD);
+        add(FRU_RECORD_ID_START + fru->first, fruRecord(*fru), nextId);
+    }
+    for (auto entity = entities.begin(); entity != entities.end(); ++entity)
+    {
+        auto next = std::next(entity);
+        uint16_t nextId = next != entities.end()
+                              ? ENTITY_RECORD_ID_START + next->first
+                              : END_OF_RECORD;
+        add(ENTITY_RECORD_ID_START + entity->first, entityRecord(*entity),
+            nextId);
+    }
+
+    first = sensors.empty() ? END_OF_RECORD : sensors.begin()->first;
+    built = true;
+    track();
+}
+
+void Repository::track()
+{
+    using Json = nlohmann::json;
+
+    uint32_t hash = imageHash(image);
+    size_t records = std::count_if(index.begin(), index.end(),
+                                   [](const Record& r) { return r.size; });
+
+    Json last = nullptr;
+    std::ifstream in(changesFile);
+    if (in.good())
+    {
+        last = Json::parse(in, nullptr, false);
+    }
+    if (last.is_object())
+    {
+        changed.generation = last.value("generation", 0u);
+        changed.additionTimestamp = last.value("additionTimestamp", 0u);
+        changed.eraseTimestamp = last.value("eraseTimestamp", 0u);
+        if (last.value("hash", 0u) == hash &&
+            last.value("records", size_t{0}) == records)
+        {
+            return;
+        }
+    }
+
+    uint32_t now = std::time(nullptr);
+    changed.generation++;
+    changed.additionTimestamp = now;
+    if (last.is_object() && last.value("records", size_t{0}) > records)
+    {
+        changed.eraseTimestamp = now;
+    }
+
+    Json current = {{"hash", hash},
+                    {"records", records},
+                    {"generation", changed.generation},
+                    {"additionTimestamp", changed.additionTimestamp},
+                    {"eraseTimestamp", changed.eraseTimestamp}};
+    std::ofstream out(changesFile);
+    if (!out.good())
+    {
+        log<level::ERR>("Failed to save the SDR change tracking",
+                        entry("FILE=%s", changesFile));
+        return;
+    }
+    out << current;
+}
+
+const Changes& Repository::changes()
+{
+    if (!built)
+    {
+        build();
+    }
+    return changed;
+}
+
+void Repository::rebuild(uint16_t recordId)
+{
+    if (!built)
+    {
+        // the next lookup builds everything anyway
+        return;
+    }
+    if (recordId >= index.size() || !index[recordId].size)
+    {
+        return;
+    }
+
+    auto store = [this, recordId](const auto& record) {
+        uint8_t* bytes = image.data() + index[recordId].offset;
+        if (std::memcmp(bytes, &record, sizeof(record)))
+        {
+            std::memcpy(bytes, &record, sizeof(record));
+            track();
+        }
+    };
+
+    if (recordId >= ENTITY_RECORD_ID_START)
+    {
+        auto entity = entities.find(recordId - ENTITY_RECORD_ID_START);
+        if (entity != entities.end())
+        {
+            store(entityRecord(*entity));
+        }
+    }
+    else if (recordId >= FRU_RECORD_ID_START)
+    {
+        auto fru = frus.find(recordId - FRU_RECORD_ID_START);
+        if (fru != frus.end())
+        {
+            store(fruRecord(*fru));
+        }
+    }
+    else
+    {
+        auto sensor = sensors.find(recordId);
+        if (sensor != sensors.end())
+        {
+            store(fullRecord(*sensor));
+        }
+    }
+}
+
+} // namespace sdr
+} // namespace ipmi
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ipmi
+{
+namespace sdr
+{
+
+/** @struct Record
+ *  @brief Where one serialized SDR lives in the repository image
+ */
+struct Record
+{
+    size_t offset = 0;
+    size_t size = 0;
+    uint16_t next = 0;
+};
+
+/** @struct Changes
+ *  @brief When the contents of the repository last changed
+ *
+ *  The times are in seconds since the epoch and are kept across restarts,
+ *  so they only move when the records themselves change.
+ */
+struct Changes
+{
+    uint32_t generation = 0;
+    uint32_t additionTimestamp = 0;
+    uint32_t eraseTimestamp = 0;
+};
+
+/** @class Repository
+ *  @brief The full sensor, FRU locator and entity association SDRs,
+ *         serialized once into a single image with a record ID index
+ *
+ *  Get SDR is served as a copy out of the image, so the several partial
+ *  reads a host needs for each record do not rebuild the record each time.
+ */
+class Repository
+{
+  public:
+    Repository(const Repository&) = delete;
+    Repository& operator=(const Repository&) = delete;
+    Repository(Repository&&) = delete;
+    Repository& operator=(Repository&&) = delete;
+
+    static Repository& instance();
+
+    /** @brief Look up a record, building the image on first use
+     *
+     *  @param[in] recordId - record ID; 0 is the first record
+     *
+     *  @return the record or nullptr if there is no such record
+     */
+    const Record* find(uint16_t recordId);
+
+    /** @brief The bytes of a record returned by find */
+    const uint8_t* data(const Record& record) const
+    {
+        return image.data() + record.offset;
+    }
+
+    /** @brief Serialize one record again, in place, after the metadata it
+     *         is built from has changed
+     *
+     *  @param[in] recordId - record ID of the record to rebuild
+     */
+    void rebuild(uint16_t recordId);
+
+    /** @brief Get the change tracking of the repository, building the
+     *         image on first use
+     */
+    const Changes& changes();
+
+  private:
+    Repository() = default;
+
+    /** @brief Serialize every record into the image */
+    void build();
+
+    /** @brief Compare the image with the one seen last and move the
+     *         change tracking on if it differs
+     */
+    void track();
+
+    std::vector<uint8_t> image;
+    /* indexed by record ID; a size of 0 means there is no such record */
+    std::vector<Record> index;
+    uint16_t first = 0;
+    bool built = false;
+    Changes changed;
+};
+
+} // namespace sdr
+} // namespace ipmi
@@ -2,12 +2,20 @@
 
 #include "selutility.hpp"
 
+#include <systemd/sd-bus.h>
+
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <ctime>
 #include <filesystem>
 #include <ipmid/api.hpp>
+#include <ipmid/event-buffer.hpp>
+#include <ipmid/log-limit.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
 #include <phosphor-logging/elog-errors.hpp>
+#include <string_view>
 #include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
 
@@ -31,7 +39,7 @@ GetSELEntryResponse
 {
     GetSELEntryResponse record{};
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     auto service = ipmi::getService(bus, logEntryIntf, objPath);
 
     // Read all the log entry properties.
@@ -42,7 +50,8 @@ GetSELEntryResponse
     auto reply = bus.call(methodCall);
     if (reply.is_method_error())
     {
-        log<level::ERR>("Error in reading logging property entries");
+        ipmi::logLimited<level::ERR>(
+            "Error in reading logging property entries");
         elog<InternalFailure>();
     }
 
@@ -54,7 +63,7 @@ GetSELEntryResponse
     auto iterId = entryData.find(propId);
     if (iterId == entryData.end())
     {
-        log<level::ERR>("Error in reading Id of logging entry");
+        ipmi::logLimited<level::ERR>("Error in reading Id of logging entry");
         elog<InternalFailure>();
     }
 
@@ -65,7 +74,8 @@ GetSELEntryResponse
     auto iterTimeStamp = entryData.find(propTimeStamp);
     if (iterTimeStamp == entryData.end())
     {
-        log<level::ERR>("Error in reading Timestamp of logging entry");
+        ipmi::logLimited<level::ERR>(
+            "Error in reading Timestamp of logging entry");
         elog<InternalFailure>();
     }
 
@@ -92,7 +102,8 @@ GetSELEntryResponse
     auto iterResolved = entryData.find(propResolved);
     if (iterResolved == entryData.end())
     {
-        log<level::ERR>("Error in reading Resolved field of logging entry");
+        ipmi::logLimited<level::ERR>(
+            "Error in reading Resolved field of logging entry");
         elog<InternalFailure>();
     }
 
@@ -111,38 +122,8 @@ GetSELEntryResponse
     return record;
 }
 
-} // namespace internal
-
-GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
+Callout resolveCallout(const AssociationList& assocs)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-
-    static constexpr auto assocIntf = "org.openbmc.Associations";
-    static constexpr auto assocProp = "associations";
-
-    auto service = ipmi::getService(bus, assocIntf, objPath);
-
-    // Read the Associations interface.
-    auto methodCall =
-        bus.new_method_call(service.c_str(), objPath.c_str(), propIntf, "Get");
-    methodCall.append(assocIntf);
-    methodCall.append(assocProp);
-
-    auto reply = bus.call(methodCall);
-    if (reply.is_method_error())
-    {
-        log<level::ERR>("Error in reading Associations interface");
-        elog<InternalFailure>();
-    }
-
-    using AssociationList =
-        std::vector<std::tuple<std::string, std::string, std::string>>;
-
-    sdbusplus::message::variant<AssociationList> list;
-    reply.read(list);
-
-    auto& assocs = std::get<AssociationList>(list);
-
     /*
      * Check if the log entry has any callout associations, if there is a
      * callout association try to match the inventory path to the corresponding
@@ -158,12 +139,13 @@ GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
                 iter = invSensors.find(BOARD_SENSOR);
                 if (iter == invSensors.end())
                 {
-                    log<level::ERR>("Motherboard sensor not found");
+                    ipmi::logLimited<level::ERR>(
+                        "Motherboard sensor not found");
                     elog<InternalFailure>();
                 }
             }
 
-            return internal::prepareSELEntry(objPath, iter);
+            return iter;
         }
     }
 
@@ -172,16 +154,48 @@ GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
     auto iter = invSensors.find(SYSTEM_SENSOR);
     if (iter == invSensors.end())
     {
-        log<level::ERR>("System event sensor not found");
+        ipmi::logLimited<level::ERR>("System event sensor not found");
         elog<InternalFailure>();
     }
 
-    return internal::prepareSELEntry(objPath, iter);
+    return iter;
+}
+
+Callout readCallout(const std::string& objPath)
+{
+    sdbusplus::bus::bus& bus = getBus();
+
+    auto service = ipmi::getService(bus, assocIntf, objPath);
+
+    // Read the Associations interface.
+    auto methodCall =
+        bus.new_method_call(service.c_str(), objPath.c_str(), propIntf, "Get");
+    methodCall.append(assocIntf);
+    methodCall.append(assocProp);
+
+    auto reply = bus.call(methodCall);
+    if (reply.is_method_error())
+    {
+        ipmi::logLimited<level::ERR>("Error in reading Associations interface");
+        elog<InternalFailure>();
+    }
+
+    sdbusplus::message::variant<AssociationList> list;
+    reply.read(list);
+
+    return resolveCallout(std::get<AssociationList>(list));
+}
+
+} // namespace internal
+
+GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
+{
+    return internal::prepareSELEntry(objPath, internal::readCallout(objPath));
 }
 
 std::chrono::seconds getEntryTimeStamp(const std::string& objPath)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
 
     auto service = ipmi::getService(bus, logEntryIntf, objPath);
 
@@ -196,7 +210,8 @@ std::chrono::seconds getEntryTimeStamp(const std::string& objPath)
     auto reply = bus.call(methodCall);
     if (reply.is_method_error())
     {
-        log<level::ERR>("Error in reading Timestamp from Entry interface");
+        ipmi::logLimited<level::ERR>(
+            "Error in reading Timestamp from Entry interface");
         elog<InternalFailure>();
     }
 
@@ -210,7 +225,7 @@ std::chrono::seconds getEntryTimeStamp(const std::string& objPath)
 
 void readLoggingObjectPaths(ObjectPaths& paths)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     auto depth = 0;
     paths.clear();
 
@@ -242,6 +257,520 @@ void readLoggingObjectPaths(ObjectPaths& paths)
     }
 }
 
+namespace
+{
+
+constexpr auto logRootPath = "/xyz/openbmc_project/logging";
+
+/** @brief Read the path and the callout associations of InterfacesAdded
+ *
+ *  The other properties are skipped rather than decoded, since they may
+ *  use types outside of ipmi::Value.
+ *
+ *  @param[in] msg - the InterfacesAdded signal
+ *  @param[out] path - the object path
+ *  @param[out] assocs - the associations, if the entry was added with them
+ *
+ *  @return false if the signal could not be read
+ */
+bool readAddedAssociations(sdbusplus::message::message& msg, std::string& path,
+                           std::optional<AssociationList>& assocs)
+{
+    sd_bus_message* m = msg.get();
+    const char* objPath = nullptr;
+    if (sd_bus_message_read(m, "o", &objPath) < 0 ||
+        sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sa{sv}}") < 0)
+    {
+        return false;
+    }
+    path = objPath;
+
+    int r;
+    while ((r = sd_bus_message_enter_container(m, SD_BUS_TYPE_DICT_ENTRY,
+                                               "sa{sv}")) > 0)
+    {
+        const char* interface = nullptr;
+        if (sd_bus_message_read(m, "s", &interface) < 0)
+        {
+            return false;
+        }
+        if (std::strcmp(interface, assocIntf) != 0)
+        {
+            if (sd_bus_message_skip(m, "a{sv}") < 0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            if (sd_bus_message_enter_container(m, SD_BUS_TYPE_ARRAY, "{sv}") <
+                0)
+            {
+                return false;
+            }
+            while ((r = sd_bus_message_enter_container(
+                        m, SD_BUS_TYPE_DICT_ENTRY, "sv")) > 0)
+            {
+                const char* name = nullptr;
+                if (sd_bus_message_read(m, "s", &name) < 0)
+                {
+                    return false;
+                }
+                if (std::strcmp(name, assocProp) == 0 &&
+                    sd_bus_message_enter_container(m, SD_BUS_TYPE_VARIANT,
+                                                   "a(sss)") > 0)
+                {
+                    AssociationList list;
+                    msg.read(list);
+                    assocs = std::move(list);
+                    if (sd_bus_message_exit_container(m) < 0)
+                    {
+                        return false;
+                    }
+                }
+                else if (sd_bus_message_skip(m, "v") < 0)
+                {
+                    return false;
+                }
+                if (sd_bus_message_exit_container(m) < 0)
+                {
+                    return false;
+                }
+            }
+            if (r < 0 || sd_bus_message_exit_container(m) < 0)
+            {
+                return false;
+            }
+        }
+        if (sd_bus_message_exit_container(m) < 0)
+        {
+            return false;
+        }
+    }
+    return r >= 0 && sd_bus_message_exit_container(m) >= 0;
+}
+
+/** @brief Get the record ID of a logging entry from its object path
+ *
+ *  @return the record ID, or nothing if the path is not a logging entry
+ */
+std::optional<Id> recordIdOf(const std::string& objPath)
+{
+    std::string_view path(objPath);
+    std::string_view base(logBasePath);
+    if (path.size() <= base.size() + 1 || path.substr(0, base.size()) != base ||
+        path[base.size()] != '/')
+    {
+        return std::nullopt;
+    }
+    path.remove_prefix(base.size() + 1);
+
+    Id id = 0;
+    for (char c : path)
+    {
+        if (c < '0' || c > '9')
+        {
+            return std::nullopt;
+        }
+        id = id * 10 + (c - '0');
+    }
+    return id;
+}
+
+} // namespace
+
+std::string entryPath(Id recordId)
+{
+    return std::string(logBasePath) + "/" + std::to_string(recordId);
+}
+
+EntryIndex& EntryIndex::instance()
+{
+    // never destroyed; the matches must not outlive the bus connection
+    static EntryIndex* index = []() {
+        cache_stats::registerCache(
+            "sel-index", []() { return EntryIndex::instance().indexUsage(); });
+        cache_stats::registerCache("sel-records", []() {
+            return EntryIndex::instance().recordUsage();
+        });
+        cache_stats::registerCache("sel-callouts", []() {
+            return EntryIndex::instance().calloutUsage();
+        });
+        return new EntryIndex();
+    }();
+    return *index;
+}
+
+const std::vector<Id>& EntryIndex::ids()
+{
+    if (valid)
+    {
+        return entries;
+    }
+
+    // watch first, so no entry added while reading is missed; the
+    // signals are only dispatched after the read
+    watch();
+
+    ObjectPaths paths;
+    entries.clear();
+    try
+    {
+        readLoggingObjectPaths(paths);
+    }
+    catch (const sdbusplus::exception::SdBusError& e)
+    {
+        // the mapper fails when there are no logging entries
+    }
+    for (const auto& path : paths)
+    {
+        if (auto id = recordIdOf(path))
+        {
+            entries.push_back(*id);
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    valid = addedMatch && removedMatch;
+    return entries;
+}
+
+std::vector<Id>::const_iterator EntryIndex::find(Id recordId)
+{
+    const auto& sorted = ids();
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), recordId);
+    return (it != sorted.end() && *it == recordId) ? it : sorted.end();
+}
+
+uint32_t EntryIndex::addTimeStamp()
+{
+    const auto& sorted = ids();
+    if (addTime)
+    {
+        return *addTime;
+    }
+    if (sorted.empty())
+    {
+        return invalidTimeStamp;
+    }
+
+    // only read once; additions after that are timed by their signal
+    uint32_t stamp = invalidTimeStamp;
+    try
+    {
+        stamp = getEntryTimeStamp(entryPath(sorted.back())).count();
+    }
+    catch (const InternalFailure& e)
+    {
+        return invalidTimeStamp;
+    }
+    catch (const std::runtime_error& e)
+    {
+        log<level::ERR>(e.what());
+        return invalidTimeStamp;
+    }
+    if (valid)
+    {
+        addTime = stamp;
+    }
+    return stamp;
+}
+
+GetSELEntryResponse EntryIndex::record(Id recordId)
+{
+    auto cached = records.find(recordId);
+    if (cached != records.end())
+    {
+        cached->second.lastUsed = ++useClock;
+        return cached->second.record;
+    }
+
+    // the callout is usually known from the signal that added the entry
+    std::string path = entryPath(recordId);
+    auto known = callouts.find(recordId);
+    internal::Callout callout = known != callouts.end()
+                                    ? known->second
+                                    : internal::readCallout(path);
+    GetSELEntryResponse converted = internal::prepareSELEntry(path, callout);
+    if (valid && changedMatch)
+    {
+        callouts.emplace(recordId, callout);
+        keep(recordId, converted);
+    }
+    return converted;
+}
+
+void EntryIndex::keep(Id recordId, const GetSELEntryResponse& record)
+{
+    // a SEL is read front to back, so the least recently used record is
+    // found with a scan only when the cache is full
+    if (IPMI_SEL_RECORD_CACHE_LIMIT &&
+        records.size() >= IPMI_SEL_RECORD_CACHE_LIMIT)
+    {
+        auto oldest = std::min_element(
+            records.begin(), records.end(), [](const auto& a, const auto& b) {
+                return a.second.lastUsed < b.second.lastUsed;
+            });
+        records.erase(oldest);
+        evictions++;
+    }
+    records.emplace(recordId, Record{record, ++useClock});
+}
+
+cache_stats::Usage EntryIndex::indexUsage() const
+{
+    cache_stats::Usage usage;
+    usage.entries = entries.size();
+    usage.bytes = entries.capacity() * sizeof(Id);
+    return usage;
+}
+
+cache_stats::Usage EntryIndex::calloutUsage() const
+{
+    // a map node holds the key and the table position next to the tree
+    // pointers
+    constexpr size_t nodeBytes = sizeof(Id) + sizeof(internal::Callout) + 32;
+    cache_stats::Usage usage;
+    usage.entries = callouts.size();
+    usage.bytes = callouts.size() * nodeBytes;
+    return usage;
+}
+
+cache_stats::Usage EntryIndex::recordUsage() const
+{
+    // a map node holds the key and the record next to the tree pointers
+    constexpr size_t nodeBytes = sizeof(Id) + sizeof(Record) + 32;
+    cache_stats::Usage usage;
+    usage.entries = records.size();
+    usage.bytes = records.size() * nodeBytes;
+    usage.limit = IPMI_SEL_RECORD_CACHE_LIMIT;
+    usage.evictions = evictions;
+    return usage;
+}
+
+void EntryIndex::prefetch(Id recordId)
+{
+    if (!valid || !changedMatch || records.count(recordId))
+    {
+        return;
+    }
+    post_work([this, recordId]() {
+        if (records.count(recordId) || find(recordId) == entries.end())
+        {
+            return;
+        }
+        try
+        {
+            record(recordId);
+        }
+        catch (const std::exception& e)
+        {
+            // Get SEL Entry converts it again and reports the failure
+        }
+    });
+}
+
+void EntryIndex::erase(Id recordId)
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), recordId);
+    if (it != entries.end() && *it == recordId)
+    {
+        entries.erase(it);
+        eraseTime = std::time(nullptr);
+    }
+    records.erase(recordId);
+    callouts.erase(recordId);
+}
+
+void EntryIndex::clear()
+{
+    if (!entries.empty())
+    {
+        eraseTime = std::time(nullptr);
+    }
+    entries.clear();
+    records.clear();
+    callouts.clear();
+    valid = false;
+}
+
+void EntryIndex::watch()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto bus = getSdBus();
+    if (!bus)
+    {
+        return;
+    }
+    if (!addedMatch)
+    {
+        addedMatch = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::interfacesAdded(logRootPath),
+            [this](sdbusplus::message::message& msg) { added(msg); });
+    }
+    if (!removedMatch)
+    {
+        removedMatch = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::interfacesRemoved(logRootPath),
+            [this](sdbusplus::message::message& msg) { removed(msg); });
+    }
+    if (!changedMatch)
+    {
+        // one match for all of the entries; a match per entry would cost
+        // the bus daemon a rule for every log entry
+        changedMatch = std::make_unique<sdbusplus::bus::match::match>(
+            *bus,
+            rules::type::signal() + rules::member("PropertiesChanged") +
+                rules::interface(propIntf) + rules::path_namespace(logBasePath),
+            [this](sdbusplus::message::message& msg) { changed(msg); });
+    }
+}
+
+void EntryIndex::changed(sdbusplus::message::message& msg)
+{
+    // Resolved and the callout associations are both in the record
+    auto id = recordIdOf(msg.get_path());
+    if (!id)
+    {
+        return;
+    }
+    records.erase(*id);
+
+    std::string interface;
+    try
+    {
+        msg.read(interface);
+    }
+    catch (const sdbusplus::exception::SdBusError& e)
+    {
+        callouts.erase(*id);
+        return;
+    }
+    if (interface == assocIntf)
+    {
+        callouts.erase(*id);
+    }
+}
+
+void EntryIndex::added(sdbusplus::message::message& msg)
+{
+    std::string path;
+    std::optional<AssociationList> assocs;
+    bool read = false;
+    try
+    {
+        // the entry is only converted on demand, but its callout is
+        // resolved now, while the associations are at hand
+        read = readAddedAssociations(msg, path, assocs);
+    }
+    catch (const sdbusplus::exception::SdBusError& e)
+    {
+    }
+    if (!read)
+    {
+        valid = false;
+        return;
+    }
+
+    auto id = recordIdOf(path);
+    if (!id)
+    {
+        return;
+    }
+    bool sensorEvent = false;
+    if (assocs)
+    {
+        try
+        {
+            callouts.insert_or_assign(*id, internal::resolveCallout(*assocs));
+            sensorEvent = true;
+        }
+        catch (const InternalFailure& e)
+        {
+            // converting the entry reports the missing sensor
+        }
+    }
+    // new entries almost always have the highest record ID
+    auto it = std::lower_bound(entries.begin(), entries.end(), *id);
+    if (it == entries.end() || *it != *id)
+    {
+        entries.insert(it, *id);
+        // the signal follows the creation of the entry closely enough
+        addTime = std::time(nullptr);
+        if (sensorEvent)
+        {
+            queueEvent(*id);
+        }
+    }
+}
+
+void EntryIndex::queueEvent(Id recordId)
+{
+    static_assert(sizeof(GetSELEntryResponse) - sizeof(uint16_t) ==
+                  events::messageSize);
+
+    // every host sees the one SEL
+    bool wanted = false;
+    for (size_t host = 0; host < IPMI_HOST_INSTANCES; host++)
+    {
+        wanted = wanted || events::enabled(host);
+    }
+    if (!wanted)
+    {
+        return;
+    }
+    // converted once the signal has been handled; the record is kept for
+    // the Get SEL Entry of the host that reads the event
+    post_work([this, recordId]() {
+        if (find(recordId) == entries.end())
+        {
+            return;
+        }
+        GetSELEntryResponse converted;
+        try
+        {
+            converted = record(recordId);
+        }
+        catch (const std::exception& e)
+        {
+            // Get SEL Entry converts it again and reports the failure
+            return;
+        }
+        // the event message is the record without its next record ID
+        events::Message message;
+        std::memcpy(message.data(),
+                    reinterpret_cast<const uint8_t*>(&converted) +
+                        sizeof(converted.nextRecordID),
+                    message.size());
+        for (size_t host = 0; host < IPMI_HOST_INSTANCES; host++)
+        {
+            events::post(host, message);
+        }
+    });
+}
+
+void EntryIndex::removed(sdbusplus::message::message& msg)
+{
+    sdbusplus::message::object_path path;
+    std::vector<std::string> interfaces;
+    try
+    {
+        msg.read(path, interfaces);
+    }
+    catch (const sdbusplus::exception::SdBusError& e)
+    {
+        valid = false;
+        return;
+    }
+
+    auto id = recordIdOf(path.str);
+    if (id && std::find(interfaces.begin(), interfaces.end(), logEntryIntf) !=
+                  interfaces.end())
+    {
+        erase(*id);
+    }
+}
+
 } // namespace sel
 
 } // namespace ipmi
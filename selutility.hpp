@@ -2,8 +2,16 @@
 
 #include <chrono>
 #include <cstdint>
+#include <ipmid/cache-stats.hpp>
 #include <ipmid/types.hpp>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/server.hpp>
+#include <string>
+#include <tuple>
+#include <vector>
 
 namespace ipmi
 {
@@ -21,6 +29,9 @@ static constexpr auto logDeleteIntf = "xyz.openbmc_project.Object.Delete";
 
 static constexpr auto propIntf = "org.freedesktop.DBus.Properties";
 
+static constexpr auto assocIntf = "org.openbmc.Associations";
+static constexpr auto assocProp = "associations";
+
 using ObjectPaths = std::vector<std::string>;
 using PropertyName = std::string;
 using Resolved = bool;
@@ -30,6 +41,8 @@ using Message = std::string;
 using AdditionalData = std::vector<std::string>;
 using PropertyType = sdbusplus::message::variant<Resolved, Id, Timestamp,
                                                  Message, AdditionalData>;
+using AssociationList =
+    std::vector<std::tuple<std::string, std::string, std::string>>;
 
 static constexpr auto selVersion = 0x51;
 static constexpr auto invalidTimeStamp = 0xFFFFFFFF;
@@ -98,6 +111,7 @@ struct DeleteSELEntryRequest
 
 static constexpr auto initiateErase = 0xAA;
 static constexpr auto getEraseStatus = 0x00;
+static constexpr auto eraseInProgress = 0x00;
 static constexpr auto eraseComplete = 0x01;
 
 /** @struct ClearSELRequest
@@ -138,16 +152,165 @@ std::chrono::seconds getEntryTimeStamp(const std::string& objPath);
  *
  *  @param[in,out] paths - sorted list of logging entry object paths.
  *
- *  @note This function is invoked when the Get SEL Info command or the Delete
- *        SEL entry command is invoked. The Get SEL Entry command is preceded
- *        typically by Get SEL Info command, so readLoggingObjectPaths is not
- *        invoked before each Get SEL entry command.
+ *  @note This is only the cold fill of EntryIndex::ids(): it runs on the
+ *        first use of the index, and again after the SEL was cleared or a
+ *        logging signal could not be read. The SEL commands go through the
+ *        index otherwise, which the logging signals keep current.
  */
 void readLoggingObjectPaths(ObjectPaths& paths);
 
 namespace internal
 {
 
+/** @brief Position of the sensor of a logging entry in invSensors */
+using Callout = ipmi::sensor::InvObjectIDMap::const_iterator;
+
+/** @brief Find the sensor of a logging entry from its associations
+ *
+ *  @param[in] assocs - the associations of the logging entry.
+ *
+ *  @return the sensor of the first callout, the motherboard sensor if the
+ *          callout has none, or the system event sensor if there is no
+ *          callout; throws InternalFailure if that sensor is missing.
+ */
+Callout resolveCallout(const AssociationList& assocs);
+
+/** @brief Read the associations of a logging entry and find its sensor
+ *
+ *  @param[in] objPath - DBUS object path of the logging entry.
+ *
+ *  @return the sensor, as resolveCallout() finds it.
+ */
+Callout readCallout(const std::string& objPath);
+
+} // namespace internal
+
+/** @brief Get the object path of the logging entry with a record ID */
+std::string entryPath(Id recordId);
+
+/** @class EntryIndex
+ *  @brief The record IDs of the logging entries, in numeric order
+ *  @details The logging entries are read through the mapper once; after
+ *           that the index follows the InterfacesAdded and
+ *           InterfacesRemoved signals of the logging service, so the SEL
+ *           commands do not rescan the entries on every request.
+ */
+class EntryIndex
+{
+  public:
+    /** @brief Get the index of the logging entries */
+    static EntryIndex& instance();
+
+    /** @brief Get the record IDs, reading them if they are not known
+     *
+     *  @return the record IDs in numeric order.
+     */
+    const std::vector<Id>& ids();
+
+    /** @brief Look up a record ID with a binary search
+     *
+     *  @param[in] recordId - the record ID.
+     *  @return the position of the record in ids(), or ids().end() if
+     *          there is no such record; the record after it is the next
+     *          record of the SEL.
+     */
+    std::vector<Id>::const_iterator find(Id recordId);
+
+    /** @brief Get the time of the most recent addition to the SEL
+     *
+     *  @return seconds since the epoch, or invalidTimeStamp if unknown.
+     */
+    uint32_t addTimeStamp();
+
+    /** @brief Get the time entries were last deleted from the SEL
+     *
+     *  @return seconds since the epoch, or invalidTimeStamp if no entry
+     *          was deleted since ipmid started.
+     */
+    uint32_t eraseTimeStamp() const
+    {
+        return eraseTime;
+    }
+
+    /** @brief Get the SEL record of a logging entry, converting it on
+     *         first use
+     *
+     *  The converted records are kept until the logging entry changes or
+     *  is removed, or until IPMI_SEL_RECORD_CACHE_LIMIT newer ones push
+     *  out the least recently used.
+     *
+     *  @param[in] recordId - the record ID.
+     *  @return the record, without its next record ID.
+     */
+    GetSELEntryResponse record(Id recordId);
+
+    /** @brief Convert a record once the current request has been answered,
+     *         ahead of the Get SEL Entry that is likely to ask for it
+     *
+     *  @param[in] recordId - the record ID.
+     */
+    void prefetch(Id recordId);
+
+    /** @brief Drop a record that was deleted through ipmid itself, ahead
+     *         of the signal */
+    void erase(Id recordId);
+
+    /** @brief Forget the entries after the SEL was cleared all at once
+     *
+     *  The record IDs are read again on the next use of ids(), so an entry
+     *  logged while the SEL was being cleared is kept.
+     */
+    void clear();
+
+    /** @brief Measure the record IDs for cache_stats */
+    cache_stats::Usage indexUsage() const;
+
+    /** @brief Measure the converted records for cache_stats */
+    cache_stats::Usage recordUsage() const;
+
+    /** @brief Measure the resolved callouts for cache_stats */
+    cache_stats::Usage calloutUsage() const;
+
+  private:
+    EntryIndex() = default;
+
+    void watch();
+    void added(sdbusplus::message::message& msg);
+    void removed(sdbusplus::message::message& msg);
+    void changed(sdbusplus::message::message& msg);
+
+    /** @brief Queue a new sensor event for the hosts that take event
+     *         messages */
+    void queueEvent(Id recordId);
+
+    struct Record
+    {
+        GetSELEntryResponse record;
+        uint64_t lastUsed;
+    };
+
+    void keep(Id recordId, const GetSELEntryResponse& record);
+
+    std::vector<Id> entries;
+    std::map<Id, Record> records;
+    /* the sensor of each entry, resolved from its callout associations;
+     * kept until the associations change or the entry is removed */
+    std::map<Id, internal::Callout> callouts;
+    uint64_t useClock = 0;
+    uint64_t evictions = 0;
+    std::optional<uint32_t> addTime;
+    uint32_t eraseTime = invalidTimeStamp;
+    /* false until the entries have been read, and when there is no
+     * connection to watch the signals on */
+    bool valid = false;
+    std::unique_ptr<sdbusplus::bus::match::match> addedMatch;
+    std::unique_ptr<sdbusplus::bus::match::match> removedMatch;
+    std::unique_ptr<sdbusplus::bus::match::match> changedMatch;
+};
+
+namespace internal
+{
+
 /** @brief Convert logging entry to SEL event record
  *
  *  @param[in] objPath - DBUS object path of the logging entry.
@@ -4,12 +4,18 @@
 
 #include <bitset>
 #include <filesystem>
+#include <ipmid/log-limit.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
+#include <map>
 #include <optional>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/message/types.hpp>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 namespace ipmi
@@ -45,9 +51,9 @@ ServicePath getServiceAndPath(sdbusplus::bus::bus& bus,
     auto mapperResponseMsg = bus.call(mapperCall);
     if (mapperResponseMsg.is_method_error())
     {
-        log<level::ERR>("Mapper GetSubTree failed",
-                        entry("PATH=%s", path.c_str()),
-                        entry("INTERFACE=%s", interface.c_str()));
+        ipmi::logLimited<level::ERR>("Mapper GetSubTree failed",
+                                     entry("PATH=%s", path.c_str()),
+                                     entry("INTERFACE=%s", interface.c_str()));
         elog<InternalFailure>();
     }
 
@@ -55,9 +61,9 @@ ServicePath getServiceAndPath(sdbusplus::bus::bus& bus,
     mapperResponseMsg.read(mapperResponse);
     if (mapperResponse.empty())
     {
-        log<level::ERR>("Invalid mapper response",
-                        entry("PATH=%s", path.c_str()),
-                        entry("INTERFACE=%s", interface.c_str()));
+        ipmi::logLimited<level::ERR>("Invalid mapper response",
+                                     entry("PATH=%s", path.c_str()),
+                                     entry("INTERFACE=%s", interface.c_str()));
         elog<InternalFailure>();
     }
 
@@ -70,9 +76,9 @@ ServicePath getServiceAndPath(sdbusplus::bus::bus& bus,
     const auto& iter = mapperResponse.find(path);
     if (iter == mapperResponse.end())
     {
-        log<level::ERR>("Couldn't find D-Bus path",
-                        entry("PATH=%s", path.c_str()),
-                        entry("INTERFACE=%s", interface.c_str()));
+        ipmi::logLimited<level::ERR>("Couldn't find D-Bus path",
+                                     entry("PATH=%s", path.c_str()),
+                                     entry("INTERFACE=%s", interface.c_str()));
         elog<InternalFailure>();
     }
     return std::make_pair(iter->first, iter->second.begin()->first);
@@ -91,13 +97,13 @@ AssertionSet getAssertionSet(const SetSensorReadingReq& cmdData)
 
 ipmi_ret_t updateToDbus(IpmiUpdateData& msg)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     try
     {
         auto serviceResponseMsg = bus.call(msg);
         if (serviceResponseMsg.is_method_error())
         {
-            log<level::ERR>("Error in D-Bus call");
+            ipmi::logLimited<level::ERR>("Error in D-Bus call");
             return IPMI_CC_UNSPECIFIED_ERROR;
         }
     }
@@ -109,6 +115,107 @@ ipmi_ret_t updateToDbus(IpmiUpdateData& msg)
     return IPMI_CC_OK;
 }
 
+ReadingCache& ReadingCache::instance()
+{
+    // never destroyed; the matches must not outlive the bus connection
+    static ReadingCache* cache = []() {
+        cache_stats::registerCache("sensor-readings", []() {
+            return ReadingCache::instance().usage();
+        });
+        return new ReadingCache();
+    }();
+    return *cache;
+}
+
+const GetSensorResponse* ReadingCache::find(Id id) const
+{
+    const Entry& entry = entries[id];
+    return entry.valid ? &entry.response : nullptr;
+}
+
+uint64_t ReadingCache::watch(Id id, const Info& info)
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto bus = getSdBus();
+    if (!bus)
+    {
+        // no signals without the shared connection, so nothing is cached
+        return 0;
+    }
+    if (!ownerChanged)
+    {
+        // a restarted service publishes new values without signalling them
+        ownerChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *bus, rules::nameOwnerChanged(),
+            [this](sdbusplus::message::message&) {
+                for (Id i = 0; i < std::numeric_limits<Id>::max(); i++)
+                {
+                    invalidate(i);
+                }
+                invalidate(std::numeric_limits<Id>::max());
+            });
+    }
+
+    Entry& entry = entries[id];
+    if (entry.changed.empty())
+    {
+        std::set<std::string> interfaces{info.sensorInterface};
+        for (const auto& [interface, properties] : info.propertyInterfaces)
+        {
+            interfaces.insert(interface);
+        }
+        for (const auto& interface : interfaces)
+        {
+            entry.changed.emplace_back(
+                std::make_unique<sdbusplus::bus::match::match>(
+                    *bus, rules::propertiesChanged(info.sensorPath, interface),
+                    [this, id](sdbusplus::message::message&) {
+                        invalidate(id);
+                    }));
+        }
+        entry.generation = ++nextGeneration;
+    }
+    return entry.generation;
+}
+
+void ReadingCache::fill(Id id, uint64_t token,
+                        const GetSensorResponse& response)
+{
+    Entry& entry = entries[id];
+    if (!token || entry.generation != token)
+    {
+        return;
+    }
+    entry.response = response;
+    entry.valid = true;
+}
+
+void ReadingCache::invalidate(Id id)
+{
+    Entry& entry = entries[id];
+    entry.valid = false;
+    if (!entry.changed.empty())
+    {
+        entry.generation = ++nextGeneration;
+    }
+}
+
+cache_stats::Usage ReadingCache::usage() const
+{
+    // one entry per sensor number is always there; count the ones in use
+    cache_stats::Usage usage;
+    usage.bytes = sizeof(entries);
+    for (const Entry& entry : entries)
+    {
+        usage.entries += entry.valid;
+        usage.bytes +=
+            entry.changed.capacity() * sizeof(entry.changed[0]) +
+            entry.changed.size() * sizeof(sdbusplus::bus::match::match);
+    }
+    return usage;
+}
+
 namespace get
 {
 
@@ -126,24 +233,130 @@ SensorName nameParentLeaf(const Info& sensorInfo)
     return parent;
 }
 
-GetSensorResponse mapDbusToAssertion(const Info& sensorInfo,
+std::string getSensorService(const Context::ptr& ctx,
+                             const DbusInterface& interface,
+                             const InstancePath& path)
+{
+    std::string service;
+    boost::system::error_code ec =
+        ipmi::getService(ctx, interface, path, service);
+    if (ec)
+    {
+        ipmi::logLimited<level::ERR>("Failed to get the sensor service",
+                                     entry("PATH=%s", path.c_str()),
+                                     entry("INTERFACE=%s", interface.c_str()),
+                                     entry("ERROR=%s", ec.message().c_str()));
+        elog<InternalFailure>();
+    }
+    return service;
+}
+
+Value getSensorProperty(const Context::ptr& ctx, const std::string& service,
+                        const InstancePath& path,
+                        const DbusInterface& interface,
+                        const DbusProperty& property)
+{
+    Value value;
+    boost::system::error_code ec = ipmi::getCachedDbusProperty(
+        ctx, service, path, interface, property, value);
+    if (ec)
+    {
+        ipmi::logLimited<level::ERR>("Failed to get the sensor property",
+                                     entry("PATH=%s", path.c_str()),
+                                     entry("INTERFACE=%s", interface.c_str()),
+                                     entry("PROPERTY=%s", property.c_str()),
+                                     entry("ERROR=%s", ec.message().c_str()));
+        elog<InternalFailure>();
+    }
+    return value;
+}
+
+namespace
+{
+
+/** @brief Fetch every interface of a sensor that isn't cached yet in one
+ *         batch, so the lookups that follow are answered from the cache.
+ *
+ *  Failures are left for the lookups to report.
+ */
+void prefetchSensorProperties(const Context::ptr& ctx,
+                              const std::string& service,
+                              const InstancePath& path,
+                              const DbusInterfaceMap& interfaces)
+{
+    ObjectCache& cache = ObjectCache::instance();
+    std::vector<DbusInterface> missing;
+    std::vector<uint64_t> tokens;
+    std::vector<sdbusplus::message::message> methods;
+    for (const auto& interface : interfaces)
+    {
+        if (cache.find(service, path, interface.first))
+        {
+            continue;
+        }
+        tokens.push_back(cache.watch(service, path, interface.first));
+        missing.push_back(interface.first);
+        auto method = getSdBus()->new_method_call(
+            service.c_str(), path.c_str(), PROP_INTF, METHOD_GET_ALL);
+        method.append(interface.first);
+        methods.push_back(std::move(method));
+    }
+    // a single miss costs the same round trip from the lookup itself
+    if (methods.size() < 2)
+    {
+        return;
+    }
+
+    std::vector<BatchReply> replies = callBatch(ctx, methods);
+    for (size_t i = 0; i < replies.size(); i++)
+    {
+        if (replies[i].ec)
+        {
+            continue;
+        }
+        try
+        {
+            FlatPropertyMap properties;
+            readProperties(replies[i].reply, properties);
+            cache.fill(service, path, missing[i], tokens[i],
+                       std::move(properties));
+        }
+        catch (const std::exception& e)
+        {
+            continue;
+        }
+    }
+}
+
+} // namespace
+
+void warm(const Context::ptr& ctx, const Info& sensorInfo)
+{
+    auto service = getSensorService(ctx, sensorInfo.sensorInterface,
+                                    sensorInfo.sensorPath);
+    prefetchSensorProperties(ctx, service, sensorInfo.sensorPath,
+                             sensorInfo.propertyInterfaces);
+}
+
+GetSensorResponse mapDbusToAssertion(const Context::ptr& ctx,
+                                     const Info& sensorInfo,
                                      const InstancePath& path,
                                      const DbusInterface& interface)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     GetSensorResponse response{};
     auto responseData = reinterpret_cast<GetReadingResponse*>(response.data());
 
-    auto service = ipmi::getService(bus, interface, path);
+    auto service = getSensorService(ctx, interface, path);
 
     const auto& interfaceList = sensorInfo.propertyInterfaces;
+    prefetchSensorProperties(ctx, service, path, interfaceList);
 
     for (const auto& interface : interfaceList)
     {
         for (const auto& property : interface.second)
         {
-            auto propValue = ipmi::getDbusProperty(
-                bus, service, path, interface.first, property.first);
+            auto propValue = getSensorProperty(ctx, service, path,
+                                               interface.first, property.first);
 
             for (const auto& value : std::get<OffsetValueMap>(property.second))
             {
@@ -159,30 +372,31 @@ GetSensorResponse mapDbusToAssertion(const Info& sensorInfo,
     return response;
 }
 
-GetSensorResponse assertion(const Info& sensorInfo)
+GetSensorResponse assertion(const Context::ptr& ctx, const Info& sensorInfo)
 {
-    return mapDbusToAssertion(sensorInfo, sensorInfo.sensorPath,
+    return mapDbusToAssertion(ctx, sensorInfo, sensorInfo.sensorPath,
                               sensorInfo.sensorInterface);
 }
 
-GetSensorResponse eventdata2(const Info& sensorInfo)
+GetSensorResponse eventdata2(const Context::ptr& ctx, const Info& sensorInfo)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     GetSensorResponse response{};
     auto responseData = reinterpret_cast<GetReadingResponse*>(response.data());
 
-    auto service = ipmi::getService(bus, sensorInfo.sensorInterface,
+    auto service = getSensorService(ctx, sensorInfo.sensorInterface,
                                     sensorInfo.sensorPath);
 
     const auto& interfaceList = sensorInfo.propertyInterfaces;
+    prefetchSensorProperties(ctx, service, sensorInfo.sensorPath,
+                             interfaceList);
 
     for (const auto& interface : interfaceList)
     {
         for (const auto& property : interface.second)
         {
             auto propValue =
-                ipmi::getDbusProperty(bus, service, sensorInfo.sensorPath,
-                                      interface.first, property.first);
+                getSensorProperty(ctx, service, sensorInfo.sensorPath,
+                                  interface.first, property.first);
 
             for (const auto& value : std::get<OffsetValueMap>(property.second))
             {
@@ -208,7 +422,7 @@ IpmiUpdateData makeDbusMsg(const std::string& updateInterface,
                            const std::string& command,
                            const std::string& sensorInterface)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     using namespace std::string_literals;
 
     auto dbusService = getService(bus, sensorInterface, sensorPath);
@@ -217,27 +431,120 @@ IpmiUpdateData makeDbusMsg(const std::string& updateInterface,
                                updateInterface.c_str(), command.c_str());
 }
 
+namespace
+{
+
+/* key is the object path, interface and name of a property */
+using PropertyKey = std::tuple<std::string, DbusInterface, DbusProperty>;
+
+struct PendingWrite
+{
+    DbusInterface sensorInterface;
+    std::optional<Value> value;
+};
+
+/* properties with a write in flight, and the value to write next if it was
+ * updated again in the meantime */
+std::map<PropertyKey, PendingWrite> pendingWrites;
+
+void writeNext(const PropertyKey& key)
+{
+    auto pending = pendingWrites.find(key);
+    if (pending == pendingWrites.end())
+    {
+        return;
+    }
+    if (!pending->second.value)
+    {
+        pendingWrites.erase(pending);
+        return;
+    }
+    Value value = std::move(*pending->second.value);
+    pending->second.value.reset();
+
+    const auto& [path, interface, property] = key;
+    std::string service;
+    try
+    {
+        sdbusplus::bus::bus& bus = getBus();
+        service = getService(bus, pending->second.sensorInterface, path);
+    }
+    catch (const std::exception& e)
+    {
+        ipmi::logLimited<level::ERR>("Failed to find the service of a sensor",
+                                     entry("PATH=%s", path.c_str()),
+                                     entry("ERROR=%s", e.what()));
+        pendingWrites.erase(pending);
+        return;
+    }
+
+    getSdBus()->async_method_call(
+        [key](const boost::system::error_code ec) {
+            if (ec)
+            {
+                const auto& [path, interface, property] = key;
+                ipmi::logLimited<level::ERR>(
+                    "Failed to set a sensor property",
+                    entry("PATH=%s", path.c_str()),
+                    entry("INTERFACE=%s", interface.c_str()),
+                    entry("PROPERTY=%s", property.c_str()),
+                    entry("ERROR=%s", ec.message().c_str()));
+            }
+            writeNext(key);
+        },
+        service, path, "org.freedesktop.DBus.Properties", "Set", interface,
+        property, value);
+}
+
+} // namespace
+
+ipmi_ret_t updateProperty(const Info& sensorInfo,
+                          const DbusInterface& interface,
+                          const DbusProperty& property, const Value& value)
+{
+    if (!getSdBus())
+    {
+        auto msg = makeDbusMsg("org.freedesktop.DBus.Properties",
+                               sensorInfo.sensorPath, "Set",
+                               sensorInfo.sensorInterface);
+        msg.append(interface);
+        msg.append(property);
+        msg.append(value);
+        return updateToDbus(msg);
+    }
+
+    PropertyKey key{sensorInfo.sensorPath, interface, property};
+    auto [pending, idle] = pendingWrites.try_emplace(key);
+    pending->second.sensorInterface = sensorInfo.sensorInterface;
+    pending->second.value = value;
+    if (idle)
+    {
+        // start writing once the response to this request has been sent
+        post_work([key]() { writeNext(key); });
+    }
+    return IPMI_CC_OK;
+}
+
 ipmi_ret_t eventdata(const SetSensorReadingReq& cmdData, const Info& sensorInfo,
                      uint8_t data)
 {
-    auto msg =
-        makeDbusMsg("org.freedesktop.DBus.Properties", sensorInfo.sensorPath,
-                    "Set", sensorInfo.sensorInterface);
-
     const auto& interface = sensorInfo.propertyInterfaces.begin();
-    msg.append(interface->first);
     for (const auto& property : interface->second)
     {
-        msg.append(property.first);
         const auto& iter = std::get<OffsetValueMap>(property.second).find(data);
         if (iter == std::get<OffsetValueMap>(property.second).end())
         {
             log<level::ERR>("Invalid event data");
             return IPMI_CC_PARM_OUT_OF_RANGE;
         }
-        msg.append(iter->second.assert);
+        auto rc = updateProperty(sensorInfo, interface->first, property.first,
+                                 iter->second.assert);
+        if (rc)
+        {
+            return rc;
+        }
     }
-    return updateToDbus(msg);
+    return IPMI_CC_OK;
 }
 
 ipmi_ret_t assertion(const SetSensorReadingReq& cmdData, const Info& sensorInfo)
@@ -273,14 +580,8 @@ ipmi_ret_t assertion(const SetSensorReadingReq& cmdData, const Info& sensorInfo)
 
         if (tmp)
         {
-            auto msg = makeDbusMsg("org.freedesktop.DBus.Properties",
-                                   sensorInfo.sensorPath, "Set",
-                                   sensorInfo.sensorInterface);
-            msg.append(interface->first);
-            msg.append(property.first);
-            msg.append(*tmp);
-
-            auto rc = updateToDbus(msg);
+            auto rc = updateProperty(sensorInfo, interface->first,
+                                     property.first, *tmp);
             if (rc)
             {
                 return rc;
@@ -301,7 +602,7 @@ IpmiUpdateData makeDbusMsg(const std::string& updateInterface,
                            const std::string& command,
                            const std::string& sensorInterface)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     using namespace std::string_literals;
 
     static const auto dbusPath = "/xyz/openbmc_project/inventory"s;
@@ -385,7 +686,7 @@ namespace inventory
 namespace get
 {
 
-GetSensorResponse assertion(const Info& sensorInfo)
+GetSensorResponse assertion(const Context::ptr& ctx, const Info& sensorInfo)
 {
     namespace fs = std::filesystem;
 
@@ -393,7 +694,7 @@ GetSensorResponse assertion(const Info& sensorInfo)
     path += sensorInfo.sensorPath;
 
     return ipmi::sensor::get::mapDbusToAssertion(
-        sensorInfo, path.string(),
+        ctx, sensorInfo, path.string(),
         sensorInfo.propertyInterfaces.begin()->first);
 }
 
@@ -2,11 +2,17 @@
 
 #include "sensorhandler.hpp"
 
+#include <array>
 #include <cmath>
 #include <ipmid/api.hpp>
+#include <ipmid/sensor-metadata.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
+#include <limits>
+#include <memory>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/message/types.hpp>
+#include <vector>
 
 namespace ipmi
 {
@@ -49,6 +55,68 @@ AssertionSet getAssertionSet(const SetSensorReadingReq& cmdData);
  */
 ipmi_ret_t updateToDbus(IpmiUpdateData& msg);
 
+/** @class ReadingCache
+ *  @brief Precomputed Get Sensor Reading responses, by sensor number.
+ *  @details The response of a sensor is computed by its getFunc on the
+ *           first read and then kept until a PropertiesChanged signal
+ *           arrives for one of the interfaces of the sensor object, or the
+ *           owner of a service changes. A sweep over all of the sensors is
+ *           then answered from memory.
+ */
+class ReadingCache
+{
+  public:
+    /** @brief Get the cache of the sensors of this provider */
+    static ReadingCache& instance();
+
+    /** @brief Look up the cached response of a sensor
+     *
+     *  @param[in] id - sensor number.
+     *  @return The cached response or nullptr if it is not cached.
+     */
+    const GetSensorResponse* find(Id id) const;
+
+    /** @brief Start watching a sensor ahead of computing its response
+     *
+     *  @param[in] id - sensor number.
+     *  @param[in] info - the sensor.
+     *  @return A token to pass to fill once the response is computed.
+     */
+    uint64_t watch(Id id, const Info& info);
+
+    /** @brief Store the computed response of a watched sensor
+     *
+     *  The response is dropped if the sensor changed after the token was
+     *  handed out, since it may already be stale.
+     *
+     *  @param[in] id - sensor number.
+     *  @param[in] token - token returned by watch.
+     *  @param[in] response - the response from getFunc.
+     */
+    void fill(Id id, uint64_t token, const GetSensorResponse& response);
+
+    /** @brief Drop the cached response of a sensor */
+    void invalidate(Id id);
+
+    /** @brief Measure the cache for cache_stats */
+    cache_stats::Usage usage() const;
+
+  private:
+    ReadingCache() = default;
+
+    struct Entry
+    {
+        GetSensorResponse response{};
+        bool valid = false;
+        uint64_t generation = 0;
+        std::vector<std::unique_ptr<sdbusplus::bus::match::match>> changed;
+    };
+
+    std::array<Entry, std::numeric_limits<Id>::max() + 1> entries;
+    uint64_t nextGeneration = 0;
+    std::unique_ptr<sdbusplus::bus::match::match> ownerChanged;
+};
+
 namespace get
 {
 
@@ -106,17 +174,59 @@ inline SensorName nameLeaf(const Info& sensorInfo)
  */
 SensorName nameParentLeaf(const Info& sensorInfo);
 
+/**
+ *  @brief Look up the service of a sensor object, suspending the request
+ *         while the mapper is queried.
+ *
+ *  @param[in] ctx - context of the Get Sensor Reading request.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] path - Dbus object path.
+ *
+ *  @return The service name; throws InternalFailure on failure.
+ */
+std::string getSensorService(const Context::ptr& ctx,
+                             const DbusInterface& interface,
+                             const InstancePath& path);
+
+/**
+ *  @brief Fetch the properties a sensor is read from into the ObjectCache
+ *         ahead of its first Get Sensor Reading, for the cache warm-up.
+ *
+ *  @param[in] ctx - context of the warm-up task.
+ *  @param[in] sensorInfo - Dbus info related to sensor.
+ */
+void warm(const Context::ptr& ctx, const Info& sensorInfo);
+
+/**
+ *  @brief Read a sensor property from the ObjectCache, suspending the
+ *         request while the interface is fetched on a miss.
+ *
+ *  @param[in] ctx - context of the Get Sensor Reading request.
+ *  @param[in] service - Dbus service name.
+ *  @param[in] path - Dbus object path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] property - name of the property.
+ *
+ *  @return The property value; throws InternalFailure on failure.
+ */
+Value getSensorProperty(const Context::ptr& ctx, const std::string& service,
+                        const InstancePath& path,
+                        const DbusInterface& interface,
+                        const DbusProperty& property);
+
 /**
  *  @brief Helper function to map the dbus info to sensor's assertion status
  *         for the get sensor reading command.
  *
+ *  @param[in] ctx - context of the Get Sensor Reading request.
  *  @param[in] sensorInfo - Dbus info related to sensor.
  *  @param[in] path - Dbus object path.
  *  @param[in] interface - Dbus interface.
  *
  *  @return Response for get sensor reading command.
  */
-GetSensorResponse mapDbusToAssertion(const Info& sensorInfo,
+GetSensorResponse mapDbusToAssertion(const Context::ptr& ctx,
+                                     const Info& sensorInfo,
                                      const InstancePath& path,
                                      const DbusInterface& interface);
 
@@ -124,43 +234,46 @@ GetSensorResponse mapDbusToAssertion(const Info& sensorInfo,
  *  @brief Map the Dbus info to sensor's assertion status in the Get sensor
  *         reading command response.
  *
+ *  @param[in] ctx - context of the Get Sensor Reading request.
  *  @param[in] sensorInfo - Dbus info related to sensor.
  *
  *  @return Response for get sensor reading command.
  */
-GetSensorResponse assertion(const Info& sensorInfo);
+GetSensorResponse assertion(const Context::ptr& ctx, const Info& sensorInfo);
 
 /**
  *  @brief Maps the Dbus info to the reading field in the Get sensor reading
  *         command response.
  *
+ *  @param[in] ctx - context of the Get Sensor Reading request.
  *  @param[in] sensorInfo - Dbus info related to sensor.
  *
  *  @return Response for get sensor reading command.
  */
-GetSensorResponse eventdata2(const Info& sensorInfo);
+GetSensorResponse eventdata2(const Context::ptr& ctx, const Info& sensorInfo);
 
 /**
  *  @brief readingAssertion is a case where the entire assertion state field
  *         serves as the sensor value.
  *
  *  @tparam T - type of the dbus property related to sensor.
+ *  @param[in] ctx - context of the Get Sensor Reading request.
  *  @param[in] sensorInfo - Dbus info related to sensor.
  *
  *  @return Response for get sensor reading command.
  */
 template <typename T>
-GetSensorResponse readingAssertion(const Info& sensorInfo)
+GetSensorResponse readingAssertion(const Context::ptr& ctx,
+                                   const Info& sensorInfo)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     GetSensorResponse response{};
     auto responseData = reinterpret_cast<GetReadingResponse*>(response.data());
 
-    auto service = ipmi::getService(bus, sensorInfo.sensorInterface,
+    auto service = getSensorService(ctx, sensorInfo.sensorInterface,
                                     sensorInfo.sensorPath);
 
-    auto propValue = ipmi::getDbusProperty(
-        bus, service, sensorInfo.sensorPath,
+    auto propValue = getSensorProperty(
+        ctx, service, sensorInfo.sensorPath,
         sensorInfo.propertyInterfaces.begin()->first,
         sensorInfo.propertyInterfaces.begin()->second.begin()->first);
 
@@ -174,29 +287,37 @@ GetSensorResponse readingAssertion(const Info& sensorInfo)
  *         command response
  *
  *  @tparam T - type of the dbus property related to sensor.
+ *  @param[in] ctx - context of the Get Sensor Reading request.
  *  @param[in] sensorInfo - Dbus info related to sensor.
  *
  *  @return Response for get sensor reading command.
  */
 template <typename T>
-GetSensorResponse readingData(const Info& sensorInfo)
+GetSensorResponse readingData(const Context::ptr& ctx, const Info& sensorInfo)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     GetSensorResponse response{};
     auto responseData = reinterpret_cast<GetReadingResponse*>(response.data());
 
     enableScanning(responseData);
 
-    auto service = ipmi::getService(bus, sensorInfo.sensorInterface,
+    auto service = getSensorService(ctx, sensorInfo.sensorInterface,
                                     sensorInfo.sensorPath);
 
-    auto propValue = ipmi::getDbusProperty(
-        bus, service, sensorInfo.sensorPath,
+    auto propValue = getSensorProperty(
+        ctx, service, sensorInfo.sensorPath,
         sensorInfo.propertyInterfaces.begin()->first,
         sensorInfo.propertyInterfaces.begin()->second.begin()->first);
 
-    double value = std::get<T>(propValue) *
-                   std::pow(10, sensorInfo.scale - sensorInfo.exponentR);
+    // a Sensor.Value that was rescaled since the YAML was written is read at
+    // the scale it announces now
+    int64_t scale = sensorInfo.scale;
+    if (auto metadata = sensor_metadata::find(sensorInfo.sensorPath))
+    {
+        scale = metadata->scale;
+    }
+
+    double value =
+        std::get<T>(propValue) * std::pow(10, scale - sensorInfo.exponentR);
 
     auto rawData = static_cast<uint8_t>((value - sensorInfo.scaledOffset) /
                                         sensorInfo.coefficientM);
@@ -223,6 +344,23 @@ IpmiUpdateData makeDbusMsg(const std::string& updateInterface,
                            const std::string& command,
                            const std::string& sensorInterface);
 
+/** @brief Write a property of a sensor object behind the response
+ *
+ *  The host is answered before the property is written. Updates of a
+ *  property that arrive while its previous write is in flight are
+ *  coalesced, so only the latest value is written, and failed writes are
+ *  logged. Without the asio connection the write is synchronous.
+ *
+ *  @param[in] sensorInfo - sensor d-bus info
+ *  @param[in] interface - interface of the property
+ *  @param[in] property - the property to write
+ *  @param[in] value - the new value
+ *  @return a IPMI error code
+ */
+ipmi_ret_t updateProperty(const Info& sensorInfo,
+                          const DbusInterface& interface,
+                          const DbusProperty& property, const Value& value);
+
 /** @brief Update d-bus based on assertion type sensor data
  *  @param[in] cmdData - input sensor data
  *  @param[in] sensorInfo - sensor d-bus info
@@ -241,20 +379,19 @@ template <typename T>
 ipmi_ret_t readingAssertion(const SetSensorReadingReq& cmdData,
                             const Info& sensorInfo)
 {
-    auto msg =
-        makeDbusMsg("org.freedesktop.DBus.Properties", sensorInfo.sensorPath,
-                    "Set", sensorInfo.sensorInterface);
-
     const auto& interface = sensorInfo.propertyInterfaces.begin();
-    msg.append(interface->first);
     for (const auto& property : interface->second)
     {
-        msg.append(property.first);
-        sdbusplus::message::variant<T> value =
-            (cmdData.assertOffset8_14 << 8) | cmdData.assertOffset0_7;
-        msg.append(value);
+        Value value = static_cast<T>((cmdData.assertOffset8_14 << 8) |
+                                     cmdData.assertOffset0_7);
+        auto rc =
+            updateProperty(sensorInfo, interface->first, property.first, value);
+        if (rc)
+        {
+            return rc;
+        }
     }
-    return updateToDbus(msg);
+    return IPMI_CC_OK;
 }
 
 /** @brief Update d-bus based on a discrete reading
@@ -271,20 +408,17 @@ ipmi_ret_t readingData(const SetSensorReadingReq& cmdData,
 
     raw_value *= std::pow(10, sensorInfo.exponentR - sensorInfo.scale);
 
-    auto msg =
-        makeDbusMsg("org.freedesktop.DBus.Properties", sensorInfo.sensorPath,
-                    "Set", sensorInfo.sensorInterface);
-
     const auto& interface = sensorInfo.propertyInterfaces.begin();
-    msg.append(interface->first);
-
     for (const auto& property : interface->second)
     {
-        msg.append(property.first);
-        sdbusplus::message::variant<T> value = raw_value;
-        msg.append(value);
+        auto rc = updateProperty(sensorInfo, interface->first, property.first,
+                                 Value(raw_value));
+        if (rc)
+        {
+            return rc;
+        }
     }
-    return updateToDbus(msg);
+    return IPMI_CC_OK;
 }
 
 /** @brief Update d-bus based on eventdata type sensor data
@@ -366,11 +500,12 @@ namespace get
  *  @brief Map the Dbus info to sensor's assertion status in the Get sensor
  *         reading command response.
  *
+ *  @param[in] ctx - context of the Get Sensor Reading request.
  *  @param[in] sensorInfo - Dbus info related to sensor.
  *
  *  @return Response for get sensor reading command.
  */
-GetSensorResponse assertion(const Info& sensorInfo);
+GetSensorResponse assertion(const Context::ptr& ctx, const Info& sensorInfo);
 
 } // namespace get
 
@@ -1,26 +1,34 @@
 #include "sensorhandler.hpp"
 
 #include "fruread.hpp"
+#include "sdr-repository.hpp"
+#include "sensordatahandler.hpp"
 
 #include <mapper.h>
 #include <systemd/sd-bus.h>
 
+#include <algorithm>
+#include <array>
 #include <bitset>
 #include <cmath>
 #include <cstring>
 #include <ipmid/api.hpp>
+#include <ipmid/log-limit.hpp>
+#include <ipmid/oemopenbmc.hpp>
 #include <ipmid/types.hpp>
 #include <ipmid/utils.hpp>
+#include <ipmid/warmup.hpp>
+#include <limits>
+#include <memory>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/message/types.hpp>
-#include <set>
+#include <string>
+#include <tuple>
+#include <user_channel/channel_layer.hpp>
+#include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
-#include <xyz/openbmc_project/Sensor/Value/server.hpp>
-
-static constexpr uint8_t fruInventoryDevice = 0x10;
-static constexpr uint8_t IPMIFruInventory = 0x02;
-static constexpr uint8_t BMCSlaveAddress = 0x20;
 
 extern int updateSensorRecordFromSSRAESC(const void*);
 extern sd_bus* bus;
@@ -81,13 +89,71 @@ int get_bus_for_path(const char* path, char** busname)
     return mapper_get_service(bus, path, busname);
 }
 
+namespace
+{
+
+/* bus names of the sensors, by sensor number; an empty name has not been
+ * resolved yet */
+std::array<std::string, std::numeric_limits<uint8_t>::max() + 1> busNames;
+
+std::unique_ptr<sdbusplus::bus::match::match> busNamesOwnerChanged;
+
+/** @brief Get the bus name of a sensor, through the mapper on first use
+ *
+ *  The names are kept until the owner of any bus name changes, so the
+ *  events a BIOS reports while booting resolve each sensor only once.
+ *
+ *  @param[in] num - sensor number
+ *  @param[in] path - object path of the sensor
+ *
+ *  @return the bus name or an empty string if the mapper failed
+ */
+std::string getSensorBusName(uint8_t num, const std::string& path)
+{
+    if (!busNames[num].empty())
+    {
+        return busNames[num];
+    }
+
+    char* busname = nullptr;
+    int rc = get_bus_for_path(path.c_str(), &busname);
+    if (rc < 0)
+    {
+        std::fprintf(stderr, "Failed to get %s busname: %s\n", path.c_str(),
+                     busname);
+        free(busname);
+        return std::string();
+    }
+    std::string name = busname;
+    free(busname);
+
+    auto sdbus = getSdBus();
+    if (!busNamesOwnerChanged && sdbus)
+    {
+        busNamesOwnerChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *sdbus, sdbusplus::bus::match::rules::nameOwnerChanged(),
+            [](sdbusplus::message::message&) {
+                for (auto& busName : busNames)
+                {
+                    busName.clear();
+                }
+            });
+    }
+    // only keep the name when a signal can tell us it went stale
+    if (busNamesOwnerChanged)
+    {
+        busNames[num] = name;
+    }
+    return name;
+}
+
+} // namespace
+
 // Use a lookup table to find the interface name of a specific sensor
 // This will be used until an alternative is found.  this is the first
 // step for mapping IPMI
 int find_openbmc_path(uint8_t num, dbus_interface_t* interface)
 {
-    int rc;
-
     const auto& sensor_it = sensors.find(num);
     if (sensor_it == sensors.end())
     {
@@ -97,17 +163,14 @@ int find_openbmc_path(uint8_t num, dbus_interface_t* interface)
 
     const auto& info = sensor_it->second;
 
-    char* busname = nullptr;
-    rc = get_bus_for_path(info.sensorPath.c_str(), &busname);
-    if (rc < 0)
+    std::string busname = getSensorBusName(num, info.sensorPath);
+    if (busname.empty())
     {
-        std::fprintf(stderr, "Failed to get %s busname: %s\n",
-                     info.sensorPath.c_str(), busname);
-        goto final;
+        return -ENXIO;
     }
 
     interface->sensortype = info.sensorType;
-    strcpy(interface->bus, busname);
+    strcpy(interface->bus, busname.c_str());
     strcpy(interface->path, info.sensorPath.c_str());
     // Take the interface name from the beginning of the DbusInterfaceMap. This
     // works for the Value interface but may not suffice for more complex
@@ -117,9 +180,7 @@ int find_openbmc_path(uint8_t num, dbus_interface_t* interface)
            info.propertyInterfaces.begin()->first.c_str());
     interface->sensornumber = num;
 
-final:
-    free(busname);
-    return rc;
+    return 0;
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -312,16 +373,6 @@ ipmi_ret_t ipmi_sen_get_sensor_type(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return rc;
 }
 
-const std::set<std::string> analogSensorInterfaces = {
-    "xyz.openbmc_project.Sensor.Value",
-    "xyz.openbmc_project.Control.FanPwm",
-};
-
-bool isAnalogSensor(const std::string& interface)
-{
-    return (analogSensorInterfaces.count(interface));
-}
-
 ipmi_ret_t setSensorReading(void* request)
 {
     ipmi::sensor::SetSensorReadingReq cmdData =
@@ -339,16 +390,17 @@ ipmi_ret_t setSensorReading(void* request)
         if (ipmi::sensor::Mutability::Write !=
             (iter->second.mutability & ipmi::sensor::Mutability::Write))
         {
-            log<level::ERR>("Sensor Set operation is not allowed",
-                            entry("SENSOR_NUM=%d", cmdData.number));
+            ipmi::logLimited<level::ERR>(
+                "Sensor Set operation is not allowed",
+                entry("SENSOR_NUM=%d", cmdData.number));
             return IPMI_CC_ILLEGAL_COMMAND;
         }
         return iter->second.updateFunc(cmdData, iter->second);
     }
     catch (InternalFailure& e)
     {
-        log<level::ERR>("Set sensor failed",
-                        entry("SENSOR_NUM=%d", cmdData.number));
+        ipmi::logLimited<level::ERR>("Set sensor failed",
+                                     entry("SENSOR_NUM=%d", cmdData.number));
         commit<InternalFailure>();
     }
     catch (const std::runtime_error& e)
@@ -385,53 +437,225 @@ ipmi_ret_t ipmi_sen_set_sensor(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return ipmiRC;
 }
 
-ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                       ipmi_request_t request,
-                                       ipmi_response_t response,
-                                       ipmi_data_len_t data_len,
-                                       ipmi_context_t context)
+/** @brief Read a sensor, answering from the reading cache when it can
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] sensorNum - sensor number
+ *  @param[in] info - the sensor
+ *
+ *  @returns the Get Sensor Reading response of the sensor; a sensor that
+ *           cannot be read reports scanning disabled and no states
+ */
+static ipmi::sensor::GetReadingResponse
+    readSensor(ipmi::Context::ptr& ctx, uint8_t sensorNum,
+               const ipmi::sensor::Info& info)
 {
-    auto reqptr = static_cast<sensor_data_t*>(request);
-    auto resp = static_cast<sensorreadingresp_t*>(response);
-    ipmi::sensor::GetSensorResponse getResponse{};
     static constexpr auto scanningEnabledBit = 6;
 
-    const auto iter = sensors.find(reqptr->sennum);
+    try
+    {
+        // readings are answered from the cache until the sensor changes
+        auto& cache = ipmi::sensor::ReadingCache::instance();
+        ipmi::sensor::GetSensorResponse getResponse;
+        if (const auto* cached = cache.find(sensorNum))
+        {
+            getResponse = *cached;
+        }
+        else
+        {
+            uint64_t token = cache.watch(sensorNum, info);
+            getResponse = info.getFunc(ctx, info);
+            cache.fill(sensorNum, token, getResponse);
+        }
+        auto reading = reinterpret_cast<ipmi::sensor::GetReadingResponse*>(
+            getResponse.data());
+        reading->operation = 1 << scanningEnabledBit;
+        return *reading;
+    }
+    catch (const std::exception& e)
+    {
+        return ipmi::sensor::GetReadingResponse{};
+    }
+}
+
+static bool isReadable(const ipmi::sensor::Info& info)
+{
+    return ipmi::sensor::Mutability::Read ==
+           (info.mutability & ipmi::sensor::Mutability::Read);
+}
+
+/** @brief implements the get sensor reading command
+ *
+ *  The D-Bus lookups suspend the request instead of blocking ipmid, so a
+ *  slow sensor daemon no longer stalls every other command.
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] sensorNum - sensor number
+ *
+ *  @returns IPMI completion code plus response data
+ *   - reading - sensor reading
+ *   - operation - sensor scanning status / reading state
+ *   - assertOffset0_7 - discrete assertion states(0-7)
+ *   - assertOffset8_14 - discrete assertion states(8-14)
+ */
+ipmi::RspType<uint8_t, // reading
+              uint8_t, // operation
+              uint8_t, // assertOffset0_7
+              uint8_t  // assertOffset8_14
+              >
+    ipmiSensorGetSensorReading(ipmi::Context::ptr ctx, uint8_t sensorNum)
+{
+    const auto iter = sensors.find(sensorNum);
     if (iter == sensors.end())
     {
-        return IPMI_CC_SENSOR_INVALID;
+        return ipmi::responseSensorInvalid();
     }
-    if (ipmi::sensor::Mutability::Read !=
-        (iter->second.mutability & ipmi::sensor::Mutability::Read))
+    if (!isReadable(iter->second))
     {
-        return IPMI_CC_ILLEGAL_COMMAND;
+        return ipmi::responseIllegalCommand();
     }
 
-    try
+    auto reading = readSensor(ctx, sensorNum, iter->second);
+    return ipmi::responseSuccess(reading.reading, reading.operation,
+                                 reading.assertOffset0_7,
+                                 reading.assertOffset8_14);
+}
+
+using SensorReadingEntry = std::tuple<uint8_t, // sensor number
+                                      uint8_t, // reading
+                                      uint8_t, // operation
+                                      uint8_t, // assertOffset0_7
+                                      uint8_t  // assertOffset8_14
+                                      >;
+
+/** @brief implements the OpenBMC OEM Get Multiple Sensor Readings command
+ *
+ *  Reads every readable sensor numbered from firstSensor to lastSensor in
+ *  one request. The response stops early when the next reading would not
+ *  fit in the channel's maximum transfer size; the caller continues from
+ *  the sensor after the last one returned.
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] oen - OEM number; must be the OpenBMC OEM number
+ *  @param[in] firstSensor - first sensor number to read
+ *  @param[in] lastSensor - last sensor number to read
+ *
+ *  @returns IPMI completion code plus response data
+ *   - OEM number
+ *   - for each sensor read: the sensor number followed by the Get Sensor
+ *     Reading response data of the sensor
+ */
+ipmi::RspType<uint24_t,                       // OEM number
+              std::vector<SensorReadingEntry> // readings
+              >
+    ipmiOemGetMultipleSensorReadings(ipmi::Context::ptr ctx, uint24_t oen,
+                                     uint8_t firstSensor, uint8_t lastSensor)
+{
+    if (oen != oem::obmcOemNumber || firstSensor > lastSensor)
     {
-        getResponse = iter->second.getFunc(iter->second);
-        *data_len = getResponse.size();
-        std::memcpy(resp, getResponse.data(), *data_len);
-        resp->operation = 1 << scanningEnabledBit;
-        return IPMI_CC_OK;
+        return ipmi::responseInvalidFieldRequest();
     }
-    catch (const std::exception& e)
+
+    // the completion code and the OEM number share the response
+    constexpr size_t headerSize = 1 + 3;
+    size_t maxSize = ipmi::getChannelMaxTransferSize(ctx->channel);
+    constexpr size_t entrySize = 1 + sizeof(ipmi::sensor::GetReadingResponse);
+    size_t maxEntries =
+        maxSize > headerSize ? (maxSize - headerSize) / entrySize : 0;
+
+    // the sensors are kept in sensor number order
+    auto iter = std::lower_bound(sensors.begin(), sensors.end(), firstSensor,
+                                 [](const auto& sensor, uint8_t num) {
+                                     return sensor.first < num;
+                                 });
+    std::vector<SensorReadingEntry> readings;
+    for (; iter != sensors.end() && iter->first <= lastSensor &&
+           readings.size() < maxEntries;
+         ++iter)
     {
-        *data_len = getResponse.size();
-        std::memcpy(resp, getResponse.data(), *data_len);
-        return IPMI_CC_OK;
+        if (!isReadable(iter->second))
+        {
+            continue;
+        }
+        auto reading = readSensor(ctx, iter->first, iter->second);
+        readings.emplace_back(iter->first, reading.reading, reading.operation,
+                              reading.assertOffset0_7,
+                              reading.assertOffset8_14);
     }
+    return ipmi::responseSuccess(oen, readings);
 }
 
-void getSensorThresholds(uint8_t sensorNum,
-                         get_sdr::GetSensorThresholdsResponse* response)
+namespace
 {
-    constexpr auto warningThreshIntf =
-        "xyz.openbmc_project.Sensor.Threshold.Warning";
-    constexpr auto criticalThreshIntf =
-        "xyz.openbmc_project.Sensor.Threshold.Critical";
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+constexpr auto warningThreshIntf =
+    "xyz.openbmc_project.Sensor.Threshold.Warning";
+constexpr auto criticalThreshIntf =
+    "xyz.openbmc_project.Sensor.Threshold.Critical";
+
+struct ThresholdEntry
+{
+    get_sdr::GetSensorThresholdsResponse response{};
+    bool valid = false;
+    std::vector<std::unique_ptr<sdbusplus::bus::match::match>> changed;
+};
+
+/* scaled thresholds of the sensors, by sensor number; kept until the
+ * threshold interfaces of the sensor signal a change */
+std::array<ThresholdEntry, std::numeric_limits<uint8_t>::max() + 1>
+    thresholds;
+
+std::unique_ptr<sdbusplus::bus::match::match> thresholdsOwnerChanged;
+
+/** @brief Start watching the thresholds of a sensor
+ *
+ *  @return false if there is no connection to watch them on, in which case
+ *          they must not be cached
+ */
+bool watchThresholds(uint8_t sensorNum, const std::string& path)
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    auto sdbus = getSdBus();
+    if (!sdbus)
+    {
+        return false;
+    }
+    if (!thresholdsOwnerChanged)
+    {
+        thresholdsOwnerChanged = std::make_unique<sdbusplus::bus::match::match>(
+            *sdbus, rules::nameOwnerChanged(),
+            [](sdbusplus::message::message&) {
+                for (auto& entry : thresholds)
+                {
+                    entry.valid = false;
+                }
+            });
+    }
+
+    ThresholdEntry& entry = thresholds[sensorNum];
+    if (entry.changed.empty())
+    {
+        for (const char* interface : {warningThreshIntf, criticalThreshIntf})
+        {
+            entry.changed.emplace_back(
+                std::make_unique<sdbusplus::bus::match::match>(
+                    *sdbus, rules::propertiesChanged(path, interface),
+                    [&entry](sdbusplus::message::message&) {
+                        entry.valid = false;
+                    }));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+static void
+    readSensorThresholds(uint8_t sensorNum,
+                         get_sdr::GetSensorThresholdsResponse* response)
+{
+    sdbusplus::bus::bus& bus = getBus();
 
     const auto iter = sensors.find(sensorNum);
     const auto info = iter->second;
@@ -490,6 +714,29 @@ void getSensorThresholds(uint8_t sensorNum,
     }
 }
 
+void getSensorThresholds(uint8_t sensorNum,
+                         get_sdr::GetSensorThresholdsResponse* response)
+{
+    ThresholdEntry& entry = thresholds[sensorNum];
+    if (entry.valid)
+    {
+        *response = entry.response;
+        return;
+    }
+
+    bool cache = watchThresholds(sensorNum, sensors.at(sensorNum).sensorPath);
+    get_sdr::GetSensorThresholdsResponse fetched{};
+    readSensorThresholds(sensorNum, &fetched);
+    *response = fetched;
+    if (cache)
+    {
+        // a change signalled while fetching is only dispatched after this,
+        // so it still invalidates what is stored here
+        entry.response = fetched;
+        entry.valid = true;
+    }
+}
+
 ipmi_ret_t ipmi_sen_get_sensor_thresholds(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                           ipmi_request_t request,
                                           ipmi_response_t response,
@@ -578,6 +825,14 @@ ipmi_ret_t ipmi_sen_get_sdr_info(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     response::set_lun_not_present(3, &(resp->luns_and_dynamic_population));
     response::set_static_population(&(resp->luns_and_dynamic_population));
 
+    // only moves when the records change, so hosts can keep their copy
+    uint32_t changed =
+        ipmi::sdr::Repository::instance().changes().additionTimestamp;
+    for (size_t i = 0; i < sizeof(resp->population_change); i++)
+    {
+        resp->population_change[i] = changed >> (8 * i);
+    }
+
     *data_len = SDR_INFO_RESP_SIZE;
 
     return IPMI_CC_OK;
@@ -598,351 +853,50 @@ ipmi_ret_t ipmi_sen_reserve_sdr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return IPMI_CC_OK;
 }
 
-void setUnitFieldsForObject(const ipmi::sensor::Info* info,
-                            get_sdr::SensorDataFullRecordBody* body)
-{
-    namespace server = sdbusplus::xyz::openbmc_project::Sensor::server;
-    try
-    {
-        auto unit = server::Value::convertUnitFromString(info->unit);
-        // Unit strings defined in
-        // phosphor-dbus-interfaces/xyz/openbmc_project/Sensor/Value.interface.yaml
-        switch (unit)
-        {
-            case server::Value::Unit::DegreesC:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_DEGREES_C;
-                break;
-            case server::Value::Unit::RPMS:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_RPM;
-                break;
-            case server::Value::Unit::Volts:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_VOLTS;
-                break;
-            case server::Value::Unit::Meters:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_METERS;
-                break;
-            case server::Value::Unit::Amperes:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_AMPERES;
-                break;
-            case server::Value::Unit::Joules:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_JOULES;
-                break;
-            case server::Value::Unit::Watts:
-                body->sensor_units_2_base = get_sdr::SENSOR_UNIT_WATTS;
-                break;
-            default:
-                // Cannot be hit.
-                std::fprintf(stderr, "Unknown value unit type: = %s\n",
-                             info->unit.c_str());
-        }
-    }
-    catch (const sdbusplus::exception::InvalidEnumString& e)
-    {
-        log<level::WARNING>("Warning: no unit provided for sensor!");
-    }
-}
-
-ipmi_ret_t populate_record_from_dbus(get_sdr::SensorDataFullRecordBody* body,
-                                     const ipmi::sensor::Info* info,
-                                     ipmi_data_len_t data_len)
-{
-    /* Functional sensor case */
-    if (isAnalogSensor(info->propertyInterfaces.begin()->first))
-    {
-
-        body->sensor_units_1 = 0; // unsigned, no rate, no modifier, not a %
-
-        /* Unit info */
-        setUnitFieldsForObject(info, body);
-
-        get_sdr::body::set_b(info->coefficientB, body);
-        get_sdr::body::set_m(info->coefficientM, body);
-        get_sdr::body::set_b_exp(info->exponentB, body);
-        get_sdr::body::set_r_exp(info->exponentR, body);
-
-        get_sdr::body::set_id_type(0b00, body); // 00 = unicode
-    }
-
-    /* ID string */
-    auto id_string = info->sensorNameFunc(*info);
-
-    if (id_string.length() > FULL_RECORD_ID_STR_MAX_LENGTH)
-    {
-        get_sdr::body::set_id_strlen(FULL_RECORD_ID_STR_MAX_LENGTH, body);
-    }
-    else
-    {
-        get_sdr::body::set_id_strlen(id_string.length(), body);
-    }
-    strncpy(body->id_string, id_string.c_str(),
-            get_sdr::body::get_id_strlen(body));
-
-    return IPMI_CC_OK;
-};
-
-ipmi_ret_t ipmi_fru_get_sdr(ipmi_request_t request, ipmi_response_t response,
-                            ipmi_data_len_t data_len)
+ipmi_ret_t ipmi_sen_get_sdr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                            ipmi_request_t request, ipmi_response_t response,
+                            ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    auto req = reinterpret_cast<get_sdr::GetSdrReq*>(request);
-    auto resp = reinterpret_cast<get_sdr::GetSdrResp*>(response);
-    get_sdr::SensorDataFruRecord record{};
-    auto dataLength = 0;
-
-    auto fru = frus.begin();
-    uint8_t fruID{};
-    auto recordID = get_sdr::request::get_record_id(req);
-
-    fruID = recordID - FRU_RECORD_ID_START;
-    fru = frus.find(fruID);
-    if (fru == frus.end())
-    {
-        return IPMI_CC_SENSOR_INVALID;
-    }
-
-    /* Header */
-    get_sdr::header::set_record_id(recordID, &(record.header));
-    record.header.sdr_version = SDR_VERSION; // Based on IPMI Spec v2.0 rev 1.1
-    record.header.record_type = get_sdr::SENSOR_DATA_FRU_RECORD;
-    record.header.record_length = sizeof(record.key) + sizeof(record.body);
-
-    /* Key */
-    record.key.fruID = fruID;
-    record.key.accessLun |= IPMI_LOGICAL_FRU;
-    record.key.deviceAddress = BMCSlaveAddress;
-
-    /* Body */
-    record.body.entityID = fru->second[0].entityID;
-    record.body.entityInstance = fru->second[0].entityInstance;
-    record.body.deviceType = fruInventoryDevice;
-    record.body.deviceTypeModifier = IPMIFruInventory;
-
-    /* Device ID string */
-    auto deviceID =
-        fru->second[0].path.substr(fru->second[0].path.find_last_of('/') + 1,
-                                   fru->second[0].path.length());
-
-    if (deviceID.length() > get_sdr::FRU_RECORD_DEVICE_ID_MAX_LENGTH)
-    {
-        get_sdr::body::set_device_id_strlen(
-            get_sdr::FRU_RECORD_DEVICE_ID_MAX_LENGTH, &(record.body));
-    }
-    else
-    {
-        get_sdr::body::set_device_id_strlen(deviceID.length(), &(record.body));
-    }
-
-    strncpy(record.body.deviceID, deviceID.c_str(),
-            get_sdr::body::get_device_id_strlen(&(record.body)));
-
-    if (++fru == frus.end())
-    {
-        // we have reached till end of fru, so assign the next record id to
-        // 512(Max fru ID = 511) + Entity Record ID(may start with 0).
-        auto next_record_id =
-            (entities.size()) ? entities.begin()->first + ENTITY_RECORD_ID_START
-                              : END_OF_RECORD;
-        get_sdr::response::set_next_record_id(next_record_id, resp);
-    }
-    else
-    {
-        get_sdr::response::set_next_record_id(
-            (FRU_RECORD_ID_START + fru->first), resp);
-    }
-
-    // Check for invalid offset size
-    if (req->offset > sizeof(record))
+    get_sdr::GetSdrReq* req = (get_sdr::GetSdrReq*)request;
+    get_sdr::GetSdrResp* resp = (get_sdr::GetSdrResp*)response;
+    if (req == NULL)
     {
-        return IPMI_CC_PARM_OUT_OF_RANGE;
+        return IPMI_CC_OK;
     }
 
-    dataLength = std::min(static_cast<size_t>(req->bytes_to_read),
-                          sizeof(record) - req->offset);
-
-    std::memcpy(resp->record_data,
-                reinterpret_cast<uint8_t*>(&record) + req->offset, dataLength);
-
-    *data_len = dataLength;
-    *data_len += 2; // additional 2 bytes for next record ID
-
-    return IPMI_CC_OK;
-}
-
-ipmi_ret_t ipmi_entity_get_sdr(ipmi_request_t request, ipmi_response_t response,
-                               ipmi_data_len_t data_len)
-{
-    auto req = reinterpret_cast<get_sdr::GetSdrReq*>(request);
-    auto resp = reinterpret_cast<get_sdr::GetSdrResp*>(response);
-    get_sdr::SensorDataEntityRecord record{};
-    auto dataLength = 0;
-
-    auto entity = entities.begin();
-    uint8_t entityRecordID;
-    auto recordID = get_sdr::request::get_record_id(req);
-
-    entityRecordID = recordID - ENTITY_RECORD_ID_START;
-    entity = entities.find(entityRecordID);
-    if (entity == entities.end())
+    // The records are serialized once into the SDR repository image; the
+    // host reads each of them in several parts, which are copied out of it.
+    // At the beginning of a scan, the host side will send us id=0.
+    auto& repository = ipmi::sdr::Repository::instance();
+    const ipmi::sdr::Record* record =
+        repository.find(get_sdr::request::get_record_id(req));
+    if (!record)
     {
         return IPMI_CC_SENSOR_INVALID;
     }
 
-    /* Header */
-    get_sdr::header::set_record_id(recordID, &(record.header));
-    record.header.sdr_version = SDR_VERSION; // Based on IPMI Spec v2.0 rev 1.1
-    record.header.record_type = get_sdr::SENSOR_DATA_ENTITY_RECORD;
-    record.header.record_length = sizeof(record.key) + sizeof(record.body);
-
-    /* Key */
-    record.key.containerEntityId = entity->second.containerEntityId;
-    record.key.containerEntityInstance = entity->second.containerEntityInstance;
-    get_sdr::key::set_flags(entity->second.isList, entity->second.isLinked,
-                            &(record.key));
-    record.key.entityId1 = entity->second.containedEntities[0].first;
-    record.key.entityInstance1 = entity->second.containedEntities[0].second;
-
-    /* Body */
-    record.body.entityId2 = entity->second.containedEntities[1].first;
-    record.body.entityInstance2 = entity->second.containedEntities[1].second;
-    record.body.entityId3 = entity->second.containedEntities[2].first;
-    record.body.entityInstance3 = entity->second.containedEntities[2].second;
-    record.body.entityId4 = entity->second.containedEntities[3].first;
-    record.body.entityInstance4 = entity->second.containedEntities[3].second;
-
-    if (++entity == entities.end())
-    {
-        get_sdr::response::set_next_record_id(END_OF_RECORD,
-                                              resp); // last record
-    }
-    else
-    {
-        get_sdr::response::set_next_record_id(
-            (ENTITY_RECORD_ID_START + entity->first), resp);
-    }
+    get_sdr::response::set_next_record_id(record->next, resp);
 
-    // Check for invalid offset size
-    if (req->offset > sizeof(record))
+    if (req->offset > record->size)
     {
         return IPMI_CC_PARM_OUT_OF_RANGE;
     }
 
-    dataLength = std::min(static_cast<size_t>(req->bytes_to_read),
-                          sizeof(record) - req->offset);
+    // data_len will ultimately be the size of the record, plus
+    // the size of the next record ID:
+    *data_len = std::min(static_cast<size_t>(req->bytes_to_read),
+                         record->size - req->offset);
 
-    std::memcpy(resp->record_data,
-                reinterpret_cast<uint8_t*>(&record) + req->offset, dataLength);
+    std::memcpy(resp->record_data, repository.data(*record) + req->offset,
+                *data_len);
 
-    *data_len = dataLength;
-    *data_len += 2; // additional 2 bytes for next record ID
+    // data_len should include the LSB and MSB:
+    *data_len +=
+        sizeof(resp->next_record_id_lsb) + sizeof(resp->next_record_id_msb);
 
     return IPMI_CC_OK;
 }
 
-ipmi_ret_t ipmi_sen_get_sdr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                            ipmi_request_t request, ipmi_response_t response,
-                            ipmi_data_len_t data_len, ipmi_context_t context)
-{
-    ipmi_ret_t ret = IPMI_CC_OK;
-    get_sdr::GetSdrReq* req = (get_sdr::GetSdrReq*)request;
-    get_sdr::GetSdrResp* resp = (get_sdr::GetSdrResp*)response;
-    get_sdr::SensorDataFullRecord record = {0};
-    if (req != NULL)
-    {
-        // Note: we use an iterator so we can provide the next ID at the end of
-        // the call.
-        auto sensor = sensors.begin();
-        auto recordID = get_sdr::request::get_record_id(req);
-
-        // At the beginning of a scan, the host side will send us id=0.
-        if (recordID != 0)
-        {
-            // recordID 0 to 255 means it is a FULL record.
-            // recordID 256 to 511 means it is a FRU record.
-            // recordID greater then 511 means it is a Entity Association
-            // record. Currently we are supporting three record types: FULL
-            // record, FRU record and Enttiy Association record.
-            if (recordID >= ENTITY_RECORD_ID_START)
-            {
-                return ipmi_entity_get_sdr(request, response, data_len);
-            }
-            else if (recordID >= FRU_RECORD_ID_START &&
-                     recordID < ENTITY_RECORD_ID_START)
-            {
-                return ipmi_fru_get_sdr(request, response, data_len);
-            }
-            else
-            {
-                sensor = sensors.find(recordID);
-                if (sensor == sensors.end())
-                {
-                    return IPMI_CC_SENSOR_INVALID;
-                }
-            }
-        }
-
-        uint8_t sensor_id = sensor->first;
-
-        /* Header */
-        get_sdr::header::set_record_id(sensor_id, &(record.header));
-        record.header.sdr_version = 0x51; // Based on IPMI Spec v2.0 rev 1.1
-        record.header.record_type = get_sdr::SENSOR_DATA_FULL_RECORD;
-        record.header.record_length = sizeof(get_sdr::SensorDataFullRecord);
-
-        /* Key */
-        get_sdr::key::set_owner_id_bmc(&(record.key));
-        record.key.sensor_number = sensor_id;
-
-        /* Body */
-        record.body.entity_id = sensor->second.entityType;
-        record.body.sensor_type = sensor->second.sensorType;
-        record.body.event_reading_type = sensor->second.sensorReadingType;
-        record.body.entity_instance = sensor->second.instance;
-        if (ipmi::sensor::Mutability::Write ==
-            (sensor->second.mutability & ipmi::sensor::Mutability::Write))
-        {
-            get_sdr::body::init_settable_state(true, &(record.body));
-        }
-
-        // Set the type-specific details given the DBus interface
-        ret = populate_record_from_dbus(&(record.body), &(sensor->second),
-                                        data_len);
-
-        if (++sensor == sensors.end())
-        {
-            // we have reached till end of sensor, so assign the next record id
-            // to 256(Max Sensor ID = 255) + FRU ID(may start with 0).
-            auto next_record_id =
-                (frus.size()) ? frus.begin()->first + FRU_RECORD_ID_START
-                              : END_OF_RECORD;
-
-            get_sdr::response::set_next_record_id(next_record_id, resp);
-        }
-        else
-        {
-            get_sdr::response::set_next_record_id(sensor->first, resp);
-        }
-
-        if (req->offset > sizeof(record))
-        {
-            return IPMI_CC_PARM_OUT_OF_RANGE;
-        }
-
-        // data_len will ultimately be the size of the record, plus
-        // the size of the next record ID:
-        *data_len = std::min(static_cast<size_t>(req->bytes_to_read),
-                             sizeof(record) - req->offset);
-
-        std::memcpy(resp->record_data,
-                    reinterpret_cast<uint8_t*>(&record) + req->offset,
-                    *data_len);
-
-        // data_len should include the LSB and MSB:
-        *data_len +=
-            sizeof(resp->next_record_id_lsb) + sizeof(resp->next_record_id_msb);
-    }
-
-    return ret;
-}
-
 static bool isFromSystemChannel()
 {
     // TODO we could not figure out where the request is from based on IPMI
@@ -1014,7 +968,7 @@ ipmi_ret_t ipmicmdPlatformEvent(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     assert = req->eventDirectionType & directionMask ? false : true;
     std::vector<uint8_t> eventData(req->data, req->data + count);
 
-    sdbusplus::bus::bus dbus(bus);
+    sdbusplus::bus::bus& dbus = getBus();
     std::string service =
         ipmi::getService(dbus, ipmiSELAddInterface, ipmiSELPath);
     sdbusplus::message::message writeSEL = dbus.new_method_call(
@@ -1051,8 +1005,14 @@ void register_netfn_sen_functions()
                            ipmi_sen_set_sensor, PRIVILEGE_OPERATOR);
 
     // <Get Sensor Reading>
-    ipmi_register_callback(NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, nullptr,
-                           ipmi_sen_get_sensor_reading, PRIVILEGE_USER);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnSensor,
+                          ipmi::sensor_event::cmdGetSensorReading,
+                          ipmi::Privilege::User, ipmiSensorGetSensorReading);
+
+    // <Get Multiple Sensor Readings>
+    ipmi::registerOemHandler(ipmi::prioOpenBmcBase, oem::obmcOemNumber,
+                             oem::multiSensorReadingCmd, ipmi::Privilege::User,
+                             ipmiOemGetMultipleSensorReadings);
 
     // <Reserve Device SDR Repository>
     ipmi_register_callback(NETFUN_SENSOR, IPMI_CMD_RESERVE_DEVICE_SDR_REPO,
@@ -1071,5 +1031,19 @@ void register_netfn_sen_functions()
                            nullptr, ipmi_sen_get_sensor_thresholds,
                            PRIVILEGE_USER);
 
+    // build the SDR image and fetch the sensors a host reads first, once
+    // ipmid is running
+    ipmi::warmup::add("sdr image", [](ipmi::Context::ptr) {
+        ipmi::sdr::Repository::instance().changes();
+    });
+    for (const auto& sensor : sensors)
+    {
+        const ipmi::sensor::Info& info = sensor.second;
+        ipmi::warmup::add("sensor " + info.sensorPath,
+                          [&info](ipmi::Context::ptr ctx) {
+                              ipmi::sensor::get::warm(ctx, info);
+                          });
+    }
+
     return;
 }
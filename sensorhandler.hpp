@@ -109,7 +109,7 @@ inline bool get_count(void* req)
 
 namespace response
 {
-#define SDR_INFO_RESP_SIZE 2
+#define SDR_INFO_RESP_SIZE 6
 inline void set_lun_present(int lun, uint8_t* resp)
 {
     *resp |= 1 << lun;
@@ -132,7 +132,8 @@ struct GetSdrInfoResp
 {
     uint8_t count;
     uint8_t luns_and_dynamic_population;
-};
+    uint8_t population_change[4]; //< Sensor population change, LS first
+} __attribute__((packed));
 
 } // namespace get_sdr_info
 
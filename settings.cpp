@@ -34,10 +34,33 @@ Objects::Objects(sdbusplus::bus::bus& bus,
         elog<InternalFailure>();
     }
 
-    using Interfaces = std::vector<Interface>;
-    using MapperResponse = std::map<Path, std::map<Service, Interfaces>>;
     MapperResponse result;
     response.read(result);
+    load(result);
+}
+
+Objects::Objects(sdbusplus::bus::bus& bus,
+                 const std::vector<Interface>& filter,
+                 boost::asio::yield_context yield) :
+    bus(bus)
+{
+    auto depth = 0;
+
+    boost::system::error_code ec;
+    auto result = ipmi::getSdBus()->yield_method_call<MapperResponse>(
+        yield, ec, mapperService, mapperPath, mapperIntf, "GetSubTree", root,
+        depth, filter);
+    if (ec)
+    {
+        log<level::ERR>("Error in mapper GetSubTree",
+                        entry("ERROR=%s", ec.message().c_str()));
+        elog<InternalFailure>();
+    }
+    load(result);
+}
+
+void Objects::load(MapperResponse& result)
+{
     if (result.empty())
     {
         log<level::ERR>("Invalid response from mapper");
@@ -47,8 +70,11 @@ Objects::Objects(sdbusplus::bus::bus& bus,
     for (auto& iter : result)
     {
         const auto& path = iter.first;
+        const auto& service = iter.second.begin()->first;
         for (auto& interface : iter.second.begin()->second)
         {
+            // the settings are looked up again on the request path
+            ipmi::cacheService(path, interface, service);
             auto found = map.find(interface);
             if (map.end() != found)
             {
@@ -65,39 +91,17 @@ Objects::Objects(sdbusplus::bus::bus& bus,
 
 Service Objects::service(const Path& path, const Interface& interface) const
 {
-    using Interfaces = std::vector<Interface>;
-    auto mapperCall =
-        bus.new_method_call(mapperService, mapperPath, mapperIntf, "GetObject");
-    mapperCall.append(path);
-    mapperCall.append(Interfaces({interface}));
-
-    auto response = bus.call(mapperCall);
-    if (response.is_method_error())
-    {
-        log<level::ERR>("Error in mapper GetObject");
-        elog<InternalFailure>();
-    }
-
-    std::map<Service, Interfaces> result;
-    response.read(result);
-    if (result.empty())
-    {
-        log<level::ERR>("Invalid response from mapper");
-        elog<InternalFailure>();
-    }
-
-    return result.begin()->first;
+    return ipmi::getService(bus, interface, path);
 }
 
 namespace boot
 {
 
-std::tuple<Path, OneTimeEnabled> setting(const Objects& objects,
-                                         const Interface& iface)
+const Path& setting(const Objects& objects, const Interface& iface,
+                    OneTimeEnabled oneTime)
 {
     constexpr auto bootObjCount = 2;
-    constexpr auto oneTime = "one_time";
-    constexpr auto enabledIntf = "xyz.openbmc_project.Object.Enable";
+    constexpr auto oneTimeName = "one_time";
 
     const std::vector<Path>& paths = objects.map.at(iface);
     auto count = paths.size();
@@ -109,31 +113,40 @@ std::tuple<Path, OneTimeEnabled> setting(const Objects& objects,
         elog<InternalFailure>();
     }
     size_t index = 0;
-    if (std::string::npos == paths[0].rfind(oneTime))
+    if (std::string::npos == paths[0].rfind(oneTimeName))
     {
         index = 1;
     }
-    const Path& oneTimeSetting = paths[index];
-    const Path& regularSetting = paths[!index];
-
-    auto method = objects.bus.new_method_call(
-        objects.service(oneTimeSetting, iface).c_str(), oneTimeSetting.c_str(),
-        ipmi::PROP_INTF, "Get");
-    method.append(enabledIntf, "Enabled");
-    auto reply = objects.bus.call(method);
-    if (reply.is_method_error())
+    return oneTime ? paths[index] : paths[!index];
+}
+
+std::tuple<Path, OneTimeEnabled> setting(const Objects& objects,
+                                         const Interface& iface)
+{
+    constexpr auto enabledIntf = "xyz.openbmc_project.Object.Enable";
+
+    const Path& oneTimeSetting = setting(objects, iface, true);
+
+    // the settings daemon announces its changes with PropertiesChanged, so
+    // the property is read through the ObjectCache
+    bool oneTimeEnabled = false;
+    try
+    {
+        auto enabled = ipmi::getCachedDbusProperty(
+            objects.bus, objects.service(oneTimeSetting, iface),
+            oneTimeSetting, enabledIntf, "Enabled");
+        oneTimeEnabled = std::get<bool>(enabled);
+    }
+    catch (const std::exception& e)
     {
         log<level::ERR>("Error in getting Enabled property",
                         entry("OBJECT=%s", oneTimeSetting.c_str()),
-                        entry("INTERFACE=%s", iface.c_str()));
+                        entry("INTERFACE=%s", iface.c_str()),
+                        entry("ERROR=%s", e.what()));
         elog<InternalFailure>();
     }
-
-    sdbusplus::message::variant<bool> enabled;
-    reply.read(enabled);
-    auto oneTimeEnabled = std::get<bool>(enabled);
-    const Path& setting = oneTimeEnabled ? oneTimeSetting : regularSetting;
-    return std::make_tuple(setting, oneTimeEnabled);
+    return std::make_tuple(setting(objects, iface, oneTimeEnabled),
+                           oneTimeEnabled);
 }
 
 } // namespace boot
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <boost/asio/spawn.hpp>
+#include <map>
 #include <sdbusplus/bus.hpp>
 #include <string>
 #include <tuple>
+#include <vector>
 
 namespace settings
 {
@@ -26,6 +29,20 @@ struct Objects
      *            interested in.
      */
     Objects(sdbusplus::bus::bus& bus, const std::vector<Interface>& filter);
+
+    /** @brief Constructor - fetch settings objects without blocking
+     *
+     *  Same as above, but the mapper call is made on the shared asio
+     *  connection and the coroutine yields until it is answered, so the
+     *  main loop keeps serving requests meanwhile.
+     *
+     * @param[in] bus - The Dbus bus object, kept for the later lookups
+     * @param[in] filter - A vector of settings interfaces the caller is
+     *            interested in.
+     * @param[in] yield - The coroutine to suspend during the mapper call
+     */
+    Objects(sdbusplus::bus::bus& bus, const std::vector<Interface>& filter,
+            boost::asio::yield_context yield);
     Objects(const Objects&) = default;
     Objects& operator=(const Objects&) = default;
     Objects(Objects&&) = delete;
@@ -33,8 +50,10 @@ struct Objects
     ~Objects() = default;
 
     /** @brief Fetch d-bus service, given a path and an interface. The
-     *         service can't be cached because mapper returns unique
-     *         service names.
+     *         lookup goes through the process-wide service cache, which
+     *         drops the service when its owner changes. The services of
+     *         the objects in map are put there on construction, so this
+     *         only asks the mapper again after such a change.
      *
      * @param[in] path - The Dbus object
      * @param[in] interface - The Dbus interface
@@ -48,6 +67,16 @@ struct Objects
 
     /** @brief The Dbus bus object */
     sdbusplus::bus::bus& bus;
+
+  private:
+    using MapperResponse =
+        std::map<Path, std::map<Service, std::vector<Interface>>>;
+
+    /** @brief Fill map from a GetSubTree response and cache the services
+     *
+     * @param[in] result - The mapper response
+     */
+    void load(MapperResponse& result);
 };
 
 namespace boot
@@ -67,6 +96,18 @@ using OneTimeEnabled = bool;
 std::tuple<Path, OneTimeEnabled> setting(const Objects& objects,
                                          const Interface& iface);
 
+/** @brief Return the one-time or the regular boot setting object path,
+ *         without looking at which one is enabled.
+ *
+ * @param[in] objects - const reference to an object of type Objects
+ * @param[in] iface - boot setting interface
+ * @param[in] oneTime - true for the one-time boot setting
+ *
+ * @return The boot setting object path
+ */
+const Path& setting(const Objects& objects, const Interface& iface,
+                    OneTimeEnabled oneTime);
+
 } // namespace boot
 
 } // namespace settings
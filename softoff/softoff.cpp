@@ -17,9 +17,14 @@
 
 #include "softoff.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <exception>
 #include <ipmid/utils.hpp>
+#include <map>
 #include <phosphor-logging/log.hpp>
+#include <string>
+#include <variant>
 #include <xyz/openbmc_project/Control/Host/server.hpp>
 namespace phosphor
 {
@@ -82,6 +87,8 @@ void SoftPowerOff::hostControlEvent(sdbusplus::message::message& msg)
         }
         else
         {
+            shutdownStart = Clock::now();
+            shutdownDeadline = *shutdownStart + time;
             log<level::INFO>(
                 "Timer started waiting for host to shutdown",
                 entry("TIMEOUT_IN_MSEC=%llu",
@@ -100,6 +107,69 @@ void SoftPowerOff::hostControlEvent(sdbusplus::message::message& msg)
     return;
 }
 
+// Function called on host progress signals
+void SoftPowerOff::hostProgressEvent(sdbusplus::message::message& msg)
+{
+    using namespace std::chrono;
+
+    // only the progress of the shutdown itself matters
+    if (!shutdownStart || completed || timer.isExpired())
+    {
+        return;
+    }
+
+    std::string interface;
+    std::map<std::string, std::variant<std::string, uint64_t>> properties;
+    try
+    {
+        msg.read(interface, properties);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to read host progress signal",
+                        entry("ERROR=%s", e.what()));
+        return;
+    }
+
+    auto osState = properties.find("OperatingSystemState");
+    if (osState != properties.end())
+    {
+        auto value = std::get_if<std::string>(&osState->second);
+        if (value && *value == "xyz.openbmc_project.State.OperatingSystem."
+                               "Status.OSStatus.Inactive")
+        {
+            log<level::INFO>("Host OS is inactive, done waiting for shutdown");
+            responseReceived(HostResponse::HostShutdown);
+            return;
+        }
+    }
+
+    // give the host some more time, but not more than the longest wait
+    auto now = Clock::now();
+    auto deadline =
+        std::min(now + seconds(IPMI_HOST_SHUTDOWN_PROGRESS_TIMEOUT_SECS),
+                 *shutdownStart + seconds(IPMI_HOST_SHUTDOWN_MAX_TIMEOUT_SECS));
+    if (deadline <= shutdownDeadline)
+    {
+        return;
+    }
+
+    auto r = startTimer(duration_cast<microseconds>(deadline - now));
+    if (r < 0)
+    {
+        log<level::ERR>("Failure to extend Host shutdown wait timer",
+                        entry("ERRNO=0x%X", -r));
+        return;
+    }
+    shutdownDeadline = deadline;
+    log<level::INFO>(
+        "Host reported shutdown progress, extended the wait",
+        entry("TIMEOUT_IN_MSEC=%llu",
+              static_cast<unsigned long long>(
+                  duration_cast<milliseconds>(deadline - *shutdownStart)
+                      .count())));
+}
+
 // Starts a timer
 int SoftPowerOff::startTimer(const std::chrono::microseconds& usec)
 {
@@ -122,6 +192,17 @@ auto SoftPowerOff::responseReceived(HostResponse response) -> HostResponse
                             entry("ERRNO=0x%X", -r));
         }
 
+        if (shutdownStart && !completed)
+        {
+            log<level::INFO>(
+                "Host shutdown complete",
+                entry("DURATION_IN_MSEC=%llu",
+                      static_cast<unsigned long long>(
+                          duration_cast<milliseconds>(Clock::now() -
+                                                      *shutdownStart)
+                              .count())));
+        }
+
         // This marks the completion of soft power off sequence.
         completed = true;
     }
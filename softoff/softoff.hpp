@@ -2,7 +2,9 @@
 
 #include "config.h"
 
+#include <chrono>
 #include <functional>
+#include <optional>
 #include <sdbusplus/bus.hpp>
 #include <sdbusplus/server/object.hpp>
 #include <sdbusplus/timer.hpp>
@@ -18,6 +20,12 @@ using namespace sdbusplus::xyz::openbmc_project::Control::server;
 
 namespace sdbusRule = sdbusplus::bus::match::rules;
 
+/* the object of the host that reports its progress */
+constexpr auto HOST_STATE_OBJ = "/xyz/openbmc_project/state/" HOST_NAME "0";
+constexpr auto OS_STATUS_INTF =
+    "xyz.openbmc_project.State.OperatingSystem.Status";
+constexpr auto BOOT_PROGRESS_INTF = "xyz.openbmc_project.State.Boot.Progress";
+
 /** @class SoftPowerOff
  *  @brief Responsible for coordinating Host SoftPowerOff operation
  */
@@ -43,6 +51,15 @@ class SoftPowerOff
                 sdbusRule::interface(CONTROL_HOST_BUSNAME) +
                 sdbusRule::argN(0, convertForMessage(Host::Command::SoftOff)),
             std::bind(std::mem_fn(&SoftPowerOff::hostControlEvent), this,
+                      std::placeholders::_1)),
+        osStatusSignal(
+            bus, sdbusRule::propertiesChanged(HOST_STATE_OBJ, OS_STATUS_INTF),
+            std::bind(std::mem_fn(&SoftPowerOff::hostProgressEvent), this,
+                      std::placeholders::_1)),
+        bootProgressSignal(
+            bus,
+            sdbusRule::propertiesChanged(HOST_STATE_OBJ, BOOT_PROGRESS_INTF),
+            std::bind(std::mem_fn(&SoftPowerOff::hostProgressEvent), this,
                       std::placeholders::_1))
     {
         // Need to announce since we may get the response
@@ -88,6 +105,8 @@ class SoftPowerOff
     int startTimer(const std::chrono::microseconds& usec);
 
   private:
+    using Clock = std::chrono::steady_clock;
+
     // Need this to send SMS_ATTN
     // TODO : Switch over to using mapper service in a different patch
     static constexpr auto HOST_IPMI_BUS = "org.openbmc.HostIpmi";
@@ -114,6 +133,20 @@ class SoftPowerOff
      **/
     sdbusplus::bus::match_t hostControlSignal;
 
+    /** @brief Subscribe to the progress the host reports
+     *
+     *  While the host is shutting down, any progress it reports gives it
+     *  more time and an inactive OS completes the soft power off.
+     **/
+    sdbusplus::bus::match_t osStatusSignal;
+    sdbusplus::bus::match_t bootProgressSignal;
+
+    /** @brief When the host acknowledged the soft off, if it did yet */
+    std::optional<Clock::time_point> shutdownStart;
+
+    /** @brief When the host shutdown wait timer expires */
+    Clock::time_point shutdownDeadline;
+
     /** @brief Sends host control command to tell host to shut down
      *
      *  After sending the command, wait for a signal indicating the status
@@ -136,6 +169,18 @@ class SoftPowerOff
      *
      */
     void hostControlEvent(sdbusplus::message::message& msg);
+
+    /** @brief Callback function on host progress signals
+     *
+     *  Moves the timeout out to IPMI_HOST_SHUTDOWN_PROGRESS_TIMEOUT_SECS
+     *  ahead, up to IPMI_HOST_SHUTDOWN_MAX_TIMEOUT_SECS after the soft off
+     *  was acknowledged, or completes the soft power off once the OS is
+     *  inactive.
+     *
+     * @param[in]  msg       - Data associated with subscribed signal
+     *
+     */
+    void hostProgressEvent(sdbusplus::message::message& msg);
 };
 } // namespace ipmi
 } // namespace phosphor
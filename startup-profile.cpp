@@ -0,0 +1,124 @@
+#include "startup-profile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <phosphor-logging/log.hpp>
+
+namespace ipmi
+{
+namespace startup
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+/* as close to process start as a static can get */
+const Clock::time_point origin = Clock::now();
+
+std::vector<Phase> phases;
+std::vector<Provider> providers;
+
+/* the provider being opened and its last registration */
+Provider* current = nullptr;
+Clock::time_point last;
+
+inline long long toMilliseconds(Clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+}
+
+inline long long toMicroseconds(Clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+} // namespace
+
+void phase(const char* name)
+{
+    Clock::duration at = Clock::now() - origin;
+    Clock::duration previous = phases.empty() ? Clock::duration{}
+                                              : phases.back().at;
+    phases.push_back({name, at, at - previous});
+}
+
+void beginProvider(const std::string& name)
+{
+    last = Clock::now();
+    providers.push_back({name, last - origin, {}});
+    current = &providers.back();
+}
+
+void registered(const char* table, uint32_t id, uint8_t cmd)
+{
+    if (!current)
+    {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    current->registrations++;
+    if (now - last > current->slowest)
+    {
+        current->slowest = now - last;
+        char at[48];
+        std::snprintf(at, sizeof(at), "%s 0x%x cmd 0x%02x", table, id, cmd);
+        current->slowestAt = at;
+    }
+    last = now;
+}
+
+void endProvider()
+{
+    if (!current)
+    {
+        return;
+    }
+    current->duration = Clock::now() - origin - current->start;
+    log<level::INFO>(
+        "Loaded IPMI provider", entry("PROVIDER=%s", current->name.c_str()),
+        entry("DURATION_US=%lld", toMicroseconds(current->duration)),
+        entry("REGISTRATIONS=%zu", current->registrations),
+        entry("SLOWEST_US=%lld", toMicroseconds(current->slowest)),
+        entry("SLOWEST_AT=%s", current->slowestAt.c_str()));
+    current = nullptr;
+}
+
+void report()
+{
+    for (const Phase& step : phases)
+    {
+        log<level::INFO>("IPMI startup phase",
+                         entry("PHASE=%s", step.name.c_str()),
+                         entry("AT_MS=%lld", toMilliseconds(step.at)),
+                         entry("DURATION_MS=%lld",
+                               toMilliseconds(step.duration)));
+    }
+    auto slowest = std::max_element(
+        providers.begin(), providers.end(),
+        [](const Provider& a, const Provider& b) {
+            return a.duration < b.duration;
+        });
+    if (slowest != providers.end())
+    {
+        log<level::INFO>(
+            "Slowest IPMI provider",
+            entry("PROVIDER=%s", slowest->name.c_str()),
+            entry("DURATION_US=%lld", toMicroseconds(slowest->duration)),
+            entry("SLOWEST_AT=%s", slowest->slowestAt.c_str()));
+    }
+}
+
+const std::vector<Phase>& getPhases()
+{
+    return phases;
+}
+
+const std::vector<Provider>& getProviders()
+{
+    return providers;
+}
+
+} // namespace startup
+} // namespace ipmi
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ipmi
+{
+namespace startup
+{
+
+using Clock = std::chrono::steady_clock;
+
+/** @struct Phase
+ *  @brief One step of the daemon startup; times are from process start
+ */
+struct Phase
+{
+    std::string name;
+    Clock::duration at;
+    Clock::duration duration;
+};
+
+/** @struct Provider
+ *  @brief Time spent opening one provider, including its constructors
+ *
+ *  The registrations of a provider are made by its constructors, so the
+ *  longest wait before one of them is mostly the work of the constructor
+ *  that made it. slowestAt names that registration.
+ */
+struct Provider
+{
+    std::string name;
+    Clock::duration start;
+    Clock::duration duration;
+    size_t registrations = 0;
+    Clock::duration slowest{};
+    std::string slowestAt;
+};
+
+/** @brief Mark the end of a phase of the startup
+ *
+ *  @param[in] name - what the daemon did since the previous phase
+ */
+void phase(const char* name);
+
+/** @brief Start timing a provider that is about to be opened
+ *
+ *  @param[in] name - path of the provider library
+ */
+void beginProvider(const std::string& name);
+
+/** @brief Note a registration made while a provider is being opened
+ *
+ *  It's cheap enough to call for every registration; outside of
+ *  beginProvider() and endProvider() it does nothing.
+ *
+ *  @param[in] table - "netfn", "group", "iana" or "filter"
+ *  @param[in] id - NetFn, Group or IANA of the registration
+ *  @param[in] cmd - Cmd of the registration
+ */
+void registered(const char* table, uint32_t id, uint8_t cmd);
+
+/** @brief Finish timing the provider being opened and log it */
+void endProvider();
+
+/** @brief Log the phases so far and the slowest provider */
+void report();
+
+/** @brief The phases recorded so far, in order */
+const std::vector<Phase>& getPhases();
+
+/** @brief The providers opened so far, in order */
+const std::vector<Provider>& getProviders();
+
+} // namespace startup
+} // namespace ipmi
@@ -9,12 +9,14 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <ipmid/api.hpp>
 #include <ipmid/types.hpp>
 #include <memory>
 #include <phosphor-logging/elog.hpp>
+#include <utility>
 #include <vector>
 #include <xyz/openbmc_project/Logging/Entry/server.hpp>
 
@@ -22,6 +24,48 @@ using namespace std;
 using namespace phosphor::logging;
 using namespace sdbusplus::xyz::openbmc_project::Logging::server;
 
+namespace
+{
+
+constexpr auto eSELFile = "/tmp/esel";
+
+/* log entries waiting to be committed: procedure number and eSEL data */
+std::deque<std::pair<uint8_t, std::string>> logQueue;
+
+/* eSELs dropped because the queue was full */
+uint64_t dropped = 0;
+
+/* commit one queued log entry per turn so the other IPMI requests get to
+ * run in between while the host floods us with eSELs */
+void commitNext()
+{
+    if (logQueue.empty())
+    {
+        return;
+    }
+
+    auto [procedureNum, eSELData] = std::move(logQueue.front());
+    logQueue.pop_front();
+
+    try
+    {
+        createProcedureLogEntry(procedureNum, eSELData);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to create the procedure log entry",
+                        entry("PROCEDURE=%u", procedureNum),
+                        entry("ERROR=%s", e.what()));
+    }
+
+    if (!logQueue.empty())
+    {
+        post_work(commitNext);
+    }
+}
+
+} // namespace
+
 std::string readESEL(const char* fileName)
 {
     std::string content;
@@ -45,9 +89,11 @@ std::string readESEL(const char* fileName)
 void createProcedureLogEntry(uint8_t procedureNum)
 {
     // Read the eSEL data from the file.
-    static constexpr auto eSELFile = "/tmp/esel";
-    auto eSELData = readESEL(eSELFile);
+    createProcedureLogEntry(procedureNum, readESEL(eSELFile));
+}
 
+void createProcedureLogEntry(uint8_t procedureNum, const std::string& eSELData)
+{
     // Each byte in eSEL is formatted as %02x with a space between bytes and
     // insert '/0' at the end of the character array.
     static constexpr auto byteSeparator = 3;
@@ -66,3 +112,37 @@ void createProcedureLogEntry(uint8_t procedureNum)
     report<error>(metadata::ESEL(data.get()),
                   metadata::PROCEDURE(static_cast<uint32_t>(procedureNum)));
 }
+
+bool queueProcedureLogEntry(uint8_t procedureNum)
+{
+    if (logQueue.size() >= maxQueuedLogEntries)
+    {
+        dropped++;
+        log<level::ERR>("Log entry queue is full, dropping eSEL",
+                        entry("PROCEDURE=%u", procedureNum),
+                        entry("DROPPED=%llu",
+                              static_cast<unsigned long long>(dropped)));
+        return false;
+    }
+
+    logQueue.emplace_back(procedureNum, readESEL(eSELFile));
+    if (logQueue.size() == 1)
+    {
+        post_work(commitNext);
+    }
+    return true;
+}
+
+ipmi::cache_stats::Usage logQueueUsage()
+{
+    ipmi::cache_stats::Usage usage;
+    usage.entries = logQueue.size();
+    for (const auto& [procedureNum, eSELData] : logQueue)
+    {
+        usage.bytes += sizeof(procedureNum) + sizeof(eSELData) +
+                       ipmi::cache_stats::heapBytes(eSELData);
+    }
+    usage.limit = maxQueuedLogEntries;
+    usage.evictions = dropped;
+    return usage;
+}
@@ -2,6 +2,10 @@
 
 #include <stdint.h>
 
+#include <cstddef>
+#include <ipmid/cache-stats.hpp>
+#include <string>
+
 /** @brief Read eSEL data into a string
  *
  *  @param[in] filename - filename of file containing eSEL
@@ -15,3 +19,33 @@ std::string readESEL(const char* filename);
  *  @param[in] procedureNum - procedure number associated with the log entry
  */
 void createProcedureLogEntry(uint8_t procedureNum);
+
+/** @brief Create a log entry with maintenance procedure
+ *
+ *  @param[in] procedureNum - procedure number associated with the log entry
+ *  @param[in] eSELData - eSEL data to attach to the log entry
+ */
+void createProcedureLogEntry(uint8_t procedureNum,
+                             const std::string& eSELData);
+
+/* Maximum number of log entries waiting to be committed; the host is told to
+ * retry once this many are outstanding. */
+constexpr size_t maxQueuedLogEntries = 64;
+
+/** @brief Queue a log entry with maintenance procedure
+ *
+ *  The eSEL data is read right away, since the host overwrites it with the
+ *  next eSEL, and the log entry is created in the background.
+ *
+ *  @param[in] procedureNum - procedure number associated with the log entry
+ *
+ *  @return true if queued, false if the queue is full and it was dropped
+ */
+bool queueProcedureLogEntry(uint8_t procedureNum);
+
+/** @brief Measure the queue of log entries for cache_stats
+ *
+ *  The eSELs dropped because the queue was full are reported as its
+ *  evictions.
+ */
+ipmi::cache_stats::Usage logQueueUsage();
@@ -2,26 +2,41 @@
 
 #include "fruread.hpp"
 #include "read_fru_data.hpp"
+#include "sdr-repository.hpp"
 #include "selutility.hpp"
 #include "sensorhandler.hpp"
 #include "storageaddsel.hpp"
 
 #include <arpa/inet.h>
 #include <mapper.h>
+#include <sys/timerfd.h>
 #include <systemd/sd-bus.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <cerrno>
 #include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
+#include <ipmid/oemopenbmc.hpp>
 #include <ipmid/utils.hpp>
+#include <ipmid/warmup.hpp>
+#include <limits>
 #include <phosphor-logging/elog-errors.hpp>
+#include <map>
+#include <memory>
+#include <optional>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/message/types.hpp>
 #include <sdbusplus/server.hpp>
 #include <string>
+#include <string_view>
+#include <user_channel/channel_layer.hpp>
+#include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 void register_netfn_storage_functions() __attribute__((constructor));
@@ -46,27 +61,265 @@ const char* getTimeString(const uint64_t& usecSinceEpoch)
 }
 } // namespace
 
-namespace cache
-{
-/*
- * This cache contains the object paths of the logging entries sorted in the
- * order of the filename(numeric order). The cache is initialized by
- * invoking readLoggingObjectPaths with the cache as the parameter. The
- * cache is invoked in the execution of the Get SEL info and Delete SEL
- * entry command. The Get SEL Info command is typically invoked before the
- * Get SEL entry command, so the cache is utilized for responding to Get SEL
- * entry command. The cache is invalidated by clearing after Delete SEL
- * entry and Clear SEL command.
- */
-ipmi::sel::ObjectPaths paths;
-
-} // namespace cache
-
 using InternalFailure =
     sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 using namespace phosphor::logging;
 using namespace ipmi::fru;
 
+namespace erase
+{
+
+constexpr auto logRootPath = "/xyz/openbmc_project/logging";
+constexpr auto deleteAllIntf = "xyz.openbmc_project.Collection.DeleteAll";
+
+/* number of Delete calls kept in flight when DeleteAll is not available */
+constexpr size_t batchSize = 16;
+
+/* set while a Clear SEL is deleting the logging entries */
+bool inProgress = false;
+
+using ObjectMap = std::map<std::string, std::vector<std::string>>;
+
+struct Job
+{
+    std::string service;
+    std::vector<ipmi::sel::Id> ids;
+    ipmi::sel::ObjectPaths paths;
+    size_t next = 0;
+    size_t inFlight = 0;
+};
+
+void finish()
+{
+    inProgress = false;
+}
+
+void deleteNext(std::shared_ptr<Job> job)
+{
+    while (job->inFlight < batchSize && job->next < job->paths.size())
+    {
+        ipmi::sel::Id id = job->ids[job->next];
+        const std::string& path = job->paths[job->next++];
+        job->inFlight++;
+        getSdBus()->async_method_call(
+            [job, id, path](const boost::system::error_code ec) {
+                if (ec)
+                {
+                    log<level::ERR>("Failed to delete a logging entry",
+                                    entry("PATH=%s", path.c_str()),
+                                    entry("ERROR=%s", ec.message().c_str()));
+                }
+                else
+                {
+                    // only what was deleted; entries logged since stay
+                    ipmi::sel::EntryIndex::instance().erase(id);
+                }
+                job->inFlight--;
+                deleteNext(job);
+            },
+            job->service, path, ipmi::sel::logDeleteIntf, "Delete");
+    }
+    if (!job->inFlight && job->next == job->paths.size())
+    {
+        finish();
+    }
+}
+
+/** @brief Delete the entries one by one, a batch at a time */
+void deleteEach()
+{
+    auto job = std::make_shared<Job>();
+    job->ids = ipmi::sel::EntryIndex::instance().ids();
+    for (auto id : job->ids)
+    {
+        job->paths.emplace_back(ipmi::sel::entryPath(id));
+    }
+    if (job->paths.empty())
+    {
+        finish();
+        return;
+    }
+
+    getSdBus()->async_method_call(
+        [job](const boost::system::error_code ec, const ObjectMap& objects) {
+            if (ec || objects.empty())
+            {
+                log<level::ERR>("Failed to find the logging service");
+                finish();
+                return;
+            }
+            job->service = objects.begin()->first;
+            deleteNext(job);
+        },
+        ipmi::sel::mapperBusName, ipmi::sel::mapperObjPath,
+        ipmi::sel::mapperIntf, "GetObject", job->paths.front(),
+        std::vector<std::string>({ipmi::sel::logDeleteIntf}));
+}
+
+/** @brief Start erasing the SEL in the background
+ *
+ *  Uses the DeleteAll of the logging service when it has one, and deletes
+ *  the entries one by one when it does not.
+ *
+ *  @return false if there is no connection to erase on
+ */
+bool start()
+{
+    auto bus = getSdBus();
+    if (!bus)
+    {
+        log<level::ERR>("No D-Bus connection to clear the SEL on");
+        return false;
+    }
+
+    inProgress = true;
+    bus->async_method_call(
+        [](const boost::system::error_code ec, const ObjectMap& objects) {
+            if (ec || objects.empty())
+            {
+                deleteEach();
+                return;
+            }
+            getSdBus()->async_method_call(
+                [](const boost::system::error_code ec) {
+                    if (ec)
+                    {
+                        deleteEach();
+                        return;
+                    }
+                    // which entries went isn't known, and some may have
+                    // been logged while they were deleted
+                    ipmi::sel::EntryIndex::instance().clear();
+                    finish();
+                },
+                objects.begin()->first, logRootPath, deleteAllIntf,
+                "DeleteAll");
+        },
+        ipmi::sel::mapperBusName, ipmi::sel::mapperObjPath,
+        ipmi::sel::mapperIntf, "GetObject", logRootPath,
+        std::vector<std::string>({deleteAllIntf}));
+    return true;
+}
+
+} // namespace erase
+
+namespace seltime
+{
+
+constexpr auto timeSettingsPath = "/xyz/openbmc_project/time";
+
+/* host time minus CLOCK_REALTIME in microseconds; only kept while the clock
+ * changes are being tracked, since either clock may be set at any time */
+std::optional<int64_t> offset;
+
+std::unique_ptr<boost::asio::posix::stream_descriptor> clockChanges;
+std::unique_ptr<sdbusplus::bus::match::match> settingsMatch;
+
+int64_t realtime()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch())
+        .count();
+}
+
+void stop()
+{
+    offset.reset();
+    clockChanges.reset();
+}
+
+/* arm a timer that never expires but is cancelled whenever CLOCK_REALTIME
+ * is set, then wait for that to happen */
+void waitClockChange()
+{
+    struct itimerspec never = {};
+    never.it_value.tv_sec = std::numeric_limits<time_t>::max();
+    if (timerfd_settime(clockChanges->native_handle(),
+                        TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &never,
+                        nullptr) < 0)
+    {
+        log<level::ERR>("Failed to arm the clock change timer",
+                        entry("ERRNO=%d", errno));
+        stop();
+        return;
+    }
+
+    clockChanges->async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        [](const boost::system::error_code& ec) {
+            if (ec || !clockChanges)
+            {
+                return;
+            }
+            // fails with ECANCELED once the clock was set
+            uint64_t expirations = 0;
+            if (read(clockChanges->native_handle(), &expirations,
+                     sizeof(expirations)) < 0)
+            {
+                if (errno == EAGAIN || errno == EINTR)
+                {
+                    // woken up without a change; the timer is still armed
+                    waitClockChange();
+                    return;
+                }
+                if (errno != ECANCELED)
+                {
+                    log<level::ERR>("Failed to read the clock change timer",
+                                    entry("ERRNO=%d", errno));
+                    stop();
+                    return;
+                }
+            }
+            offset.reset();
+            waitClockChange();
+        });
+}
+
+/* start tracking the changes to either clock; returns true if tracked */
+bool watch()
+{
+    if (clockChanges)
+    {
+        return true;
+    }
+    auto bus = getSdBus();
+    if (!bus)
+    {
+        return false;
+    }
+
+    int fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to create the clock change timer",
+                        entry("ERRNO=%d", errno));
+        return false;
+    }
+    clockChanges = std::make_unique<boost::asio::posix::stream_descriptor>(
+        *getIoContext(), fd);
+    waitClockChange();
+
+    if (!settingsMatch)
+    {
+        // the time mode and owner decide how the host time follows the BMC,
+        // and the host time object changes when the host time is set; all
+        // of them are under timeSettingsPath
+        static_assert(std::string_view(HOST_TIME_PATH)
+                          .substr(0, std::string_view(timeSettingsPath).size())
+                          == timeSettingsPath);
+        namespace rules = sdbusplus::bus::match::rules;
+        settingsMatch = std::make_unique<sdbusplus::bus::match::match>(
+            *bus,
+            rules::type::signal() + rules::member("PropertiesChanged") +
+                rules::interface(DBUS_PROPERTIES) +
+                rules::path_namespace(timeSettingsPath),
+            [](sdbusplus::message::message&) { offset.reset(); });
+    }
+    return clockChanges != nullptr;
+}
+
+} // namespace seltime
+
 /**
  * @enum Device access mode
  */
@@ -103,42 +356,14 @@ ipmi_ret_t getSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         reinterpret_cast<ipmi::sel::GetSELInfoResponse*>(outPayload.data());
 
     responseData->selVersion = ipmi::sel::selVersion;
-    // Last erase timestamp is not available from log manager.
-    responseData->eraseTimeStamp = ipmi::sel::invalidTimeStamp;
     responseData->operationSupport = ipmi::sel::operationSupport;
 
-    try
-    {
-        ipmi::sel::readLoggingObjectPaths(cache::paths);
-    }
-    catch (const sdbusplus::exception::SdBusError& e)
-    {
-        // No action if reading log objects have failed for this command.
-        // readLoggingObjectPaths will throw exception if there are no log
-        // entries. The command will be responded with number of SEL entries
-        // as 0.
-    }
-
-    responseData->entries = 0;
-    responseData->addTimeStamp = ipmi::sel::invalidTimeStamp;
-
-    if (!cache::paths.empty())
-    {
-        responseData->entries = static_cast<uint16_t>(cache::paths.size());
-
-        try
-        {
-            responseData->addTimeStamp = static_cast<uint32_t>(
-                (ipmi::sel::getEntryTimeStamp(cache::paths.back()).count()));
-        }
-        catch (InternalFailure& e)
-        {
-        }
-        catch (const std::runtime_error& e)
-        {
-            log<level::ERR>(e.what());
-        }
-    }
+    // the index is read once and then follows the logging service, so
+    // polling Get SEL Info costs no D-Bus calls
+    auto& index = ipmi::sel::EntryIndex::instance();
+    responseData->entries = static_cast<uint16_t>(index.ids().size());
+    responseData->addTimeStamp = index.addTimeStamp();
+    responseData->eraseTimeStamp = index.eraseTimeStamp();
 
     std::memcpy(response, outPayload.data(), outPayload.size());
     *data_len = outPayload.size();
@@ -168,30 +393,29 @@ ipmi_ret_t getSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         }
     }
 
-    if (cache::paths.empty())
+    auto& index = ipmi::sel::EntryIndex::instance();
+    const auto& ids = index.ids();
+    if (ids.empty())
     {
         *data_len = 0;
         return IPMI_CC_SENSOR_INVALID;
     }
 
-    ipmi::sel::ObjectPaths::const_iterator iter;
+    std::vector<ipmi::sel::Id>::const_iterator iter;
 
     // Check for the requested SEL Entry.
     if (requestData->selRecordID == ipmi::sel::firstEntry)
     {
-        iter = cache::paths.begin();
+        iter = ids.begin();
     }
     else if (requestData->selRecordID == ipmi::sel::lastEntry)
     {
-        iter = cache::paths.end();
+        iter = std::prev(ids.end());
     }
     else
     {
-        std::string objPath = std::string(ipmi::sel::logBasePath) + "/" +
-                              std::to_string(requestData->selRecordID);
-
-        iter = std::find(cache::paths.begin(), cache::paths.end(), objPath);
-        if (iter == cache::paths.end())
+        iter = index.find(requestData->selRecordID);
+        if (iter == ids.end())
         {
             *data_len = 0;
             return IPMI_CC_SENSOR_INVALID;
@@ -203,7 +427,7 @@ ipmi_ret_t getSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     // Convert the log entry into SEL record.
     try
     {
-        record = ipmi::sel::convertLogEntrytoSEL(*iter);
+        record = index.record(*iter);
     }
     catch (InternalFailure& e)
     {
@@ -218,19 +442,18 @@ ipmi_ret_t getSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     }
 
     // Identify the next SEL record ID
-    if (iter != cache::paths.end())
+    if (iter != ids.end())
     {
         ++iter;
-        if (iter == cache::paths.end())
+        if (iter == ids.end())
         {
             record.nextRecordID = ipmi::sel::lastEntry;
         }
         else
         {
-            namespace fs = std::filesystem;
-            fs::path path(*iter);
-            record.nextRecordID = static_cast<uint16_t>(
-                std::stoul(std::string(path.filename().c_str())));
+            record.nextRecordID = static_cast<uint16_t>(*iter);
+            // hosts walk the SEL in order
+            index.prefetch(*iter);
         }
     }
     else
@@ -267,6 +490,77 @@ ipmi_ret_t getSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return IPMI_CC_OK;
 }
 
+/** @brief implements the OpenBMC OEM Export SEL command
+ *
+ *  Returns as many consecutive SEL records as fit in the channel's maximum
+ *  transfer size, so a collector needs a handful of requests for the
+ *  whole SEL instead of at least one per record.
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] oen - OEM number; must be the OpenBMC OEM number
+ *  @param[in] startId - record ID to start from; 0 is the first record.
+ *                       A record that was deleted since is skipped.
+ *
+ *  @returns IPMI completion code plus response data
+ *   - OEM number
+ *   - record ID to start the next request from; 0xFFFF when done
+ *   - the 16 byte SEL records, as Get SEL Entry returns them
+ */
+ipmi::RspType<uint24_t,            // OEM number
+              uint16_t,            // next record ID
+              std::vector<uint8_t> // records
+              >
+    ipmiOemExportSel(ipmi::Context::ptr ctx, uint24_t oen, uint16_t startId)
+{
+    if (oen != oem::obmcOemNumber)
+    {
+        return ipmi::responseInvalidFieldRequest();
+    }
+
+    auto& index = ipmi::sel::EntryIndex::instance();
+    const auto& ids = index.ids();
+    auto iter = std::lower_bound(ids.begin(), ids.end(), startId);
+
+    // the completion code, the OEM number and the next record ID
+    constexpr size_t headerSize = 1 + 3 + sizeof(uint16_t);
+    constexpr size_t recordSize = ipmi::sel::selRecordSize;
+    size_t maxSize = ipmi::getChannelMaxTransferSize(ctx->channel);
+    size_t maxRecords =
+        maxSize > headerSize ? (maxSize - headerSize) / recordSize : 0;
+
+    std::vector<uint8_t> records;
+    records.reserve(std::min<size_t>(maxRecords, ids.end() - iter) *
+                    recordSize);
+    for (; iter != ids.end() && records.size() < maxRecords * recordSize;
+         ++iter)
+    {
+        ipmi::sel::GetSELEntryResponse record{};
+        try
+        {
+            record = index.record(*iter);
+        }
+        catch (const std::exception& e)
+        {
+            if (records.empty())
+            {
+                return ipmi::responseUnspecifiedError();
+            }
+            // the next request reports the failure of this record
+            break;
+        }
+        auto bytes = reinterpret_cast<const uint8_t*>(&record.recordID);
+        records.insert(records.end(), bytes, bytes + recordSize);
+    }
+
+    uint16_t nextId = iter != ids.end() ? static_cast<uint16_t>(*iter)
+                                        : ipmi::sel::lastEntry;
+    if (iter != ids.end())
+    {
+        index.prefetch(*iter);
+    }
+    return ipmi::responseSuccess(oen, nextId, records);
+}
+
 ipmi_ret_t deleteSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                           ipmi_request_t request, ipmi_response_t response,
                           ipmi_data_len_t data_len, ipmi_context_t context)
@@ -277,7 +571,6 @@ ipmi_ret_t deleteSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_REQ_DATA_LEN_INVALID;
     }
 
-    namespace fs = std::filesystem;
     auto requestData =
         reinterpret_cast<const ipmi::sel::DeleteSELEntryRequest*>(request);
 
@@ -291,61 +584,41 @@ ipmi_ret_t deleteSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     // deleted
     cancelSELReservation();
 
-    try
-    {
-        ipmi::sel::readLoggingObjectPaths(cache::paths);
-    }
-    catch (const sdbusplus::exception::SdBusError& e)
+    auto& index = ipmi::sel::EntryIndex::instance();
+    const auto& ids = index.ids();
+    if (ids.empty())
     {
-        // readLoggingObjectPaths will throw exception if there are no error
-        // log entries.
         *data_len = 0;
         return IPMI_CC_SENSOR_INVALID;
     }
 
-    if (cache::paths.empty())
-    {
-        *data_len = 0;
-        return IPMI_CC_SENSOR_INVALID;
-    }
-
-    ipmi::sel::ObjectPaths::const_iterator iter;
     uint16_t delRecordID = 0;
 
     if (requestData->selRecordID == ipmi::sel::firstEntry)
     {
-        iter = cache::paths.begin();
-        fs::path path(*iter);
-        delRecordID = static_cast<uint16_t>(
-            std::stoul(std::string(path.filename().c_str())));
+        delRecordID = static_cast<uint16_t>(ids.front());
     }
     else if (requestData->selRecordID == ipmi::sel::lastEntry)
     {
-        iter = cache::paths.end();
-        fs::path path(*iter);
-        delRecordID = static_cast<uint16_t>(
-            std::stoul(std::string(path.filename().c_str())));
+        delRecordID = static_cast<uint16_t>(ids.back());
     }
     else
     {
-        std::string objPath = std::string(ipmi::sel::logBasePath) + "/" +
-                              std::to_string(requestData->selRecordID);
-
-        iter = std::find(cache::paths.begin(), cache::paths.end(), objPath);
-        if (iter == cache::paths.end())
+        if (index.find(requestData->selRecordID) == ids.end())
         {
             *data_len = 0;
             return IPMI_CC_SENSOR_INVALID;
         }
         delRecordID = requestData->selRecordID;
     }
+    std::string objPath = ipmi::sel::entryPath(delRecordID);
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    sdbusplus::bus::bus& bus = getBus();
     std::string service;
 
     try
     {
-        service = ipmi::getService(bus, ipmi::sel::logDeleteIntf, *iter);
+        service = ipmi::getService(bus, ipmi::sel::logDeleteIntf, objPath);
     }
     catch (const std::runtime_error& e)
     {
@@ -354,7 +627,7 @@ ipmi_ret_t deleteSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
-    auto methodCall = bus.new_method_call(service.c_str(), (*iter).c_str(),
+    auto methodCall = bus.new_method_call(service.c_str(), objPath.c_str(),
                                           ipmi::sel::logDeleteIntf, "Delete");
     auto reply = bus.call(methodCall);
     if (reply.is_method_error())
@@ -363,8 +636,8 @@ ipmi_ret_t deleteSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
-    // Invalidate the cache of dbus entry objects.
-    cache::paths.clear();
+    // The InterfacesRemoved signal would tell the index the same, later.
+    index.erase(delRecordID);
     std::memcpy(response, &delRecordID, sizeof(delRecordID));
     *data_len = sizeof(delRecordID);
 
@@ -397,13 +670,14 @@ ipmi_ret_t clearSEL(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t request,
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
 
-    uint8_t eraseProgress = ipmi::sel::eraseComplete;
-
     /*
-     * Erasure status cannot be fetched from DBUS, so always return erasure
-     * status as `erase completed`.
+     * The erase runs in the background; the status reports it until the
+     * last entry is deleted.
      */
-    if (requestData->eraseOperation == ipmi::sel::getEraseStatus)
+    uint8_t eraseProgress = erase::inProgress ? ipmi::sel::eraseInProgress
+                                              : ipmi::sel::eraseComplete;
+    if (requestData->eraseOperation == ipmi::sel::getEraseStatus ||
+        erase::inProgress)
     {
         std::memcpy(response, &eraseProgress, sizeof(eraseProgress));
         *data_len = sizeof(eraseProgress);
@@ -413,71 +687,13 @@ ipmi_ret_t clearSEL(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t request,
     // Per the IPMI spec, need to cancel any reservation when the SEL is cleared
     cancelSELReservation();
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-    ipmi::sel::ObjectPaths objectPaths;
-    auto depth = 0;
-
-    auto mapperCall =
-        bus.new_method_call(ipmi::sel::mapperBusName, ipmi::sel::mapperObjPath,
-                            ipmi::sel::mapperIntf, "GetSubTreePaths");
-    mapperCall.append(ipmi::sel::logBasePath);
-    mapperCall.append(depth);
-    mapperCall.append(ipmi::sel::ObjectPaths({ipmi::sel::logEntryIntf}));
-
-    try
-    {
-        auto reply = bus.call(mapperCall);
-        if (reply.is_method_error())
-        {
-            std::memcpy(response, &eraseProgress, sizeof(eraseProgress));
-            *data_len = sizeof(eraseProgress);
-            return IPMI_CC_OK;
-        }
-
-        reply.read(objectPaths);
-        if (objectPaths.empty())
-        {
-            std::memcpy(response, &eraseProgress, sizeof(eraseProgress));
-            *data_len = sizeof(eraseProgress);
-            return IPMI_CC_OK;
-        }
-    }
-    catch (const sdbusplus::exception::SdBusError& e)
+    if (!erase::start())
     {
-        std::memcpy(response, &eraseProgress, sizeof(eraseProgress));
-        *data_len = sizeof(eraseProgress);
-        return IPMI_CC_OK;
-    }
-
-    std::string service;
-
-    try
-    {
-        service = ipmi::getService(bus, ipmi::sel::logDeleteIntf,
-                                   objectPaths.front());
-    }
-    catch (const std::runtime_error& e)
-    {
-        log<level::ERR>(e.what());
         *data_len = 0;
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
-    for (const auto& iter : objectPaths)
-    {
-        auto methodCall = bus.new_method_call(
-            service.c_str(), iter.c_str(), ipmi::sel::logDeleteIntf, "Delete");
-
-        auto reply = bus.call(methodCall);
-        if (reply.is_method_error())
-        {
-            *data_len = 0;
-            return IPMI_CC_UNSPECIFIED_ERROR;
-        }
-    }
-
-    // Invalidate the cache of dbus entry objects.
-    cache::paths.clear();
+    eraseProgress = ipmi::sel::eraseInProgress;
     std::memcpy(response, &eraseProgress, sizeof(eraseProgress));
     *data_len = sizeof(eraseProgress);
     return IPMI_CC_OK;
@@ -500,37 +716,51 @@ ipmi_ret_t ipmi_storage_get_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     uint32_t resp = 0;
     std::stringstream hostTime;
 
-    try
+    if (seltime::offset)
     {
-        sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-        auto service = ipmi::getService(bus, TIME_INTERFACE, HOST_TIME_PATH);
-        sdbusplus::message::variant<uint64_t> value;
-
-        // Get host time
-        auto method = bus.new_method_call(service.c_str(), HOST_TIME_PATH,
-                                          DBUS_PROPERTIES, "Get");
-
-        method.append(TIME_INTERFACE, PROPERTY_ELAPSED);
-        auto reply = bus.call(method);
-        if (reply.is_method_error())
+        host_time_usec = seltime::realtime() + *seltime::offset;
+    }
+    else
+    {
+        try
         {
-            log<level::ERR>("Error getting time",
-                            entry("SERVICE=%s", service.c_str()),
-                            entry("PATH=%s", HOST_TIME_PATH));
+            sdbusplus::bus::bus& bus = getBus();
+            auto service =
+                ipmi::getService(bus, TIME_INTERFACE, HOST_TIME_PATH);
+            sdbusplus::message::variant<uint64_t> value;
+
+            // Get host time
+            auto method = bus.new_method_call(service.c_str(), HOST_TIME_PATH,
+                                              DBUS_PROPERTIES, "Get");
+
+            method.append(TIME_INTERFACE, PROPERTY_ELAPSED);
+            auto reply = bus.call(method);
+            if (reply.is_method_error())
+            {
+                log<level::ERR>("Error getting time",
+                                entry("SERVICE=%s", service.c_str()),
+                                entry("PATH=%s", HOST_TIME_PATH));
+                return IPMI_CC_UNSPECIFIED_ERROR;
+            }
+            reply.read(value);
+            host_time_usec = std::get<uint64_t>(value);
+        }
+        catch (InternalFailure& e)
+        {
+            log<level::ERR>(e.what());
             return IPMI_CC_UNSPECIFIED_ERROR;
         }
-        reply.read(value);
-        host_time_usec = std::get<uint64_t>(value);
-    }
-    catch (InternalFailure& e)
-    {
-        log<level::ERR>(e.what());
-        return IPMI_CC_UNSPECIFIED_ERROR;
-    }
-    catch (const std::runtime_error& e)
-    {
-        log<level::ERR>(e.what());
-        return IPMI_CC_UNSPECIFIED_ERROR;
+        catch (const std::runtime_error& e)
+        {
+            log<level::ERR>(e.what());
+            return IPMI_CC_UNSPECIFIED_ERROR;
+        }
+
+        // answer the following requests from CLOCK_REALTIME
+        if (seltime::watch())
+        {
+            seltime::offset = host_time_usec - seltime::realtime();
+        }
     }
 
     hostTime << "Host time:" << getTimeString(host_time_usec);
@@ -572,7 +802,7 @@ ipmi_ret_t ipmi_storage_set_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     try
     {
-        sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+        sdbusplus::bus::bus& bus = getBus();
         auto service = ipmi::getService(bus, TIME_INTERFACE, HOST_TIME_PATH);
         sdbusplus::message::variant<uint64_t> value{usec.count()};
 
@@ -589,6 +819,10 @@ ipmi_ret_t ipmi_storage_set_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                             entry("PATH=%s", HOST_TIME_PATH));
             rc = IPMI_CC_UNSPECIFIED_ERROR;
         }
+        else if (seltime::watch())
+        {
+            seltime::offset = usec.count() - seltime::realtime();
+        }
     }
     catch (InternalFailure& e)
     {
@@ -643,6 +877,22 @@ ipmi_ret_t ipmi_storage_add_sel(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     ipmi_add_sel_request_t* p = (ipmi_add_sel_request_t*)request;
     uint16_t recordid;
 
+    // Hostboot sends SEL with OEM record type 0xDE to indicate that there is
+    // a maintenance procedure associated with eSEL record. The log entry is
+    // created in the background; when too many are outstanding the host is
+    // asked to retry rather than stalling every other command.
+    static constexpr auto procedureType = 0xDE;
+    if (p->recordtype == procedureType)
+    {
+        // In the OEM record type 0xDE, byte 11 in the SEL record indicate the
+        // procedure number.
+        if (!queueProcedureLogEntry(p->sensortype))
+        {
+            *data_len = 0;
+            return IPMI_CC_BUSY;
+        }
+    }
+
     // Per the IPMI spec, need to cancel the reservation when a SEL entry is
     // added
     cancelSELReservation();
@@ -654,111 +904,88 @@ ipmi_ret_t ipmi_storage_add_sel(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     // Pack the actual response
     std::memcpy(response, &p->eventdata[1], 2);
 
-    // Hostboot sends SEL with OEM record type 0xDE to indicate that there is
-    // a maintenance procedure associated with eSEL record.
-    static constexpr auto procedureType = 0xDE;
-    if (p->recordtype == procedureType)
-    {
-        // In the OEM record type 0xDE, byte 11 in the SEL record indicate the
-        // procedure number.
-        createProcedureLogEntry(p->sensortype);
-    }
-
     return rc;
 }
 
-// Read FRU info area
-ipmi_ret_t ipmi_storage_get_fru_inv_area_info(
-    ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t request,
-    ipmi_response_t response, ipmi_data_len_t data_len, ipmi_context_t context)
+/** @brief implements the Get FRU Inventory Area Info command
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] fruId - FRU device ID
+ *
+ *  @returns IPMI completion code plus response data
+ *   - size of the FRU inventory area in bytes
+ *   - access type; the FRU is accessed by bytes
+ */
+ipmi::RspType<uint16_t, // area size
+              uint8_t   // access type
+              >
+    ipmiStorageGetFruInvAreaInfo(ipmi::Context::ptr ctx, uint8_t fruId)
 {
-    ipmi_ret_t rc = IPMI_CC_OK;
-    const FruInvenAreaInfoRequest* reqptr =
-        reinterpret_cast<const FruInvenAreaInfoRequest*>(request);
-
-    auto iter = frus.find(reqptr->fruID);
-    if (iter == frus.end())
+    if (frus.find(fruId) == frus.end())
     {
-        *data_len = 0;
-        return IPMI_CC_SENSOR_INVALID;
+        return ipmi::responseSensorInvalid();
     }
 
     try
     {
-        const auto& fruArea = getFruAreaData(reqptr->fruID);
-        auto size = static_cast<uint16_t>(fruArea.size());
-        FruInvenAreaInfoResponse resp;
-        resp.sizems = size >> 8;
-        resp.sizels = size;
-        resp.access = static_cast<uint8_t>(AccessMode::bytes);
-
-        *data_len = sizeof(resp);
-
-        // Pack the actual response
-        std::memcpy(response, &resp, *data_len);
+        // a read of the FRU starts here; serve its chunks from this image
+        auto fruArea = getFruAreaData(fruId, {ctx->channel, ctx->userId},
+                                      ReadStep::areaInfo);
+        return ipmi::responseSuccess(
+            static_cast<uint16_t>(fruArea->data.size()),
+            static_cast<uint8_t>(AccessMode::bytes));
     }
     catch (const InternalFailure& e)
     {
-        rc = IPMI_CC_UNSPECIFIED_ERROR;
-        *data_len = 0;
         log<level::ERR>(e.what());
+        return ipmi::responseUnspecifiedError();
     }
-    return rc;
 }
 
-// Read FRU data
-ipmi_ret_t ipmi_storage_read_fru_data(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                      ipmi_request_t request,
-                                      ipmi_response_t response,
-                                      ipmi_data_len_t data_len,
-                                      ipmi_context_t context)
+/** @brief implements the Read FRU Data command
+ *
+ *  @param[in] ctx - context of the request
+ *  @param[in] fruId - FRU device ID
+ *  @param[in] offset - offset into the FRU inventory area
+ *  @param[in] count - number of bytes to read
+ *
+ *  @returns IPMI completion code plus response data
+ *   - number of bytes returned
+ *   - the data
+ */
+ipmi::RspType<uint8_t,             // count returned
+              std::vector<uint8_t> // data
+              >
+    ipmiStorageReadFruData(ipmi::Context::ptr ctx, uint8_t fruId,
+                           uint16_t offset, uint8_t count)
 {
-    ipmi_ret_t rc = IPMI_CC_OK;
-    const ReadFruDataRequest* reqptr =
-        reinterpret_cast<const ReadFruDataRequest*>(request);
-    auto resptr = reinterpret_cast<ReadFruDataResponse*>(response);
-
-    auto iter = frus.find(reqptr->fruID);
-    if (iter == frus.end())
+    if (frus.find(fruId) == frus.end())
     {
-        *data_len = 0;
-        return IPMI_CC_SENSOR_INVALID;
+        return ipmi::responseSensorInvalid();
     }
 
-    auto offset =
-        static_cast<uint16_t>(reqptr->offsetMS << 8 | reqptr->offsetLS);
     try
     {
-        const auto& fruArea = getFruAreaData(reqptr->fruID);
-        auto size = fruArea.size();
-
-        if (offset >= size)
-        {
-            return IPMI_CC_PARM_OUT_OF_RANGE;
-        }
-
-        // Write the count of response data.
-        if ((offset + reqptr->count) <= size)
-        {
-            resptr->count = reqptr->count;
-        }
-        else
+        auto fruArea = getFruAreaData(
+            fruId, {ctx->channel, ctx->userId},
+            offset == 0 ? ReadStep::firstChunk : ReadStep::nextChunk);
+        const auto& data = fruArea->data;
+        if (offset >= data.size())
         {
-            resptr->count = size - offset;
+            return ipmi::responseParmOutOfRange();
         }
 
-        std::copy((fruArea.begin() + offset),
-                  (fruArea.begin() + offset + resptr->count), resptr->data);
-
-        *data_len = resptr->count + 1; // additional one byte for count
+        size_t returned = std::min<size_t>(count, data.size() - offset);
+        return ipmi::responseSuccess(
+            static_cast<uint8_t>(returned),
+            std::vector<uint8_t>(data.begin() + offset,
+                                 data.begin() + offset + returned));
     }
     catch (const InternalFailure& e)
     {
-        rc = IPMI_CC_UNSPECIFIED_ERROR;
-        *data_len = 0;
         log<level::ERR>(e.what());
+        return ipmi::responseUnspecifiedError();
     }
-    return rc;
 }
 
 ipmi_ret_t ipmi_get_repository_info(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
@@ -781,6 +1008,14 @@ ipmi_ret_t ipmi_get_repository_info(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     responseData->freeSpace[0] = 0xFF;
     responseData->freeSpace[1] = 0xFF;
 
+    const auto& changes = ipmi::sdr::Repository::instance().changes();
+    for (size_t i = 0; i < sizeof(responseData->additionTimestamp); i++)
+    {
+        responseData->additionTimestamp[i] =
+            changes.additionTimestamp >> (8 * i);
+        responseData->deletionTimestamp[i] = changes.eraseTimestamp >> (8 * i);
+    }
+
     *data_len = sizeof(GetRepositoryInfoResponse);
 
     return IPMI_CC_OK;
@@ -812,6 +1047,11 @@ void register_netfn_storage_functions()
     ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_GET_SEL_ENTRY, NULL,
                            getSELEntry, PRIVILEGE_USER);
 
+    // <Export SEL>
+    ipmi::registerOemHandler(ipmi::prioOpenBmcBase, oem::obmcOemNumber,
+                             oem::selExportCmd, ipmi::Privilege::User,
+                             ipmiOemExportSel);
+
     // <Delete SEL Entry>
     ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_DELETE_SEL, NULL,
                            deleteSELEntry, PRIVILEGE_OPERATOR);
@@ -823,13 +1063,15 @@ void register_netfn_storage_functions()
     ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_CLEAR_SEL, NULL, clearSEL,
                            PRIVILEGE_OPERATOR);
     // <Get FRU Inventory Area Info>
-    ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_GET_FRU_INV_AREA_INFO, NULL,
-                           ipmi_storage_get_fru_inv_area_info,
-                           PRIVILEGE_OPERATOR);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnStorage,
+                          ipmi::storage::cmdGetFruInventoryAreaInfo,
+                          ipmi::Privilege::Operator,
+                          ipmiStorageGetFruInvAreaInfo);
 
-    // <Add READ FRU Data
-    ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_READ_FRU_DATA, NULL,
-                           ipmi_storage_read_fru_data, PRIVILEGE_OPERATOR);
+    // <Read FRU Data>
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnStorage,
+                          ipmi::storage::cmdReadFruData,
+                          ipmi::Privilege::Operator, ipmiStorageReadFruData);
 
     // <Get Repository Info>
     ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_GET_REPOSITORY_INFO,
@@ -844,5 +1086,12 @@ void register_netfn_storage_functions()
                            ipmi_sen_get_sdr, PRIVILEGE_USER);
 
     ipmi::fru::registerCallbackHandler();
+
+    ipmi::cache_stats::registerCache("sel-log-queue", logQueueUsage);
+
+    // the logging entries Get SEL Info and Get SEL Entry count and walk
+    ipmi::warmup::add("sel index", [](ipmi::Context::ptr) {
+        ipmi::sel::EntryIndex::instance().ids();
+    });
     return;
 }
@@ -5,9 +5,14 @@
 #include "host-cmd-manager.hpp"
 #include "host-interface.hpp"
 
+#include <array>
 #include <cstring>
 #include <ipmid-host/cmd.hpp>
 #include <ipmid/api.hpp>
+#include <ipmid/cache-stats.hpp>
+#include <ipmid/event-buffer.hpp>
+#include <string>
+#include <vector>
 
 void register_netfn_app_functions() __attribute__((constructor));
 
@@ -15,7 +20,7 @@ using namespace sdbusplus::xyz::openbmc_project::Control::server;
 
 // For accessing Host command manager
 using cmdManagerPtr = std::unique_ptr<phosphor::host::command::Manager>;
-extern cmdManagerPtr& ipmid_get_host_cmd_manager();
+extern cmdManagerPtr& ipmid_get_host_cmd_manager(size_t host);
 
 // global enables
 // bit0   - Message Receive Queue enable
@@ -25,20 +30,28 @@ extern cmdManagerPtr& ipmid_get_host_cmd_manager();
 // bit4   - reserved
 // bit5-7 - OEM 0~2 enables
 static constexpr uint8_t selEnable = 0x08;
+static constexpr uint8_t eventMsgBufferEnable = 0x04;
 static constexpr uint8_t recvMsgQueueEnable = 0x01;
 static constexpr uint8_t globalEnablesDefault = selEnable | recvMsgQueueEnable;
 
 //-------------------------------------------------------------------
 // Called by Host post response from Get_Message_Flags
 //-------------------------------------------------------------------
-ipmi_ret_t ipmi_app_read_event(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                               ipmi_request_t request, ipmi_response_t response,
-                               ipmi_data_len_t data_len, ipmi_context_t context)
+static_assert(sizeof(oem_sel_timestamped) == ipmi::events::messageSize);
+
+ipmi::RspType<ipmi::events::Message>
+    ipmiAppReadEventBuffer(ipmi::Context::ptr ctx)
 {
-    ipmi_ret_t rc = IPMI_CC_OK;
+    // the commands of the Command Manager control the host, so they go
+    // ahead of the event messages
+    auto& cmdManager = ipmid_get_host_cmd_manager(ctx->hostIdx);
+    ipmi::events::Message event;
+    if (!cmdManager->hasCommands() && ipmi::events::take(ctx->hostIdx, event))
+    {
+        return ipmi::responseSuccess(event);
+    }
 
     struct oem_sel_timestamped oem_sel = {0};
-    *data_len = sizeof(struct oem_sel_timestamped);
 
     // either id[0] -or- id[1] can be filled in. We will use id[0]
     oem_sel.id[0] = SEL_OEM_ID_0;
@@ -53,9 +66,9 @@ ipmi_ret_t ipmi_app_read_event(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     // per IPMI spec NetFuntion for OEM
     oem_sel.netfun = 0x3A;
 
-    // Read from the Command Manager queue. What gets returned is a
-    // pair of <command, data> that can be directly used here
-    auto hostCmd = ipmid_get_host_cmd_manager()->getNextCommand();
+    // Read from the Command Manager queue of the host that asks. What gets
+    // returned is a pair of <command, data> that can be directly used here
+    auto hostCmd = cmdManager->getNextCommand();
     oem_sel.cmd = hostCmd.first;
     oem_sel.data[0] = hostCmd.second;
 
@@ -63,73 +76,59 @@ ipmi_ret_t ipmi_app_read_event(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     std::memset(&oem_sel.data[1], 0xFF, 3);
 
     // Pack the actual response
-    std::memcpy(response, &oem_sel, *data_len);
-    return rc;
+    ipmi::events::Message response;
+    std::memcpy(response.data(), &oem_sel, sizeof(oem_sel));
+    return ipmi::responseSuccess(response);
 }
 
 //---------------------------------------------------------------------
-// Called by Host on seeing a SMS_ATN bit set. Return a hardcoded
-// value of 0x2 indicating we need Host read some data.
+// Called by Host on seeing a SMS_ATN bit set.
 //-------------------------------------------------------------------
-ipmi::RspType<uint8_t> ipmiAppGetMessageFlags()
+ipmi::RspType<uint8_t> ipmiAppGetMessageFlags(ipmi::Context::ptr ctx)
 {
     // From IPMI spec V2.0 for Get Message Flags Command :
     // bit:[1] from LSB : 1b = Event Message Buffer Full.
-    // Return as 0 if Event Message Buffer is not supported,
-    // or when the Event Message buffer is disabled.
-    // This path is used to communicate messages to the host
-    // from within the phosphor::host::command::Manager
-    constexpr uint8_t setEventMsgBufferFull = 0x2;
-    return ipmi::responseSuccess(setEventMsgBufferFull);
-}
-
-ipmi_ret_t ipmi_app_get_bmc_global_enables(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                           ipmi_request_t request,
-                                           ipmi_response_t response,
-                                           ipmi_data_len_t data_len,
-                                           ipmi_context_t context)
-{
-    ipmi_ret_t rc = IPMI_CC_OK;
-    if (0 != *data_len)
+    // Set while there are event messages for the host, or commands from
+    // within the phosphor::host::command::Manager, for the host to read
+    // with Read Event Message Buffer.
+    constexpr uint8_t eventMsgBufferFull = 0x2;
+    uint8_t flags = 0;
+    if (ipmi::events::pending(ctx->hostIdx) ||
+        ipmid_get_host_cmd_manager(ctx->hostIdx)->hasCommands())
     {
-        *data_len = 0;
-        return IPMI_CC_REQ_DATA_LEN_INVALID;
+        flags |= eventMsgBufferFull;
     }
-    *data_len = sizeof(globalEnablesDefault);
-    *reinterpret_cast<uint8_t*>(response) = globalEnablesDefault;
-    return rc;
+    return ipmi::responseSuccess(flags);
 }
 
-ipmi_ret_t ipmi_app_set_bmc_global_enables(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                                           ipmi_request_t request,
-                                           ipmi_response_t response,
-                                           ipmi_data_len_t data_len,
-                                           ipmi_context_t context)
+ipmi::RspType<uint8_t> ipmiAppGetBmcGlobalEnables(ipmi::Context::ptr ctx)
 {
-    ipmi_ret_t rc = IPMI_CC_OK;
-
-    uint8_t reqMask = *reinterpret_cast<uint8_t*>(request);
-    if (sizeof(reqMask) != *data_len)
+    uint8_t enables = globalEnablesDefault;
+    if (ipmi::events::enabled(ctx->hostIdx))
     {
-        *data_len = 0;
-        return IPMI_CC_REQ_DATA_LEN_INVALID;
+        enables |= eventMsgBufferEnable;
     }
+    return ipmi::responseSuccess(enables);
+}
 
-    *data_len = 0;
-    // Recv Message Queue and SEL are enabled by default.
-    // Event Message buffer are disabled by default (not supported).
-    // Any request that try to change the mask will be rejected
-    if (reqMask != (selEnable | recvMsgQueueEnable))
+ipmi::RspType<> ipmiAppSetBmcGlobalEnables(ipmi::Context::ptr ctx,
+                                           uint8_t reqMask)
+{
+    // Recv Message Queue and SEL are always enabled, and only the Event
+    // Message Buffer can be turned on and off.
+    // Any request that try to change the rest of the mask will be rejected
+    if ((reqMask & ~eventMsgBufferEnable) != globalEnablesDefault)
     {
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        return ipmi::responseInvalidFieldRequest();
     }
-    return rc;
+    ipmi::events::setEnabled(ctx->hostIdx, reqMask & eventMsgBufferEnable);
+    return ipmi::responseSuccess();
 }
 
 namespace
 {
-// Static storage to keep the object alive during process life
-std::unique_ptr<phosphor::host::command::Host> host
+// Static storage to keep the objects alive during process life
+std::vector<std::unique_ptr<phosphor::host::command::Host>> hosts
     __attribute__((init_priority(101)));
 std::unique_ptr<sdbusplus::server::manager::manager> objManager
     __attribute__((init_priority(101)));
@@ -139,24 +138,26 @@ void register_netfn_app_functions()
 {
 
     // <Read Event Message Buffer>
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_READ_EVENT, NULL,
-                           ipmi_app_read_event, SYSTEM_INTERFACE);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
+                          ipmi::app::cmdReadEventMessageBuffer,
+                          ipmi::Privilege::Admin, ipmiAppReadEventBuffer);
 
     // <Set BMC Global Enables>
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_SET_BMC_GLOBAL_ENABLES, NULL,
-                           ipmi_app_set_bmc_global_enables, SYSTEM_INTERFACE);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
+                          ipmi::app::cmdSetBmcGlobalEnables,
+                          ipmi::Privilege::Admin, ipmiAppSetBmcGlobalEnables);
 
     // <Get BMC Global Enables>
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_GET_BMC_GLOBAL_ENABLES, NULL,
-                           ipmi_app_get_bmc_global_enables, SYSTEM_INTERFACE);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
+                          ipmi::app::cmdGetBmcGlobalEnables,
+                          ipmi::Privilege::Admin, ipmiAppGetBmcGlobalEnables);
 
     // <Get Message Flags>
     ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
                           ipmi::app::cmdGetMessageFlags, ipmi::Privilege::Admin,
                           ipmiAppGetMessageFlags);
 
-    // Create new xyz.openbmc_project.host object on the bus
-    auto objPath = std::string{CONTROL_HOST_OBJ_MGR} + '/' + HOST_NAME + '0';
+    ipmi::cache_stats::registerCache("event-buffer", ipmi::events::usage);
 
     std::unique_ptr<sdbusplus::asio::connection>& sdbusp =
         ipmid_get_sdbus_plus_handler();
@@ -165,8 +166,14 @@ void register_netfn_app_functions()
     objManager = std::make_unique<sdbusplus::server::manager::manager>(
         *sdbusp, CONTROL_HOST_OBJ_MGR);
 
-    host = std::make_unique<phosphor::host::command::Host>(*sdbusp,
-                                                           objPath.c_str());
+    // Create new xyz.openbmc_project.host object on the bus for each host
+    for (size_t host = 0; host < IPMI_HOST_INSTANCES; host++)
+    {
+        auto objPath = std::string{CONTROL_HOST_OBJ_MGR} + '/' + HOST_NAME +
+                       std::to_string(host);
+        hosts.emplace_back(std::make_unique<phosphor::host::command::Host>(
+            *sdbusp, objPath.c_str(), host));
+    }
     sdbusp->request_name(CONTROL_HOST_BUSNAME);
 
     return;
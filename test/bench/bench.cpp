@@ -0,0 +1,66 @@
+#include "bench.hpp"
+
+#include <time.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace bench
+{
+
+namespace
+{
+
+const char* filter = nullptr;
+
+std::atomic<uint64_t> allocationCount{0};
+
+} // namespace
+
+void setFilter(const char* name)
+{
+    filter = name;
+}
+
+bool selected(const char* name)
+{
+    return !filter || std::strstr(name, filter);
+}
+
+uint64_t cpuTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t allocations()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+} // namespace bench
+
+/* count the allocations of the cases; the array and nothrow forms end up
+ * here too */
+void* operator new(size_t size)
+{
+    bench::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
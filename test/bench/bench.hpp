@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+/* each case is repeated, doubling the iteration count, until one run takes
+ * at least this long so that the timer resolution does not matter */
+constexpr auto minRunTime = std::chrono::milliseconds(200);
+
+/** @brief Only run the cases whose name contains the given string */
+void setFilter(const char* name);
+
+/** @brief Check whether a case was selected on the command line */
+bool selected(const char* name);
+
+/** @brief CPU time of the calling thread, in nanoseconds
+ *
+ *  Unlike the wall time it leaves out the time spent waiting, on a mocked
+ *  D-Bus call say.
+ */
+uint64_t cpuTime();
+
+/** @brief Number of operator new calls so far, from any thread */
+uint64_t allocations();
+
+/** @brief Keep the compiler from optimizing a value away */
+template <typename T>
+inline void doNotOptimize(T& value)
+{
+    asm volatile("" : "+m"(value) : : "memory");
+}
+
+/** @brief Time one case and print its cost per iteration
+ *
+ *  @param[in] name - name of the case, printed with the result
+ *  @param[in] op - the operation to measure
+ */
+template <typename Op>
+void run(const char* name, Op&& op)
+{
+    if (!selected(name))
+    {
+        return;
+    }
+
+    uint64_t iterations = 1;
+    Clock::duration elapsed;
+    uint64_t cpu;
+    uint64_t allocs;
+    for (;;)
+    {
+        auto start = Clock::now();
+        uint64_t cpuStart = cpuTime();
+        uint64_t allocStart = allocations();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            op();
+        }
+        elapsed = Clock::now() - start;
+        cpu = cpuTime() - cpuStart;
+        allocs = allocations() - allocStart;
+        if (elapsed >= minRunTime || iterations >= (uint64_t{1} << 40))
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::printf("%-36s %12llu %10.1f ns/op %10.1f cpu-ns/op %8.2f allocs/op\n",
+                name, static_cast<unsigned long long>(iterations),
+                ns / iterations, static_cast<double>(cpu) / iterations,
+                static_cast<double>(allocs) / iterations);
+}
+
+/** @brief pack/unpack cases, in pack.cpp */
+void packBenchmarks();
+
+/** @brief handler dispatch cases, in handler.cpp */
+void handlerBenchmarks();
+
+} // namespace bench
@@ -0,0 +1,91 @@
+#include "bench.hpp"
+
+#include <ipmid/api.hpp>
+#include <ipmid/handler.hpp>
+#include <ipmid/message.hpp>
+#include <memory>
+#include <vector>
+
+namespace ipmi
+{
+
+/* the legacy adapter sizes its response buffer from the channel layer; give
+ * it the IPMB size here so that the benchmark does not need the channel
+ * configuration */
+size_t getChannelMaxTransferSize(uint8_t)
+{
+    return 32;
+}
+
+} // namespace ipmi
+
+namespace bench
+{
+
+namespace
+{
+
+ipmi::RspType<> noArgs()
+{
+    return ipmi::responseSuccess();
+}
+
+ipmi::RspType<uint8_t, uint8_t, uint8_t, uint8_t>
+    sensorReading(ipmi::Context::ptr, uint8_t sensor)
+{
+    return ipmi::responseSuccess(sensor, uint8_t{0xc0}, uint8_t{0x01},
+                                 uint8_t{0x80});
+}
+
+ipmi::RspType<uint8_t, std::vector<uint8_t>>
+    vectorEcho(uint8_t selector, std::vector<uint8_t> data)
+{
+    return ipmi::responseSuccess(selector, std::move(data));
+}
+
+ipmi_ret_t legacySensorReading(ipmi_netfn_t, ipmi_cmd_t,
+                               ipmi_request_t request,
+                               ipmi_response_t response,
+                               ipmi_data_len_t dataLen, ipmi_context_t)
+{
+    auto req = static_cast<const uint8_t*>(request);
+    auto rsp = static_cast<uint8_t*>(response);
+    rsp[0] = req[0];
+    rsp[1] = 0xc0;
+    rsp[2] = 0x01;
+    rsp[3] = 0x80;
+    *dataLen = 4;
+    return IPMI_CC_OK;
+}
+
+/** @brief call a handler the way the dispatcher does for every request */
+void callCase(const char* name, ipmi::HandlerBase::ptr handler,
+              const std::vector<uint8_t>& data)
+{
+    auto ctx = std::make_shared<ipmi::Context>(
+        ipmi::netFnSensor, ipmi::sensor_event::cmdGetSensorReading, 0, 0,
+        ipmi::Privilege::Admin);
+    run(name, [&]() {
+        std::vector<uint8_t> bytes = data;
+        auto request =
+            std::make_shared<ipmi::message::Request>(ctx, std::move(bytes));
+        ipmi::message::Response::ptr response = handler->call(request);
+        doNotOptimize(response);
+    });
+}
+
+} // namespace
+
+void handlerBenchmarks()
+{
+    callCase("handler/no-args", ipmi::makeHandler(noArgs), {});
+    callCase("handler/sensor-reading", ipmi::makeHandler(sensorReading),
+             {0x01});
+    callCase("handler/vector-echo", ipmi::makeHandler(vectorEcho),
+             std::vector<uint8_t>(24, 0xa5));
+    callCase("handler/unpack-error", ipmi::makeHandler(sensorReading), {});
+    callCase("legacy/sensor-reading",
+             ipmi::makeLegacyHandler(legacySensorReading), {0x01});
+}
+
+} // namespace bench
@@ -0,0 +1,20 @@
+/* Microbenchmarks for the message templates and the handler adapters.
+ *
+ * Usage: message_bench [filter]
+ *   Only the cases whose name contains the filter are run. Each line of the
+ *   output has the case name, the iteration count and the cost per iteration
+ *   so that the results can be compared across releases.
+ */
+#include "bench.hpp"
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        bench::setFilter(argv[1]);
+    }
+
+    bench::packBenchmarks();
+    bench::handlerBenchmarks();
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <climits>
+#include <ipmid/api.hpp>
+#include <ipmid/message.hpp>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace bench
+{
+
+namespace
+{
+
+/* the shapes below follow the responses and requests of common commands */
+
+/** @brief pack a set of values into a fresh payload, as a response does */
+template <typename... Args>
+void packCase(const char* name, Args... args)
+{
+    run(name, [&]() {
+        ipmi::message::Payload p;
+        p.reserve(ipmi::message::details::packedSize(args...));
+        p.pack(args...);
+        doNotOptimize(p.raw);
+    });
+}
+
+/** @brief the same without sizing the buffer first, as responses were
+ *         packed before the size was worked out
+ */
+template <typename... Args>
+void packUnsizedCase(const char* name, Args... args)
+{
+    run(name, [&]() {
+        ipmi::message::Payload p;
+        p.pack(args...);
+        doNotOptimize(p.raw);
+    });
+}
+
+/** @brief unpack a set of values out of fixed bytes, as a request does */
+template <typename... Args>
+void unpackCase(const char* name, std::vector<uint8_t> bytes)
+{
+    ipmi::message::Payload p(std::move(bytes));
+    run(name, [&]() {
+        std::tuple<Args...> values;
+        p.reset();
+        p.unpack(values);
+        doNotOptimize(values);
+    });
+}
+
+/** @brief append bits a byte at a time, as the bit-field packers did
+ *         before adjacent fields were gathered into a word
+ */
+void appendBytewise(ipmi::message::Payload& p, size_t count, uint64_t bits)
+{
+    while (count > 0)
+    {
+        size_t n = std::min(count, static_cast<size_t>(CHAR_BIT));
+        p.appendBits(n, static_cast<uint8_t>(bits));
+        bits >>= n;
+        count -= n;
+    }
+}
+
+/** @brief pop bits a byte at a time, the reference for popWord */
+uint64_t popBytewise(ipmi::message::Payload& p, size_t count)
+{
+    uint64_t bits = 0;
+    for (size_t shift = 0; shift < count; shift += CHAR_BIT)
+    {
+        size_t n = std::min(count - shift, static_cast<size_t>(CHAR_BIT));
+        p.fillBits(n);
+        bits |= static_cast<uint64_t>(p.popBits(n)) << shift;
+    }
+    return bits;
+}
+
+/* widths of the fields in the bit-fields cases */
+constexpr std::array<size_t, 8> bitFieldWidths = {1, 2, 5, 1, 3, 4, 1, 8};
+
+} // namespace
+
+void packBenchmarks()
+{
+    // Get Sensor Reading
+    packCase("pack/uint8x4", uint8_t{0x20}, uint8_t{0xc0}, uint8_t{0x01},
+             uint8_t{0x80});
+    // Get Device ID
+    packCase("pack/device-id", uint8_t{0x20}, uint8_t{0x81}, uint8_t{0x02},
+             uint8_t{0x51}, uint8_t{0xbf}, uint24_t{0xc2b2},
+             uint16_t{0x0001}, uint32_t{0x00000001});
+    // a response tuple that takes the fixed layout path
+    packCase("pack/fixed-tuple",
+             std::make_tuple(uint8_t{0x20}, uint16_t{0x0001},
+                             uint32_t{0x00000001},
+                             std::array<uint8_t, 4>{1, 2, 3, 4}));
+    // Get Chassis Status style bit-fields
+    packCase("pack/bit-fields", true, uint2_t{1}, uint5_t{3},
+             false, uint3_t{2}, uint4_t{7}, uint1_t{0},
+             uint8_t{0});
+    // the same fields through the byte-wise bit stream, for comparison
+    run("pack/bit-fields-bytewise", []() {
+        ipmi::message::Payload p;
+        for (size_t width : bitFieldWidths)
+        {
+            appendBytewise(p, width, 1);
+        }
+        p.drain();
+        doNotOptimize(p.raw);
+    });
+    packCase("pack/bitset", std::bitset<8>{0x5a}, std::bitset<3>{0x5},
+             std::bitset<5>{0x11}, std::bitset<16>{0x1234});
+    packCase("pack/optional", std::optional<uint8_t>{0x42},
+             std::optional<uint32_t>{}, std::optional<uint16_t>{0x1234});
+    packCase("pack/vector32", std::vector<uint8_t>(32, 0xa5));
+    packCase("pack/vector16xuint16", std::vector<uint16_t>(16, 0x1234));
+    packUnsizedCase("pack/vector16xuint16-unsized",
+                    std::vector<uint16_t>(16, 0x1234));
+    // Get SDR: a record id and the record bytes
+    packCase("pack/sdr-record", uint16_t{0x0002},
+             std::vector<uint8_t>(64, 0x5a));
+    packUnsizedCase("pack/sdr-record-unsized", uint16_t{0x0002},
+                    std::vector<uint8_t>(64, 0x5a));
+    // Get Channel Cipher Suites: the channel and a list of records
+    packCase("pack/cipher-suites", uint8_t{0x01},
+             std::vector<uint16_t>(8, 0x01c0));
+    packUnsizedCase("pack/cipher-suites-unsized", uint8_t{0x01},
+                    std::vector<uint16_t>(8, 0x01c0));
+    packCase("pack/array16", std::array<uint8_t, 16>{});
+    packCase("pack/array4xuint32", std::array<uint32_t, 4>{});
+
+    // Get Sensor Reading
+    unpackCase<uint8_t>("unpack/uint8", {0x01});
+    unpackCase<uint8_t, uint16_t, uint32_t, std::array<uint8_t, 4>>(
+        "unpack/fixed-tuple", {0x20, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+                               0x02, 0x03, 0x04});
+    // Set Chassis Capabilities style bit-fields
+    unpackCase<bool, uint7_t, uint4_t, uint4_t, uint8_t>(
+        "unpack/bit-fields", {0x81, 0x5a, 0x20});
+    {
+        ipmi::message::Payload p(std::vector<uint8_t>{0x81, 0x5a, 0x20});
+        run("unpack/bit-fields-bytewise", [&]() {
+            p.reset();
+            uint64_t sum = 0;
+            for (size_t width : {1, 7, 4, 4, 8})
+            {
+                sum += popBytewise(p, width);
+            }
+            doNotOptimize(sum);
+        });
+    }
+    unpackCase<std::bitset<8>, std::bitset<3>, std::bitset<5>,
+               std::bitset<16>>("unpack/bitset", {0x5a, 0x8d, 0x34, 0x12});
+    unpackCase<uint8_t, std::optional<uint8_t>, std::optional<uint16_t>>(
+        "unpack/optional", {0x01, 0x02});
+    unpackCase<std::vector<uint8_t>>("unpack/vector32",
+                                     std::vector<uint8_t>(32, 0xa5));
+    unpackCase<std::vector<uint16_t>>("unpack/vector16xuint16",
+                                      std::vector<uint8_t>(32, 0xa5));
+    unpackCase<std::array<uint8_t, 16>>("unpack/array16",
+                                        std::vector<uint8_t>(16, 0xa5));
+    unpackCase<std::array<uint32_t, 4>>("unpack/array4xuint32",
+                                        std::vector<uint8_t>(16, 0xa5));
+}
+
+} // namespace bench
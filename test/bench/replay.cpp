@@ -0,0 +1,207 @@
+/* Replay an IPMI trace recorded by ipmid against a running ipmid.
+ *
+ * Usage: ipmi_replay <trace> [speedup]
+ *   Record a trace on the BMC with
+ *     busctl call xyz.openbmc_project.Ipmi.Host \
+ *         /xyz/openbmc_project/Ipmi/Statistics \
+ *         xyz.openbmc_project.Ipmi.Statistics StartTrace s /tmp/ipmi.trace
+ *   and finish it with StopTrace. Each request is sent to the execute
+ *   method with the recorded data and options, spaced by the recorded
+ *   delays divided by speedup (1 by default). With a speedup of 0 each
+ *   request is sent as soon as the previous one is answered.
+ *
+ *   ipmid sees the replayed requests on the channel of this program, not
+ *   the one they were recorded on. At the end the latency percentiles of
+ *   the replay and of the recording are printed, along with the number of
+ *   completion codes that differ from the recording.
+ */
+#include "request-trace.hpp"
+
+#include <algorithm>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sdbusplus/asio/connection.hpp>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Replay
+{
+    std::vector<ipmi::trace::Record> records;
+    double speedup = 1.0;
+    size_t next = 0;
+    size_t answered = 0;
+    size_t failed = 0;
+    size_t changed = 0;
+    Clock::time_point start;
+    // offset of the next request from the start, already sped up
+    Clock::duration offset{};
+    std::vector<uint32_t> latencies;
+};
+
+void send(boost::asio::io_context& io,
+          std::shared_ptr<sdbusplus::asio::connection>& conn, Replay& replay,
+          boost::asio::steady_timer& timer);
+
+/* schedule the next request of a timed replay */
+void schedule(boost::asio::io_context& io,
+              std::shared_ptr<sdbusplus::asio::connection>& conn,
+              Replay& replay, boost::asio::steady_timer& timer)
+{
+    if (replay.next >= replay.records.size())
+    {
+        return;
+    }
+    const ipmi::trace::Record& record = replay.records[replay.next];
+    replay.offset += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::micro>(record.delay /
+                                                  replay.speedup));
+    timer.expires_at(replay.start + replay.offset);
+    timer.async_wait([&](const boost::system::error_code& ec) {
+        if (!ec)
+        {
+            send(io, conn, replay, timer);
+        }
+    });
+}
+
+void send(boost::asio::io_context& io,
+          std::shared_ptr<sdbusplus::asio::connection>& conn, Replay& replay,
+          boost::asio::steady_timer& timer)
+{
+    const size_t index = replay.next++;
+    const ipmi::trace::Record& record = replay.records[index];
+    Clock::time_point sent = Clock::now();
+    conn->async_method_call(
+        [&, index, sent](const boost::system::error_code& ec, uint8_t,
+                         uint8_t, uint8_t, uint8_t cc,
+                         const std::vector<uint8_t>&) {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - sent);
+            replay.latencies.push_back(static_cast<uint32_t>(us.count()));
+            if (ec)
+            {
+                replay.failed++;
+            }
+            else if (cc != replay.records[index].cc)
+            {
+                replay.changed++;
+            }
+            if (++replay.answered == replay.records.size())
+            {
+                io.stop();
+            }
+            else if (replay.speedup == 0)
+            {
+                send(io, conn, replay, timer);
+            }
+        },
+        "xyz.openbmc_project.Ipmi.Host", "/xyz/openbmc_project/Ipmi",
+        "xyz.openbmc_project.Ipmi.Server", "execute", record.netFn,
+        record.lun, record.cmd, record.data, record.options);
+
+    if (replay.speedup != 0)
+    {
+        schedule(io, conn, replay, timer);
+    }
+}
+
+void printPercentiles(const char* name, std::vector<uint32_t>& latencies)
+{
+    if (latencies.empty())
+    {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&latencies](double p) {
+        size_t i = static_cast<size_t>(p * (latencies.size() - 1));
+        return latencies[i];
+    };
+    std::printf("%-10s p50 %8u us  p90 %8u us  p99 %8u us  max %8u us\n",
+                name, at(0.50), at(0.90), at(0.99), latencies.back());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <trace> [speedup]\n", argv[0]);
+        return 1;
+    }
+
+    Replay replay;
+    if (argc > 2)
+    {
+        replay.speedup = std::strtod(argv[2], nullptr);
+        if (replay.speedup < 0)
+        {
+            std::fprintf(stderr, "speedup must be 0 or more\n");
+            return 1;
+        }
+    }
+
+    FILE* in = std::fopen(argv[1], "re");
+    if (!in)
+    {
+        std::perror(argv[1]);
+        return 1;
+    }
+    if (!ipmi::trace::readHeader(in))
+    {
+        std::fprintf(stderr, "%s: not an IPMI trace\n", argv[1]);
+        std::fclose(in);
+        return 1;
+    }
+    ipmi::trace::Record record;
+    while (ipmi::trace::read(in, record))
+    {
+        replay.records.push_back(record);
+    }
+    std::fclose(in);
+    if (replay.records.empty())
+    {
+        std::fprintf(stderr, "%s: no requests\n", argv[1]);
+        return 1;
+    }
+    // the first request is sent right away
+    replay.records.front().delay = 0;
+
+    boost::asio::io_context io;
+    auto conn = std::make_shared<sdbusplus::asio::connection>(io);
+    boost::asio::steady_timer timer(io);
+    replay.latencies.reserve(replay.records.size());
+    replay.start = Clock::now();
+    if (replay.speedup == 0)
+    {
+        send(io, conn, replay, timer);
+    }
+    else
+    {
+        schedule(io, conn, replay, timer);
+    }
+    io.run();
+
+    double seconds =
+        std::chrono::duration<double>(Clock::now() - replay.start).count();
+    std::printf("%zu requests in %.3f s, %zu failed, %zu changed cc\n",
+                replay.answered, seconds, replay.failed, replay.changed);
+    printPercentiles("replay", replay.latencies);
+
+    std::vector<uint32_t> recorded;
+    recorded.reserve(replay.records.size());
+    for (const ipmi::trace::Record& r : replay.records)
+    {
+        recorded.push_back(r.latency);
+    }
+    printPercentiles("recorded", recorded);
+    return replay.failed ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/* Benchmarks for the user and channel layer queries the IPMI handlers make.
+ *
+ * Usage: user_channel_bench [filter]
+ *   Same output as message_bench. The layers read the real configuration,
+ *   so this has to run on a BMC with ipmid's configuration files and the
+ *   D-Bus user manager, as root. The data files are not modified; the
+ *   password file gets its timestamps back at the end.
+ *
+ * The "-reload" cases bump the shared generation of the data file (or the
+ * mtime of the password file) before every query, the same as another
+ * process writing it would, so they measure the reload path.
+ */
+#include "bench.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <user_channel/channel_layer.hpp>
+#include <user_channel/channel_mgmt.hpp>
+#include <user_channel/user_layer.hpp>
+
+namespace bench
+{
+
+namespace
+{
+
+/* as in user_mgmt.cpp and passwd_mgr.cpp */
+constexpr const char* userGeneration = "ipmi_usr_generation";
+constexpr const char* passwdFileName = "/etc/ipmi-pass";
+
+/** @class Generation
+ *  @brief One of the generation counters the layers share between processes
+ */
+class Generation
+{
+  public:
+    /** @brief map a counter; the layer must have created the segment */
+    Generation(const char* segment, size_t index)
+    {
+        boost::interprocess::shared_memory_object shm(
+            boost::interprocess::open_only, segment,
+            boost::interprocess::read_write);
+        region = boost::interprocess::mapped_region(
+            shm, boost::interprocess::read_write);
+        counter =
+            static_cast<std::atomic<uint32_t>*>(region.get_address()) + index;
+    }
+
+    /** @brief make the next query reload the file */
+    void bump()
+    {
+        (*counter)++;
+    }
+
+  private:
+    boost::interprocess::mapped_region region;
+    std::atomic<uint32_t>* counter;
+};
+
+/* flip the mtime of the password file between two values in the past, so
+ * that every query sees a change without the content changing */
+void touchPasswdFile()
+{
+    static bool odd = false;
+    odd = !odd;
+    struct timespec times[2] = {};
+    times[0].tv_sec = times[1].tv_sec = odd ? 1 : 2;
+    utimensat(AT_FDCWD, passwdFileName, times, 0);
+}
+
+void userBenchmarks(uint8_t userId, uint8_t chNum)
+{
+    std::string userName;
+    if (ipmi::ipmiUserGetUserName(userId, userName) != IPMI_CC_OK ||
+        userName.empty())
+    {
+        std::printf("user %d does not exist; skipping the user cases\n",
+                    userId);
+        return;
+    }
+
+    run("user/get-user-id", [&]() {
+        uint8_t id = ipmi::ipmiUserGetUserId(userName);
+        doNotOptimize(id);
+    });
+    run("user/get-user-name", [&]() {
+        std::string name;
+        ipmi::ipmiUserGetUserName(userId, name);
+        doNotOptimize(name);
+    });
+    run("user/check-enabled", [&]() {
+        bool enabled = false;
+        ipmi::ipmiUserCheckEnabled(userId, enabled);
+        doNotOptimize(enabled);
+    });
+    run("user/get-privilege-access", [&]() {
+        ipmi::PrivAccess access{};
+        ipmi::ipmiUserGetPrivilegeAccess(userId, chNum, access);
+        doNotOptimize(access);
+    });
+    run("user/get-all-counts", [&]() {
+        uint8_t maxUsers = 0, enabledUsers = 0, fixedUsers = 0;
+        ipmi::ipmiUserGetAllCounts(maxUsers, enabledUsers, fixedUsers);
+        doNotOptimize(enabledUsers);
+    });
+    run("passwd/get-password", [&]() {
+        std::string password = ipmi::ipmiUserGetPassword(userName);
+        doNotOptimize(password);
+    });
+
+    Generation generation(userGeneration, 0);
+    run("user/check-enabled-reload", [&]() {
+        generation.bump();
+        bool enabled = false;
+        ipmi::ipmiUserCheckEnabled(userId, enabled);
+        doNotOptimize(enabled);
+    });
+
+    struct stat fileStat = {};
+    if (stat(passwdFileName, &fileStat) == 0)
+    {
+        run("passwd/get-password-reload", [&]() {
+            touchPasswdFile();
+            std::string password = ipmi::ipmiUserGetPassword(userName);
+            doNotOptimize(password);
+        });
+        struct timespec times[2] = {fileStat.st_atim, fileStat.st_mtim};
+        utimensat(AT_FDCWD, passwdFileName, times, 0);
+    }
+}
+
+void channelBenchmarks(uint8_t chNum)
+{
+    run("channel/is-valid-channel", [&]() {
+        bool valid = ipmi::isValidChannel(chNum);
+        doNotOptimize(valid);
+    });
+    run("channel/get-session-support", [&]() {
+        ipmi::EChannelSessSupported support =
+            ipmi::getChannelSessionSupport(chNum);
+        doNotOptimize(support);
+    });
+    run("channel/get-max-transfer-size", [&]() {
+        size_t size = ipmi::getChannelMaxTransferSize(chNum);
+        doNotOptimize(size);
+    });
+    run("channel/get-channel-info", [&]() {
+        ipmi::ChannelInfo info{};
+        ipmi::getChannelInfo(chNum, info);
+        doNotOptimize(info);
+    });
+    run("channel/get-access-data", [&]() {
+        ipmi::ChannelAccess access{};
+        ipmi::getChannelAccessData(chNum, access);
+        doNotOptimize(access);
+    });
+    run("channel/get-access-persist-data", [&]() {
+        ipmi::ChannelAccess access{};
+        ipmi::getChannelAccessPersistData(chNum, access);
+        doNotOptimize(access);
+    });
+
+    // the NV generation comes first in the segment, then the volatile one
+    Generation nvGeneration(ipmi::ipmiChannelGeneration, 0);
+    Generation volatileGeneration(ipmi::ipmiChannelGeneration, 1);
+    run("channel/get-access-data-reload", [&]() {
+        volatileGeneration.bump();
+        ipmi::ChannelAccess access{};
+        ipmi::getChannelAccessData(chNum, access);
+        doNotOptimize(access);
+    });
+    run("channel/get-access-persist-data-reload", [&]() {
+        nvGeneration.bump();
+        ipmi::ChannelAccess access{};
+        ipmi::getChannelAccessPersistData(chNum, access);
+        doNotOptimize(access);
+    });
+}
+
+/* the first channel that supports sessions, as the user cases need one */
+uint8_t findSessionChannel()
+{
+    for (uint8_t chNum = 0; chNum < ipmi::maxIpmiChannels; chNum++)
+    {
+        if (ipmi::isValidChannel(chNum) &&
+            ipmi::getChannelSessionSupport(chNum) !=
+                ipmi::EChannelSessSupported::none)
+        {
+            return chNum;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+} // namespace bench
+
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        bench::setFilter(argv[1]);
+    }
+
+    ipmi::ipmiChannelInit();
+    ipmi::ipmiUserInit();
+
+    uint8_t chNum = bench::findSessionChannel();
+    bench::channelBenchmarks(chNum);
+    bench::userBenchmarks(1, chNum);
+    return 0;
+}
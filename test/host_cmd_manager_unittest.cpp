@@ -0,0 +1,128 @@
+#include "host-cmd-manager.hpp"
+
+#include "systemintfcmds.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <ipmid-host/cmd-utils.hpp>
+#include <ipmid/utils.hpp>
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/test/sdbus_mock.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace ipmi
+{
+
+// the bridge is whatever the mocked bus says it is, without a mapper
+std::string getService(sdbusplus::bus::bus&, const std::string&,
+                       const std::string&)
+{
+    return "org.openbmc.HostIpmi";
+}
+
+} // namespace ipmi
+
+namespace
+{
+
+using namespace phosphor::host::command;
+
+constexpr IPMIcmd otherCmd = 0x01;
+
+class HostCmdManager : public testing::Test
+{
+  protected:
+    /* queue a command that records its result each time it completes */
+    void execute(const IpmiCmdData& command, std::vector<bool>& results)
+    {
+        manager.execute(std::make_tuple(
+            command, [&results](IpmiCmdData, bool status) {
+                results.push_back(status);
+            }));
+    }
+
+    testing::NiceMock<sdbusplus::SdBusMock> sdbusMock;
+    sdbusplus::bus::bus bus = sdbusplus::get_mocked_new(&sdbusMock);
+    Manager manager{bus};
+};
+
+} // namespace
+
+TEST_F(HostCmdManager, PriorityCommandJumpsNormalOnes)
+{
+    const IpmiCmdData heartbeat{CMD_HEARTBEAT, 0x00};
+    const IpmiCmdData first{otherCmd, 0x01};
+    const IpmiCmdData second{otherCmd, 0x02};
+    const IpmiCmdData softOff{CMD_POWER, SOFT_OFF};
+    std::vector<bool> results;
+    execute(heartbeat, results);
+    execute(first, results);
+    execute(second, results);
+    execute(softOff, results);
+
+    // a soft off first, heartbeats last, the rest in the order they came
+    EXPECT_EQ(softOff, manager.getNextCommand());
+    EXPECT_EQ(first, manager.getNextCommand());
+    EXPECT_EQ(second, manager.getNextCommand());
+    EXPECT_EQ(heartbeat, manager.getNextCommand());
+    EXPECT_FALSE(manager.hasCommands());
+    EXPECT_EQ(std::vector<bool>(4, true), results);
+}
+
+TEST_F(HostCmdManager, DuplicatesCompleteEveryCallbackOnce)
+{
+    const IpmiCmdData softOff{CMD_POWER, SOFT_OFF};
+    const IpmiCmdData other{otherCmd, 0x01};
+    std::vector<bool> softOffResults;
+    std::vector<bool> otherResults;
+    execute(softOff, softOffResults);
+    execute(other, otherResults);
+    execute(softOff, softOffResults);
+    execute(softOff, softOffResults);
+
+    // the host reads the soft off once, for all three of them
+    EXPECT_EQ(softOff, manager.getNextCommand());
+    EXPECT_EQ(std::vector<bool>(3, true), softOffResults);
+    EXPECT_TRUE(otherResults.empty());
+
+    EXPECT_EQ(other, manager.getNextCommand());
+    EXPECT_EQ(std::vector<bool>{true}, otherResults);
+    EXPECT_FALSE(manager.hasCommands());
+
+    // once read, the same command is queued again
+    execute(softOff, softOffResults);
+    EXPECT_TRUE(manager.hasCommands());
+    EXPECT_EQ(softOff, manager.getNextCommand());
+    EXPECT_EQ(std::vector<bool>(4, true), softOffResults);
+}
+
+TEST_F(HostCmdManager, StatsCountCommands)
+{
+    constexpr auto wait = std::chrono::milliseconds(2);
+    std::vector<bool> results;
+    execute({otherCmd, 0x01}, results);
+    execute({otherCmd, 0x02}, results);
+    execute({otherCmd, 0x01}, results);
+    execute({otherCmd, 0x03}, results);
+
+    std::this_thread::sleep_for(wait);
+    while (manager.hasCommands())
+    {
+        manager.getNextCommand();
+    }
+    // the host asking with nothing queued isn't a command read
+    EXPECT_EQ((IpmiCmdData{CMD_HEARTBEAT, 0x00}), manager.getNextCommand());
+
+    const QueueStats& stats = manager.getStats();
+    EXPECT_EQ(3, stats.commands);
+    EXPECT_EQ(1, stats.coalesced);
+    EXPECT_EQ(3, stats.peakDepth);
+    EXPECT_GE(stats.maxLatency, wait);
+    EXPECT_GE(stats.totalLatency, stats.maxLatency);
+    EXPECT_EQ(4, results.size());
+}
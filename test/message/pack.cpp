@@ -424,3 +424,58 @@ TEST(PackAdvanced, ComplexOptionalTuple)
                               0x1f, 0xd8};
     ASSERT_EQ(p.raw, k);
 }
+
+TEST(PackAdvanced, FixedLayoutTuple)
+{
+    // a tuple made up of byte-aligned fixed-width integers is stored as one
+    // block, which must match packing the elements one at a time
+    uint16_t v1 = 0x8604;
+    uint24_t v2 = 0x0a0b0c;
+    std::array<uint8_t, 2> v3 = {0x11, 0x22};
+    uint32_t v4 = 0x02008604;
+    ipmi::message::Payload p;
+    p.pack(std::make_tuple(v1, v2, v3, v4));
+    ipmi::message::Payload q;
+    q.pack(v1, v2, v3, v4);
+    // check that the number of bytes matches
+    ASSERT_EQ(p.size(), 11);
+    // check that the bytes were correctly packed (LSB first)
+    std::vector<uint8_t> k = {0x04, 0x86, 0x0c, 0x0b, 0x0a, 0x11,
+                              0x22, 0x04, 0x86, 0x00, 0x02};
+    ASSERT_EQ(p.raw, k);
+    ASSERT_EQ(p.raw, q.raw);
+}
+
+TEST(PackAdvanced, PackedSizeMatchesPack)
+{
+    // the size used to reserve the response buffer is the size that is
+    // packed, whether it is known at compile time or from the values
+    using Fixed = std::tuple<uint8_t, uint16_t, uint24_t, std::bitset<4>,
+                             uint4_t, std::array<uint32_t, 2>>;
+    static_assert(ipmi::message::details::PackedBits<Fixed>::fixed ==
+                  (1 + 2 + 3 + 1 + 8) * CHAR_BIT);
+    Fixed fixed{};
+    std::vector<uint16_t> v2(5, 0x1234);
+    std::optional<uint32_t> v3 = 0x01020304;
+    std::optional<uint32_t> v4;
+    std::string v5 = "sdr";
+    std::variant<uint8_t, uint32_t> v6 = uint32_t{7};
+    std::vector<bool> v7(3, true);
+    ipmi::message::Payload p;
+    p.pack(fixed, v2, v3, v4, v5, v6, v7);
+    ASSERT_EQ(ipmi::message::details::packedSize(fixed, v2, v3, v4, v5, v6,
+                                                 v7),
+              p.size());
+}
+
+TEST(PackAdvanced, ReservedPackDoesNotGrow)
+{
+    std::vector<uint16_t> records(100, 0x1234);
+    auto t = std::make_tuple(uint8_t{0x20}, records, std::string("fru"));
+    ipmi::message::Payload p;
+    p.reserve(ipmi::message::details::packedSize(t));
+    const uint8_t* buffer = p.data();
+    p.pack(t);
+    ASSERT_EQ(p.size(), 205);
+    ASSERT_EQ(p.data(), buffer);
+}
@@ -99,6 +99,18 @@ TEST(PayloadResponse, AppendBits)
     ASSERT_EQ(p.raw, k2);
 }
 
+TEST(PayloadResponse, AppendWord)
+{
+    ipmi::message::Payload p;
+    p.appendBits(3, 0b101);
+    // the pending bits come first, whole bytes are flushed right away
+    p.appendWord(18, 0b110011110000111100);
+    ASSERT_EQ(p.bitCount, 5);
+    ASSERT_EQ(p.bitStream, 0b11001);
+    std::vector<uint8_t> k = {0b11100101, 0b11100001};
+    ASSERT_EQ(p.raw, k);
+}
+
 TEST(PayloadResponse, Drain16Bits)
 {
     ipmi::message::Payload p;
@@ -199,6 +211,31 @@ TEST(PayloadRequest, PopBits)
     ASSERT_EQ(v, 0x0f);
 }
 
+TEST(PayloadRequest, PopWord)
+{
+    std::vector<uint8_t> i = {0xbf, 0x04, 0x86, 0x00, 0x02};
+    ipmi::message::Payload p(std::forward<std::vector<uint8_t>>(i));
+    p.fillBits(4);
+    p.popBits(4);
+    uint64_t v = 0;
+    ASSERT_FALSE(p.popWord(16, v));
+    ASSERT_EQ(v, 0x604b);
+    ASSERT_EQ(p.bitStream, 0x08);
+    ASSERT_EQ(p.bitCount, 4);
+    ASSERT_EQ(p.rawIndex, 3);
+}
+
+TEST(PayloadRequest, PopWordInsufficientBits)
+{
+    std::vector<uint8_t> i = {0xbf, 0x04};
+    ipmi::message::Payload p(std::forward<std::vector<uint8_t>>(i));
+    uint64_t v = 0;
+    // the stream is left as it was
+    ASSERT_TRUE(p.popWord(17, v));
+    ASSERT_EQ(p.bitCount, 0);
+    ASSERT_EQ(p.rawIndex, 0);
+}
+
 TEST(PayloadRequest, PopBitsNoFillBits)
 {
     std::vector<uint8_t> i = {0xbf, 0x04, 0x86, 0x00, 0x02};
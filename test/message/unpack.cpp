@@ -855,3 +855,19 @@ TEST(UnpackAdvanced, UnalignedBitUnpacking)
     ASSERT_EQ(v6, k6);
     ASSERT_EQ(v7, k7);
 }
+
+TEST(UnpackAdvanced, FixedLayoutTupleInsufficientBytes)
+{
+    // a fixed layout tuple is unpacked as a whole or not at all
+    std::vector<uint8_t> i = {0x04, 0x86, 0x0c, 0x0b};
+    ipmi::message::Payload p(std::forward<std::vector<uint8_t>>(i));
+    std::tuple<uint16_t, uint24_t> v;
+    // check that the number of bytes matches
+    ASSERT_NE(p.unpack(v), 0);
+    // check that nothing was consumed from the payload
+    ASSERT_EQ(p.rawIndex, 0);
+    uint16_t v1;
+    // check that the payload can still be unpacked
+    ASSERT_EQ(p.unpack(v1), 0);
+    ASSERT_EQ(v1, 0x8604);
+}
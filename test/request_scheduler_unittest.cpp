@@ -0,0 +1,221 @@
+#include "config.h"
+
+#include "request-scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ipmid/message.hpp>
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using namespace ipmi;
+using Clock = std::chrono::steady_clock;
+
+/* the scheduler is global, so every test takes out what it queued */
+void drain()
+{
+    while (scheduler::pop(0))
+    {
+    }
+}
+
+/* queue a request that records its channel once it is started */
+bool push(uint8_t channel, bool priority, std::vector<uint8_t>& started,
+          Clock::time_point received = Clock::now())
+{
+    return scheduler::push(
+        channel, priority,
+        [channel, &started]() { started.push_back(channel); }, received);
+}
+
+/* start the next request; false if none may start */
+bool start(size_t inUse)
+{
+    std::optional<scheduler::Pending> next = scheduler::pop(inUse);
+    if (!next)
+    {
+        return false;
+    }
+    next->resume();
+    return true;
+}
+
+} // namespace
+
+TEST(Scheduler, QueueFullRejects)
+{
+    constexpr uint8_t channel = 1;
+    std::vector<uint8_t> started;
+    for (size_t i = 0; i < IPMI_SCHEDULER_QUEUE_LIMIT; i++)
+    {
+        ASSERT_TRUE(push(channel, false, started));
+    }
+    EXPECT_FALSE(push(channel, false, started));
+    EXPECT_EQ(IPMI_SCHEDULER_QUEUE_LIMIT, scheduler::queued());
+    EXPECT_EQ(IPMI_SCHEDULER_QUEUE_LIMIT,
+              scheduler::getStats()[channel].peak);
+
+    // the other channels have queues of their own
+    EXPECT_TRUE(push(channel + 1, false, started));
+
+    drain();
+    EXPECT_EQ(0, scheduler::queued());
+    EXPECT_EQ(0, scheduler::getStats()[channel].queued);
+}
+
+TEST(Scheduler, ChannelStartsInOrder)
+{
+    constexpr uint8_t channel = 2;
+    std::vector<uint8_t> started;
+    ASSERT_TRUE(scheduler::admit(channel, false, 0));
+    ASSERT_TRUE(push(channel, false, started));
+
+    // a request queues behind those of its channel, even with coroutines
+    // free, but not behind those of another channel
+    EXPECT_FALSE(scheduler::admit(channel, false, 0));
+    EXPECT_TRUE(scheduler::admit(channel + 1, false, 0));
+
+    ASSERT_TRUE(start(0));
+    EXPECT_EQ(std::vector<uint8_t>{channel}, started);
+    EXPECT_TRUE(scheduler::admit(channel, false, 0));
+    EXPECT_FALSE(start(0));
+}
+
+TEST(Scheduler, ReservedCoroutines)
+{
+    constexpr uint8_t channel = 3;
+    constexpr uint8_t systemChannel = 4;
+    constexpr size_t shared =
+        IPMI_COROUTINE_POOL_DEPTH - IPMI_SCHEDULER_RESERVED;
+    std::vector<uint8_t> started;
+
+    EXPECT_TRUE(scheduler::admit(channel, false, shared - 1));
+    EXPECT_FALSE(scheduler::admit(channel, false, shared));
+    EXPECT_TRUE(scheduler::admit(systemChannel, true, shared));
+    EXPECT_FALSE(scheduler::admit(systemChannel, true,
+                                  IPMI_COROUTINE_POOL_DEPTH));
+
+    // a queued request of another channel waits for a shared coroutine
+    ASSERT_TRUE(push(channel, false, started));
+    EXPECT_FALSE(start(shared));
+    ASSERT_TRUE(push(systemChannel, true, started));
+    ASSERT_TRUE(start(shared));
+    EXPECT_EQ(std::vector<uint8_t>{systemChannel}, started);
+    EXPECT_FALSE(start(shared));
+
+    drain();
+}
+
+TEST(Scheduler, SystemChannelWeight)
+{
+    constexpr uint8_t channel = 5;
+    constexpr uint8_t systemChannel = 6;
+    static_assert(IPMI_SCHEDULER_QUEUE_LIMIT >= IPMI_SCHEDULER_SYSTEM_WEIGHT,
+                  "the test queues a full round on the system channel");
+    std::vector<uint8_t> started;
+    ASSERT_TRUE(push(channel, false, started));
+    for (size_t i = 0; i < IPMI_SCHEDULER_SYSTEM_WEIGHT; i++)
+    {
+        ASSERT_TRUE(push(systemChannel, true, started));
+    }
+
+    // one round: the system channel starts its weight, the other one
+    for (size_t i = 0; i <= IPMI_SCHEDULER_SYSTEM_WEIGHT; i++)
+    {
+        ASSERT_TRUE(start(0));
+    }
+    EXPECT_EQ(IPMI_SCHEDULER_SYSTEM_WEIGHT,
+              std::count(started.begin(), started.end(), systemChannel));
+    EXPECT_EQ(1, std::count(started.begin(), started.end(), channel));
+    EXPECT_FALSE(start(0));
+}
+
+TEST(Scheduler, SenderLimit)
+{
+    constexpr uint64_t sender = 1;
+    constexpr uint64_t other = 2;
+    uint64_t rejected = scheduler::getInFlightStats().senderRejected;
+    for (size_t i = 0; i < IPMI_SENDER_IN_FLIGHT_LIMIT; i++)
+    {
+        ASSERT_TRUE(scheduler::enter(sender, false));
+    }
+    // the system interface channels are not exempt
+    EXPECT_FALSE(scheduler::enter(sender, true));
+    EXPECT_EQ(rejected + 1, scheduler::getInFlightStats().senderRejected);
+    EXPECT_TRUE(scheduler::enter(other, false));
+
+    scheduler::leave(other);
+    scheduler::leave(sender);
+    EXPECT_TRUE(scheduler::enter(sender, false));
+    for (size_t i = 0; i < IPMI_SENDER_IN_FLIGHT_LIMIT; i++)
+    {
+        scheduler::leave(sender);
+    }
+    EXPECT_EQ(0, scheduler::getInFlightStats().inFlight);
+}
+
+TEST(Scheduler, UnknownSendersNotLimitedAsOne)
+{
+    for (size_t i = 0; i <= IPMI_SENDER_IN_FLIGHT_LIMIT; i++)
+    {
+        ASSERT_TRUE(scheduler::enter(scheduler::unknownSender, false));
+    }
+    EXPECT_EQ(IPMI_SENDER_IN_FLIGHT_LIMIT + 1,
+              scheduler::getInFlightStats().inFlight);
+    for (size_t i = 0; i <= IPMI_SENDER_IN_FLIGHT_LIMIT; i++)
+    {
+        scheduler::leave(scheduler::unknownSender);
+    }
+    EXPECT_EQ(0, scheduler::getInFlightStats().inFlight);
+}
+
+TEST(Scheduler, InFlightLimit)
+{
+    // one request per sender, to stay clear of the per sender limit
+    constexpr uint64_t firstSender = 100;
+    constexpr uint64_t systemSender = firstSender + IPMI_IN_FLIGHT_LIMIT;
+    uint64_t rejected = scheduler::getInFlightStats().rejected;
+    for (uint64_t sender = firstSender; sender < systemSender; sender++)
+    {
+        ASSERT_TRUE(scheduler::enter(sender, false));
+    }
+    EXPECT_FALSE(scheduler::enter(systemSender, false));
+    EXPECT_EQ(rejected + 1, scheduler::getInFlightStats().rejected);
+    EXPECT_TRUE(scheduler::enter(systemSender, true));
+
+    for (uint64_t sender = firstSender; sender <= systemSender; sender++)
+    {
+        scheduler::leave(sender);
+    }
+    EXPECT_EQ(0, scheduler::getInFlightStats().inFlight);
+}
+
+TEST(Scheduler, DeadlineCountsQueuedTime)
+{
+    constexpr uint8_t channel = 7;
+    constexpr auto deadline = std::chrono::milliseconds(500);
+    std::vector<uint8_t> started;
+    Clock::time_point received = Clock::now() - std::chrono::seconds(1);
+    ASSERT_TRUE(push(channel, false, started, received));
+
+    std::optional<scheduler::Pending> next = scheduler::pop(0);
+    ASSERT_TRUE(next);
+    EXPECT_EQ(received, next->received);
+
+    // a request that waited past its deadline has expired once it starts
+    Context ctx;
+    ctx.deadline = next->received + deadline;
+    EXPECT_TRUE(ctx.expired());
+
+    ASSERT_TRUE(push(channel, false, started));
+    next = scheduler::pop(0);
+    ASSERT_TRUE(next);
+    ctx.deadline = next->received + deadline;
+    EXPECT_FALSE(ctx.expired());
+}
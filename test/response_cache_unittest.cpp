@@ -0,0 +1,92 @@
+#include "response-cache.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <ipmid/api.hpp>
+#include <ipmid/handler.hpp>
+#include <ipmid/message.hpp>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using namespace ipmi;
+
+constexpr Cmd cachedCmd = app::cmdGetSystemGuid;
+constexpr int channel = 1;
+
+message::Request::ptr makeRequest(size_t hostIdx, Cmd cmd = cachedCmd)
+{
+    auto ctx = std::make_shared<Context>(netFnApp, cmd, channel, 1,
+                                         Privilege::Admin);
+    ctx->hostIdx = hostIdx;
+    return std::make_shared<message::Request>(ctx, std::vector<uint8_t>{});
+}
+
+message::Response::ptr makeResponse(const message::Request::ptr& request,
+                                    uint8_t value, Cc cc = ccSuccess)
+{
+    message::Response::ptr response = request->makeResponse();
+    response->cc = cc;
+    response->payload.pack(value);
+    return response;
+}
+
+class ResponseCache : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        registerResponseCache(netFnApp, cachedCmd,
+                              std::chrono::milliseconds(0));
+    }
+
+    void TearDown() override
+    {
+        cache::clear();
+    }
+};
+
+} // namespace
+
+TEST_F(ResponseCache, StoredResponseIsReturned)
+{
+    auto request = makeRequest(0);
+    EXPECT_EQ(nullptr, cache::lookup(request));
+    cache::store(request, makeResponse(request, 0x42));
+
+    message::Response::ptr cached = cache::lookup(makeRequest(0));
+    ASSERT_NE(nullptr, cached);
+    EXPECT_EQ(ccSuccess, cached->cc);
+    EXPECT_EQ(std::vector<uint8_t>{0x42}, cached->payload.raw);
+}
+
+TEST_F(ResponseCache, HostsGetTheirOwnEntries)
+{
+    auto host0 = makeRequest(0);
+    auto host1 = makeRequest(1);
+    cache::store(host0, makeResponse(host0, 0x10));
+    EXPECT_EQ(nullptr, cache::lookup(host1));
+
+    cache::store(host1, makeResponse(host1, 0x11));
+    message::Response::ptr cached0 = cache::lookup(makeRequest(0));
+    message::Response::ptr cached1 = cache::lookup(makeRequest(1));
+    ASSERT_NE(nullptr, cached0);
+    ASSERT_NE(nullptr, cached1);
+    EXPECT_EQ(std::vector<uint8_t>{0x10}, cached0->payload.raw);
+    EXPECT_EQ(std::vector<uint8_t>{0x11}, cached1->payload.raw);
+}
+
+TEST_F(ResponseCache, OnlySuccessfulResponsesOfCachedCommandsAreKept)
+{
+    auto failed = makeRequest(0);
+    cache::store(failed, makeResponse(failed, 0, ccUnspecifiedError));
+    EXPECT_EQ(nullptr, cache::lookup(failed));
+
+    auto other = makeRequest(0, app::cmdGetDeviceId);
+    cache::store(other, makeResponse(other, 0x20));
+    EXPECT_EQ(nullptr, cache::lookup(other));
+}
@@ -0,0 +1,154 @@
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio/io_context.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <ipmid/event-buffer.hpp>
+#include <ipmid/ring-buffer.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// libipmid only lets ipmid set these
+extern void setIoContext(std::shared_ptr<boost::asio::io_context>& newIo);
+
+using ipmi::RingBuffer;
+
+TEST(RingBuffer, PopOnEmpty)
+{
+    RingBuffer<int, 4> ring;
+    int value = -1;
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.pop(value));
+    EXPECT_EQ(-1, value);
+}
+
+TEST(RingBuffer, PushUntilFull)
+{
+    RingBuffer<int, 4> ring;
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(ring.push(i));
+    }
+    EXPECT_EQ(4, ring.size());
+    EXPECT_FALSE(ring.push(4));
+    EXPECT_EQ(4, ring.size());
+
+    // what is in the ring is kept, in order
+    int value;
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(ring.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(ring.pop(value));
+}
+
+TEST(RingBuffer, WrapsAround)
+{
+    RingBuffer<int, 4> ring;
+    int value;
+    // many turns of the ring, at every fill level
+    for (int turn = 0; turn < 64; turn++)
+    {
+        int count = turn % 4 + 1;
+        for (int i = 0; i < count; i++)
+        {
+            ASSERT_TRUE(ring.push(turn * 10 + i));
+        }
+        for (int i = 0; i < count; i++)
+        {
+            ASSERT_TRUE(ring.pop(value));
+            EXPECT_EQ(turn * 10 + i, value);
+        }
+        EXPECT_TRUE(ring.empty());
+    }
+}
+
+TEST(RingBuffer, ConcurrentPushAndPop)
+{
+    constexpr size_t producers = 4;
+    constexpr size_t consumers = 4;
+    constexpr uint32_t perProducer = 100000;
+    RingBuffer<uint32_t, 64> ring;
+
+    std::vector<std::atomic<uint32_t>> seen(producers * perProducer);
+    std::atomic<size_t> popped{0};
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&ring, p]() {
+            for (uint32_t i = 0; i < perProducer; i++)
+            {
+                while (!ring.push(p * perProducer + i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&ring, &seen, &popped]() {
+            uint32_t value;
+            while (popped.load() < producers * perProducer)
+            {
+                if (ring.pop(value))
+                {
+                    seen[value]++;
+                    popped++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // every value came out exactly once
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(producers * perProducer, popped.load());
+    EXPECT_TRUE(std::all_of(seen.begin(), seen.end(),
+                            [](const auto& count) { return count == 1; }));
+}
+
+TEST(EventBuffer, FullBufferDropsAndCounts)
+{
+    auto io = std::make_shared<boost::asio::io_context>();
+    setIoContext(io);
+    constexpr size_t host = 0;
+    ipmi::events::setEnabled(host, true);
+
+    ipmi::events::Message message{};
+    for (size_t i = 0; i < IPMI_EVENT_BUFFER_ENTRIES; i++)
+    {
+        message[0] = static_cast<uint8_t>(i);
+        ASSERT_TRUE(ipmi::events::post(host, message));
+    }
+    uint64_t overflows = ipmi::events::overflows(host);
+    EXPECT_FALSE(ipmi::events::post(host, message));
+    EXPECT_EQ(overflows + 1, ipmi::events::overflows(host));
+    EXPECT_EQ(IPMI_EVENT_BUFFER_ENTRIES, ipmi::events::pending(host));
+
+    for (size_t i = 0; i < IPMI_EVENT_BUFFER_ENTRIES; i++)
+    {
+        ASSERT_TRUE(ipmi::events::take(host, message));
+        EXPECT_EQ(static_cast<uint8_t>(i), message[0]);
+    }
+    EXPECT_FALSE(ipmi::events::take(host, message));
+
+    // a disabled buffer takes nothing, and isn't counted as full
+    ipmi::events::setEnabled(host, false);
+    EXPECT_FALSE(ipmi::events::post(host, message));
+    EXPECT_EQ(overflows + 1, ipmi::events::overflows(host));
+    EXPECT_EQ(0, ipmi::events::pending(host));
+}
@@ -7,14 +7,16 @@
 
 #include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <ipmid/api.hpp>
 #include <ipmid/utils.hpp>
+#include <map>
+#include <memory>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/message/types.hpp>
 #include <sdbusplus/timer.hpp>
 #include <string>
+#include <vector>
 #include <xyz/openbmc_project/Common/error.hpp>
 
 #define SYSTEMD_NETWORKD_DBUS 1
@@ -50,12 +52,106 @@ struct ChannelConfig_t* getChannelConfig(int channel)
     return channelConfig[channel].get();
 }
 
+namespace lan_cache
+{
+
+/* The values of the network parameters of each channel as they go into
+ * the Get LAN Configuration Parameters response, keyed by channel and then
+ * by parameter. Every value costs several mapper and property calls, and
+ * an `ipmitool lan print` asks for all of them, so they are kept until the
+ * network daemon announces a change. */
+std::map<int, std::map<uint8_t, std::vector<uint8_t>>> values;
+
+std::vector<std::unique_ptr<sdbusplus::bus::match::match>> networkChanged;
+
+/* the size of a parameter in the response, excluding the revision */
+size_t paramSize(uint8_t lanParam)
+{
+    switch (static_cast<LanParam>(lanParam))
+    {
+        case LanParam::IP:
+        case LanParam::SUBNET:
+        case LanParam::GATEWAY:
+            return ipmi::network::IPV4_ADDRESS_SIZE_BYTE;
+        case LanParam::IPSRC:
+            return ipmi::network::IPSRC_SIZE_BYTE;
+        case LanParam::MAC:
+            return ipmi::network::MAC_ADDRESS_SIZE_BYTE;
+        case LanParam::VLAN:
+            return ipmi::network::VLAN_SIZE_BYTE;
+        default:
+            return 0;
+    }
+}
+
+/* start dropping the values when the network configuration changes;
+ * returns true if the values can be kept */
+bool watch()
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    if (!networkChanged.empty())
+    {
+        return true;
+    }
+    auto bus = ipmi::getSdBus();
+    if (!bus)
+    {
+        return false;
+    }
+    // the parameters of a channel are spread over the interface, its IP
+    // and VLAN objects and the system config, so any change drops all
+    auto drop = [](sdbusplus::message::message&) { values.clear(); };
+    networkChanged.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus,
+        rules::type::signal() + rules::member("PropertiesChanged") +
+            rules::interface("org.freedesktop.DBus.Properties") +
+            rules::path_namespace(ipmi::network::ROOT),
+        drop));
+    networkChanged.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesAdded(ipmi::network::ROOT), drop));
+    networkChanged.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus, rules::interfacesRemoved(ipmi::network::ROOT), drop));
+    networkChanged.emplace_back(std::make_unique<sdbusplus::bus::match::match>(
+        *bus,
+        rules::nameOwnerChanged() + rules::argN(0, ipmi::network::SERVICE),
+        drop));
+    return true;
+}
+
+const std::vector<uint8_t>* find(int channel, uint8_t lanParam)
+{
+    auto channelValues = values.find(channel);
+    if (channelValues == values.end())
+    {
+        return nullptr;
+    }
+    auto value = channelValues->second.find(lanParam);
+    if (value == channelValues->second.end())
+    {
+        return nullptr;
+    }
+    return &value->second;
+}
+
+void store(int channel, uint8_t lanParam, const uint8_t* data)
+{
+    size_t size = paramSize(lanParam);
+    if (size && watch())
+    {
+        values[channel].insert_or_assign(
+            lanParam, std::vector<uint8_t>(data, data + size));
+    }
+}
+
+} // namespace lan_cache
+
 // Helper Function to get IP Address/NetMask/Gateway/MAC Address from Network
 // Manager or Cache based on Set-In-Progress State
 ipmi_ret_t getNetworkData(uint8_t lan_param, uint8_t* data, int channel)
 {
     ipmi_ret_t rc = IPMI_CC_OK;
-    sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+    sdbusplus::bus::bus& bus = getBus();
 
     auto ethdevice = ipmi::getChannelName(channel);
     // if ethdevice is an empty string they weren't expecting this channel.
@@ -67,6 +163,15 @@ ipmi_ret_t getNetworkData(uint8_t lan_param, uint8_t* data, int channel)
     auto ethIP = ethdevice + "/" + ipmi::network::IP_TYPE;
     auto channelConf = getChannelConfig(channel);
 
+    if (channelConf->lan_set_in_progress == SET_COMPLETE)
+    {
+        if (auto cached = lan_cache::find(channel, lan_param))
+        {
+            std::memcpy(data, cached->data(), cached->size());
+            return IPMI_CC_OK;
+        }
+    }
+
     try
     {
         switch (static_cast<LanParam>(lan_param))
@@ -324,43 +429,14 @@ ipmi_ret_t getNetworkData(uint8_t lan_param, uint8_t* data, int channel)
         rc = IPMI_CC_UNSPECIFIED_ERROR;
         return rc;
     }
-    return rc;
-}
-
-namespace cipher
-{
-
-std::vector<uint8_t> getCipherList()
-{
-    std::vector<uint8_t> cipherList;
-
-    std::ifstream jsonFile(configFile);
-    if (!jsonFile.is_open())
-    {
-        log<level::ERR>("Channel Cipher suites file not found");
-        elog<InternalFailure>();
-    }
 
-    auto data = Json::parse(jsonFile, nullptr, false);
-    if (data.is_discarded())
+    if (rc == IPMI_CC_OK && channelConf->lan_set_in_progress == SET_COMPLETE)
     {
-        log<level::ERR>("Parsing channel cipher suites JSON failed");
-        elog<InternalFailure>();
+        lan_cache::store(channel, lan_param, data);
     }
-
-    // Byte 1 is reserved
-    cipherList.push_back(0x00);
-
-    for (const auto& record : data)
-    {
-        cipherList.push_back(record.value(cipher, 0));
-    }
-
-    return cipherList;
+    return rc;
 }
 
-} // namespace cipher
-
 ipmi_ret_t ipmi_transport_wildcard(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                    ipmi_request_t request,
                                    ipmi_response_t response,
@@ -423,7 +499,7 @@ ipmi_ret_t ipmi_transport_set_lan(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     char gateway[INET_ADDRSTRLEN];
 
     auto reqptr = reinterpret_cast<const set_lan_t*>(request);
-    sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+    sdbusplus::bus::bus& bus = getBus();
 
     // channel number is the lower nibble
     int channel = reqptr->channel & CHANNEL_MASK;
@@ -565,21 +641,16 @@ ipmi_ret_t ipmi_transport_get_lan(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         return IPMI_CC_OK;
     }
 
-    static std::vector<uint8_t> cipherList;
-    static auto listInit = false;
-
-    if (!listInit)
+    std::shared_ptr<const cipher::Records> ciphers;
+    try
     {
-        try
-        {
-            cipherList = cipher::getCipherList();
-            listInit = true;
-        }
-        catch (const std::exception& e)
-        {
-            return IPMI_CC_UNSPECIFIED_ERROR;
-        }
+        ciphers = cipher::getRecords();
+    }
+    catch (const std::exception& e)
+    {
+        return IPMI_CC_UNSPECIFIED_ERROR;
     }
+    const auto& cipherList = ciphers->cipherList;
 
     auto ethdevice = ipmi::getChannelName(channel);
     if (ethdevice.empty())
@@ -699,6 +770,143 @@ ipmi_ret_t ipmi_transport_get_lan(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return rc;
 }
 
+/** @struct NetworkState
+ *  @brief The configuration of a channel's interface that applyChanges
+ *         compares the requested one against
+ */
+struct NetworkState
+{
+    /** @brief All the VLAN objects */
+    std::vector<std::string> vlanObjects;
+    /** @brief VLAN ID of the only VLAN object, if it is on the channel */
+    uint32_t vlanID = 0;
+    /** @brief Interface that carries the IP: the VLAN or the physical one */
+    std::string interfacePath;
+    /** @brief Match for the IPv4 addresses of the interface */
+    std::string ipMatch;
+    /** @brief Whether the interface uses DHCP */
+    bool dhcp = false;
+    /** @brief The IPv4 addresses of the interface and their prefixes */
+    std::vector<std::pair<std::string, uint8_t>> addresses;
+};
+
+static NetworkState getNetworkState(sdbusplus::bus::bus& bus,
+                                    const std::string& ethdevice)
+{
+    NetworkState state;
+
+    auto vlans = ipmi::getAllDbusObjects(bus, ipmi::network::ROOT,
+                                         ipmi::network::VLAN_INTERFACE);
+    for (const auto& vlan : vlans)
+    {
+        state.vlanObjects.push_back(vlan.first);
+    }
+
+    state.interfacePath =
+        ipmi::getDbusObject(bus, ipmi::network::ETHERNET_INTERFACE,
+                            ipmi::network::ROOT, ethdevice)
+            .first;
+    if (state.vlanObjects.size() == 1)
+    {
+        const auto& vlanPath = state.vlanObjects.front();
+        auto vlanName = ethdevice + "_";
+        auto name = vlanPath.substr(vlanPath.rfind('/') + 1);
+        if (name.compare(0, vlanName.size(), vlanName) == 0)
+        {
+            // the ID follows the underscore of the interface name; getVLAN
+            // expects the path of an IP object below the interface
+            state.vlanID = ipmi::network::getVLAN(
+                vlanPath + "/" + ipmi::network::IP_TYPE);
+            state.interfacePath = vlanPath;
+        }
+    }
+
+    state.ipMatch = state.interfacePath.substr(
+                        state.interfacePath.rfind('/') + 1) +
+                    "/" + ipmi::network::IP_TYPE;
+    state.dhcp = std::get<bool>(ipmi::getDbusProperty(
+        bus, ipmi::network::SERVICE, state.interfacePath,
+        ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled"));
+
+    auto ips = ipmi::getAllDbusObjects(bus, ipmi::network::ROOT,
+                                       ipmi::network::IP_INTERFACE,
+                                       state.ipMatch);
+    for (const auto& ip : ips)
+    {
+        auto properties = ipmi::getAllDbusProperties(
+            bus, ip.second.begin()->first, ip.first,
+            ipmi::network::IP_INTERFACE);
+        state.addresses.emplace_back(
+            std::get<std::string>(properties["Address"]),
+            std::get<uint8_t>(properties["PrefixLength"]));
+    }
+    return state;
+}
+
+/** @brief Apply the requested configuration to an interface whose VLAN
+ *         stays as it is, skipping what is already configured
+ */
+static void applyToInterface(sdbusplus::bus::bus& bus,
+                             const NetworkState& current,
+                             ipmi::network::IPOrigin ipsrc,
+                             const std::string& ipaddress, uint8_t prefix,
+                             const std::string& gateway,
+                             const ipmi::DbusObjectInfo& systemObject)
+{
+    if (ipsrc == ipmi::network::IPOrigin::DHCP)
+    {
+        if (!current.dhcp)
+        {
+            ipmi::deleteAllDbusObjects(bus, ipmi::network::ROOT,
+                                       ipmi::network::IP_INTERFACE,
+                                       current.ipMatch);
+            ipmi::setDbusProperty(
+                bus, ipmi::network::SERVICE, current.interfacePath,
+                ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", true);
+        }
+        return;
+    }
+
+    if (current.dhcp)
+    {
+        ipmi::setDbusProperty(bus, ipmi::network::SERVICE,
+                              current.interfacePath,
+                              ipmi::network::ETHERNET_INTERFACE,
+                              "DHCPEnabled", false);
+    }
+
+    // the addresses that DHCP handed out are always replaced
+    bool keepIP =
+        !current.dhcp && !ipaddress.empty() &&
+        current.addresses.size() == 1 &&
+        current.addresses.front() == std::make_pair(ipaddress, prefix);
+    if (!keepIP)
+    {
+        ipmi::deleteAllDbusObjects(bus, ipmi::network::ROOT,
+                                   ipmi::network::IP_INTERFACE,
+                                   current.ipMatch);
+        if (!ipaddress.empty())
+        {
+            ipmi::network::createIP(bus, ipmi::network::SERVICE,
+                                    current.interfacePath, ipv4Protocol,
+                                    ipaddress, prefix);
+        }
+    }
+
+    if (!gateway.empty())
+    {
+        auto currentGateway = std::get<std::string>(ipmi::getDbusProperty(
+            bus, systemObject.second, systemObject.first,
+            ipmi::network::SYSTEMCONFIG_INTERFACE, "DefaultGateway"));
+        if (currentGateway != gateway)
+        {
+            ipmi::setDbusProperty(bus, systemObject.second, systemObject.first,
+                                  ipmi::network::SYSTEMCONFIG_INTERFACE,
+                                  "DefaultGateway", gateway);
+        }
+    }
+}
+
 void applyChanges(int channel)
 {
     std::string ipaddress;
@@ -721,7 +929,7 @@ void applyChanges(int channel)
 
     try
     {
-        sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+        sdbusplus::bus::bus& bus = getBus();
 
         log<level::INFO>("Network data from Cache",
                          entry("PREFIX=%s", channelConf->netmask.c_str()),
@@ -871,75 +1079,92 @@ void applyChanges(int channel)
             }
         }
 
-        // Currently network manager doesn't support purging of all the
-        // ip addresses and the vlan interfaces from the parent interface,
-        // TODO once the support is there, will make the change here.
-        // https://github.com/openbmc/openbmc/issues/2141.
-
-        // TODO Currently IPMI supports single interface,need to handle
-        // Multiple interface through
-        // https://github.com/openbmc/openbmc/issues/2138
+        // Each change makes the network daemon rewrite the configuration
+        // and reload the interface, so only what differs from the current
+        // configuration is changed.
+        auto current = getNetworkState(bus, ethdevice);
+        bool keepVLAN =
+            (current.vlanObjects.empty() && !vlanID) ||
+            (current.vlanObjects.size() == 1 && current.vlanID == vlanID &&
+             vlanID);
+        if (keepVLAN)
+        {
+            applyToInterface(bus, current, channelConf->ipsrc, ipaddress,
+                             prefix, gateway, systemObject);
+        }
+        else
+        {
+            // Currently network manager doesn't support purging of all the
+            // ip addresses and the vlan interfaces from the parent interface,
+            // TODO once the support is there, will make the change here.
+            // https://github.com/openbmc/openbmc/issues/2141.
 
-        // instead of deleting all the vlan interfaces and
-        // all the ipv4 address,we will call reset method.
-        // delete all the vlan interfaces
+            // TODO Currently IPMI supports single interface,need to handle
+            // Multiple interface through
+            // https://github.com/openbmc/openbmc/issues/2138
 
-        ipmi::deleteAllDbusObjects(bus, ipmi::network::ROOT,
-                                   ipmi::network::VLAN_INTERFACE);
+            // instead of deleting all the vlan interfaces and
+            // all the ipv4 address,we will call reset method.
+            // delete all the vlan interfaces
 
-        // set the interface mode  to static
-        auto networkInterfaceObject =
-            ipmi::getDbusObject(bus, ipmi::network::ETHERNET_INTERFACE,
-                                ipmi::network::ROOT, ethdevice);
+            ipmi::deleteAllDbusObjects(bus, ipmi::network::ROOT,
+                                       ipmi::network::VLAN_INTERFACE);
 
-        // setting the physical interface mode to static.
-        ipmi::setDbusProperty(
-            bus, ipmi::network::SERVICE, networkInterfaceObject.first,
-            ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", false);
+            // set the interface mode  to static
+            auto networkInterfaceObject =
+                ipmi::getDbusObject(bus, ipmi::network::ETHERNET_INTERFACE,
+                                    ipmi::network::ROOT, ethdevice);
 
-        networkInterfacePath = networkInterfaceObject.first;
+            // setting the physical interface mode to static.
+            ipmi::setDbusProperty(
+                bus, ipmi::network::SERVICE, networkInterfaceObject.first,
+                ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", false);
 
-        // delete all the ipv4 addresses
-        ipmi::deleteAllDbusObjects(bus, ipmi::network::ROOT,
-                                   ipmi::network::IP_INTERFACE, ethIp);
+            networkInterfacePath = networkInterfaceObject.first;
 
-        if (vlanID)
-        {
-            ipmi::network::createVLAN(bus, ipmi::network::SERVICE,
-                                      ipmi::network::ROOT, ethdevice, vlanID);
+            // delete all the ipv4 addresses
+            ipmi::deleteAllDbusObjects(bus, ipmi::network::ROOT,
+                                       ipmi::network::IP_INTERFACE, ethIp);
 
-            auto networkInterfaceObject = ipmi::getDbusObject(
-                bus, ipmi::network::VLAN_INTERFACE, ipmi::network::ROOT);
+            if (vlanID)
+            {
+                ipmi::network::createVLAN(bus, ipmi::network::SERVICE,
+                                          ipmi::network::ROOT, ethdevice,
+                                          vlanID);
 
-            networkInterfacePath = networkInterfaceObject.first;
-        }
+                auto networkInterfaceObject = ipmi::getDbusObject(
+                    bus, ipmi::network::VLAN_INTERFACE, ipmi::network::ROOT);
 
-        if (channelConf->ipsrc == ipmi::network::IPOrigin::DHCP)
-        {
-            ipmi::setDbusProperty(
-                bus, ipmi::network::SERVICE, networkInterfacePath,
-                ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", true);
-        }
-        else
-        {
-            // change the mode to static
-            ipmi::setDbusProperty(
-                bus, ipmi::network::SERVICE, networkInterfacePath,
-                ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", false);
+                networkInterfacePath = networkInterfaceObject.first;
+            }
 
-            if (!ipaddress.empty())
+            if (channelConf->ipsrc == ipmi::network::IPOrigin::DHCP)
             {
-                ipmi::network::createIP(bus, ipmi::network::SERVICE,
-                                        networkInterfacePath, ipv4Protocol,
-                                        ipaddress, prefix);
+                ipmi::setDbusProperty(
+                    bus, ipmi::network::SERVICE, networkInterfacePath,
+                    ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", true);
             }
-
-            if (!gateway.empty())
+            else
             {
-                ipmi::setDbusProperty(bus, systemObject.second,
-                                      systemObject.first,
-                                      ipmi::network::SYSTEMCONFIG_INTERFACE,
-                                      "DefaultGateway", std::string(gateway));
+                // change the mode to static
+                ipmi::setDbusProperty(
+                    bus, ipmi::network::SERVICE, networkInterfacePath,
+                    ipmi::network::ETHERNET_INTERFACE, "DHCPEnabled", false);
+
+                if (!ipaddress.empty())
+                {
+                    ipmi::network::createIP(bus, ipmi::network::SERVICE,
+                                            networkInterfacePath, ipv4Protocol,
+                                            ipaddress, prefix);
+                }
+
+                if (!gateway.empty())
+                {
+                    ipmi::setDbusProperty(
+                        bus, systemObject.second, systemObject.first,
+                        ipmi::network::SYSTEMCONFIG_INTERFACE,
+                        "DefaultGateway", std::string(gateway));
+                }
             }
         }
     }
@@ -954,6 +1179,8 @@ void applyChanges(int channel)
         commit<InternalFailure>();
     }
 
+    // don't wait for the signals of the changes just made
+    lan_cache::values.clear();
     channelConf->clear();
 }
 
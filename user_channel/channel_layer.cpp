@@ -83,6 +83,11 @@ size_t getChannelMaxTransferSize(uint8_t chNum)
     return getChannelConfigObject().getChannelMaxTransferSize(chNum);
 }
 
+uint32_t getChannelConfigGeneration()
+{
+    return getChannelConfigObject().getChannelConfigGeneration();
+}
+
 ipmi_ret_t ipmiChannelInit()
 {
     getChannelConfigObject();
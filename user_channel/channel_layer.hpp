@@ -253,6 +253,16 @@ int getChannelActiveSessions(const uint8_t chNum);
  */
 size_t getChannelMaxTransferSize(uint8_t chNum);
 
+/** @brief provides the generation of the channel configuration
+ *
+ *  The generation changes every time the channel configuration is loaded,
+ *  so callers can cache values derived from it and rebuild them only when
+ *  it changes.
+ *
+ *  @return channel configuration generation
+ */
+uint32_t getChannelConfigGeneration();
+
 /** @brief initializes channel management
  *
  *  @return IPMI_CC_OK for success, others for failure.
@@ -21,14 +21,19 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
+#include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <cerrno>
 #include <exception>
 #include <experimental/filesystem>
 #include <fstream>
+#include <iterator>
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/server/object.hpp>
+#include <string_view>
 #include <unordered_map>
 
 namespace ipmi
@@ -91,52 +96,64 @@ static constexpr size_t smallChannelSize = 64;
 std::unique_ptr<sdbusplus::bus::match_t> chPropertiesSignal
     __attribute__((init_priority(101)));
 
-// String mappings use in JSON config file
-static std::unordered_map<std::string, EChannelMediumType> mediumTypeMap = {
-    {"reserved", EChannelMediumType::reserved},
-    {"ipmb", EChannelMediumType::ipmb},
-    {"icmb-v1.0", EChannelMediumType::icmbV10},
-    {"icmb-v0.9", EChannelMediumType::icmbV09},
-    {"lan-802.3", EChannelMediumType::lan8032},
-    {"serial", EChannelMediumType::serial},
-    {"other-lan", EChannelMediumType::otherLan},
-    {"pci-smbus", EChannelMediumType::pciSmbus},
-    {"smbus-v1.0", EChannelMediumType::smbusV11},
-    {"smbus-v2.0", EChannelMediumType::smbusV20},
-    {"usb-1x", EChannelMediumType::usbV1x},
-    {"usb-2x", EChannelMediumType::usbV2x},
-    {"system-interface", EChannelMediumType::systemInterface},
-    {"oem", EChannelMediumType::oem},
-    {"unknown", EChannelMediumType::unknown}};
+// String mappings use in JSON config file; constant tables, so that nothing
+// has to be constructed before the configuration can be parsed
+static constexpr std::array<std::pair<std::string_view, EChannelMediumType>,
+                            15>
+    mediumTypeMap = {{{"reserved", EChannelMediumType::reserved},
+                      {"ipmb", EChannelMediumType::ipmb},
+                      {"icmb-v1.0", EChannelMediumType::icmbV10},
+                      {"icmb-v0.9", EChannelMediumType::icmbV09},
+                      {"lan-802.3", EChannelMediumType::lan8032},
+                      {"serial", EChannelMediumType::serial},
+                      {"other-lan", EChannelMediumType::otherLan},
+                      {"pci-smbus", EChannelMediumType::pciSmbus},
+                      {"smbus-v1.0", EChannelMediumType::smbusV11},
+                      {"smbus-v2.0", EChannelMediumType::smbusV20},
+                      {"usb-1x", EChannelMediumType::usbV1x},
+                      {"usb-2x", EChannelMediumType::usbV2x},
+                      {"system-interface", EChannelMediumType::systemInterface},
+                      {"oem", EChannelMediumType::oem},
+                      {"unknown", EChannelMediumType::unknown}}};
 
 static std::unordered_map<EInterfaceIndex, std::string> interfaceMap = {
     {interfaceKCS, "SMS"},
     {interfaceLAN1, "eth0"},
     {interfaceUnknown, "unknown"}};
 
-static std::unordered_map<std::string, EChannelProtocolType> protocolTypeMap = {
-    {"na", EChannelProtocolType::na},
-    {"ipmb-1.0", EChannelProtocolType::ipmbV10},
-    {"icmb-2.0", EChannelProtocolType::icmbV11},
-    {"reserved", EChannelProtocolType::reserved},
-    {"ipmi-smbus", EChannelProtocolType::ipmiSmbus},
-    {"kcs", EChannelProtocolType::kcs},
-    {"smic", EChannelProtocolType::smic},
-    {"bt-10", EChannelProtocolType::bt10},
-    {"bt-15", EChannelProtocolType::bt15},
-    {"tmode", EChannelProtocolType::tMode},
-    {"oem", EChannelProtocolType::oem}};
-
-static std::array<std::string, 4> accessModeList = {
+static constexpr std::array<
+    std::pair<std::string_view, EChannelProtocolType>, 11>
+    protocolTypeMap = {{{"na", EChannelProtocolType::na},
+                        {"ipmb-1.0", EChannelProtocolType::ipmbV10},
+                        {"icmb-2.0", EChannelProtocolType::icmbV11},
+                        {"reserved", EChannelProtocolType::reserved},
+                        {"ipmi-smbus", EChannelProtocolType::ipmiSmbus},
+                        {"kcs", EChannelProtocolType::kcs},
+                        {"smic", EChannelProtocolType::smic},
+                        {"bt-10", EChannelProtocolType::bt10},
+                        {"bt-15", EChannelProtocolType::bt15},
+                        {"tmode", EChannelProtocolType::tMode},
+                        {"oem", EChannelProtocolType::oem}}};
+
+static constexpr std::array<std::string_view, 4> accessModeList = {
     "disabled", "pre-boot", "always_available", "shared"};
 
-static std::array<std::string, 4> sessionSupportList = {
+static constexpr std::array<std::string_view, 4> sessionSupportList = {
     "session-less", "single-session", "multi-session", "session-based"};
 
-static std::array<std::string, PRIVILEGE_OEM + 1> privList = {
+static constexpr std::array<std::string_view, PRIVILEGE_OEM + 1> privList = {
     "priv-reserved", "priv-callback", "priv-user",
     "priv-operator", "priv-admin",    "priv-oem"};
 
+/* find the value of a string in one of the mapping tables */
+template <typename Map>
+static auto findMapping(const Map& map, const std::string& value)
+{
+    return std::find_if(map.begin(), map.end(), [&value](const auto& entry) {
+        return entry.first == value;
+    });
+}
+
 std::string ChannelConfig::getChannelName(const uint8_t chNum)
 {
     if (!isValidChannel(chNum))
@@ -305,6 +322,8 @@ ChannelConfig::ChannelConfig() : bus(ipmid_get_sd_bus_connection())
     if (mutexCleanupLock.try_lock())
     {
         boost::interprocess::named_recursive_mutex::remove(ipmiChannelMutex);
+        boost::interprocess::shared_memory_object::remove(
+            ipmiChannelGeneration);
         channelMutex =
             std::make_unique<boost::interprocess::named_recursive_mutex>(
                 boost::interprocess::open_or_create, ipmiChannelMutex);
@@ -318,6 +337,17 @@ ChannelConfig::ChannelConfig() : bus(ipmid_get_sd_bus_connection())
                 boost::interprocess::open_or_create, ipmiChannelMutex);
     }
 
+    // a new segment is zero filled, which are valid generations
+    boost::interprocess::shared_memory_object generationShm(
+        boost::interprocess::open_or_create, ipmiChannelGeneration,
+        boost::interprocess::read_write);
+    generationShm.truncate(2 * sizeof(*nvGeneration));
+    generationRegion = boost::interprocess::mapped_region(
+        generationShm, boost::interprocess::read_write);
+    nvGeneration =
+        static_cast<std::atomic<uint32_t>*>(generationRegion.get_address());
+    volatileGeneration = nvGeneration + 1;
+
     initChannelPersistData();
 
     sigHndlrLock = boost::interprocess::file_lock(channelNvDataFilename);
@@ -348,7 +378,7 @@ ChannelConfig::ChannelConfig() : bus(ipmid_get_sd_bus_connection())
 
 bool ChannelConfig::isValidChannel(const uint8_t chNum)
 {
-    if (chNum > maxIpmiChannels)
+    if (chNum >= maxIpmiChannels)
     {
         log<level::DEBUG>("Invalid channel ID - Out of range");
         return false;
@@ -678,15 +708,30 @@ ipmi_ret_t ChannelConfig::getChannelEnabledAuthType(const uint8_t chNum,
     return IPMI_CC_OK;
 }
 
-std::time_t ChannelConfig::getUpdatedFileTime(const std::string& fileName)
+ChannelConfig::FileStamp
+    ChannelConfig::getFileStamp(const std::string& fileName)
 {
     struct stat fileStat;
     if (stat(fileName.c_str(), &fileStat) != 0)
     {
         log<level::DEBUG>("Error in getting last updated time stamp");
-        return -EIO;
+        return FileStamp{};
     }
-    return fileStat.st_mtime;
+    return FileStamp{fileStat.st_mtim.tv_sec, fileStat.st_mtim.tv_nsec,
+                     fileStat.st_ino};
+}
+
+bool ChannelConfig::fileChanged(const std::string& fileName,
+                                const FileStamp& loaded,
+                                std::chrono::steady_clock::time_point& checked)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now - checked < std::chrono::seconds(1))
+    {
+        return false;
+    }
+    checked = now;
+    return getFileStamp(fileName) != loaded;
 }
 
 EChannelAccessMode
@@ -712,7 +757,7 @@ std::string ChannelConfig::convertToAccessModeString(const uint8_t value)
         throw std::invalid_argument("Invalid access mode.");
     }
 
-    return accessModeList.at(value);
+    return std::string(accessModeList[value]);
 }
 
 CommandPrivilege
@@ -737,7 +782,7 @@ std::string ChannelConfig::convertToPrivLimitString(const uint8_t value)
         throw std::invalid_argument("Invalid privilege.");
     }
 
-    return privList.at(value);
+    return std::string(privList[value]);
 }
 
 EChannelSessSupported
@@ -759,8 +804,7 @@ EChannelSessSupported
 EChannelMediumType
     ChannelConfig::convertToMediumTypeIndex(const std::string& value)
 {
-    std::unordered_map<std::string, EChannelMediumType>::iterator it =
-        mediumTypeMap.find(value);
+    auto it = findMapping(mediumTypeMap, value);
     if (it == mediumTypeMap.end())
     {
         log<level::ERR>("Invalid medium type.",
@@ -774,8 +818,7 @@ EChannelMediumType
 EChannelProtocolType
     ChannelConfig::convertToProtocolTypeIndex(const std::string& value)
 {
-    std::unordered_map<std::string, EChannelProtocolType>::iterator it =
-        protocolTypeMap.find(value);
+    auto it = findMapping(protocolTypeMap, value);
     if (it == protocolTypeMap.end())
     {
         log<level::ERR>("Invalid protocol type.",
@@ -846,17 +889,43 @@ Json ChannelConfig::readJsonFile(const std::string& configFile)
 int ChannelConfig::writeJsonFile(const std::string& configFile,
                                  const Json& jsonData)
 {
-    std::ofstream jsonFile(configFile);
+    std::string content = jsonData.dump();
+
+    // Most writes store what the file already has; leave the flash alone
+    std::ifstream currentFile(configFile, std::ios::in | std::ios::binary);
+    if (currentFile.good() &&
+        std::string(std::istreambuf_iterator<char>(currentFile), {}) ==
+            content)
+    {
+        return 0;
+    }
+    currentFile.close();
+
+    // Write JSON to a temporary file and replace the file with it, so that
+    // a reader never sees it half written
+    std::string tmpFile = configFile + "_tmp";
+    std::ofstream jsonFile(tmpFile, std::ios::out | std::ios::binary);
     if (!jsonFile.good())
     {
         log<level::ERR>("JSON file not found");
         return -EIO;
     }
-
-    // Write JSON to file
-    jsonFile << jsonData;
-
+    jsonFile << content;
     jsonFile.flush();
+    if (!jsonFile.good())
+    {
+        log<level::ERR>("Error in writing JSON file",
+                        entry("FILE=%s", tmpFile.c_str()));
+        return -EIO;
+    }
+    jsonFile.close();
+
+    if (std::rename(tmpFile.c_str(), configFile.c_str()) != 0)
+    {
+        log<level::ERR>("Error in renaming JSON file",
+                        entry("FILE=%s", configFile.c_str()));
+        return -EIO;
+    }
     return 0;
 }
 
@@ -888,6 +957,7 @@ int ChannelConfig::loadChannelConfig()
     }
 
     channelData.fill(ChannelProperties{});
+    configGeneration++;
 
     for (int chNum = 0; chNum < maxIpmiChannels; chNum++)
     {
@@ -955,6 +1025,9 @@ int ChannelConfig::readChannelVolatileData()
     boost::interprocess::scoped_lock<boost::interprocess::named_recursive_mutex>
         channelLock{*channelMutex};
 
+    // writers hold the lock, so this is the generation of the file read here
+    uint32_t generation = volatileGeneration->load();
+    FileStamp stamp = getFileStamp(channelVolatileDataFilename);
     Json data = readJsonFile(channelVolatileDataFilename);
     if (data == nullptr)
     {
@@ -1013,8 +1086,8 @@ int ChannelConfig::readChannelVolatileData()
         throw std::runtime_error("Corrupted volatile channel access file");
     }
 
-    // Update the timestamp
-    voltFileLastUpdatedTime = getUpdatedFileTime(channelVolatileDataFilename);
+    volatileLoadedGeneration = generation;
+    volatileLoadedStamp = stamp;
     return 0;
 }
 
@@ -1023,6 +1096,9 @@ int ChannelConfig::readChannelPersistData()
     boost::interprocess::scoped_lock<boost::interprocess::named_recursive_mutex>
         channelLock{*channelMutex};
 
+    // writers hold the lock, so this is the generation of the file read here
+    uint32_t generation = nvGeneration->load();
+    FileStamp stamp = getFileStamp(channelNvDataFilename);
     Json data = readJsonFile(channelNvDataFilename);
     if (data == nullptr)
     {
@@ -1080,8 +1156,8 @@ int ChannelConfig::readChannelPersistData()
         throw std::runtime_error("Corrupted nv channel access file");
     }
 
-    // Update the timestamp
-    nvFileLastUpdatedTime = getUpdatedFileTime(channelNvDataFilename);
+    nvLoadedGeneration = generation;
+    nvLoadedStamp = stamp;
     return 0;
 }
 
@@ -1129,8 +1205,9 @@ int ChannelConfig::writeChannelVolatileData()
         return -EIO;
     }
 
-    // Update the timestamp
-    voltFileLastUpdatedTime = getUpdatedFileTime(channelVolatileDataFilename);
+    // the channel data is what was just written, only the others reload
+    volatileLoadedGeneration = ++(*volatileGeneration);
+    volatileLoadedStamp = getFileStamp(channelVolatileDataFilename);
     return 0;
 }
 
@@ -1180,16 +1257,17 @@ int ChannelConfig::writeChannelPersistData()
         return -EIO;
     }
 
-    // Update the timestamp
-    nvFileLastUpdatedTime = getUpdatedFileTime(channelNvDataFilename);
+    // the channel data is what was just written, only the others reload
+    nvLoadedGeneration = ++(*nvGeneration);
+    nvLoadedStamp = getFileStamp(channelNvDataFilename);
     return 0;
 }
 
 int ChannelConfig::checkAndReloadNVData()
 {
-    std::time_t updateTime = getUpdatedFileTime(channelNvDataFilename);
     int ret = 0;
-    if (updateTime != nvFileLastUpdatedTime || updateTime == -EIO)
+    if (nvLoadedGeneration != nvGeneration->load() ||
+        fileChanged(channelNvDataFilename, nvLoadedStamp, nvStampChecked))
     {
         try
         {
@@ -1207,9 +1285,10 @@ int ChannelConfig::checkAndReloadNVData()
 
 int ChannelConfig::checkAndReloadVolatileData()
 {
-    std::time_t updateTime = getUpdatedFileTime(channelVolatileDataFilename);
     int ret = 0;
-    if (updateTime != voltFileLastUpdatedTime || updateTime == -EIO)
+    if (volatileLoadedGeneration != volatileGeneration->load() ||
+        fileChanged(channelVolatileDataFilename, volatileLoadedStamp,
+                    volatileStampChecked))
     {
         try
         {
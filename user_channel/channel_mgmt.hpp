@@ -17,12 +17,19 @@
 #pragma once
 #include "channel_layer.hpp"
 
+#include <sys/types.h>
+
+#include <atomic>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <boost/interprocess/sync/named_recursive_mutex.hpp>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
+#include <optional>
 #include <nlohmann/json.hpp>
 #include <sdbusplus/bus.hpp>
+#include <tuple>
 
 namespace ipmi
 {
@@ -35,6 +42,7 @@ using DbusVariant =
 using DbusChObjProperties = std::vector<std::pair<std::string, DbusVariant>>;
 
 static constexpr const char* ipmiChannelMutex = "ipmi_channel_mutex";
+static constexpr const char* ipmiChannelGeneration = "ipmi_channel_generation";
 static constexpr const char* ipmiChMutexCleanupLockFile =
     "/var/lib/ipmi/ipmi_channel_mutex_cleanup";
 
@@ -141,6 +149,15 @@ class ChannelConfig
      */
     size_t getChannelMaxTransferSize(uint8_t chNum);
 
+    /** @brief provides the generation of the channel configuration
+     *
+     *  @return generation; changes each time the configuration is loaded
+     */
+    uint32_t getChannelConfigGeneration()
+    {
+        return configGeneration;
+    }
+
     /** @brief provides channel info details
      *
      *  @param[in] chNum - channel number
@@ -246,12 +263,31 @@ class ChannelConfig
 
   private:
     uint32_t signalFlag = 0;
+    uint32_t configGeneration = 0;
     std::unique_ptr<boost::interprocess::named_recursive_mutex> channelMutex{
         nullptr};
     std::array<ChannelProperties, maxIpmiChannels> channelData;
-    std::time_t nvFileLastUpdatedTime;
-    std::time_t voltFileLastUpdatedTime;
     boost::interprocess::file_lock mutexCleanupLock;
+
+    /* generations of the NV and the volatile data files, shared by the
+     * processes that use them; bumped on every write so the others know to
+     * read the file again */
+    boost::interprocess::mapped_region generationRegion;
+    std::atomic<uint32_t>* nvGeneration = nullptr;
+    std::atomic<uint32_t>* volatileGeneration = nullptr;
+
+    /* generations of the files the channel data was read from, if any */
+    std::optional<uint32_t> nvLoadedGeneration;
+    std::optional<uint32_t> volatileLoadedGeneration;
+
+    /* mtime, in seconds and nanoseconds, and inode of each file; compared
+     * too, at most once a second, for a writer that doesn't bump the
+     * generation, such as an older netipmid or a restored backup */
+    using FileStamp = std::tuple<std::time_t, long, ino_t>;
+    FileStamp nvLoadedStamp{};
+    FileStamp volatileLoadedStamp{};
+    std::chrono::steady_clock::time_point nvStampChecked;
+    std::chrono::steady_clock::time_point volatileStampChecked;
     sdbusplus::bus::bus bus;
     bool signalHndlrObjectState = false;
     boost::interprocess::file_lock sigHndlrLock;
@@ -420,14 +456,26 @@ class ChannelConfig
     void processChAccessPropChange(const std::string& path,
                                    const DbusChObjProperties& chProperties);
 
-    /** @brief function to retrieve last modification time for the named file
+    /** @brief function to retrieve the last modification time and the inode
+     *  of the named file
+     *
+     *  @param[in] fileName - the name of the file
+     *
+     *  @return mtime and inode, or all zero for failure
+     */
+    FileStamp getFileStamp(const std::string& fileName);
+
+    /** @brief function to check a file against the stamp it was read with,
+     *  at most once a second
      *
-     *  @param[in] fileName - the name of the file for which to acquire
-     *  timestamp data
+     *  @param[in] fileName - the name of the file
+     *  @param[in] loaded - stamp of the file when it was read
+     *  @param[in,out] checked - when the file was last checked
      *
-     *  @return time the file was last modified
+     *  @return true if the file changed since
      */
-    std::time_t getUpdatedFileTime(const std::string& fileName);
+    bool fileChanged(const std::string& fileName, const FileStamp& loaded,
+                     std::chrono::steady_clock::time_point& checked);
 
     /** @brief function to convert the DBus path to a network channel name
      *
@@ -214,22 +214,7 @@ void PasswdMgr::initPasswordMap(void)
     if (dataBuf.size() != 0)
     {
         // populate the user list with password
-        char* outPtr = reinterpret_cast<char*>(dataBuf.data());
-        char* nToken = NULL;
-        char* linePtr = strtok_r(outPtr, "\n", &nToken);
-        size_t userEPos = 0, lineSize = 0;
-        while (linePtr != NULL)
-        {
-            std::string lineStr(linePtr);
-            if ((userEPos = lineStr.find(":")) != std::string::npos)
-            {
-                lineSize = lineStr.size();
-                passwdMapList.emplace(
-                    lineStr.substr(0, userEPos),
-                    lineStr.substr(userEPos + 1, lineSize - (userEPos + 1)));
-            }
-            linePtr = strtok_r(NULL, "\n", &nToken);
-        }
+        parsePasswdData(reinterpret_cast<char*>(dataBuf.data()));
     }
 
     // Update the timestamp
@@ -237,6 +222,25 @@ void PasswdMgr::initPasswordMap(void)
     return;
 }
 
+void PasswdMgr::parsePasswdData(char* data)
+{
+    char* nToken = NULL;
+    char* linePtr = strtok_r(data, "\n", &nToken);
+    size_t userEPos = 0, lineSize = 0;
+    while (linePtr != NULL)
+    {
+        std::string lineStr(linePtr);
+        if ((userEPos = lineStr.find(":")) != std::string::npos)
+        {
+            lineSize = lineStr.size();
+            passwdMapList.emplace(
+                lineStr.substr(0, userEPos),
+                lineStr.substr(userEPos + 1, lineSize - (userEPos + 1)));
+        }
+        linePtr = strtok_r(NULL, "\n", &nToken);
+    }
+}
+
 int PasswdMgr::readPasswdFileData(std::vector<uint8_t>& outBytes)
 {
     std::array<uint8_t, maxKeySize> keyBuff;
@@ -553,6 +557,16 @@ int PasswdMgr::updatePasswdSpecialFile(const std::string& userName,
         return -EIO;
     }
 
+    // The entries just written are the new content of the file, so take the
+    // password map from them instead of decrypting the file again on the
+    // next lookup.
+    inBytes.resize(inBytesLen);
+    inBytes.push_back(0);
+    passwdMapList.clear();
+    parsePasswdData(reinterpret_cast<char*>(inBytes.data()));
+    OPENSSL_cleanse(inBytes.data(), inBytes.size());
+    fileLastUpdatedTime = getUpdatedFileTime();
+
     return 0;
 }
 
@@ -75,6 +75,13 @@ class PasswdMgr
      */
     void initPasswordMap(void);
 
+    /** @brief adds the entries of the decrypted password file to
+     *  passwdMapList
+     *
+     *  @param[in,out] data - NUL terminated file data, modified while parsed
+     */
+    void parsePasswdData(char* data);
+
     /** @brief Function to read the encrypted password file data
      *
      *  @param[out] outBytes - vector to hold decrypted password file data
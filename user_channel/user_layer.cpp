@@ -88,6 +88,15 @@ ipmi_ret_t ipmiUserSetUserPassword(const uint8_t userId,
     return getUserAccessObject().setUserPassword(userId, userPassword);
 }
 
+ipmi_ret_t ipmiUserValidatePassword(const uint8_t userId,
+                                    const char* userPassword,
+                                    std::string& userName,
+                                    std::string& password)
+{
+    return getUserAccessObject().validateUserPassword(userId, userPassword,
+                                                      userName, password);
+}
+
 ipmi_ret_t ipmiSetSpecialUserPassword(const std::string& userName,
                                       const std::string& userPassword)
 {
@@ -138,6 +138,23 @@ ipmi_ret_t ipmiUserSetUserName(const uint8_t userId, const char* userName);
 ipmi_ret_t ipmiUserSetUserPassword(const uint8_t userId,
                                    const char* userPassword);
 
+/** @brief check a new user password before setting it
+ *
+ *  Setting the password of the returned user name with
+ *  ipmiSetSpecialUserPassword then does the same as ipmiUserSetUserPassword.
+ *
+ *  @param[in] userId - user id
+ *  @param[in] userPassword - New Password
+ *  @param[out] userName - user name
+ *  @param[out] password - the password as it is to be set
+ *
+ *  @return IPMI_CC_OK if it can be set, others for failure.
+ */
+ipmi_ret_t ipmiUserValidatePassword(const uint8_t userId,
+                                    const char* userPassword,
+                                    std::string& userName,
+                                    std::string& password);
+
 /** @brief set special user password (non-ipmi accounts)
  *
  *  @param[in] userName - user name
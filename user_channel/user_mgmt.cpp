@@ -21,10 +21,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/sync/named_recursive_mutex.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <cerrno>
 #include <fstream>
+#include <iterator>
 #include <nlohmann/json.hpp>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
@@ -64,6 +66,7 @@ static constexpr const char* getSubTreeMethod = "GetSubTree";
 static constexpr const char* getObjectMethod = "GetObject";
 
 static constexpr const char* ipmiUserMutex = "ipmi_usr_mutex";
+static constexpr const char* ipmiUserGeneration = "ipmi_usr_generation";
 static constexpr const char* ipmiMutexCleanupLockFile =
     "/var/lib/ipmi/ipmi_usr_mutex_cleanup";
 static constexpr const char* ipmiUserDataFile = "/var/lib/ipmi/ipmi_user.json";
@@ -205,7 +208,11 @@ int getUserNameFromPath(const std::string& path, std::string& userName)
     return 0;
 }
 
-void userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
+/** @brief apply one user manager event to the users table
+ *
+ *  @return true if the table changed and has to be written
+ */
+bool userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
                       const std::string& userName, const std::string& priv,
                       const bool& enabled, const std::string& newUserName)
 {
@@ -214,7 +221,7 @@ void userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
     {
         if (usrAccess.addUserEntry(userName, priv, enabled) == false)
         {
-            return;
+            return false;
         }
     }
     else
@@ -236,7 +243,7 @@ void userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
             log<level::DEBUG>("User not found for signal",
                               entry("USER_NAME=%s", userName.c_str()),
                               entry("USER_EVENT=%d", userEvent));
-            return;
+            return false;
         }
         switch (userEvent)
         {
@@ -255,15 +262,14 @@ void userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
                 // to getUsrMgmtSyncIndex()
                 if (userData->user[usrIndex]
                         .userPrivAccess[UserAccess::getUsrMgmtSyncIndex()]
-                        .privilege != userPriv)
+                        .privilege == userPriv)
                 {
-                    for (size_t chIndex = 0; chIndex < ipmiMaxChannels;
-                         ++chIndex)
-                    {
-                        userData->user[usrIndex]
-                            .userPrivAccess[chIndex]
-                            .privilege = userPriv;
-                    }
+                    return false;
+                }
+                for (size_t chIndex = 0; chIndex < ipmiMaxChannels; ++chIndex)
+                {
+                    userData->user[usrIndex].userPrivAccess[chIndex].privilege =
+                        userPriv;
                 }
                 break;
             }
@@ -282,6 +288,10 @@ void userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
             }
             case UserUpdateEvent::userStateUpdated:
             {
+                if (userData->user[usrIndex].userEnabled == enabled)
+                {
+                    return false;
+                }
                 userData->user[usrIndex].userEnabled = enabled;
                 break;
             }
@@ -289,16 +299,15 @@ void userUpdateHelper(UserAccess& usrAccess, const UserUpdateEvent& userEvent,
             {
                 log<level::ERR>("Unhandled user event",
                                 entry("USER_EVENT=%d", userEvent));
-                return;
+                return false;
             }
         }
     }
-    usrAccess.writeUserData();
     log<level::DEBUG>("User event handled successfully",
                       entry("USER_NAME=%s", userName.c_str()),
                       entry("USER_EVENT=%d", userEvent));
 
-    return;
+    return true;
 }
 
 void userUpdatedSignalHandler(UserAccess& usrAccess,
@@ -363,6 +372,8 @@ void userUpdatedSignalHandler(UserAccess& usrAccess,
         userLock{*(usrAccess.userMutex)};
     usrAccess.checkAndReloadUserData();
 
+    // all the changes of one signal are written together
+    bool changed = false;
     if (signal == propertiesChangedSignal)
     {
         std::string intfName;
@@ -394,8 +405,9 @@ void userUpdatedSignalHandler(UserAccess& usrAccess,
                     groups.end())
                 {
                     // remove user from ipmi user list.
-                    userUpdateHelper(usrAccess, UserUpdateEvent::userDeleted,
-                                     userName, priv, enabled, newUserName);
+                    changed |= userUpdateHelper(
+                        usrAccess, UserUpdateEvent::userDeleted, userName, priv,
+                        enabled, newUserName);
                 }
                 else
                 {
@@ -415,26 +427,31 @@ void userUpdatedSignalHandler(UserAccess& usrAccess,
                             "Failed to excute method",
                             entry("METHOD=%s", getAllPropertiesMethod),
                             entry("PATH=%s", msg.get_path()));
-                        return;
+                        break;
                     }
                     usrAccess.getUserProperties(properties, groups, priv,
                                                 enabled);
                     // add user to ipmi user list.
-                    userUpdateHelper(usrAccess, UserUpdateEvent::userCreated,
-                                     userName, priv, enabled, newUserName);
+                    changed |= userUpdateHelper(
+                        usrAccess, UserUpdateEvent::userCreated, userName, priv,
+                        enabled, newUserName);
                 }
             }
             else if (userEvent != UserUpdateEvent::reservedEvent)
             {
-                userUpdateHelper(usrAccess, userEvent, userName, priv, enabled,
-                                 newUserName);
+                changed |= userUpdateHelper(usrAccess, userEvent, userName,
+                                            priv, enabled, newUserName);
             }
         }
     }
     else if (userEvent != UserUpdateEvent::reservedEvent)
     {
-        userUpdateHelper(usrAccess, userEvent, userName, priv, enabled,
-                         newUserName);
+        changed = userUpdateHelper(usrAccess, userEvent, userName, priv,
+                                   enabled, newUserName);
+    }
+    if (changed)
+    {
+        usrAccess.writeUserData();
     }
     return;
 }
@@ -465,11 +482,22 @@ UserAccess::UserAccess() : bus(ipmid_get_sd_bus_connection())
     if (mutexCleanupLock.try_lock())
     {
         boost::interprocess::named_recursive_mutex::remove(ipmiUserMutex);
+        boost::interprocess::shared_memory_object::remove(ipmiUserGeneration);
     }
     mutexCleanupLock.lock_sharable();
     userMutex = std::make_unique<boost::interprocess::named_recursive_mutex>(
         boost::interprocess::open_or_create, ipmiUserMutex);
 
+    // a new segment is zero filled, which is a valid generation
+    boost::interprocess::shared_memory_object generationShm(
+        boost::interprocess::open_or_create, ipmiUserGeneration,
+        boost::interprocess::read_write);
+    generationShm.truncate(sizeof(*userGeneration));
+    generationRegion = boost::interprocess::mapped_region(
+        generationShm, boost::interprocess::read_write);
+    userGeneration = static_cast<std::atomic<uint32_t>*>(
+        generationRegion.get_address());
+
     initUserDataFile();
     getSystemPrivAndGroups();
     sigHndlrLock = boost::interprocess::file_lock(ipmiUserDataFile);
@@ -726,17 +754,17 @@ ipmi_ret_t UserAccess::setSpecialUserPassword(const std::string& userName,
     return IPMI_CC_OK;
 }
 
-ipmi_ret_t UserAccess::setUserPassword(const uint8_t userId,
-                                       const char* userPassword)
+ipmi_ret_t UserAccess::validateUserPassword(const uint8_t userId,
+                                            const char* userPassword,
+                                            std::string& userName,
+                                            std::string& passwd)
 {
-    std::string userName;
     if (ipmiUserGetUserName(userId, userName) != IPMI_CC_OK)
     {
         log<level::DEBUG>("User Name not found",
                           entry("USER-ID:%d", (uint8_t)userId));
         return IPMI_CC_PARM_OUT_OF_RANGE;
     }
-    std::string passwd;
     passwd.assign(reinterpret_cast<const char*>(userPassword), 0,
                   maxIpmi20PasswordSize);
     if (!std::regex_match(passwd.c_str(),
@@ -746,6 +774,20 @@ ipmi_ret_t UserAccess::setUserPassword(const uint8_t userId,
                           entry("USER-ID:%d", (uint8_t)userId));
         return IPMI_CC_INVALID_FIELD_REQUEST;
     }
+    return IPMI_CC_OK;
+}
+
+ipmi_ret_t UserAccess::setUserPassword(const uint8_t userId,
+                                       const char* userPassword)
+{
+    std::string userName;
+    std::string passwd;
+    ipmi_ret_t cc =
+        validateUserPassword(userId, userPassword, userName, passwd);
+    if (cc != IPMI_CC_OK)
+    {
+        return cc;
+    }
     if (!pamUpdatePasswd(userName.c_str(), passwd.c_str()))
     {
         log<level::DEBUG>("Failed to update password",
@@ -1005,6 +1047,9 @@ void UserAccess::readUserData()
     boost::interprocess::scoped_lock<boost::interprocess::named_recursive_mutex>
         userLock{*userMutex};
 
+    // writers hold the lock, so this is the generation of the file read here
+    uint32_t generation = userGeneration->load();
+    FileStamp stamp = getFileStamp();
     std::ifstream iUsrData(ipmiUserDataFile, std::ios::in | std::ios::binary);
     if (!iUsrData.good())
     {
@@ -1077,8 +1122,8 @@ void UserAccess::readUserData()
 
     log<level::DEBUG>("User data read from IPMI data file");
     iUsrData.close();
-    // Update the timestamp
-    fileLastUpdatedTime = getUpdatedFileTime();
+    loadedGeneration = generation;
+    loadedStamp = stamp;
     return;
 }
 
@@ -1087,15 +1132,6 @@ void UserAccess::writeUserData()
     boost::interprocess::scoped_lock<boost::interprocess::named_recursive_mutex>
         userLock{*userMutex};
 
-    static std::string tmpFile{std::string(ipmiUserDataFile) + "_tmp"};
-    std::ofstream oUsrData(tmpFile, std::ios::out | std::ios::binary);
-    if (!oUsrData.good())
-    {
-        log<level::ERR>("Error in creating temporary IPMI user data file");
-        throw std::ios_base::failure(
-            "Error in creating temporary IPMI user data file");
-    }
-
     Json jsonUsersTbl = Json::array();
     // user index 0 is reserved, starts with 1
     for (size_t usrIndex = 1; usrIndex <= ipmiMaxUsers; ++usrIndex)
@@ -1129,8 +1165,26 @@ void UserAccess::writeUserData()
         jsonUserInfo[jsonFixedUser] = usersTbl.user[usrIndex].fixedUserName;
         jsonUsersTbl.push_back(jsonUserInfo);
     }
+    std::string usrData = jsonUsersTbl.dump();
 
-    oUsrData << jsonUsersTbl;
+    // Most writes store what the file already has; leave the flash alone
+    std::ifstream iUsrData(ipmiUserDataFile, std::ios::in | std::ios::binary);
+    if (iUsrData.good() &&
+        std::string(std::istreambuf_iterator<char>(iUsrData), {}) == usrData)
+    {
+        return;
+    }
+    iUsrData.close();
+
+    static std::string tmpFile{std::string(ipmiUserDataFile) + "_tmp"};
+    std::ofstream oUsrData(tmpFile, std::ios::out | std::ios::binary);
+    if (!oUsrData.good())
+    {
+        log<level::ERR>("Error in creating temporary IPMI user data file");
+        throw std::ios_base::failure(
+            "Error in creating temporary IPMI user data file");
+    }
+    oUsrData << usrData;
     oUsrData.flush();
     oUsrData.close();
 
@@ -1139,8 +1193,9 @@ void UserAccess::writeUserData()
         log<level::ERR>("Error in renaming temporary IPMI user data file");
         throw std::runtime_error("Error in renaming IPMI user data file");
     }
-    // Update the timestamp
-    fileLastUpdatedTime = getUpdatedFileTime();
+    // the users table is what was just written, only the others reload
+    loadedGeneration = ++(*userGeneration);
+    loadedStamp = getFileStamp();
     return;
 }
 
@@ -1219,8 +1274,14 @@ void UserAccess::deleteUserIndex(const size_t& usrIdx)
 
 void UserAccess::checkAndReloadUserData()
 {
-    std::time_t updateTime = getUpdatedFileTime();
-    if (updateTime != fileLastUpdatedTime || updateTime == -EIO)
+    bool changed = loadedGeneration != userGeneration->load();
+    auto now = std::chrono::steady_clock::now();
+    if (!changed && now - stampChecked >= std::chrono::seconds(1))
+    {
+        stampChecked = now;
+        changed = getFileStamp() != loadedStamp;
+    }
+    if (changed)
     {
         std::fill(reinterpret_cast<uint8_t*>(&usersTbl),
                   reinterpret_cast<uint8_t*>(&usersTbl) + sizeof(usersTbl), 0);
@@ -1272,15 +1333,16 @@ void UserAccess::getSystemPrivAndGroups()
     return;
 }
 
-std::time_t UserAccess::getUpdatedFileTime()
+UserAccess::FileStamp UserAccess::getFileStamp()
 {
     struct stat fileStat;
     if (stat(ipmiUserDataFile, &fileStat) != 0)
     {
         log<level::DEBUG>("Error in getting last updated time stamp");
-        return -EIO;
+        return FileStamp{};
     }
-    return fileStat.st_mtime;
+    return FileStamp{fileStat.st_mtim.tv_sec, fileStat.st_mtim.tv_nsec,
+                     fileStat.st_ino};
 }
 
 void UserAccess::getUserProperties(const DbusUserObjProperties& properties,
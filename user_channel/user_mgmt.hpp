@@ -17,12 +17,18 @@
 #include "user_layer.hpp"
 
 #include <ipmid/api.h>
+#include <sys/types.h>
 
+#include <atomic>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 #include <boost/interprocess/sync/named_recursive_mutex.hpp>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
+#include <optional>
 #include <sdbusplus/bus.hpp>
+#include <tuple>
 
 namespace ipmi
 {
@@ -217,6 +223,20 @@ class UserAccess
      */
     ipmi_ret_t setUserPassword(const uint8_t userId, const char* userPassword);
 
+    /** @brief to check a new user password before setting it
+     *
+     *  @param[in] userId - user id
+     *  @param[in] userPassword  - new password of the user
+     *  @param[out] userName - name of the user
+     *  @param[out] password - the password as it is to be set
+     *
+     *  @return IPMI_CC_OK if it can be set, others for failure.
+     */
+    ipmi_ret_t validateUserPassword(const uint8_t userId,
+                                    const char* userPassword,
+                                    std::string& userName,
+                                    std::string& password);
+
     /** @brief to set special user password
      *
      *  @param[in] userName - user name
@@ -314,16 +334,30 @@ class UserAccess
     std::vector<std::string> availablePrivileges;
     std::vector<std::string> availableGroups;
     sdbusplus::bus::bus bus;
-    std::time_t fileLastUpdatedTime;
     bool signalHndlrObject = false;
     boost::interprocess::file_lock sigHndlrLock;
     boost::interprocess::file_lock mutexCleanupLock;
 
-    /** @brief function to get user configuration file timestamp
+    /* generation of the configuration file, shared by the processes that
+     * use it; bumped on every write so the others know to read it again */
+    boost::interprocess::mapped_region generationRegion;
+    std::atomic<uint32_t>* userGeneration = nullptr;
+
+    /* generation of the file the users table was read from, if any */
+    std::optional<uint32_t> loadedGeneration;
+
+    /* mtime, in seconds and nanoseconds, and inode of the file; compared
+     * too, at most once a second, for a writer that doesn't bump the
+     * generation, such as an older netipmid or a restored backup */
+    using FileStamp = std::tuple<std::time_t, long, ino_t>;
+    FileStamp loadedStamp{};
+    std::chrono::steady_clock::time_point stampChecked;
+
+    /** @brief function to get the user configuration file stamp
      *
-     *  @return time stamp or -EIO for failure
+     *  @return mtime and inode, or all zero for failure
      */
-    std::time_t getUpdatedFileTime();
+    FileStamp getFileStamp();
 
     /** @brief function to available system privileges and groups
      *
@@ -18,13 +18,16 @@
 
 #include "apphandler.hpp"
 #include "channel_layer.hpp"
+#include "handler-threads.hpp"
 #include "user_layer.hpp"
 
 #include <security/pam_appl.h>
 
+#include <cstring>
 #include <ipmid/api.hpp>
 #include <phosphor-logging/log.hpp>
 #include <regex>
+#include <vector>
 
 namespace ipmi
 {
@@ -80,29 +83,6 @@ struct GetUserNameResp
     uint8_t userName[16];
 } __attribute__((packed));
 
-/** @struct SetUserPasswordReq
- *
- *  Structure for set user password request command (refer spec sec 22.30)
- */
-struct SetUserPasswordReq
-{
-#if BYTE_ORDER == LITTLE_ENDIAN
-    uint8_t userId : 6;
-    uint8_t reserved1 : 1;
-    uint8_t ipmi20 : 1;
-    uint8_t operation : 2;
-    uint8_t reserved2 : 6;
-#endif
-#if BYTE_ORDER == BIG_ENDIAN
-    uint8_t ipmi20 : 1;
-    uint8_t reserved1 : 1;
-    uint8_t userId : 6;
-    uint8_t reserved2 : 6;
-    uint8_t operation : 2;
-#endif
-    uint8_t userPassword[maxIpmi20PasswordSize];
-} __attribute__((packed));
-
 /** @brief implements the set user access command
  *  @param ctx - IPMI context pointer (for channel)
  *  @param channel - channel number
@@ -320,84 +300,90 @@ ipmi_ret_t ipmiGetUserName(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return IPMI_CC_OK;
 }
 
-/** @brief implementes the set user password command
- *  @param[in] netfn - specifies netfn.
- *  @param[in] cmd   - specifies cmd number.
- *  @param[in] request - pointer to request data.
- *  @param[in, out] dataLen - specifies request data length, and returns
- * response data length.
- *  @param[in] context - ipmi context.
+/** @brief implements the set user password command
+ *  @param ctx - IPMI context pointer
+ *  @param id - user id
+ *  @param reserved1 - skip 1 bit
+ *  @param pwLen20 - true for a 20 byte password, false for 16 bytes
+ *  @param operation - disable/enable the user or set/test the password
+ *  @param reserved2 - skip 6 bits
+ *  @param userPassword - password data
+ *
  *  @returns ipmi completion code.
+ *
+ *  Setting the password goes through PAM, which can take a while, so it
+ *  runs on a worker thread when there are any.
  */
-ipmi_ret_t ipmiSetUserPassword(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
-                               ipmi_request_t request, ipmi_response_t response,
-                               ipmi_data_len_t dataLen, ipmi_context_t context)
+ipmi::RspType<> ipmiSetUserPassword(ipmi::Context::ptr ctx, uint6_t id,
+                                    bool reserved1, bool pwLen20,
+                                    uint2_t operation, uint6_t reserved2,
+                                    std::vector<uint8_t> userPassword)
 {
-    const SetUserPasswordReq* req = static_cast<SetUserPasswordReq*>(request);
-    size_t reqLength = *dataLen;
-    // subtract 2 bytes header to know the password length - including NULL
-    uint8_t passwordLength = *dataLen - 2;
-    *dataLen = 0;
+    uint8_t userId = static_cast<uint8_t>(id);
+    uint8_t op = static_cast<uint8_t>(operation);
 
     // verify input length based on operation. Required password size is 20
     // bytes as  we support only IPMI 2.0, but in order to be compatible with
     // tools, accept 16 bytes of password size too.
-    if (reqLength < 2 ||
-        // If enable / disable user, reqLength has to be >=2 & <= 22
-        ((req->operation == disableUser || req->operation == enableUser) &&
-         ((reqLength < 2) || (reqLength > sizeof(SetUserPasswordReq)))))
+    if ((op == disableUser || op == enableUser) &&
+        userPassword.size() > maxIpmi20PasswordSize)
     {
         log<level::DEBUG>("Invalid Length");
-        return IPMI_CC_REQ_DATA_LEN_INVALID;
+        return ipmi::responseReqDataLenInvalid();
     }
     // If set / test password then password length has to be 16 or 20 bytes
     // based on the password size bit.
-    if (((req->operation == setPassword) || (req->operation == testPassword)) &&
-        (((req->ipmi20 == passwordKeySize20) &&
-          (passwordLength != maxIpmi20PasswordSize)) ||
-         ((req->ipmi20 == passwordKeySize16) &&
-          (passwordLength != maxIpmi15PasswordSize))))
+    if ((op == setPassword || op == testPassword) &&
+        userPassword.size() !=
+            (pwLen20 ? maxIpmi20PasswordSize : maxIpmi15PasswordSize))
     {
         log<level::DEBUG>("Invalid Length");
-        return IPMI_CC_REQ_DATA_LEN_INVALID;
+        return ipmi::responseReqDataLenInvalid();
     }
 
     std::string userName;
-    if (ipmiUserGetUserName(req->userId, userName) != IPMI_CC_OK)
+    if (ipmiUserGetUserName(userId, userName) != IPMI_CC_OK)
     {
-        log<level::DEBUG>("User Name not found",
-                          entry("USER-ID:%d", (uint8_t)req->userId));
-        return IPMI_CC_PARM_OUT_OF_RANGE;
+        log<level::DEBUG>("User Name not found", entry("USER-ID:%d", userId));
+        return ipmi::responseParmOutOfRange();
     }
-    if (req->operation == setPassword)
+    // the password is NUL padded
+    std::string password(userPassword.begin(), userPassword.end());
+    password.resize(std::strlen(password.c_str()));
+
+    if (op == setPassword)
     {
-        return ipmiUserSetUserPassword(
-            req->userId, reinterpret_cast<const char*>(req->userPassword));
+        std::string passwd;
+        ipmi_ret_t cc = ipmiUserValidatePassword(userId, password.c_str(),
+                                                 userName, passwd);
+        if (cc != IPMI_CC_OK)
+        {
+            return ipmi::response(cc);
+        }
+        threads::runBlocking(
+            ctx, [&]() { cc = ipmiSetSpecialUserPassword(userName, passwd); });
+        return ipmi::response(cc);
     }
-    else if (req->operation == enableUser || req->operation == disableUser)
+    else if (op == enableUser || op == disableUser)
     {
-        return ipmiUserUpdateEnabledState(req->userId,
-                                          static_cast<bool>(req->operation));
+        return ipmi::response(
+            ipmiUserUpdateEnabledState(userId, static_cast<bool>(op)));
     }
-    else if (req->operation == testPassword)
+    else if (op == testPassword)
     {
-        auto password = ipmiUserGetPassword(userName);
-        std::string testPassword(
-            reinterpret_cast<const char*>(req->userPassword), 0,
-            passwordLength);
         // Note: For security reasons password size won't be compared and
         // wrong password size completion code will not be returned if size
         // doesn't match as specified in IPMI specification.
-        if (password != testPassword)
+        if (ipmiUserGetPassword(userName) != password)
         {
             log<level::DEBUG>("Test password failed",
-                              entry("USER-ID:%d", (uint8_t)req->userId));
-            return static_cast<ipmi_ret_t>(
-                IPMISetPasswordReturnCodes::ipmiCCPasswdFailMismatch);
+                              entry("USER-ID:%d", userId));
+            return ipmi::response(static_cast<ipmi::Cc>(
+                IPMISetPasswordReturnCodes::ipmiCCPasswdFailMismatch));
         }
-        return IPMI_CC_OK;
+        return ipmi::responseSuccess();
     }
-    return IPMI_CC_INVALID_FIELD_REQUEST;
+    return ipmi::responseInvalidFieldRequest();
 }
 
 /** @brief implements the get channel authentication command
@@ -503,8 +489,9 @@ void registerUserIpmiFunctions()
     ipmi_register_callback(NETFUN_APP, IPMI_CMD_SET_USER_NAME, NULL,
                            ipmiSetUserName, PRIVILEGE_ADMIN);
 
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_SET_USER_PASSWORD, NULL,
-                           ipmiSetUserPassword, PRIVILEGE_ADMIN);
+    ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
+                          ipmi::app::cmdSetUserPasswordCommand,
+                          ipmi::Privilege::Admin, ipmiSetUserPassword);
 
     ipmi::registerHandler(ipmi::prioOpenBmcBase, ipmi::netFnApp,
                           ipmi::app::cmdGetChannelAuthCapabilities,
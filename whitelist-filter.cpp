@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <array>
+#include <boost/asio/spawn.hpp>
 #include <ipmid/api.hpp>
+#include <ipmid/log-limit.hpp>
 #include <ipmid/utils.hpp>
 #include <ipmiwhitelist.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -35,6 +37,7 @@ class WhitelistFilter
 
   private:
     void postInit();
+    void postInit(boost::asio::yield_context yield);
     void cacheRestrictedMode();
     void handleRestrictedModeChange(sdbusplus::message::message& m);
     ipmi::Cc filterMessage(ipmi::message::Request::ptr request);
@@ -126,12 +129,27 @@ void WhitelistFilter::handleRestrictedModeChange(sdbusplus::message::message& m)
 
 void WhitelistFilter::postInit()
 {
-    objects = std::make_unique<settings::Objects>(
-        *bus, std::vector<settings::Interface>({restrictionModeIntf}));
-    if (!objects)
+    // the mapper may be slow to answer while the BMC boots; keep serving
+    // requests, in restricted mode, until it does
+    boost::asio::spawn(*getIoContext(),
+                       [this](boost::asio::yield_context yield) {
+                           postInit(yield);
+                       });
+}
+
+void WhitelistFilter::postInit(boost::asio::yield_context yield)
+{
+    try
+    {
+        objects = std::make_unique<settings::Objects>(
+            *bus, std::vector<settings::Interface>({restrictionModeIntf}),
+            yield);
+    }
+    catch (const std::exception& e)
     {
         log<level::ERR>(
-            "Failed to create settings object; defaulting to restricted mode");
+            "Failed to create settings object; defaulting to restricted mode",
+            entry("ERROR=%s", e.what()));
         return;
     }
 
@@ -159,13 +177,12 @@ ipmi::Cc WhitelistFilter::filterMessage(ipmi::message::Request::ptr request)
 {
     if (request->ctx->channel == ipmi::channelSystemIface && restrictedMode)
     {
-        if (!std::binary_search(
-                whitelist.cbegin(), whitelist.cend(),
-                std::make_pair(request->ctx->netFn, request->ctx->cmd)))
+        if (!isWhitelisted(whitelist, request->ctx->netFn, request->ctx->cmd))
         {
-            log<level::ERR>("Net function not whitelisted",
-                            entry("NETFN=0x%X", int(request->ctx->netFn)),
-                            entry("CMD=0x%X", int(request->ctx->cmd)));
+            ipmi::logLimited<level::ERR>(
+                "Net function not whitelisted",
+                entry("NETFN=0x%X", int(request->ctx->netFn)),
+                entry("CMD=0x%X", int(request->ctx->cmd)));
             return ipmi::ccInsufficientPrivilege;
         }
     }